@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2018 Kubos Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * @addtogroup NANOPOWER_API
+ * @{
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+/**
+ * Header at the start of each housekeeping history block
+ *
+ * The header is followed by the block's first sample (the keyframe), stored
+ * as a complete ::eps_hk_t in host byte order. Each following sample is stored as:
+ *
+ * - The time since the previous sample, as a varint
+ * - A bitmap with one bit per housekeeping field (in structure order, with arrays
+ *   expanded), set if the field changed since the previous sample
+ * - For each changed field, the zig-zag encoded difference from its previous
+ *   value, as a varint
+ */
+typedef struct
+{
+    uint32_t start;                         /**< Timestamp of the first sample */
+    uint32_t end;                           /**< Timestamp of the last sample */
+    uint16_t count;                         /**< Number of samples in the block */
+    uint16_t len;                           /**< Number of bytes used, including this header */
+} eps_history_block;
+
+/**
+ * Smallest allowed history block size
+ */
+#define EPS_HISTORY_MIN_BLOCK (sizeof(eps_history_block) + sizeof(eps_hk_t))
+
+/**
+ * Housekeeping history recorder
+ *
+ * Samples are stored in a caller-provided buffer, which is divided into
+ * fixed-size blocks. Each block starts with a keyframe, so it can be decoded on
+ * its own. Once the buffer is full, the oldest block is discarded to make room
+ * for new samples.
+ *
+ * The members of this structure should not be accessed directly
+ */
+typedef struct
+{
+    uint8_t * buffer;                       /**< Block storage */
+    uint16_t block_size;                    /**< Size of each block */
+    uint16_t num_blocks;                    /**< Number of blocks in `buffer` */
+    uint16_t first;                         /**< Index of the oldest block */
+    uint16_t used;                          /**< Number of blocks in use */
+    eps_hk_t last;                          /**< Most recent sample */
+    pthread_mutex_t mutex;                  /**< Protects the recorder's state */
+} eps_history;
+
+/**
+ * Housekeeping history summary, returned by ::k_eps_history_get_info
+ */
+typedef struct
+{
+    uint32_t samples;                       /**< Number of samples held */
+    uint32_t bytes;                         /**< Number of bytes used by the samples */
+    uint32_t oldest;                        /**< Timestamp of the oldest sample */
+    uint32_t newest;                        /**< Timestamp of the newest sample */
+} eps_history_info;
+
+/**
+ * Function called for each sample decoded from the housekeeping history
+ * @param [in] timestamp Time the sample was recorded
+ * @param [in] hk Pointer to the sample
+ * @param [in] arg Argument given to the reading function
+ */
+typedef void (*eps_history_cb)(uint32_t timestamp, const eps_hk_t * hk, void * arg);
+
+/**
+ * Set up a housekeeping history recorder
+ * @param [out] history Pointer to the recorder
+ * @param [in] buffer Storage for the recorded samples. Must be at least two blocks long
+ * @param [in] size Size of `buffer`
+ * @param [in] block_size Size of each block. Larger blocks compress better, smaller blocks
+ * discard less history at a time and can be read back faster
+ * @return KEPSStatus `EPS_OK` if OK, error otherwise
+ */
+KEPSStatus k_eps_history_init(eps_history * history, uint8_t * buffer,
+                              size_t size, uint16_t block_size);
+/**
+ * Release a housekeeping history recorder's resources
+ *
+ * The recorder's buffer is owned by the caller and is not freed
+ * @param [in] history Pointer to the recorder
+ */
+void k_eps_history_terminate(eps_history * history);
+/**
+ * Add a housekeeping sample to the history
+ * @param [in] history Pointer to the recorder
+ * @param [in] timestamp Time the sample was taken. Must not be older than the previous sample
+ * @param [in] hk Pointer to the sample
+ * @return KEPSStatus `EPS_OK` if OK, error otherwise
+ */
+KEPSStatus k_eps_history_record(eps_history * history, uint32_t timestamp,
+                                const eps_hk_t * hk);
+/**
+ * Fetch the EPS's housekeeping data and add it to the history
+ * @param [in] history Pointer to the recorder
+ * @param [in] timestamp Time to record the sample with
+ * @param [out] hk Pointer to storage for the fetched sample. May be `NULL`
+ * @return KEPSStatus `EPS_OK` if OK, error otherwise
+ */
+KEPSStatus k_eps_history_update(eps_history * history, uint32_t timestamp,
+                                eps_hk_t * hk);
+/**
+ * Get a summary of the samples held in the history
+ * @param [in] history Pointer to the recorder
+ * @param [out] info Pointer to storage for the summary
+ * @return KEPSStatus `EPS_OK` if OK, error otherwise
+ */
+KEPSStatus k_eps_history_get_info(eps_history * history, eps_history_info * info);
+/**
+ * Decode the samples recorded within a time range
+ * @param [in] history Pointer to the recorder
+ * @param [in] start Start of the time range (inclusive)
+ * @param [in] end End of the time range (inclusive)
+ * @param [in] callback Function to call for each sample, oldest first. The recorder is
+ * locked while it runs, so it must not call any other `k_eps_history_*` functions
+ * @param [in] arg Argument to pass to `callback`
+ * @return KEPSStatus `EPS_OK` if OK, error otherwise
+ */
+KEPSStatus k_eps_history_read(eps_history * history, uint32_t start,
+                              uint32_t end, eps_history_cb callback, void * arg);
+/**
+ * Copy the encoded blocks which hold a time range, ready for downlink
+ *
+ * Whole blocks are copied, so the output may include samples from either side
+ * of the range. The blocks can be decoded with ::k_eps_history_decode.
+ * @param [in] history Pointer to the recorder
+ * @param [in] start Start of the time range (inclusive)
+ * @param [in] end End of the time range (inclusive)
+ * @param [out] buffer Pointer to storage for the encoded blocks
+ * @param [in] size Size of `buffer`
+ * @param [out] len Number of bytes used. If `buffer` was too small, the number of bytes required
+ * @return KEPSStatus `EPS_OK` if OK, `EPS_ERROR_CONFIG` if `buffer` is too small, error otherwise
+ */
+KEPSStatus k_eps_history_extract(eps_history * history, uint32_t start,
+                                 uint32_t end, uint8_t * buffer, size_t size,
+                                 size_t * len);
+/**
+ * Decode blocks copied by ::k_eps_history_extract
+ * @param [in] data Pointer to the encoded blocks
+ * @param [in] len Length of `data`
+ * @param [in] start Start of the time range to decode (inclusive)
+ * @param [in] end End of the time range to decode (inclusive)
+ * @param [in] callback Function to call for each sample, oldest first
+ * @param [in] arg Argument to pass to `callback`
+ * @return KEPSStatus `EPS_OK` if OK, `EPS_ERROR` if the data is malformed
+ */
+KEPSStatus k_eps_history_decode(const uint8_t * data, size_t len,
+                                uint32_t start, uint32_t end,
+                                eps_history_cb callback, void * arg);
+
+/* @} */
@@ -22,6 +22,8 @@
 #pragma once
 
 #include <i2c.h>
+#include <power-policy.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -45,6 +47,13 @@
 #define GET_CONFIG2         22
 #define SET_CONFIG2         23
 
+/* GET_HOUSEKEEPING structure types */
+#define HK_FULL             0 /* eps_hk_t */
+#define HK_VI               1 /* eps_hk_vi_t */
+#define HK_OUT              2 /* eps_hk_out_t */
+#define HK_WDT              3 /* eps_hk_wdt_t */
+#define HK_BASIC            4 /* eps_hk_basic_t */
+
 /** \endcond */
 
 /**
@@ -134,6 +143,116 @@ typedef struct
     uint16_t reserved2;                     /**< Reserved */
 } __attribute__((packed)) eps_hk_t;
 
+/**
+ * P31u-8 voltage and current housekeeping subset
+ */
+typedef struct
+{
+    uint16_t vboost[3];                     /**< Voltage of input voltage boost converters [mV]*/
+    uint16_t vbatt;                         /**< Voltage of battery [mV] */
+    uint16_t curin[3];                      /**< Input currents [mA] */
+    uint16_t cursun;                        /**< Current from boost converters [mA] */
+    uint16_t cursys;                        /**< Current out of battery [mA] */
+    uint16_t reserved1;                     /**< Reserved for future use */
+} __attribute__((packed)) eps_hk_vi_t;
+
+/**
+ * P31u-8 output housekeeping subset
+ */
+typedef struct
+{
+    uint16_t curout[6];                     /**< Output currents [mA] */
+    uint8_t  output[8];                     /**< Output statuses [0 = Off, 1 = On] */
+    uint16_t output_on_delta[8];            /**< Time until output power on [seconds] */
+    uint16_t output_off_delta[8];           /**< Time until output power off [seconds] */
+    uint16_t latchup[6];                    /**< Number of output latch-up events */
+} __attribute__((packed)) eps_hk_out_t;
+
+/**
+ * P31u-8 watchdog housekeeping subset
+ */
+typedef struct
+{
+    uint32_t wdt_i2c_time_left;             /**< Time left for I2C watchdog [seconds] */
+    uint32_t wdt_gnd_time_left;             /**< Time left for dedicated watchdog [seconds] */
+    uint8_t  wdt_csp_pings_left[2];         /**< Pings left for CSP watchdog */
+    uint32_t counter_wdt_i2c;               /**< Number of I2C watchdog reboots */
+    uint32_t counter_wdt_gnd;               /**< Number of dedicated watchdog reboots */
+    uint32_t counter_wdt_csp[2];            /**< Number of CSP watchdog reboots */
+} __attribute__((packed)) eps_hk_wdt_t;
+
+/**
+ * P31u-8 basic housekeeping subset
+ */
+typedef struct
+{
+    uint32_t counter_boot;                  /**< Number of EPS reboots */
+    int16_t  temp[6];                       /**< Temperatures [degC] [0 = Temp1, Temp2, Temp3, Temp4, BP4a, BP4b] */
+    uint8_t  boot_cause;                    /**< Cause of last EPS reset */
+    uint8_t  batt_mode;                     /**< Mode for battery [0 = Initial, 1 = Critical, 2 = Safe, 3 = Normal, 4 = Full] */
+    uint8_t  ppt_mode;                      /**< Mode of power-point tracker [1 = Automatic maximum, 2 = Fixed] */
+    uint16_t reserved2;                     /**< Reserved */
+} __attribute__((packed)) eps_hk_basic_t;
+
+/**
+ * Types of command which can be included in a ::k_eps_set_batch batch
+ */
+typedef enum {
+    EPS_BATCH_OUTPUT,                       /**< Turn on/off a single output (see ::k_eps_set_single_output) */
+    EPS_BATCH_HEATER                        /**< Turn on/off a heater (see ::k_eps_set_heater) */
+} eps_batch_type;
+
+/**
+ * Single command within a ::k_eps_set_batch batch
+ */
+typedef struct
+{
+    eps_batch_type type;                    /**< Type of command */
+    uint8_t channel;                        /**< Output channel [0-7], or heater [0 = BP4, 1 = Onboard] */
+    uint8_t value;                          /**< Desired state [0 = Off, 1 = On] */
+    int16_t delay;                          /**< Time to wait before changing an output's value [seconds]. Ignored for heaters */
+} eps_batch_cmd;
+
+/**
+ * Location of a run of multi-byte fields within a P31u structure
+ */
+typedef struct
+{
+    uint8_t offset;                         /**< Offset of the first element within the structure */
+    uint8_t width;                          /**< Size of each element [2 or 4 bytes] */
+    uint8_t count;                          /**< Number of consecutive elements */
+} eps_field_layout;
+
+/**
+ * Layout of a P31u structure, used to convert it between the EPS's
+ * big-endian byte order and the host's byte order
+ *
+ * Single-byte fields don't need converting, so aren't listed
+ */
+typedef struct
+{
+    const eps_field_layout * fields;        /**< Multi-byte fields within the structure */
+    uint8_t num_fields;                     /**< Number of entries in `fields` */
+    uint8_t size;                           /**< Size of the structure */
+} eps_struct_layout;
+
+/** \cond Internal structure layouts */
+extern const eps_struct_layout eps_system_config_layout;
+extern const eps_struct_layout eps_battery_config_layout;
+extern const eps_struct_layout eps_hk_layout;
+extern const eps_struct_layout eps_hk_vi_layout;
+extern const eps_struct_layout eps_hk_out_layout;
+extern const eps_struct_layout eps_hk_wdt_layout;
+extern const eps_struct_layout eps_hk_basic_layout;
+/** \endcond */
+
+/*
+ * Include the rest of the headers
+ * Note: This line is here (rather than the top) because it needs KEPSStatus
+ * and eps_hk_t to be declared already
+ */
+#include "eps-history.h"
+
 /*
  * Public Functions
  */
@@ -229,6 +348,19 @@ KEPSStatus k_eps_set_input_mode(uint8_t mode);
  * @return KEPSStatus EPS_OK if OK, error otherwise
  */
 KEPSStatus k_eps_set_heater(uint8_t cmd, uint8_t heater, uint8_t mode);
+/**
+ * Apply a batch of output and heater changes as one uninterrupted command sequence
+ *
+ * All commands are validated before any are sent. No other EPS traffic is
+ * allowed between the commands. Once all commands have been sent, the output
+ * housekeeping data is read once to verify that every undelayed output change
+ * has taken effect.
+ * @param [in]  cmds    Array of commands to apply, in order
+ * @param [in]  count   Number of commands in `cmds`
+ * @param [out] out     Pointer to storage for the verification read. May be `NULL`
+ * @return KEPSStatus `EPS_OK` if OK, `EPS_ERROR` if an output didn't change, error otherwise
+ */
+KEPSStatus k_eps_set_batch(const eps_batch_cmd * cmds, int count, eps_hk_out_t * out);
 /**
  * Reset system configuration to default values
  * @return KEPSStatus EPS_OK if OK, error otherwise
@@ -252,6 +384,33 @@ KEPSStatus k_eps_reset_counters(void);
  * @return KEPSStatus EPS_OK if OK, error otherwise
  */
 KEPSStatus k_eps_get_housekeeping(eps_hk_t * buff);
+/**
+ * Get the voltage and current subset of the system housekeeping data
+ * @note Much smaller than the full housekeeping structure, so better suited to
+ * high-rate power monitoring
+ * @param [out] buff Pointer to storage structure
+ * @return KEPSStatus EPS_OK if OK, error otherwise
+ */
+KEPSStatus k_eps_get_housekeeping_vi(eps_hk_vi_t * buff);
+/**
+ * Get the output subset of the system housekeeping data
+ * @param [out] buff Pointer to storage structure
+ * @return KEPSStatus EPS_OK if OK, error otherwise
+ */
+KEPSStatus k_eps_get_housekeeping_out(eps_hk_out_t * buff);
+/**
+ * Get the watchdog subset of the system housekeeping data
+ * @param [out] buff Pointer to storage structure
+ * @return KEPSStatus EPS_OK if OK, error otherwise
+ */
+KEPSStatus k_eps_get_housekeeping_wdt(eps_hk_wdt_t * buff);
+/**
+ * Get the basic subset of the system housekeeping data (boot count,
+ * temperatures and modes)
+ * @param [out] buff Pointer to storage structure
+ * @return KEPSStatus EPS_OK if OK, error otherwise
+ */
+KEPSStatus k_eps_get_housekeeping_basic(eps_hk_basic_t * buff);
 /**
  * Get system configuration values
  * @param [out] buff Pointer to storage structure
@@ -271,21 +430,34 @@ KEPSStatus k_eps_get_battery_config(eps_battery_config_t * buff);
  * @return KEPSStatus EPS_OK if OK, error otherwise
  */
 KEPSStatus k_eps_get_heater(uint8_t * bp4, uint8_t * onboard);
+/**
+ * Fetch the system housekeeping data and use it to update the HAL power policy
+ *
+ * The EPS's battery mode and voltage are passed to ::k_power_update, which
+ * scales the polling intervals and watchdog slack used by the other device APIs
+ * @param [out] hk Pointer to storage for the fetched housekeeping data. May be `NULL`
+ * @param [out] mode Pointer to storage for the resulting power mode. May be `NULL`
+ * @return KEPSStatus `EPS_OK` if OK, error otherwise
+ */
+KEPSStatus k_eps_update_power_mode(eps_hk_t * hk, KPowerMode * mode);
 /**
  * Kick the EPS's watchdog once
  * @return KEPSStatus `EPS_OK` if OK, error otherwise
  */
 KEPSStatus k_eps_watchdog_kick(void);
 /**
- * Start a thread to kick the EPS's watchdog
+ * Start kicking the EPS's watchdog
+ *
+ * The kicks are made by the shared watchdog scheduler (see ::k_watchdog_register),
+ * every `interval` seconds. They are never brought forward to share a wakeup
  * @note The watchdog kick requires a write to EEPROM, which has a limited lifespan.
  * It is recommended that the watchdog interval be very large (ex. 48 **hours**)
- * @param [in] interval Time to sleep in between kicks [seconds]
+ * @param [in] interval Time in between kicks [seconds]. Must be less than 49 days
  * @return KEPSStatus `EPS_OK` if OK, error otherwise
  */
 KEPSStatus k_eps_watchdog_start(uint32_t interval);
 /**
- * Stop the watchdog thread
+ * Stop kicking the EPS's watchdog
  * @return KEPSStatus `EPS_OK` if OK, error otherwise
  */
 KEPSStatus k_eps_watchdog_stop(void);
@@ -314,5 +486,27 @@ KEPSStatus k_eps_passthrough(const uint8_t * tx, int tx_len, uint8_t * rx,
  */
 KEPSStatus kprv_eps_transfer(const uint8_t * tx, int tx_len, uint8_t * rx,
                              int rx_len);
+/**
+ * Write command to EPS and read back a response, with the EPS bus lock already held
+ * @param [in]  tx      Pointer to command packet to send
+ * @param [in]  tx_len  Size of command packet
+ * @param [out] rx      Pointer to storage for command response
+ * @param [in]  rx_len  Expected length of command response
+ * @return KEPSStatus EPS_OK if OK, error otherwise
+ */
+KEPSStatus kprv_eps_transfer_locked(const uint8_t * tx, int tx_len, uint8_t * rx,
+                                    int rx_len);
+/**
+ * Copy a P31u structure, converting all of its multi-byte fields between
+ * big-endian and host byte order
+ *
+ * The conversion is symmetric, so this is used both to decode responses and
+ * to encode commands. `src` and `dst` may be the same structure.
+ * @param [out] dst     Pointer to storage for the converted structure
+ * @param [in]  src     Pointer to the structure to convert
+ * @param [in]  layout  Layout of the structure
+ */
+void kprv_eps_convert(void * dst, const void * src,
+                      const eps_struct_layout * layout);
 
 /* @} */
@@ -0,0 +1,607 @@
+/*
+ * Copyright (C) 2018 Kubos Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * GOMspace NanoPower API - Housekeeping History
+ */
+
+#include <gomspace-p31u-api.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Longest possible encoding of a 32-bit varint */
+#define VARINT_MAX 5
+
+/* A single housekeeping field, with arrays expanded */
+typedef struct
+{
+    uint8_t offset;
+    uint8_t width;
+} eps_history_field;
+
+static eps_history_field history_fields[sizeof(eps_hk_t)];
+static int               history_num_fields = 0;
+static int               history_bitmap_len = 0;
+static pthread_once_t    history_once       = PTHREAD_ONCE_INIT;
+
+/*
+ * Build the field list from the byte-swapping layout, so the two can never
+ * disagree. Any byte which isn't part of a multi-byte field is a field of its own
+ */
+static void kprv_eps_history_init_fields(void)
+{
+    int offset = 0;
+
+    while (offset < (int) sizeof(eps_hk_t))
+    {
+        uint8_t width = 1;
+
+        for (int i = 0; i < eps_hk_layout.num_fields; i++)
+        {
+            const eps_field_layout * field = &eps_hk_layout.fields[i];
+            if (offset >= field->offset
+                && offset < field->offset + field->width * field->count)
+            {
+                width = field->width;
+                break;
+            }
+        }
+
+        history_fields[history_num_fields].offset = offset;
+        history_fields[history_num_fields].width  = width;
+        history_num_fields++;
+
+        offset += width;
+    }
+
+    history_bitmap_len = (history_num_fields + 7) / 8;
+}
+
+static uint32_t kprv_eps_history_get(const eps_hk_t * hk,
+                                     const eps_history_field * field)
+{
+    const uint8_t * ptr = (const uint8_t *) hk + field->offset;
+    uint16_t        val16;
+    uint32_t        val32;
+
+    switch (field->width)
+    {
+        case 2:
+            memcpy(&val16, ptr, sizeof(val16));
+            return val16;
+        case 4:
+            memcpy(&val32, ptr, sizeof(val32));
+            return val32;
+        default:
+            return *ptr;
+    }
+}
+
+static void kprv_eps_history_set(eps_hk_t * hk, const eps_history_field * field,
+                                 uint32_t value)
+{
+    uint8_t * ptr   = (uint8_t *) hk + field->offset;
+    uint16_t  val16 = (uint16_t) value;
+
+    switch (field->width)
+    {
+        case 2:
+            memcpy(ptr, &val16, sizeof(val16));
+            break;
+        case 4:
+            memcpy(ptr, &value, sizeof(value));
+            break;
+        default:
+            *ptr = (uint8_t) value;
+    }
+}
+
+static size_t kprv_eps_history_put_varint(uint8_t * buffer, uint32_t value)
+{
+    size_t len = 0;
+
+    while (value >= 0x80)
+    {
+        buffer[len++] = (uint8_t) (value | 0x80);
+        value >>= 7;
+    }
+    buffer[len++] = (uint8_t) value;
+
+    return len;
+}
+
+static bool kprv_eps_history_get_varint(const uint8_t * buffer, size_t len,
+                                        size_t * pos, uint32_t * value)
+{
+    *value = 0;
+
+    for (int shift = 0; shift < 7 * VARINT_MAX; shift += 7)
+    {
+        if (*pos >= len)
+        {
+            return false;
+        }
+
+        uint8_t byte = buffer[(*pos)++];
+        *value |= (uint32_t) (byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+ * Encode the change in a field. The difference wraps at the field's width, so
+ * signed fields and counters which roll over still give small deltas
+ */
+static uint32_t kprv_eps_history_zigzag(uint32_t old, uint32_t new, uint8_t width)
+{
+    int     shift = 32 - width * 8;
+    int32_t delta = (int32_t) ((new - old) << shift) >> shift;
+
+    return ((uint32_t) delta << 1) ^ (uint32_t) (delta >> 31);
+}
+
+static uint32_t kprv_eps_history_unzigzag(uint32_t old, uint32_t zigzag)
+{
+    return old + ((zigzag >> 1) ^ -(zigzag & 1));
+}
+
+/* Encode a sample as a delta against the previous one */
+static size_t kprv_eps_history_encode(uint8_t * buffer, uint32_t elapsed,
+                                      const eps_hk_t * prev, const eps_hk_t * hk)
+{
+    size_t    len    = kprv_eps_history_put_varint(buffer, elapsed);
+    uint8_t * bitmap = buffer + len;
+
+    memset(bitmap, 0, history_bitmap_len);
+    len += history_bitmap_len;
+
+    for (int i = 0; i < history_num_fields; i++)
+    {
+        uint32_t old = kprv_eps_history_get(prev, &history_fields[i]);
+        uint32_t new = kprv_eps_history_get(hk, &history_fields[i]);
+
+        if (old != new)
+        {
+            bitmap[i / 8] |= 1 << (i % 8);
+            len += kprv_eps_history_put_varint(
+                buffer + len,
+                kprv_eps_history_zigzag(old, new, history_fields[i].width));
+        }
+    }
+
+    return len;
+}
+
+static bool kprv_eps_history_decode_sample(const uint8_t * buffer, size_t len,
+                                           size_t * pos, uint32_t * timestamp,
+                                           eps_hk_t * hk)
+{
+    uint32_t elapsed;
+    uint32_t zigzag;
+
+    if (!kprv_eps_history_get_varint(buffer, len, pos, &elapsed)
+        || *pos + history_bitmap_len > len)
+    {
+        return false;
+    }
+
+    const uint8_t * bitmap = buffer + *pos;
+    *pos += history_bitmap_len;
+
+    for (int i = 0; i < history_num_fields; i++)
+    {
+        if (!(bitmap[i / 8] & (1 << (i % 8))))
+        {
+            continue;
+        }
+
+        if (!kprv_eps_history_get_varint(buffer, len, pos, &zigzag))
+        {
+            return false;
+        }
+
+        uint32_t old = kprv_eps_history_get(hk, &history_fields[i]);
+        kprv_eps_history_set(hk, &history_fields[i],
+                             kprv_eps_history_unzigzag(old, zigzag));
+    }
+
+    *timestamp += elapsed;
+
+    return true;
+}
+
+/* Decode the samples within [start, end] from a single block */
+static KEPSStatus kprv_eps_history_decode_block(const uint8_t * block, size_t avail,
+                                                uint32_t start, uint32_t end,
+                                                eps_history_cb callback, void * arg,
+                                                size_t * block_len)
+{
+    eps_history_block header;
+    eps_hk_t          hk;
+
+    if (avail < EPS_HISTORY_MIN_BLOCK)
+    {
+        return EPS_ERROR;
+    }
+
+    memcpy(&header, block, sizeof(header));
+    if (header.len < EPS_HISTORY_MIN_BLOCK || header.len > avail || header.count == 0)
+    {
+        return EPS_ERROR;
+    }
+
+    *block_len = header.len;
+
+    size_t   pos       = sizeof(header);
+    uint32_t timestamp = header.start;
+
+    memcpy(&hk, block + pos, sizeof(hk));
+    pos += sizeof(hk);
+
+    for (int i = 0; i < header.count; i++)
+    {
+        if (i > 0 && !kprv_eps_history_decode_sample(block, header.len, &pos,
+                                                     &timestamp, &hk))
+        {
+            return EPS_ERROR;
+        }
+
+        if (timestamp > end)
+        {
+            break;
+        }
+
+        if (timestamp >= start)
+        {
+            callback(timestamp, &hk, arg);
+        }
+    }
+
+    return EPS_OK;
+}
+
+static uint8_t * kprv_eps_history_block(const eps_history * history, int index)
+{
+    return history->buffer
+           + ((history->first + index) % history->num_blocks) * history->block_size;
+}
+
+static void kprv_eps_history_get_header(const eps_history * history, int index,
+                                        eps_history_block * header)
+{
+    memcpy(header, kprv_eps_history_block(history, index), sizeof(*header));
+}
+
+static void kprv_eps_history_set_header(eps_history * history, int index,
+                                        const eps_history_block * header)
+{
+    memcpy(kprv_eps_history_block(history, index), header, sizeof(*header));
+}
+
+/* Start a new block with a keyframe, discarding the oldest block if needed */
+static void kprv_eps_history_keyframe(eps_history * history, uint32_t timestamp,
+                                      const eps_hk_t * hk)
+{
+    eps_history_block header = {
+        .start = timestamp,
+        .end   = timestamp,
+        .count = 1,
+        .len   = EPS_HISTORY_MIN_BLOCK
+    };
+
+    if (history->used == history->num_blocks)
+    {
+        history->first = (history->first + 1) % history->num_blocks;
+        history->used--;
+    }
+
+    int index = history->used++;
+
+    kprv_eps_history_set_header(history, index, &header);
+    memcpy(kprv_eps_history_block(history, index) + sizeof(header), hk, sizeof(*hk));
+}
+
+/* Find the first block which holds samples at or after `start` */
+static int kprv_eps_history_find(const eps_history * history, uint32_t start)
+{
+    eps_history_block header;
+    int               low  = 0;
+    int               high = history->used;
+
+    while (low < high)
+    {
+        int mid = (low + high) / 2;
+
+        kprv_eps_history_get_header(history, mid, &header);
+        if (header.end < start)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+KEPSStatus k_eps_history_init(eps_history * history, uint8_t * buffer,
+                              size_t size, uint16_t block_size)
+{
+    if (history == NULL || buffer == NULL || block_size < EPS_HISTORY_MIN_BLOCK)
+    {
+        return EPS_ERROR_CONFIG;
+    }
+
+    size_t num_blocks = size / block_size;
+    if (num_blocks < 2)
+    {
+        fprintf(stderr, "EPS history buffer must hold at least two blocks\n");
+        return EPS_ERROR_CONFIG;
+    }
+
+    pthread_once(&history_once, kprv_eps_history_init_fields);
+
+    memset(history, 0, sizeof(*history));
+    history->buffer     = buffer;
+    history->block_size = block_size;
+    history->num_blocks = (num_blocks > UINT16_MAX) ? UINT16_MAX : num_blocks;
+
+    if (pthread_mutex_init(&history->mutex, NULL) != 0)
+    {
+        perror("Failed to create EPS history mutex");
+        return EPS_ERROR;
+    }
+
+    return EPS_OK;
+}
+
+void k_eps_history_terminate(eps_history * history)
+{
+    if (history != NULL)
+    {
+        pthread_mutex_destroy(&history->mutex);
+    }
+}
+
+KEPSStatus k_eps_history_record(eps_history * history, uint32_t timestamp,
+                                const eps_hk_t * hk)
+{
+    eps_history_block header;
+    uint8_t           sample[VARINT_MAX * (1 + sizeof(eps_hk_t)) + sizeof(eps_hk_t)];
+
+    if (history == NULL || hk == NULL)
+    {
+        return EPS_ERROR_CONFIG;
+    }
+
+    pthread_mutex_lock(&history->mutex);
+
+    if (history->used == 0)
+    {
+        kprv_eps_history_keyframe(history, timestamp, hk);
+        history->last = *hk;
+        pthread_mutex_unlock(&history->mutex);
+        return EPS_OK;
+    }
+
+    int index = history->used - 1;
+    kprv_eps_history_get_header(history, index, &header);
+
+    if (timestamp < header.end)
+    {
+        pthread_mutex_unlock(&history->mutex);
+        fprintf(stderr, "EPS history sample is older than the previous sample\n");
+        return EPS_ERROR_CONFIG;
+    }
+
+    size_t len = kprv_eps_history_encode(sample, timestamp - header.end,
+                                         &history->last, hk);
+
+    if (header.len + len > history->block_size || header.count == UINT16_MAX)
+    {
+        kprv_eps_history_keyframe(history, timestamp, hk);
+    }
+    else
+    {
+        memcpy(kprv_eps_history_block(history, index) + header.len, sample, len);
+        header.len += len;
+        header.count++;
+        header.end = timestamp;
+        kprv_eps_history_set_header(history, index, &header);
+    }
+
+    history->last = *hk;
+
+    pthread_mutex_unlock(&history->mutex);
+
+    return EPS_OK;
+}
+
+KEPSStatus k_eps_history_update(eps_history * history, uint32_t timestamp,
+                                eps_hk_t * hk)
+{
+    KEPSStatus status;
+    eps_hk_t   sample;
+
+    if (history == NULL)
+    {
+        return EPS_ERROR_CONFIG;
+    }
+
+    status = k_eps_get_housekeeping(&sample);
+    if (status != EPS_OK)
+    {
+        return status;
+    }
+
+    if (hk != NULL)
+    {
+        *hk = sample;
+    }
+
+    return k_eps_history_record(history, timestamp, &sample);
+}
+
+KEPSStatus k_eps_history_get_info(eps_history * history, eps_history_info * info)
+{
+    eps_history_block header;
+
+    if (history == NULL || info == NULL)
+    {
+        return EPS_ERROR_CONFIG;
+    }
+
+    memset(info, 0, sizeof(*info));
+
+    pthread_mutex_lock(&history->mutex);
+
+    for (int i = 0; i < history->used; i++)
+    {
+        kprv_eps_history_get_header(history, i, &header);
+
+        if (i == 0)
+        {
+            info->oldest = header.start;
+        }
+        info->newest = header.end;
+        info->samples += header.count;
+        info->bytes += header.len;
+    }
+
+    pthread_mutex_unlock(&history->mutex);
+
+    return EPS_OK;
+}
+
+KEPSStatus k_eps_history_read(eps_history * history, uint32_t start,
+                              uint32_t end, eps_history_cb callback, void * arg)
+{
+    KEPSStatus        status = EPS_OK;
+    eps_history_block header;
+    size_t            block_len;
+
+    if (history == NULL || callback == NULL || start > end)
+    {
+        return EPS_ERROR_CONFIG;
+    }
+
+    pthread_mutex_lock(&history->mutex);
+
+    for (int i = kprv_eps_history_find(history, start); i < history->used; i++)
+    {
+        kprv_eps_history_get_header(history, i, &header);
+        if (header.start > end)
+        {
+            break;
+        }
+
+        status = kprv_eps_history_decode_block(kprv_eps_history_block(history, i),
+                                               history->block_size, start, end,
+                                               callback, arg, &block_len);
+        if (status != EPS_OK)
+        {
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&history->mutex);
+
+    return status;
+}
+
+KEPSStatus k_eps_history_extract(eps_history * history, uint32_t start,
+                                 uint32_t end, uint8_t * buffer, size_t size,
+                                 size_t * len)
+{
+    eps_history_block header;
+
+    if (history == NULL || len == NULL || start > end
+        || (buffer == NULL && size != 0))
+    {
+        return EPS_ERROR_CONFIG;
+    }
+
+    *len = 0;
+
+    pthread_mutex_lock(&history->mutex);
+
+    int first = kprv_eps_history_find(history, start);
+    int last  = first;
+
+    /* Measure first, so nothing is copied if it won't all fit */
+    for (; last < history->used; last++)
+    {
+        kprv_eps_history_get_header(history, last, &header);
+        if (header.start > end)
+        {
+            break;
+        }
+        *len += header.len;
+    }
+
+    if (*len > size)
+    {
+        pthread_mutex_unlock(&history->mutex);
+        return EPS_ERROR_CONFIG;
+    }
+
+    size_t pos = 0;
+    for (int i = first; i < last; i++)
+    {
+        kprv_eps_history_get_header(history, i, &header);
+        memcpy(buffer + pos, kprv_eps_history_block(history, i), header.len);
+        pos += header.len;
+    }
+
+    pthread_mutex_unlock(&history->mutex);
+
+    return EPS_OK;
+}
+
+KEPSStatus k_eps_history_decode(const uint8_t * data, size_t len,
+                                uint32_t start, uint32_t end,
+                                eps_history_cb callback, void * arg)
+{
+    KEPSStatus status;
+    size_t     block_len;
+    size_t     pos = 0;
+
+    if ((data == NULL && len != 0) || callback == NULL || start > end)
+    {
+        return EPS_ERROR_CONFIG;
+    }
+
+    pthread_once(&history_once, kprv_eps_history_init_fields);
+
+    while (pos < len)
+    {
+        status = kprv_eps_history_decode_block(data + pos, len - pos, start, end,
+                                               callback, arg, &block_len);
+        if (status != EPS_OK)
+        {
+            return status;
+        }
+
+        pos += block_len;
+    }
+
+    return EPS_OK;
+}
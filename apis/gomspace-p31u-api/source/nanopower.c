@@ -15,14 +15,112 @@
  */
 
 #include <gomspace-p31u-api.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
 #include <unistd.h>
+#include <watchdog.h>
 
 static int eps_bus = 0;
 static uint8_t eps_addr = 0;
 
+/* Serializes all EPS bus traffic, so command/response pairs never interleave */
+static pthread_mutex_t eps_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+typedef struct __attribute__((packed))
+{
+    uint8_t cmd;
+    uint8_t channel;
+    uint8_t value;
+    int16_t delay;
+} eps_single_output_packet;
+
+/* Describe a multi-byte field (or array of fields) within a structure */
+#define EPS_FIELD(type, member, width) \
+    { offsetof(type, member), width, sizeof(((type *) 0)->member) / (width) }
+
+#define EPS_LAYOUT(type, fields) \
+    { fields, sizeof(fields) / sizeof(fields[0]), sizeof(type) }
+
+_Static_assert(sizeof(eps_hk_t) <= UINT8_MAX, "eps_hk_t offsets must fit in a uint8_t");
+_Static_assert(sizeof(eps_hk_vi_t) + sizeof(eps_hk_out_t) + sizeof(eps_hk_wdt_t)
+                   + sizeof(eps_hk_basic_t) == sizeof(eps_hk_t),
+               "Housekeeping subsets must cover eps_hk_t");
+
+static const eps_field_layout eps_system_config_fields[] = {
+    EPS_FIELD(eps_system_config_t, output_initial_on_delay, 2),
+    EPS_FIELD(eps_system_config_t, output_initial_off_delay, 2),
+    EPS_FIELD(eps_system_config_t, vboost, 2),
+};
+
+static const eps_field_layout eps_battery_config_fields[] = {
+    EPS_FIELD(eps_battery_config_t, batt_maxvoltage, 2),
+    EPS_FIELD(eps_battery_config_t, batt_safevoltage, 2),
+    EPS_FIELD(eps_battery_config_t, batt_criticalvoltage, 2),
+    EPS_FIELD(eps_battery_config_t, batt_normalvoltage, 2),
+    EPS_FIELD(eps_battery_config_t, reserved1, 4),
+};
+
+static const eps_field_layout eps_hk_fields[] = {
+    EPS_FIELD(eps_hk_t, vboost, 2),
+    EPS_FIELD(eps_hk_t, vbatt, 2),
+    EPS_FIELD(eps_hk_t, curin, 2),
+    EPS_FIELD(eps_hk_t, cursun, 2),
+    EPS_FIELD(eps_hk_t, cursys, 2),
+    EPS_FIELD(eps_hk_t, reserved1, 2),
+    EPS_FIELD(eps_hk_t, curout, 2),
+    EPS_FIELD(eps_hk_t, output_on_delta, 2),
+    EPS_FIELD(eps_hk_t, output_off_delta, 2),
+    EPS_FIELD(eps_hk_t, latchup, 2),
+    EPS_FIELD(eps_hk_t, wdt_i2c_time_left, 4),
+    EPS_FIELD(eps_hk_t, wdt_gnd_time_left, 4),
+    EPS_FIELD(eps_hk_t, counter_wdt_i2c, 4),
+    EPS_FIELD(eps_hk_t, counter_wdt_gnd, 4),
+    EPS_FIELD(eps_hk_t, counter_wdt_csp, 4),
+    EPS_FIELD(eps_hk_t, counter_boot, 4),
+    EPS_FIELD(eps_hk_t, temp, 2),
+    EPS_FIELD(eps_hk_t, reserved2, 2),
+};
+
+static const eps_field_layout eps_hk_vi_fields[] = {
+    EPS_FIELD(eps_hk_vi_t, vboost, 2),
+    EPS_FIELD(eps_hk_vi_t, vbatt, 2),
+    EPS_FIELD(eps_hk_vi_t, curin, 2),
+    EPS_FIELD(eps_hk_vi_t, cursun, 2),
+    EPS_FIELD(eps_hk_vi_t, cursys, 2),
+    EPS_FIELD(eps_hk_vi_t, reserved1, 2),
+};
+
+static const eps_field_layout eps_hk_out_fields[] = {
+    EPS_FIELD(eps_hk_out_t, curout, 2),
+    EPS_FIELD(eps_hk_out_t, output_on_delta, 2),
+    EPS_FIELD(eps_hk_out_t, output_off_delta, 2),
+    EPS_FIELD(eps_hk_out_t, latchup, 2),
+};
+
+static const eps_field_layout eps_hk_wdt_fields[] = {
+    EPS_FIELD(eps_hk_wdt_t, wdt_i2c_time_left, 4),
+    EPS_FIELD(eps_hk_wdt_t, wdt_gnd_time_left, 4),
+    EPS_FIELD(eps_hk_wdt_t, counter_wdt_i2c, 4),
+    EPS_FIELD(eps_hk_wdt_t, counter_wdt_gnd, 4),
+    EPS_FIELD(eps_hk_wdt_t, counter_wdt_csp, 4),
+};
+
+static const eps_field_layout eps_hk_basic_fields[] = {
+    EPS_FIELD(eps_hk_basic_t, counter_boot, 4),
+    EPS_FIELD(eps_hk_basic_t, temp, 2),
+    EPS_FIELD(eps_hk_basic_t, reserved2, 2),
+};
+
+const eps_struct_layout eps_system_config_layout = EPS_LAYOUT(eps_system_config_t, eps_system_config_fields);
+const eps_struct_layout eps_battery_config_layout = EPS_LAYOUT(eps_battery_config_t, eps_battery_config_fields);
+const eps_struct_layout eps_hk_layout = EPS_LAYOUT(eps_hk_t, eps_hk_fields);
+const eps_struct_layout eps_hk_vi_layout = EPS_LAYOUT(eps_hk_vi_t, eps_hk_vi_fields);
+const eps_struct_layout eps_hk_out_layout = EPS_LAYOUT(eps_hk_out_t, eps_hk_out_fields);
+const eps_struct_layout eps_hk_wdt_layout = EPS_LAYOUT(eps_hk_wdt_t, eps_hk_wdt_fields);
+const eps_struct_layout eps_hk_basic_layout = EPS_LAYOUT(eps_hk_basic_t, eps_hk_basic_fields);
+
 KEPSStatus k_eps_init(KEPSConf config)
 {
     if (config.bus == NULL || config.addr == 0)
@@ -30,8 +128,11 @@ KEPSStatus k_eps_init(KEPSConf config)
         return EPS_ERROR_CONFIG;
     }
 
+    pthread_mutex_lock(&eps_mutex);
+
     if (eps_bus != 0)
     {
+        pthread_mutex_unlock(&eps_mutex);
         fprintf(stderr, "EPS already initialized. Ignoring request\n");
         return EPS_ERROR;
     }
@@ -40,6 +141,7 @@ KEPSStatus k_eps_init(KEPSConf config)
 
     KI2CStatus status;
     status = k_i2c_init(config.bus, &eps_bus);
+    pthread_mutex_unlock(&eps_mutex);
     if (status != I2C_OK)
     {
         fprintf(stderr, "Failed to initialize EPS: %d\n", status);
@@ -51,11 +153,15 @@ KEPSStatus k_eps_init(KEPSConf config)
 
 void k_eps_terminate()
 {
+    pthread_mutex_lock(&eps_mutex);
+
     k_i2c_terminate(&eps_bus);
 
     eps_bus = 0;
     eps_addr = 0;
 
+    pthread_mutex_unlock(&eps_mutex);
+
     return;
 }
 
@@ -65,14 +171,20 @@ KEPSStatus k_eps_ping()
     uint8_t    cmd  = PING;
     uint8_t    resp = 0;
 
+    pthread_mutex_lock(&eps_mutex);
+
     status = k_i2c_write(eps_bus, eps_addr, &cmd, 1);
     if (status != I2C_OK)
     {
+        pthread_mutex_unlock(&eps_mutex);
         fprintf(stderr, "Failed to send EPS ping: %d\n", status);
         return EPS_ERROR;
     }
 
     status = k_i2c_read(eps_bus, eps_addr, &resp, 1);
+
+    pthread_mutex_unlock(&eps_mutex);
+
     if (status != I2C_OK)
     {
         fprintf(stderr, "Failed to get EPS ping response: %d\n", status);
@@ -94,7 +206,9 @@ KEPSStatus k_eps_reset()
     KI2CStatus status;
     uint8_t    cmd = HARD_RESET;
 
+    pthread_mutex_lock(&eps_mutex);
     status = k_i2c_write(eps_bus, eps_addr, (uint8_t *) &cmd, 1);
+    pthread_mutex_unlock(&eps_mutex);
     if (status != I2C_OK)
     {
         fprintf(stderr, "Failed to reset EPS: %d\n", status);
@@ -109,7 +223,9 @@ KEPSStatus k_eps_reboot()
     KI2CStatus status;
     uint8_t    packet[] = { REBOOT, 0x80, 0x07, 0x80, 0x07 };
 
+    pthread_mutex_lock(&eps_mutex);
     status = k_i2c_write(eps_bus, eps_addr, packet, sizeof(packet));
+    pthread_mutex_unlock(&eps_mutex);
     if (status != I2C_OK)
     {
         fprintf(stderr, "Failed to reboot EPS: %d\n", status);
@@ -137,30 +253,7 @@ KEPSStatus k_eps_configure_system(const eps_system_config_t * config)
     }
 
     packet.cmd = SET_CONFIG1;
-
-    packet.sys_config.ppt_mode = config->ppt_mode;
-    packet.sys_config.battheater_mode = config->battheater_mode;
-    packet.sys_config.battheater_low = config->battheater_low;
-    packet.sys_config.battheater_high = config->battheater_high;
-    for (int i = 0; i < 8; i++)
-    {
-        packet.sys_config.output_normal_value[i] = config->output_normal_value[i];
-    }
-    for (int i = 0; i < 8; i++)
-    {
-        packet.sys_config.output_safe_value[i] = config->output_safe_value[i];
-    }
-    for (int i = 0; i < 8; i++)
-    {
-        packet.sys_config.output_initial_on_delay[i] = htobe16(config->output_initial_on_delay[i]);
-    }
-    for (int i = 0; i < 8; i++)
-    {
-        packet.sys_config.output_initial_off_delay[i] = htobe16(config->output_initial_off_delay[i]);
-    }
-    packet.sys_config.vboost[0] = htobe16(config->vboost[0]);
-    packet.sys_config.vboost[1] = htobe16(config->vboost[1]);
-    packet.sys_config.vboost[2] = htobe16(config->vboost[2]);
+    kprv_eps_convert(&packet.sys_config, config, &eps_system_config_layout);
 
     status = kprv_eps_transfer((uint8_t *) &packet, sizeof(packet), (uint8_t *) &response,
                                sizeof(response));
@@ -191,10 +284,11 @@ KEPSStatus k_eps_configure_battery(const eps_battery_config_t * config)
     }
 
     packet.cmd = SET_CONFIG2;
-    packet.batt_config.batt_maxvoltage = htobe16(config->batt_maxvoltage);
-    packet.batt_config.batt_safevoltage = htobe16(config->batt_safevoltage);
-    packet.batt_config.batt_criticalvoltage = htobe16(config->batt_criticalvoltage);
-    packet.batt_config.batt_normalvoltage = htobe16(config->batt_normalvoltage);
+    kprv_eps_convert(&packet.batt_config, config, &eps_battery_config_layout);
+
+    /* Reserved fields are always sent as zero */
+    memset(packet.batt_config.reserved1, 0, sizeof(packet.batt_config.reserved1));
+    memset(packet.batt_config.reserved2, 0, sizeof(packet.batt_config.reserved2));
 
     status = kprv_eps_transfer((uint8_t *) &packet, sizeof(packet), (uint8_t *) &response,
                                sizeof(response));
@@ -242,32 +336,33 @@ KEPSStatus k_eps_set_output(uint8_t channel_mask)
     return EPS_OK;
 }
 
+/*
+ * The channel ordering is secretly backwards.
+ * Output[0] is actually channel 7 (onboard heater)
+ * and output[7] is channel 0
+ */
+static void kprv_eps_single_output_packet(eps_single_output_packet * packet,
+                                          uint8_t channel, uint8_t value,
+                                          int16_t delay)
+{
+    packet->cmd = SET_SINGLE_OUTPUT;
+    packet->channel = 7 - channel;
+    packet->value = value;
+    packet->delay = htobe16(delay);
+}
+
 KEPSStatus k_eps_set_single_output(uint8_t channel, uint8_t value, int16_t delay)
 {
     KEPSStatus status;
     eps_resp_header response;
-    struct __attribute__((packed))
-    {
-        uint8_t cmd;
-        uint8_t channel;
-        uint8_t value;
-        int16_t delay;
-    }  packet;
+    eps_single_output_packet packet;
 
     if (channel > 7 || value > 1)
     {
         return EPS_ERROR_CONFIG;
     }
 
-    packet.cmd = SET_SINGLE_OUTPUT;
-    /*
-     * The channel ordering is secretly backwards.
-     * Output[0] is actually channel 7 (onboard heater)
-     * and output[7] is channel 0
-     */
-    packet.channel = 7 - channel;
-    packet.value = value;
-    packet.delay = htobe16(delay);
+    kprv_eps_single_output_packet(&packet, channel, value, delay);
 
     status = kprv_eps_transfer((uint8_t *) &packet, sizeof(packet), (uint8_t *) &response,
                                sizeof(response));
@@ -366,6 +461,109 @@ KEPSStatus k_eps_set_heater(uint8_t cmd, uint8_t heater, uint8_t mode)
     return EPS_OK;
 }
 
+static bool kprv_eps_batch_valid(const eps_batch_cmd * cmd)
+{
+    switch (cmd->type)
+    {
+        case EPS_BATCH_OUTPUT:
+            return cmd->channel <= 7 && cmd->value <= 1;
+        case EPS_BATCH_HEATER:
+            return cmd->channel <= 1 && cmd->value <= 1;
+        default:
+            return false;
+    }
+}
+
+KEPSStatus k_eps_set_batch(const eps_batch_cmd * cmds, int count, eps_hk_out_t * out)
+{
+    KEPSStatus status = EPS_OK;
+    eps_resp_header response;
+    eps_hk_out_t hk_out;
+    uint8_t hk_packet[] = { GET_HOUSEKEEPING, HK_OUT };
+    uint8_t hk_response[sizeof(eps_resp_header) + sizeof(eps_hk_out_t)];
+    int8_t expected[8];
+
+    if (cmds == NULL || count < 1)
+    {
+        return EPS_ERROR_CONFIG;
+    }
+
+    /* Reject the whole batch before anything is sent */
+    for (int i = 0; i < count; i++)
+    {
+        if (!kprv_eps_batch_valid(&cmds[i]))
+        {
+            fprintf(stderr, "Invalid EPS batch command %d\n", i);
+            return EPS_ERROR_CONFIG;
+        }
+    }
+
+    memset(expected, -1, sizeof(expected));
+
+    pthread_mutex_lock(&eps_mutex);
+
+    for (int i = 0; i < count && status == EPS_OK; i++)
+    {
+        const eps_batch_cmd * cmd = &cmds[i];
+
+        if (cmd->type == EPS_BATCH_OUTPUT)
+        {
+            eps_single_output_packet packet;
+            kprv_eps_single_output_packet(&packet, cmd->channel, cmd->value, cmd->delay);
+
+            status = kprv_eps_transfer_locked((uint8_t *) &packet, sizeof(packet),
+                                              (uint8_t *) &response, sizeof(response));
+
+            /* Delayed changes can't be verified yet */
+            expected[cmd->channel] = (cmd->delay == 0) ? cmd->value : -1;
+        }
+        else
+        {
+            uint8_t packet[] = { SET_HEATER, 0, cmd->channel, cmd->value };
+
+            status = kprv_eps_transfer_locked(packet, sizeof(packet),
+                                              (uint8_t *) &response, sizeof(response));
+        }
+
+        if (status != EPS_OK)
+        {
+            fprintf(stderr, "Failed to apply EPS batch command %d: %d\n", i, status);
+        }
+    }
+
+    if (status == EPS_OK)
+    {
+        status = kprv_eps_transfer_locked(hk_packet, sizeof(hk_packet), hk_response,
+                                          sizeof(hk_response));
+    }
+
+    pthread_mutex_unlock(&eps_mutex);
+
+    if (status != EPS_OK)
+    {
+        return status;
+    }
+
+    kprv_eps_convert(&hk_out, hk_response + sizeof(eps_resp_header), &eps_hk_out_layout);
+
+    if (out != NULL)
+    {
+        *out = hk_out;
+    }
+
+    for (int channel = 0; channel < 8; channel++)
+    {
+        if (expected[channel] >= 0 && hk_out.output[7 - channel] != expected[channel])
+        {
+            fprintf(stderr, "EPS output %d did not change to %d\n", channel,
+                    expected[channel]);
+            status = EPS_ERROR;
+        }
+    }
+
+    return status;
+}
+
 KEPSStatus k_eps_reset_system_config()
 {
     KEPSStatus      status;
@@ -417,10 +615,12 @@ KEPSStatus k_eps_reset_counters()
     return EPS_OK;
 }
 
-KEPSStatus k_eps_get_housekeeping(eps_hk_t * buff)
+/* Fetch one of the housekeeping structures. Only the requested type is transferred */
+static KEPSStatus kprv_eps_get_housekeeping(uint8_t type, void * buff,
+                                            const eps_struct_layout * layout)
 {
     KEPSStatus status;
-    uint8_t packet[] = { GET_HOUSEKEEPING, 0 }; 
+    uint8_t packet[] = { GET_HOUSEKEEPING, type };
     uint8_t response[sizeof(eps_resp_header) + sizeof(eps_hk_t)] = { 0 };
 
     if (buff == NULL)
@@ -429,65 +629,43 @@ KEPSStatus k_eps_get_housekeeping(eps_hk_t * buff)
     }
 
     status = kprv_eps_transfer(packet, sizeof(packet), response,
-                               sizeof(response));
+                               sizeof(eps_resp_header) + layout->size);
     if (status != EPS_OK)
     {
-        fprintf(stderr, "Failed to get EPS housekeeping data: %d\n", status);
+        fprintf(stderr, "Failed to get EPS housekeeping data (%d): %d\n", type, status);
         return status;
     }
 
-    eps_hk_t * body = (eps_hk_t *) (response + sizeof(eps_resp_header));
-
-    /* Convert big endian to host endianness for multi-byte fields */
-    buff->vboost[0] = be16toh(body->vboost[0]);
-    buff->vboost[1] = be16toh(body->vboost[1]);
-    buff->vboost[2] = be16toh(body->vboost[2]);
-    buff->vbatt = be16toh(body->vbatt);
-    buff->curin[0] = be16toh(body->curin[0]);
-    buff->curin[1] = be16toh(body->curin[1]);
-    buff->curin[2] = be16toh(body->curin[2]);
-    buff->cursun = be16toh(body->cursun);
-    buff->cursys = be16toh(body->cursys);
-    for (int i = 0; i < 6; i++)
-    {
-        buff->curout[i] = be16toh(body->curout[i]);
-    }
-    for (int i = 0; i < 8; i++)
-    {
-        buff->output[i] = body->output[i];
-    }
-    for (int i = 0; i < 8; i++)
-    {
-        buff->output_on_delta[i] = be16toh(body->output_on_delta[i]);
-    }
-    for (int i = 0; i < 8; i++)
-    {
-        buff->output_off_delta[i] = be16toh(body->output_off_delta[i]);
-    }
-    for (int i = 0; i < 6; i++)
-    {
-        buff->latchup[i] = be16toh(body->latchup[i]);
-    }
-    buff->wdt_i2c_time_left = be32toh(body->wdt_i2c_time_left);
-    buff->wdt_gnd_time_left = be32toh(body->wdt_gnd_time_left);
-    buff->wdt_csp_pings_left[0] = body->wdt_csp_pings_left[0];
-    buff->wdt_csp_pings_left[1] = body->wdt_csp_pings_left[1];
-    buff->counter_wdt_i2c = be32toh(body->counter_wdt_i2c);
-    buff->counter_wdt_gnd = be32toh(body->counter_wdt_gnd);
-    buff->counter_wdt_csp[0] = be32toh(body->counter_wdt_csp[0]);
-    buff->counter_wdt_csp[1] = be32toh(body->counter_wdt_csp[1]);
-    buff->counter_boot = be32toh(body->counter_boot);
-    for (int i = 0; i < 6; i++)
-    {
-        buff->temp[i] = be16toh(body->temp[i]);
-    }
-    buff->boot_cause = body->boot_cause;
-    buff->batt_mode = body->batt_mode;
-    buff->ppt_mode = body->ppt_mode;
+    kprv_eps_convert(buff, response + sizeof(eps_resp_header), layout);
 
     return EPS_OK;
 }
 
+KEPSStatus k_eps_get_housekeeping(eps_hk_t * buff)
+{
+    return kprv_eps_get_housekeeping(HK_FULL, buff, &eps_hk_layout);
+}
+
+KEPSStatus k_eps_get_housekeeping_vi(eps_hk_vi_t * buff)
+{
+    return kprv_eps_get_housekeeping(HK_VI, buff, &eps_hk_vi_layout);
+}
+
+KEPSStatus k_eps_get_housekeeping_out(eps_hk_out_t * buff)
+{
+    return kprv_eps_get_housekeeping(HK_OUT, buff, &eps_hk_out_layout);
+}
+
+KEPSStatus k_eps_get_housekeeping_wdt(eps_hk_wdt_t * buff)
+{
+    return kprv_eps_get_housekeeping(HK_WDT, buff, &eps_hk_wdt_layout);
+}
+
+KEPSStatus k_eps_get_housekeeping_basic(eps_hk_basic_t * buff)
+{
+    return kprv_eps_get_housekeeping(HK_BASIC, buff, &eps_hk_basic_layout);
+}
+
 KEPSStatus k_eps_get_system_config(eps_system_config_t * buff)
 {
     KEPSStatus status;
@@ -506,31 +684,7 @@ KEPSStatus k_eps_get_system_config(eps_system_config_t * buff)
         return status;
     }
 
-    eps_system_config_t * body = (eps_system_config_t *) (response + sizeof(eps_resp_header));
-
-    buff->ppt_mode = body->ppt_mode;
-    buff->battheater_mode = body->battheater_mode;
-    buff->battheater_low = body->battheater_low;
-    buff->battheater_high = body->battheater_high;
-    for (int i = 0; i < 8; i++)
-    {
-        buff->output_normal_value[i] = body->output_normal_value[i];
-    }
-    for (int i = 0; i < 8; i++)
-    {
-        buff->output_safe_value[i] = body->output_safe_value[i];
-    }
-    for (int i = 0; i < 8; i++)
-    {
-        buff->output_initial_on_delay[i] = be16toh(body->output_initial_on_delay[i]);
-    }
-    for (int i = 0; i < 8; i++)
-    {
-        buff->output_initial_off_delay[i] = be16toh(body->output_initial_off_delay[i]);
-    }
-    buff->vboost[0] = be16toh(body->vboost[0]);
-    buff->vboost[1] = be16toh(body->vboost[1]);
-    buff->vboost[2] = be16toh(body->vboost[2]);
+    kprv_eps_convert(buff, response + sizeof(eps_resp_header), &eps_system_config_layout);
 
     return EPS_OK;
 }
@@ -553,12 +707,7 @@ KEPSStatus k_eps_get_battery_config(eps_battery_config_t * buff)
         return status;
     }
 
-    eps_battery_config_t * body = (eps_battery_config_t *) (response + sizeof(eps_resp_header));
-
-    buff->batt_maxvoltage = be16toh(body->batt_maxvoltage);
-    buff->batt_safevoltage = be16toh(body->batt_safevoltage);
-    buff->batt_criticalvoltage = be16toh(body->batt_criticalvoltage);
-    buff->batt_normalvoltage = be16toh(body->batt_normalvoltage);
+    kprv_eps_convert(buff, response + sizeof(eps_resp_header), &eps_battery_config_layout);
 
     return EPS_OK;
 }
@@ -610,43 +759,76 @@ KEPSStatus k_eps_watchdog_kick()
     return EPS_OK;
 }
 
-pthread_t handle_watchdog = { 0 };
-uint32_t watchdog_interval = 0;
-
-void * kprv_eps_watchdog_thread(void * args)
+KEPSStatus k_eps_update_power_mode(eps_hk_t * hk, KPowerMode * mode)
 {
     KEPSStatus status;
+    KPowerMode reported;
+    eps_hk_t   buff;
+
+    if (hk == NULL)
+    {
+        hk = &buff;
+    }
 
-    while (1)
+    status = k_eps_get_housekeeping(hk);
+    if (status != EPS_OK)
     {
-        k_eps_watchdog_kick();
+        return status;
+    }
 
-        sleep(watchdog_interval);
+    /* Initial, normal and full are all treated as normal */
+    switch (hk->batt_mode)
+    {
+        case 1:
+            reported = POWER_MODE_CRITICAL;
+            break;
+        case 2:
+            reported = POWER_MODE_SAFE;
+            break;
+        default:
+            reported = POWER_MODE_NORMAL;
     }
 
-    return NULL;
+    if (k_power_update(reported, hk->vbatt, mode) != POWER_OK)
+    {
+        return EPS_ERROR;
+    }
+
+    return EPS_OK;
 }
 
+static int kprv_eps_watchdog_kick(void * arg)
+{
+    return k_eps_watchdog_kick();
+}
+
+/* Watchdog scheduler ID, or -1 if not started */
+static int eps_watchdog = -1;
+
 KEPSStatus k_eps_watchdog_start(uint32_t interval)
 {
-    if (interval == 0)
+    /* The scheduler works in milliseconds */
+    if (interval == 0 || interval > UINT32_MAX / 1000)
     {
         return EPS_ERROR_CONFIG;
     }
 
-    if (handle_watchdog != 0)
+    if (eps_watchdog >= 0)
     {
-        fprintf(stderr, "EPS watchdog thread already started\n");
+        fprintf(stderr, "EPS watchdog already started\n");
         return EPS_OK;
     }
 
-    watchdog_interval = interval;
-
-    if (pthread_create(&handle_watchdog, NULL, kprv_eps_watchdog_thread, NULL)
-        != 0)
+    /*
+     * No slack. Every kick wears the EEPROM, so the kicks aren't brought
+     * forward to share wakeups with the other watchdogs
+     */
+    if (k_watchdog_register("EPS", interval * 1000, 0, kprv_eps_watchdog_kick,
+                            NULL, &eps_watchdog)
+        != WATCHDOG_OK)
     {
-        perror("Failed to create EPS watchdog thread");
-        handle_watchdog = 0;
+        fprintf(stderr, "Failed to start EPS watchdog\n");
+        eps_watchdog = -1;
         return EPS_ERROR;
     }
 
@@ -655,29 +837,23 @@ KEPSStatus k_eps_watchdog_start(uint32_t interval)
 
 KEPSStatus k_eps_watchdog_stop()
 {
-    /* Check if watchdog thread has been started */
-    if (handle_watchdog == 0)
+    if (eps_watchdog < 0)
     {
-        perror("EPS watchdog thread has not been started\n");
+        fprintf(stderr, "EPS watchdog has not been started\n");
         return EPS_ERROR;
     }
 
-    /* Send the cancel request */
-    if (pthread_cancel(handle_watchdog) != 0)
-    {
-        perror("Failed to cancel EPS watchdog thread");
-        return EPS_ERROR;
-    }
-
-    /* Wait for the cancellation to complete */
-    if (pthread_join(handle_watchdog, NULL) != 0)
+    /*
+     * No more kicks will be made once this returns, and a kick in progress is
+     * always allowed to finish, so the bus is never left locked
+     */
+    if (k_watchdog_unregister(eps_watchdog) != WATCHDOG_OK)
     {
-        perror("Failed to rejoin EPS watchdog thread");
+        fprintf(stderr, "Failed to stop EPS watchdog\n");
         return EPS_ERROR;
     }
 
-    handle_watchdog = 0;
-    watchdog_interval = 0;
+    eps_watchdog = -1;
 
     return EPS_OK;
 }
@@ -703,6 +879,18 @@ KEPSStatus k_eps_passthrough(const uint8_t * tx, int tx_len, uint8_t * rx,
 
 KEPSStatus kprv_eps_transfer(const uint8_t * tx, int tx_len, uint8_t * rx,
                              int rx_len)
+{
+    KEPSStatus status;
+
+    pthread_mutex_lock(&eps_mutex);
+    status = kprv_eps_transfer_locked(tx, tx_len, rx, rx_len);
+    pthread_mutex_unlock(&eps_mutex);
+
+    return status;
+}
+
+KEPSStatus kprv_eps_transfer_locked(const uint8_t * tx, int tx_len, uint8_t * rx,
+                                    int rx_len)
 {
     KI2CStatus status;
 
@@ -748,3 +936,48 @@ KEPSStatus kprv_eps_transfer(const uint8_t * tx, int tx_len, uint8_t * rx,
 
     return EPS_OK;
 }
+
+void kprv_eps_convert(void * dst, const void * src,
+                      const eps_struct_layout * layout)
+{
+    if (dst != src)
+    {
+        memcpy(dst, src, layout->size);
+    }
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    uint8_t * data = (uint8_t *) dst;
+
+    for (int i = 0; i < layout->num_fields; i++)
+    {
+        const eps_field_layout * field = &layout->fields[i];
+        uint8_t * elem = data + field->offset;
+
+        /*
+         * The structures are packed, so go through memcpy rather than
+         * dereferencing possibly-unaligned pointers. Each run is a simple
+         * loop over same-sized elements, which the compiler can vectorize
+         */
+        if (field->width == 2)
+        {
+            for (int j = 0; j < field->count; j++, elem += 2)
+            {
+                uint16_t value;
+                memcpy(&value, elem, 2);
+                value = __builtin_bswap16(value);
+                memcpy(elem, &value, 2);
+            }
+        }
+        else
+        {
+            for (int j = 0; j < field->count; j++, elem += 4)
+            {
+                uint32_t value;
+                memcpy(&value, elem, 4);
+                value = __builtin_bswap32(value);
+                memcpy(elem, &value, 4);
+            }
+        }
+    }
+#endif
+}
@@ -407,6 +407,88 @@ static void test_set_heater(void ** arg)
     assert_int_equal(ret, EPS_OK);
 }
 
+static void test_set_batch(void ** arg)
+{
+    KEPSStatus ret;
+    eps_hk_out_t out = { 0 };
+
+    eps_batch_cmd cmds[] = {
+        { .type = EPS_BATCH_OUTPUT, .channel = 2, .value = 1, .delay = 0 },
+        { .type = EPS_BATCH_HEATER, .channel = 1, .value = 1 },
+        { .type = EPS_BATCH_OUTPUT, .channel = 3, .value = 0, .delay = 5 },
+    };
+
+    uint8_t output_on[] = { SET_SINGLE_OUTPUT, 5, 1, 0, 0 };
+    uint8_t output_off[] = { SET_SINGLE_OUTPUT, 4, 0, 0, 5 };
+    uint8_t test_response[sizeof(eps_resp_header) + sizeof(eps_hk_out_t)] = { 0 };
+
+    /* Output 3's change is delayed, so only output 2 should be checked */
+    eps_hk_out_t * hk_out = (eps_hk_out_t *) (test_response + sizeof(eps_resp_header));
+    hk_out->output[5] = 1;
+    hk_out->output[4] = 1;
+
+    expect_value(__wrap_write, cmd, SET_SINGLE_OUTPUT);
+    expect_memory(__wrap_write, buf, output_on, sizeof(output_on));
+    expect_value(__wrap_read, len, sizeof(eps_resp_header));
+    will_return(__wrap_read, &response);
+
+    expect_value(__wrap_write, cmd, SET_HEATER);
+    expect_value(__wrap_read, len, sizeof(eps_resp_header));
+    will_return(__wrap_read, &response);
+
+    expect_value(__wrap_write, cmd, SET_SINGLE_OUTPUT);
+    expect_memory(__wrap_write, buf, output_off, sizeof(output_off));
+    expect_value(__wrap_read, len, sizeof(eps_resp_header));
+    will_return(__wrap_read, &response);
+
+    expect_value(__wrap_write, cmd, GET_HOUSEKEEPING);
+    expect_value(__wrap_read, len, sizeof(test_response));
+    will_return(__wrap_read, test_response);
+
+    ret = k_eps_set_batch(cmds, 3, &out);
+
+    assert_int_equal(ret, EPS_OK);
+    assert_int_equal(out.output[5], 1);
+}
+
+static void test_set_batch_not_applied(void ** arg)
+{
+    KEPSStatus ret;
+
+    eps_batch_cmd cmds[] = {
+        { .type = EPS_BATCH_OUTPUT, .channel = 0, .value = 1, .delay = 0 },
+    };
+
+    uint8_t output_on[] = { SET_SINGLE_OUTPUT, 7, 1, 0, 0 };
+    uint8_t test_response[sizeof(eps_resp_header) + sizeof(eps_hk_out_t)] = { 0 };
+
+    expect_value(__wrap_write, cmd, SET_SINGLE_OUTPUT);
+    expect_memory(__wrap_write, buf, output_on, sizeof(output_on));
+    expect_value(__wrap_read, len, sizeof(eps_resp_header));
+    will_return(__wrap_read, &response);
+
+    expect_value(__wrap_write, cmd, GET_HOUSEKEEPING);
+    expect_value(__wrap_read, len, sizeof(test_response));
+    will_return(__wrap_read, test_response);
+
+    ret = k_eps_set_batch(cmds, 1, NULL);
+
+    assert_int_equal(ret, EPS_ERROR);
+}
+
+static void test_set_batch_bad_cmd(void ** arg)
+{
+    eps_batch_cmd cmds[] = {
+        { .type = EPS_BATCH_OUTPUT, .channel = 2, .value = 1, .delay = 0 },
+        { .type = EPS_BATCH_HEATER, .channel = 2, .value = 1 },
+    };
+
+    /* Nothing should be sent if any command is invalid */
+    assert_int_equal(k_eps_set_batch(cmds, 2, NULL), EPS_ERROR_CONFIG);
+    assert_int_equal(k_eps_set_batch(NULL, 2, NULL), EPS_ERROR_CONFIG);
+    assert_int_equal(k_eps_set_batch(cmds, 0, NULL), EPS_ERROR_CONFIG);
+}
+
 static void test_reset_counters(void ** arg)
 {
     KEPSStatus ret;
@@ -444,6 +526,56 @@ static void test_get_housekeeping(void ** arg)
     assert_memory_equal(&hk, &hk_le, sizeof(eps_hk_t));
 }
 
+static void test_get_housekeeping_vi(void ** arg)
+{
+    KEPSStatus ret;
+
+    eps_hk_vi_t vi = { 0 };
+    uint8_t test_response[sizeof(eps_hk_vi_t) + sizeof(eps_resp_header)] = { 0 };
+
+    /* The voltage/current subset is the start of the full structure */
+    memcpy(test_response + sizeof(eps_resp_header), &hk_be, sizeof(eps_hk_vi_t));
+
+    expect_value(__wrap_write, cmd, GET_HOUSEKEEPING);
+    expect_value(__wrap_read, len, sizeof(test_response));
+    will_return(__wrap_read, test_response);
+
+    ret = k_eps_get_housekeeping_vi(&vi);
+
+    assert_int_equal(ret, EPS_OK);
+    assert_memory_equal(&vi, &hk_le, sizeof(eps_hk_vi_t));
+}
+
+static void test_get_housekeeping_basic(void ** arg)
+{
+    KEPSStatus ret;
+
+    eps_hk_basic_t basic = { 0 };
+    uint8_t test_response[sizeof(eps_hk_basic_t) + sizeof(eps_resp_header)] = { 0 };
+
+    /* The basic subset is the end of the full structure */
+    size_t offset = offsetof(eps_hk_t, counter_boot);
+    memcpy(test_response + sizeof(eps_resp_header), (uint8_t *) &hk_be + offset,
+           sizeof(eps_hk_basic_t));
+
+    expect_value(__wrap_write, cmd, GET_HOUSEKEEPING);
+    expect_value(__wrap_read, len, sizeof(test_response));
+    will_return(__wrap_read, test_response);
+
+    ret = k_eps_get_housekeeping_basic(&basic);
+
+    assert_int_equal(ret, EPS_OK);
+    assert_memory_equal(&basic, (uint8_t *) &hk_le + offset, sizeof(eps_hk_basic_t));
+}
+
+static void test_get_housekeeping_subset_null(void ** arg)
+{
+    assert_int_equal(k_eps_get_housekeeping_vi(NULL), EPS_ERROR_CONFIG);
+    assert_int_equal(k_eps_get_housekeeping_out(NULL), EPS_ERROR_CONFIG);
+    assert_int_equal(k_eps_get_housekeeping_wdt(NULL), EPS_ERROR_CONFIG);
+    assert_int_equal(k_eps_get_housekeeping_basic(NULL), EPS_ERROR_CONFIG);
+}
+
 static void test_get_system_config_null(void ** arg)
 {
     assert_int_equal(k_eps_get_system_config(NULL), EPS_ERROR_CONFIG);
@@ -492,6 +624,18 @@ static void test_get_battery_config(void ** arg)
     assert_memory_equal(&config, &batt_config_le, sizeof(eps_battery_config_t));
 }
 
+static void test_convert(void ** arg)
+{
+    eps_hk_t hk = { 0 };
+
+    kprv_eps_convert(&hk, &hk_be, &eps_hk_layout);
+    assert_memory_equal(&hk, &hk_le, sizeof(eps_hk_t));
+
+    /* Converting in place should take us back to the original */
+    kprv_eps_convert(&hk, &hk, &eps_hk_layout);
+    assert_memory_equal(&hk, &hk_be, sizeof(eps_hk_t));
+}
+
 static void test_get_heater_null_null(void ** arg)
 {
     assert_int_equal(k_eps_get_heater(NULL, NULL), EPS_ERROR_CONFIG);
@@ -547,6 +691,257 @@ static void test_get_heater(void ** arg)
     assert_int_not_equal(onboard, 0);
 }
 
+/* Housekeeping History Tests */
+
+#define HISTORY_START 1000
+
+/* Generate a sample which exercises signed fields and counter roll-over */
+static void history_sample(uint32_t n, eps_hk_t * hk)
+{
+    *hk = hk_le;
+    hk->vbatt = 7200 + (n % 7) * 3;
+    hk->curin[1] = n * 5;
+    hk->temp[2] = (int16_t) (5 - (int) (n % 11));
+    hk->counter_wdt_gnd = UINT32_MAX - 20 + n;
+    hk->output[3] = (n / 50) % 2;
+}
+
+typedef struct
+{
+    uint32_t count;
+    uint32_t first;
+    uint32_t last;
+    uint32_t errors;
+} history_check;
+
+/* Samples are recorded every two seconds */
+static void history_cb(uint32_t timestamp, const eps_hk_t * hk, void * arg)
+{
+    history_check * check = arg;
+    eps_hk_t        expected;
+
+    history_sample((timestamp - HISTORY_START) / 2, &expected);
+    if (memcmp(hk, &expected, sizeof(expected)) != 0
+        || (check->count > 0 && timestamp != check->last + 2))
+    {
+        check->errors++;
+    }
+
+    if (check->count++ == 0)
+    {
+        check->first = timestamp;
+    }
+    check->last = timestamp;
+}
+
+static void history_fill(eps_history * history, uint32_t samples)
+{
+    eps_hk_t hk;
+
+    for (uint32_t n = 0; n < samples; n++)
+    {
+        history_sample(n, &hk);
+        assert_int_equal(k_eps_history_record(history, HISTORY_START + n * 2, &hk),
+                         EPS_OK);
+    }
+}
+
+static void test_history_init_bad(void ** arg)
+{
+    eps_history history;
+    uint8_t     buffer[1024];
+
+    assert_int_equal(k_eps_history_init(NULL, buffer, sizeof(buffer), 512),
+                     EPS_ERROR_CONFIG);
+    assert_int_equal(k_eps_history_init(&history, buffer, sizeof(buffer),
+                                        EPS_HISTORY_MIN_BLOCK - 1),
+                     EPS_ERROR_CONFIG);
+    /* Too small for two blocks */
+    assert_int_equal(k_eps_history_init(&history, buffer, sizeof(buffer), 600),
+                     EPS_ERROR_CONFIG);
+}
+
+static void test_history_read(void ** arg)
+{
+    eps_history      history;
+    eps_history_info info;
+    history_check    check = { 0 };
+    uint8_t          buffer[32 * 512];
+
+    assert_int_equal(k_eps_history_init(&history, buffer, sizeof(buffer), 512),
+                     EPS_OK);
+
+    history_fill(&history, 300);
+
+    assert_int_equal(k_eps_history_get_info(&history, &info), EPS_OK);
+    assert_int_equal(info.samples, 300);
+    assert_int_equal(info.oldest, HISTORY_START);
+    assert_int_equal(info.newest, HISTORY_START + 299 * 2);
+    /* Only a handful of fields change between samples */
+    assert_true(info.bytes * 4 < 300 * sizeof(eps_hk_t));
+
+    assert_int_equal(k_eps_history_read(&history, 0, UINT32_MAX, history_cb, &check),
+                     EPS_OK);
+    assert_int_equal(check.count, 300);
+    assert_int_equal(check.errors, 0);
+
+    /* Part-way through a block, with an end which falls between samples */
+    memset(&check, 0, sizeof(check));
+    assert_int_equal(k_eps_history_read(&history, HISTORY_START + 101 * 2,
+                                        HISTORY_START + 250 * 2 + 1, history_cb,
+                                        &check),
+                     EPS_OK);
+    assert_int_equal(check.count, 150);
+    assert_int_equal(check.first, HISTORY_START + 101 * 2);
+    assert_int_equal(check.last, HISTORY_START + 250 * 2);
+    assert_int_equal(check.errors, 0);
+
+    k_eps_history_terminate(&history);
+}
+
+static void test_history_wrap(void ** arg)
+{
+    eps_history      history;
+    eps_history_info info;
+    history_check    check = { 0 };
+    uint8_t          buffer[3 * 256];
+
+    assert_int_equal(k_eps_history_init(&history, buffer, sizeof(buffer), 256),
+                     EPS_OK);
+
+    history_fill(&history, 1000);
+
+    /* The oldest samples have been discarded, but the rest are intact */
+    assert_int_equal(k_eps_history_get_info(&history, &info), EPS_OK);
+    assert_true(info.samples < 1000);
+    assert_int_equal(info.newest, HISTORY_START + 999 * 2);
+    assert_int_equal(info.oldest, HISTORY_START + (1000 - info.samples) * 2);
+
+    assert_int_equal(k_eps_history_read(&history, 0, UINT32_MAX, history_cb, &check),
+                     EPS_OK);
+    assert_int_equal(check.count, info.samples);
+    assert_int_equal(check.first, info.oldest);
+    assert_int_equal(check.errors, 0);
+
+    k_eps_history_terminate(&history);
+}
+
+static void test_history_extract(void ** arg)
+{
+    eps_history   history;
+    history_check check = { 0 };
+    uint8_t       buffer[32 * 512];
+    uint8_t       output[32 * 512];
+    size_t        len;
+    size_t        required;
+
+    assert_int_equal(k_eps_history_init(&history, buffer, sizeof(buffer), 512),
+                     EPS_OK);
+
+    history_fill(&history, 300);
+
+    uint32_t start = HISTORY_START + 120 * 2;
+    uint32_t end   = HISTORY_START + 130 * 2;
+
+    assert_int_equal(k_eps_history_extract(&history, start, end, output, 1, &required),
+                     EPS_ERROR_CONFIG);
+    assert_int_equal(k_eps_history_extract(&history, start, end, output,
+                                           sizeof(output), &len),
+                     EPS_OK);
+    assert_int_equal(len, required);
+    assert_true(len < sizeof(buffer));
+
+    assert_int_equal(k_eps_history_decode(output, len, start, end, history_cb, &check),
+                     EPS_OK);
+    assert_int_equal(check.count, 11);
+    assert_int_equal(check.first, start);
+    assert_int_equal(check.errors, 0);
+
+    /* Truncated data */
+    assert_int_equal(k_eps_history_decode(output, len - 1, 0, UINT32_MAX,
+                                          history_cb, &check),
+                     EPS_ERROR);
+
+    k_eps_history_terminate(&history);
+}
+
+static void test_history_old_sample(void ** arg)
+{
+    eps_history history;
+    uint8_t     buffer[2 * 512];
+
+    assert_int_equal(k_eps_history_init(&history, buffer, sizeof(buffer), 512),
+                     EPS_OK);
+
+    assert_int_equal(k_eps_history_record(&history, 10, &hk_le), EPS_OK);
+    assert_int_equal(k_eps_history_record(&history, 10, &hk_le), EPS_OK);
+    assert_int_equal(k_eps_history_record(&history, 9, &hk_le), EPS_ERROR_CONFIG);
+
+    k_eps_history_terminate(&history);
+}
+
+static void history_copy_cb(uint32_t timestamp, const eps_hk_t * hk, void * arg)
+{
+    memcpy(arg, hk, sizeof(*hk));
+}
+
+static void test_history_update(void ** arg)
+{
+    eps_history history;
+    eps_hk_t    hk   = { 0 };
+    eps_hk_t    read = { 0 };
+    uint8_t     buffer[2 * 512];
+    uint8_t     test_response[sizeof(eps_hk_t) + sizeof(eps_resp_header)] = { 0 };
+
+    assert_int_equal(k_eps_history_init(&history, buffer, sizeof(buffer), 512),
+                     EPS_OK);
+
+    memcpy(test_response + sizeof(eps_resp_header), &hk_be, sizeof(eps_hk_t));
+
+    expect_value(__wrap_write, cmd, GET_HOUSEKEEPING);
+    expect_value(__wrap_read, len, sizeof(test_response));
+    will_return(__wrap_read, test_response);
+
+    assert_int_equal(k_eps_history_update(&history, 5, &hk), EPS_OK);
+    assert_memory_equal(&hk, &hk_le, sizeof(eps_hk_t));
+
+    assert_int_equal(k_eps_history_read(&history, 5, 5, history_copy_cb, &read),
+                     EPS_OK);
+    assert_memory_equal(&read, &hk_le, sizeof(eps_hk_t));
+
+    k_eps_history_terminate(&history);
+}
+
+static void test_update_power_mode(void ** arg)
+{
+    KPowerMode mode;
+    eps_hk_t   hk = { 0 };
+    uint8_t    test_response[sizeof(eps_hk_t) + sizeof(eps_resp_header)] = { 0 };
+
+    memcpy(test_response + sizeof(eps_resp_header), &hk_be, sizeof(eps_hk_t));
+
+    /* Battery mode 2 is safe mode */
+    test_response[sizeof(eps_resp_header) + offsetof(eps_hk_t, batt_mode)] = 2;
+
+    expect_value(__wrap_write, cmd, GET_HOUSEKEEPING);
+    expect_value(__wrap_read, len, sizeof(test_response));
+    will_return(__wrap_read, test_response);
+
+    assert_int_equal(k_eps_update_power_mode(&hk, &mode), EPS_OK);
+    assert_int_equal(mode, POWER_MODE_SAFE);
+    assert_int_equal(k_power_get_mode(), POWER_MODE_SAFE);
+    assert_int_equal(hk.batt_mode, 2);
+
+    test_response[sizeof(eps_resp_header) + offsetof(eps_hk_t, batt_mode)] = 3;
+
+    expect_value(__wrap_write, cmd, GET_HOUSEKEEPING);
+    expect_value(__wrap_read, len, sizeof(test_response));
+    will_return(__wrap_read, test_response);
+
+    assert_int_equal(k_eps_update_power_mode(NULL, &mode), EPS_OK);
+    assert_int_equal(mode, POWER_MODE_NORMAL);
+}
+
 static void test_watchdog_kick(void ** arg)
 {
     KEPSStatus ret;
@@ -825,17 +1220,31 @@ int main(void)
         cmocka_unit_test_setup_teardown(test_set_heater_bad_heater, init, term),
         cmocka_unit_test_setup_teardown(test_set_heater_bad_mode, init, term),
         cmocka_unit_test_setup_teardown(test_set_heater, init, term),
+        cmocka_unit_test_setup_teardown(test_set_batch, init, term),
+        cmocka_unit_test_setup_teardown(test_set_batch_not_applied, init, term),
+        cmocka_unit_test_setup_teardown(test_set_batch_bad_cmd, init, term),
         cmocka_unit_test_setup_teardown(test_reset_counters, init, term),
         cmocka_unit_test_setup_teardown(test_get_housekeeping_null, init, term),
         cmocka_unit_test_setup_teardown(test_get_housekeeping, init, term),
+        cmocka_unit_test_setup_teardown(test_get_housekeeping_vi, init, term),
+        cmocka_unit_test_setup_teardown(test_get_housekeeping_basic, init, term),
+        cmocka_unit_test_setup_teardown(test_get_housekeeping_subset_null, init, term),
         cmocka_unit_test_setup_teardown(test_get_system_config_null, init, term),
         cmocka_unit_test_setup_teardown(test_get_system_config, init, term),
         cmocka_unit_test_setup_teardown(test_get_battery_config_null, init, term),
         cmocka_unit_test_setup_teardown(test_get_battery_config, init, term),
+        cmocka_unit_test(test_convert),
         cmocka_unit_test_setup_teardown(test_get_heater_null_null, init, term),
         cmocka_unit_test_setup_teardown(test_get_heater_null_bp4_good_onboard, init, term),
         cmocka_unit_test_setup_teardown(test_get_heater_good_bp4_null_onboard, init, term),
         cmocka_unit_test_setup_teardown(test_get_heater, init, term),
+        cmocka_unit_test(test_history_init_bad),
+        cmocka_unit_test(test_history_read),
+        cmocka_unit_test(test_history_wrap),
+        cmocka_unit_test(test_history_extract),
+        cmocka_unit_test(test_history_old_sample),
+        cmocka_unit_test_setup_teardown(test_history_update, init, term),
+        cmocka_unit_test_setup_teardown(test_update_power_mode, init, term),
         cmocka_unit_test_setup_teardown(test_watchdog_kick, init, term),
         cmocka_unit_test_setup_teardown(test_watchdog_thread, init, term),
         cmocka_unit_test_setup_teardown(test_watchdog_thread_twice, init, term),
@@ -88,7 +88,8 @@ typedef enum {
     ANTS_OK,                     /**< Requested function completed successfully */
     ANTS_ERROR,                  /**< Generic error */
     ANTS_ERROR_CONFIG,           /**< Configuration error */
-    ANTS_ERROR_NOT_IMPLEMENTED   /**< Requested function has not been implemented for the subsystem */
+    ANTS_ERROR_NOT_IMPLEMENTED,  /**< Requested function has not been implemented for the subsystem */
+    ANTS_ERROR_NOT_ARMED         /**< The controller now commanding hasn't been armed, ex. after a failover */
 } KANTSStatus;
 
 /**
@@ -119,6 +120,98 @@ typedef struct
     uint32_t uptime;        /**< System uptime (in seconds) */
 } __attribute__((packed)) ants_telemetry;
 
+/**
+ * Controller health, returned from ::k_ants_get_health
+ */
+typedef struct
+{
+    bool     alive;         /**< Controller has not reached the failover threshold since it last answered */
+    uint32_t uptime;        /**< Uptime from the most recent successful probe [seconds] */
+    ants_telemetry telem;   /**< Telemetry from the most recent successful probe */
+    uint32_t probes;        /**< Number of health probes made */
+    uint32_t failures;      /**< Total number of failed probes and commands */
+    uint8_t  consecutive;   /**< Current number of consecutive failures */
+    uint32_t resets;        /**< Number of times the controller's uptime has gone backwards */
+    uint32_t failovers;     /**< Number of times commanding has been switched away from this controller */
+} ants_health;
+
+/**
+ * Health probe and failover configuration, used by ::k_ants_health_start
+ */
+typedef struct
+{
+    uint32_t interval;      /**< Time between health probes [milliseconds]. 0 to only enable failover */
+    uint8_t  max_failures;  /**< Consecutive failures before a controller is considered dead. 0 to disable failover */
+} ants_health_config;
+
+/**
+ * Maximum number of antennas supported by the AntS
+ */
+#define ANTS_MAX_ANTENNAS 4
+
+/**
+ * Complete system status returned from ::k_ants_get_snapshot
+ */
+typedef struct
+{
+    ants_telemetry telem;                           /**< System telemetry, including the uptime and deployment status */
+    uint8_t  activation_count[ANTS_MAX_ANTENNAS];   /**< Number of times each antenna's deployment has been attempted */
+    uint16_t activation_time[ANTS_MAX_ANTENNAS];    /**< Time spent deploying each antenna, in 50ms steps */
+    uint8_t  transfers;                             /**< Number of I2C transactions made */
+    uint32_t duration;                              /**< Total time taken [microseconds] */
+    uint32_t wait;                                  /**< Time spent waiting between transactions [microseconds] */
+} ants_snapshot;
+
+/**
+ * Antenna deployment states, decoded from the deployment status flags
+ */
+typedef enum {
+    ANTS_DEPLOY_STOWED,     /**< Antenna is not deployed and no deployment is in progress */
+    ANTS_DEPLOY_ACTIVE,     /**< Antenna deployment system is active */
+    ANTS_DEPLOY_DEPLOYED,   /**< Antenna is deployed */
+    ANTS_DEPLOY_TIMED_OUT   /**< Deployment time limit was reached without the antenna deploying */
+} KANTSDeployState;
+
+/**
+ * Deployment monitor configuration, used by ::k_ants_monitor_start
+ */
+typedef struct
+{
+    uint8_t  antennas;      /**< Antennas to monitor. Bit 0 for antenna 1, bit 1 for antenna 2, etc */
+    uint32_t timeout;       /**< Time to give up monitoring after [milliseconds] */
+    uint32_t min_interval;  /**< Polling interval while a deployment is active [milliseconds] */
+    uint32_t max_interval;  /**< Longest polling interval used while nothing is changing [milliseconds] */
+} ants_monitor_config;
+
+/**
+ * Deployment monitor timestamp used for events which haven't happened
+ */
+#define ANTS_MONITOR_NEVER UINT32_MAX
+
+/**
+ * Deployment monitor results, returned by ::k_ants_monitor_get_report
+ */
+typedef struct
+{
+    KANTSDeployState state[ANTS_MAX_ANTENNAS];  /**< Latest state of each antenna */
+    uint32_t active_at[ANTS_MAX_ANTENNAS];      /**< Time each antenna's deployment was first seen active, or ::ANTS_MONITOR_NEVER [milliseconds since start] */
+    uint32_t finished_at[ANTS_MAX_ANTENNAS];    /**< Time each antenna was first seen deployed or timed out, or ::ANTS_MONITOR_NEVER [milliseconds since start] */
+    uint16_t deploy_status;                     /**< Latest raw deployment status flags */
+    uint32_t polls;                             /**< Number of times the deployment status has been fetched */
+    uint32_t errors;                            /**< Number of failed fetches */
+    uint32_t elapsed;                           /**< Time spent monitoring [milliseconds] */
+    bool     running;                           /**< The monitor is still polling */
+    bool     complete;                          /**< Every monitored antenna is deployed or has timed out */
+} ants_monitor_report;
+
+/**
+ * Function called by the deployment monitor when an antenna changes state
+ * @param [in] antenna Antenna which changed state
+ * @param [in] state New state
+ * @param [in] arg Argument given to ::k_ants_monitor_start
+ */
+typedef void (*ants_monitor_cb)(KANTSAnt antenna, KANTSDeployState state, void * arg);
+
 /*
  * Public Functions
  */
@@ -142,6 +235,48 @@ void k_ants_terminate(void);
  * @return KANTSStatus ANTS_OK if OK, error otherwise
  */
 KANTSStatus k_ants_configure(KANTSController config);
+/**
+ * Get the microcontroller currently used for commanding
+ *
+ * This may differ from the one given to ::k_ants_configure if automatic
+ * failover has switched controllers
+ * @return KANTSController Active microcontroller
+ */
+KANTSController k_ants_get_controller(void);
+/**
+ * Start probing the health of both microcontrollers and enable automatic failover
+ *
+ * Each probe fetches the uptime and telemetry of both controllers. Probes are
+ * made by the shared watchdog scheduler (see ::k_watchdog_register), starting
+ * with one from the caller's thread before this function returns.
+ * The probe is registered as a power policy poller (see ::k_power_register_poll),
+ * so in the low-power modes probes are only made once the mode's interval has passed.
+ *
+ * Commands and probes which fail count against the controller they were sent to.
+ * Once the active controller reaches `max_failures` consecutive failures, and
+ * the other controller is still alive, all commanding is switched to the other
+ * controller and the failed command is retried there once. Commanding is not
+ * switched back automatically when the original controller recovers.
+ *
+ * Each controller has its own arm state, so arm and deploy commands are never
+ * retried. Once commanding has moved away from an armed controller, they fail
+ * with `ANTS_ERROR_NOT_ARMED` until ::k_ants_arm is called again.
+ * @param [in] config Pointer to the probe configuration
+ * @return KANTSStatus `ANTS_OK` if OK, error otherwise
+ */
+KANTSStatus k_ants_health_start(const ants_health_config * config);
+/**
+ * Stop probing controller health and disable automatic failover
+ * @return KANTSStatus `ANTS_OK` if OK, error otherwise
+ */
+KANTSStatus k_ants_health_stop(void);
+/**
+ * Get a microcontroller's health
+ * @param [in] controller Microcontroller to query
+ * @param [out] health Pointer to ::ants_health structure
+ * @return KANTSStatus `ANTS_OK` if OK, error otherwise
+ */
+KANTSStatus k_ants_get_health(KANTSController controller, ants_health * health);
 /**
  * Reset both of the antenna's microcontrollers
  * @return KANTSStatus ANTS_OK if OK, error otherwise
@@ -149,7 +284,10 @@ KANTSStatus k_ants_configure(KANTSController config);
 KANTSStatus k_ants_reset(void);
 /**
  * Arm the antenna
- * @return KANTSStatus ANTS_OK if OK, error otherwise
+ *
+ * Only the controller currently used for commanding is armed
+ * @return KANTSStatus ANTS_OK if OK, `ANTS_ERROR_NOT_ARMED` if commanding
+ * failed over as a result, error otherwise
  */
 KANTSStatus k_ants_arm(void);
 /**
@@ -164,14 +302,16 @@ KANTSStatus k_ants_disarm(void);
  * 			   			successful deployment
  * @param [in] timeout 	Maximum time, in seconds, system should spend deploying
  * 						the antenna
- * @return KANTSStatus ANTS_OK if OK, error otherwise
+ * @return KANTSStatus ANTS_OK if OK, `ANTS_ERROR_NOT_ARMED` if the controller
+ * now commanding must be armed with ::k_ants_arm first, error otherwise
  */
 KANTSStatus k_ants_deploy(KANTSAnt antenna, bool override, uint8_t timeout);
 /**
  * Automatically deploy each antenna in sequence
  * @param [in] timeout  Maximum time, in seconds, system should spend deploying
  * 						a single antenna
- * @return KANTSStatus ANTS_OK if OK, error otherwise
+ * @return KANTSStatus ANTS_OK if OK, `ANTS_ERROR_NOT_ARMED` if the controller
+ * now commanding must be armed with ::k_ants_arm first, error otherwise
  */
 KANTSStatus k_ants_auto_deploy(uint8_t timeout);
 /**
@@ -211,19 +351,82 @@ KANTSStatus k_ants_get_activation_count(KANTSAnt antenna, uint8_t * count);
  * @return KANTSStatus `ANTS_OK` if OK, error otherwise
  */
 KANTSStatus k_ants_get_activation_time(KANTSAnt antenna, uint16_t * time);
+/**
+ * Get the complete system status in one call
+ *
+ * The system telemetry (which includes the uptime and deployment status) and
+ * each antenna's activation count and time are fetched back-to-back. Rather than
+ * sleeping for a fixed time after every transaction, each transaction only waits
+ * for whatever remains of the minimum gap since the previous one.
+ * Fields for antennas beyond the configured antenna count are set to zero.
+ * @param [out] snapshot Pointer to ::ants_snapshot structure
+ * @return KANTSStatus `ANTS_OK` if OK, error otherwise
+ */
+KANTSStatus k_ants_get_snapshot(ants_snapshot * snapshot);
+/**
+ * Decode an antenna's deployment state from the deployment status flags
+ * @param [in] status Deployment status flags, from ::k_ants_get_deploy_status
+ * @param [in] antenna Antenna to decode
+ * @return KANTSDeployState Antenna's deployment state
+ */
+KANTSDeployState k_ants_decode_deploy_state(uint16_t status, KANTSAnt antenna);
+/**
+ * Start a background thread which monitors antenna deployment
+ *
+ * The deployment status is polled every `min_interval` while any monitored
+ * antenna's deployment is active or has just changed state, backing off towards
+ * `max_interval` otherwise. The monitor is registered as a power policy poller
+ * (see ::k_power_register_poll), and both intervals are stretched by the
+ * current power mode's scale. Monitoring ends once every monitored antenna is
+ * deployed or has timed out, or after `timeout`.
+ *
+ * Each state change, including each antenna's initial state, is reported by
+ * calling `callback` (from the monitor's thread)
+ * and by adding one to an eventfd counter. The counter is also incremented once
+ * when monitoring ends, so the file descriptor can be used with `poll` or `select`
+ * instead of, or as well as, ::k_ants_monitor_wait.
+ * @param [in] config Pointer to the monitor configuration
+ * @param [in] callback Function to call for each state change. May be `NULL`
+ * @param [in] arg Argument to pass to `callback`
+ * @param [out] fd Pointer to storage for the eventfd file descriptor. May be `NULL`.
+ * The descriptor is closed by ::k_ants_monitor_stop
+ * @return KANTSStatus `ANTS_OK` if OK, error otherwise
+ */
+KANTSStatus k_ants_monitor_start(const ants_monitor_config * config,
+                                 ants_monitor_cb callback, void * arg, int * fd);
+/**
+ * Wait for the deployment monitor to finish
+ * @param [in] timeout Maximum time to wait [milliseconds]
+ * @return KANTSStatus `ANTS_OK` if the monitor has finished, `ANTS_ERROR` if it was
+ * still running when `timeout` expired, or `ANTS_ERROR_CONFIG` if it hasn't been started
+ */
+KANTSStatus k_ants_monitor_wait(uint32_t timeout);
+/**
+ * Get the deployment monitor's current results, including per-antenna timing
+ * @param [out] report Pointer to storage for the results
+ * @return KANTSStatus `ANTS_OK` if OK, error otherwise
+ */
+KANTSStatus k_ants_monitor_get_report(ants_monitor_report * report);
+/**
+ * Stop the deployment monitor, if it's still running, and release its resources
+ * @param [out] report Pointer to storage for the final results. May be `NULL`
+ * @return KANTSStatus `ANTS_OK` if OK, error otherwise
+ */
+KANTSStatus k_ants_monitor_stop(ants_monitor_report * report);
 /**
  * Kick the AntS's watchdogs once
  * @return KANTSStatus `ANTS_OK` if OK, error otherwise
  */
 KANTSStatus k_ants_watchdog_kick(void);
 /**
- * Start a thread to kick the AntS's watchdogs at an interval of
- * (timeout/3) seconds
+ * Start kicking the AntS's watchdogs at an interval of (timeout/3) seconds
+ *
+ * The kicks are made by the shared watchdog scheduler (see ::k_watchdog_register)
  * @return KANTSStatus `ANTS_OK` if OK, error otherwise
  */
 KANTSStatus k_ants_watchdog_start(void);
 /**
- * Stop the watchdog thread
+ * Stop kicking the AntS's watchdogs
  * @return KANTSStatus `ANTS_OK` if OK, error otherwise
  */
 KANTSStatus k_ants_watchdog_stop(void);
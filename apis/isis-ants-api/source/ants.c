@@ -16,7 +16,12 @@
 
 #include <ants-api.h>
 #include <i2c.h>
+#include <power-policy.h>
+#include <watchdog.h>
+#include <errno.h>
+#include <pthread.h>
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
 #include <unistd.h>
 
@@ -27,8 +32,33 @@ static uint8_t ants_addr = 0; /* Address of the antenna microcontroller commands
 static uint8_t ant_count = 0;
 static uint8_t ants_wd_timeout = 0;
 
-/* Handle for watchdog thread */
-static pthread_t handle_watchdog = { 0 };
+/* Watchdog scheduler ID, or -1 if not started */
+static int ants_watchdog = -1;
+/* Watchdog scheduler ID of the health probe, or -1 if not started */
+static int ants_probe = -1;
+/* Power policy poller ID of the health probe, or -1 if not registered */
+static int ants_probe_poll = -1;
+/* Scheduled time between probes, and the time of the last one */
+static uint32_t        ants_probe_interval = 0;
+static struct timespec ants_probe_last;
+
+/* Consecutive failures before failing over. 0 if failover is disabled */
+static uint8_t ants_max_failures = 0;
+static ants_health ants_status[2];
+
+/*
+ * Controllers armed by k_ants_arm. Arm state belongs to each controller, so
+ * once arming is tracked, deploy commands are only sent to an armed one
+ */
+static bool ants_arm_tracked = false;
+static bool ants_armed[2];
+
+/*
+ * Serializes all AntS bus traffic, so command/response pairs from the
+ * watchdog, the health probe and the caller never interleave. Also protects
+ * ants_addr and the health state
+ */
+static pthread_mutex_t ants_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 /*
  * The system can lock up if you make too many calls too quickly,
@@ -36,6 +66,163 @@ static pthread_t handle_watchdog = { 0 };
  */
 const struct timespec TRANSFER_DELAY = {.tv_sec = 0, .tv_nsec = 1000001 };
 
+static KANTSController kprv_ants_controller(uint8_t addr)
+{
+    return (addr == ants_primary) ? PRIMARY : SECONDARY;
+}
+
+/* Send a command and read its response, if any. The caller holds ants_mutex */
+static KI2CStatus kprv_ants_xfer(uint8_t addr, const uint8_t * tx, int tx_len,
+                                 uint8_t * rx, int rx_len)
+{
+    KI2CStatus status;
+
+    status = k_i2c_write(ants_bus, addr, (uint8_t *) tx, tx_len);
+    if (status == I2C_OK && rx_len != 0)
+    {
+        status = k_i2c_read(ants_bus, addr, rx, rx_len);
+    }
+
+    return status;
+}
+
+/*
+ * Record the result of a transaction against a controller. Returns true if
+ * commanding has been switched to the other controller as a result.
+ * The caller holds ants_mutex
+ */
+static bool kprv_ants_record(uint8_t addr, bool ok)
+{
+    ants_health * health = &ants_status[kprv_ants_controller(addr)];
+
+    if (ok)
+    {
+        health->alive       = true;
+        health->consecutive = 0;
+        return false;
+    }
+
+    health->failures++;
+    if (health->consecutive < UINT8_MAX)
+    {
+        health->consecutive++;
+    }
+
+    if (ants_max_failures == 0 || health->consecutive < ants_max_failures)
+    {
+        return false;
+    }
+
+    health->alive = false;
+
+    /* Only move commanding if it's currently pointed at the dead controller */
+    if (addr != ants_addr || ants_secondary == 0)
+    {
+        return false;
+    }
+
+    uint8_t other = (addr == ants_primary) ? ants_secondary : ants_primary;
+
+    if (!ants_status[kprv_ants_controller(other)].alive)
+    {
+        return false;
+    }
+
+    fprintf(stderr, "AntS controller %#x is not responding. Switching to %#x\n",
+            addr, other);
+
+    health->failovers++;
+    ants_addr = other;
+
+    return true;
+}
+
+/* Commands which depend on the receiving controller's arm state */
+static bool kprv_ants_arm_command(uint8_t cmd)
+{
+    return cmd == ARM_ANTS || cmd == AUTO_DEPLOY
+           || (cmd >= DEPLOY_1 && cmd <= DEPLOY_4)
+           || (cmd >= DEPLOY_1_OVERRIDE && cmd <= DEPLOY_4_OVERRIDE);
+}
+
+/*
+ * Send a command to the active controller and read its response, if any.
+ * If the controller has stopped answering, the command is retried once
+ * against the other controller, unless it's an arm or deploy command
+ */
+static KI2CStatus kprv_ants_transfer(const uint8_t * tx, int tx_len,
+                                     uint8_t * rx, int rx_len)
+{
+    KI2CStatus status;
+
+    pthread_mutex_lock(&ants_mutex);
+
+    status = kprv_ants_xfer(ants_addr, tx, tx_len, rx, rx_len);
+    if (kprv_ants_record(ants_addr, status == I2C_OK)
+        && !kprv_ants_arm_command(tx[0]))
+    {
+        nanosleep(&TRANSFER_DELAY, NULL);
+
+        status = kprv_ants_xfer(ants_addr, tx, tx_len, rx, rx_len);
+        kprv_ants_record(ants_addr, status == I2C_OK);
+    }
+
+    nanosleep(&TRANSFER_DELAY, NULL);
+
+    pthread_mutex_unlock(&ants_mutex);
+
+    return status;
+}
+
+/*
+ * Send an arm or deploy command to the active controller. Deploy commands are
+ * refused if arming is tracked and this controller hasn't been armed
+ */
+static KANTSStatus kprv_ants_arm_transfer(const uint8_t * tx, int tx_len)
+{
+    KANTSStatus ret = ANTS_OK;
+    KI2CStatus  status;
+
+    pthread_mutex_lock(&ants_mutex);
+
+    KANTSController controller = kprv_ants_controller(ants_addr);
+
+    if (tx[0] != ARM_ANTS && ants_arm_tracked && !ants_armed[controller])
+    {
+        pthread_mutex_unlock(&ants_mutex);
+        return ANTS_ERROR_NOT_ARMED;
+    }
+
+    status = kprv_ants_xfer(ants_addr, tx, tx_len, NULL, 0);
+    if (kprv_ants_record(ants_addr, status == I2C_OK))
+    {
+        /* Commanding moved to a controller this command never reached */
+        ret = ANTS_ERROR_NOT_ARMED;
+    }
+    else if (status != I2C_OK)
+    {
+        ret = ANTS_ERROR;
+    }
+    else if (tx[0] == ARM_ANTS)
+    {
+        ants_arm_tracked       = true;
+        ants_armed[controller] = true;
+    }
+
+    nanosleep(&TRANSFER_DELAY, NULL);
+
+    pthread_mutex_unlock(&ants_mutex);
+
+    return ret;
+}
+
+/* Forget which controllers are armed. The caller holds ants_mutex */
+static void kprv_ants_clear_armed(void)
+{
+    ants_arm_tracked = false;
+    memset(ants_armed, 0, sizeof(ants_armed));
+}
+
 KANTSStatus k_ants_init(char * bus, uint8_t primary, uint8_t secondary, uint8_t count, uint32_t timeout)
 {
     /* Save internal configuration values */
@@ -52,17 +239,39 @@ KANTSStatus k_ants_init(char * bus, uint8_t primary, uint8_t secondary, uint8_t
         return ANTS_ERROR;
     }
 
+    pthread_mutex_lock(&ants_mutex);
+
     /* Set default I2C slave address */
     ants_addr = ants_primary;
 
+    /* Assume both controllers are healthy until shown otherwise */
+    memset(ants_status, 0, sizeof(ants_status));
+    ants_status[PRIMARY].alive   = true;
+    ants_status[SECONDARY].alive = (ants_secondary != 0);
+    ants_max_failures = 0;
+    kprv_ants_clear_armed();
+
+    pthread_mutex_unlock(&ants_mutex);
+
     return ANTS_OK;
 }
 
 void k_ants_terminate()
 {
+    /* Must be done without the bus lock, since the probe takes it */
+    if (ants_probe >= 0)
+    {
+        k_ants_health_stop();
+    }
+
+    pthread_mutex_lock(&ants_mutex);
+
     ants_addr = 0;
+    ants_max_failures = 0;
     k_i2c_terminate(&ants_bus);
 
+    pthread_mutex_unlock(&ants_mutex);
+
     return;
 }
 
@@ -70,6 +279,8 @@ KANTSStatus k_ants_configure(KANTSController config)
 {
     KANTSStatus status = ANTS_OK;
 
+    pthread_mutex_lock(&ants_mutex);
+
     if (config == PRIMARY)
     {
         ants_addr = ants_primary;
@@ -88,21 +299,37 @@ KANTSStatus k_ants_configure(KANTSController config)
     }
     else
     {
+        pthread_mutex_unlock(&ants_mutex);
         fprintf(stderr, "AntS config failed: Unknown value - %d\n", config);
         return ANTS_ERROR_CONFIG;
     }
 
     nanosleep(&TRANSFER_DELAY, NULL);
 
+    pthread_mutex_unlock(&ants_mutex);
+
     return status;
 }
 
+KANTSController k_ants_get_controller(void)
+{
+    KANTSController controller;
+
+    pthread_mutex_lock(&ants_mutex);
+    controller = kprv_ants_controller(ants_addr);
+    pthread_mutex_unlock(&ants_mutex);
+
+    return controller;
+}
+
 KANTSStatus k_ants_reset()
 {
     KANTSStatus ret = ANTS_OK;
     KI2CStatus  status;
     uint8_t     cmd = SYSTEM_RESET;
 
+    pthread_mutex_lock(&ants_mutex);
+
     status = k_i2c_write(ants_bus, ants_primary, (uint8_t *) &cmd, 1);
     if (status != I2C_OK)
     {
@@ -122,26 +349,28 @@ KANTSStatus k_ants_reset()
         }
     }
 
+    /* Resetting a controller disarms it */
+    kprv_ants_clear_armed();
+
     nanosleep(&TRANSFER_DELAY, NULL);
 
+    pthread_mutex_unlock(&ants_mutex);
+
     return ret;
 }
 
 KANTSStatus k_ants_arm()
 {
-    KI2CStatus status;
-    uint8_t    cmd = ARM_ANTS;
+    KANTSStatus status;
+    uint8_t     cmd = ARM_ANTS;
 
-    status = k_i2c_write(ants_bus, ants_addr, (uint8_t *) &cmd, 1);
-    if (status != I2C_OK)
+    status = kprv_ants_arm_transfer(&cmd, 1);
+    if (status != ANTS_OK)
     {
         fprintf(stderr, "Failed to arm AntS: %d\n", status);
-        return ANTS_ERROR;
     }
 
-    nanosleep(&TRANSFER_DELAY, NULL);
-
-    return ANTS_OK;
+    return status;
 }
 
 KANTSStatus k_ants_disarm()
@@ -149,22 +378,24 @@ KANTSStatus k_ants_disarm()
     KI2CStatus status;
     uint8_t    cmd = DISARM_ANTS;
 
-    status = k_i2c_write(ants_bus, ants_addr, (uint8_t *) &cmd, 1);
+    status = kprv_ants_transfer((uint8_t *) &cmd, 1, NULL, 0);
     if (status != I2C_OK)
     {
         fprintf(stderr, "Failed to disarm AntS: %d\n", status);
         return ANTS_ERROR;
     }
 
-    nanosleep(&TRANSFER_DELAY, NULL);
+    pthread_mutex_lock(&ants_mutex);
+    kprv_ants_clear_armed();
+    pthread_mutex_unlock(&ants_mutex);
 
     return ANTS_OK;
 }
 
 KANTSStatus k_ants_deploy(KANTSAnt antenna, bool override, uint8_t timeout)
 {
-    KI2CStatus status    = ANTS_OK;
-    char       packet[2] = { 0 };
+    KANTSStatus status    = ANTS_OK;
+    uint8_t     packet[2] = { 0 };
 
     if (antenna >= ant_count)
     {
@@ -220,37 +451,31 @@ KANTSStatus k_ants_deploy(KANTSAnt antenna, bool override, uint8_t timeout)
             return ANTS_ERROR_CONFIG;
     }
 
-    status = k_i2c_write(ants_bus, ants_addr, packet, sizeof(packet));
-    if (status != I2C_OK)
+    status = kprv_ants_arm_transfer(packet, sizeof(packet));
+    if (status != ANTS_OK)
     {
         fprintf(stderr, "Failed to deploy antenna %d: %d\n", (antenna + 1),
                 status);
-        return ANTS_ERROR;
     }
 
-    nanosleep(&TRANSFER_DELAY, NULL);
-
-    return ANTS_OK;
+    return status;
 }
 
 KANTSStatus k_ants_auto_deploy(uint8_t timeout)
 {
-    KI2CStatus status    = ANTS_OK;
-    char       packet[2] = { 0 };
+    KANTSStatus status    = ANTS_OK;
+    uint8_t     packet[2] = { 0 };
 
     packet[0] = AUTO_DEPLOY;
     packet[1] = timeout;
 
-    status = k_i2c_write(ants_bus, ants_addr, packet, sizeof(packet));
-    if (status != I2C_OK)
+    status = kprv_ants_arm_transfer(packet, sizeof(packet));
+    if (status != ANTS_OK)
     {
         fprintf(stderr, "Failed to auto-deploy AntS: %d\n", status);
-        return ANTS_ERROR;
     }
 
-    nanosleep(&TRANSFER_DELAY, NULL);
-
-    return ANTS_OK;
+    return status;
 }
 
 KANTSStatus k_ants_cancel_deploy()
@@ -258,15 +483,13 @@ KANTSStatus k_ants_cancel_deploy()
     KI2CStatus status;
     uint8_t    cmd = CANCEL_DEPLOY;
 
-    status = k_i2c_write(ants_bus, ants_addr, (uint8_t *) &cmd, 1);
+    status = kprv_ants_transfer((uint8_t *) &cmd, 1, NULL, 0);
     if (status != I2C_OK)
     {
         fprintf(stderr, "Failed to cancel AntS deployment: %d\n", status);
         return ANTS_ERROR;
     }
 
-    nanosleep(&TRANSFER_DELAY, NULL);
-
     return ANTS_OK;
 }
 
@@ -280,23 +503,13 @@ KANTSStatus k_ants_get_deploy_status(uint16_t * resp)
     KI2CStatus status;
     uint8_t    cmd = GET_STATUS;
 
-    status = k_i2c_write(ants_bus, ants_addr, (uint8_t *) &cmd, 1);
-    if (status != I2C_OK)
-    {
-        fprintf(stderr, "Failed to request AntS deployment status: %d\n",
-                status);
-        return ANTS_ERROR;
-    }
-
-    status = k_i2c_read(ants_bus, ants_addr, (uint8_t *) resp, 2);
+    status = kprv_ants_transfer(&cmd, 1, (uint8_t *) resp, 2);
     if (status != I2C_OK)
     {
-        fprintf(stderr, "Failed to read AntS deployment status: %d\n", status);
+        fprintf(stderr, "Failed to get AntS deployment status: %d\n", status);
         return ANTS_ERROR;
     }
 
-    nanosleep(&TRANSFER_DELAY, NULL);
-
     return ANTS_OK;
 }
 
@@ -310,22 +523,13 @@ KANTSStatus k_ants_get_uptime(uint32_t * uptime)
     KI2CStatus status;
     uint8_t    cmd = GET_UPTIME_SYS;
 
-    status = k_i2c_write(ants_bus, ants_addr, (uint8_t *) &cmd, 1);
-    if (status != I2C_OK)
-    {
-        fprintf(stderr, "Failed to request AntS uptime: %d\n", status);
-        return ANTS_ERROR;
-    }
-
-    status = k_i2c_read(ants_bus, ants_addr, (uint8_t *) uptime, 4);
+    status = kprv_ants_transfer(&cmd, 1, (uint8_t *) uptime, 4);
     if (status != I2C_OK)
     {
-        fprintf(stderr, "Failed to read AntS uptime: %d\n", status);
+        fprintf(stderr, "Failed to get AntS uptime: %d\n", status);
         return ANTS_ERROR;
     }
 
-    nanosleep(&TRANSFER_DELAY, NULL);
-
     return ANTS_OK;
 }
 
@@ -339,23 +543,13 @@ KANTSStatus k_ants_get_system_telemetry(ants_telemetry * telem)
     KI2CStatus status;
     uint8_t    cmd = GET_TELEMETRY;
 
-    status = k_i2c_write(ants_bus, ants_addr, (uint8_t *) &cmd, 1);
+    status = kprv_ants_transfer(&cmd, 1, (uint8_t *) telem, sizeof(ants_telemetry));
     if (status != I2C_OK)
     {
-        fprintf(stderr, "Failed to request AntS telemetry: %d\n", status);
+        fprintf(stderr, "Failed to get AntS telemetry: %d\n", status);
         return ANTS_ERROR;
     }
 
-    status = k_i2c_read(ants_bus, ants_addr, (uint8_t *) telem,
-                        sizeof(ants_telemetry));
-    if (status != I2C_OK)
-    {
-        fprintf(stderr, "Failed to read AntS telemetry: %d\n", status);
-        return ANTS_ERROR;
-    }
-
-    nanosleep(&TRANSFER_DELAY, NULL);
-
     return ANTS_OK;
 }
 
@@ -371,24 +565,13 @@ KANTSStatus k_ants_get_activation_count(KANTSAnt antenna, uint8_t * count)
     KI2CStatus status;
     uint8_t    cmd = GET_COUNT_1 + antenna;
 
-    status = k_i2c_write(ants_bus, ants_addr, (uint8_t *) &cmd, 1);
+    status = kprv_ants_transfer(&cmd, 1, count, 1);
     if (status != I2C_OK)
     {
-        fprintf(stderr, "Failed to request antenna %d activation count: %d\n",
-                (antenna + 1), status);
+        fprintf(stderr, "Failed to get antenna %d activation count: %d\n", (antenna + 1), status);
         return ANTS_ERROR;
     }
 
-    status = k_i2c_read(ants_bus, ants_addr, count, 1);
-    if (status != I2C_OK)
-    {
-        fprintf(stderr, "Failed to read antenna %d activation count: %d\n",
-                (antenna + 1), status);
-        return ANTS_ERROR;
-    }
-
-    nanosleep(&TRANSFER_DELAY, NULL);
-
     return ANTS_OK;
 }
 
@@ -404,23 +587,136 @@ KANTSStatus k_ants_get_activation_time(KANTSAnt antenna, uint16_t * time)
     KI2CStatus status;
     uint8_t    cmd = GET_UPTIME_1 + antenna;
 
-    status = k_i2c_write(ants_bus, ants_addr, (uint8_t *) &cmd, 1);
+    status = kprv_ants_transfer(&cmd, 1, (uint8_t *) time, 2);
     if (status != I2C_OK)
     {
-        fprintf(stderr, "Failed to request antenna %d activation times: %d\n",
-                (antenna + 1), status);
+        fprintf(stderr, "Failed to get antenna %d activation time: %d\n", (antenna + 1), status);
         return ANTS_ERROR;
     }
 
-    status = k_i2c_read(ants_bus, ants_addr, (uint8_t *) time, 2);
-    if (status != I2C_OK)
+    return ANTS_OK;
+}
+
+static int64_t kprv_ants_diff_us(const struct timespec * end,
+                                 const struct timespec * start)
+{
+    return (int64_t) (end->tv_sec - start->tv_sec) * 1000000
+           + (end->tv_nsec - start->tv_nsec) / 1000;
+}
+
+/*
+ * Wait until TRANSFER_DELAY has passed since the end of the previous
+ * transaction. Returns the time spent waiting, in microseconds
+ */
+static uint32_t kprv_ants_pace(const struct timespec * last)
+{
+    struct timespec start;
+    struct timespec end;
+    struct timespec wake = *last;
+
+    wake.tv_nsec += TRANSFER_DELAY.tv_nsec;
+    if (wake.tv_nsec >= 1000000000)
     {
-        fprintf(stderr, "Failed to read antenna %d activation times: %d\n",
-                (antenna + 1), status);
-        return ANTS_ERROR;
+        wake.tv_sec++;
+        wake.tv_nsec -= 1000000000;
     }
 
-    nanosleep(&TRANSFER_DELAY, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (kprv_ants_diff_us(&wake, &start) <= 0)
+    {
+        return 0;
+    }
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL) == EINTR)
+    {
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    return (uint32_t) kprv_ants_diff_us(&end, &start);
+}
+
+KANTSStatus k_ants_get_snapshot(ants_snapshot * snapshot)
+{
+    struct {
+        uint8_t   cmd;
+        uint8_t * data;
+        int       len;
+    } requests[1 + (2 * ANTS_MAX_ANTENNAS)];
+
+    struct timespec start;
+    struct timespec last;
+    struct timespec end;
+    KI2CStatus      status;
+    int             count = 0;
+    uint8_t         antennas;
+
+    if (snapshot == NULL)
+    {
+        return ANTS_ERROR_CONFIG;
+    }
+
+    memset(snapshot, 0, sizeof(*snapshot));
+
+    antennas = (ant_count > ANTS_MAX_ANTENNAS) ? ANTS_MAX_ANTENNAS : ant_count;
+
+    /* The telemetry includes the uptime and deployment status */
+    requests[count].cmd  = GET_TELEMETRY;
+    requests[count].data = (uint8_t *) &snapshot->telem;
+    requests[count].len  = sizeof(ants_telemetry);
+    count++;
+
+    for (int i = 0; i < antennas; i++)
+    {
+        requests[count].cmd  = GET_COUNT_1 + i;
+        requests[count].data = &snapshot->activation_count[i];
+        requests[count].len  = 1;
+        count++;
+
+        requests[count].cmd  = GET_UPTIME_1 + i;
+        requests[count].data = (uint8_t *) &snapshot->activation_time[i];
+        requests[count].len  = 2;
+        count++;
+    }
+
+    /* Nothing else can use the bus in the gaps */
+    pthread_mutex_lock(&ants_mutex);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (int i = 0; i < count; i++)
+    {
+        if (i > 0)
+        {
+            snapshot->wait += kprv_ants_pace(&last);
+        }
+
+        status = kprv_ants_xfer(ants_addr, &requests[i].cmd, 1,
+                                requests[i].data, requests[i].len);
+
+        clock_gettime(CLOCK_MONOTONIC, &last);
+        snapshot->transfers++;
+
+        /* A failure may move later commands to the other controller */
+        kprv_ants_record(ants_addr, status == I2C_OK);
+
+        if (status != I2C_OK)
+        {
+            fprintf(stderr, "Failed to fetch AntS snapshot (command %#x): %d\n",
+                    requests[i].cmd, status);
+            nanosleep(&TRANSFER_DELAY, NULL);
+            pthread_mutex_unlock(&ants_mutex);
+            return ANTS_ERROR;
+        }
+    }
+
+    /* Leave the usual gap before whatever command comes next */
+    snapshot->wait += kprv_ants_pace(&last);
+
+    pthread_mutex_unlock(&ants_mutex);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    snapshot->duration = (uint32_t) kprv_ants_diff_us(&end, &start);
 
     return ANTS_OK;
 }
@@ -431,6 +727,8 @@ KANTSStatus k_ants_watchdog_kick()
     KANTSStatus ret = ANTS_OK;
     uint8_t     cmd = WATCHDOG_RESET;
 
+    pthread_mutex_lock(&ants_mutex);
+
     status = k_i2c_write(ants_bus, ants_primary, (uint8_t *) &cmd, 1);
     if (status != I2C_OK)
     {
@@ -448,28 +746,21 @@ KANTSStatus k_ants_watchdog_kick()
         }
     }
 
+    pthread_mutex_unlock(&ants_mutex);
+
     return ret;
 }
 
-void * kprv_ants_watchdog_thread(void * args)
+static int kprv_ants_watchdog_kick(void * arg)
 {
-    KANTSStatus status;
-
-    while (1)
-    {
-        k_ants_watchdog_kick();
-
-        sleep(ants_wd_timeout / 3);
-    }
-
-    return NULL;
+    return k_ants_watchdog_kick();
 }
 
 KANTSStatus k_ants_watchdog_start()
 {
-    if (handle_watchdog != 0)
+    if (ants_watchdog >= 0)
     {
-        fprintf(stderr, "AntS watchdog thread already started\n");
+        fprintf(stderr, "AntS watchdog already started\n");
         return ANTS_OK;
     }
 
@@ -477,15 +768,18 @@ KANTSStatus k_ants_watchdog_start()
     {
         fprintf(
             stderr,
-            "AntS watchdog has been disabled. No thread will be started\n");
+            "AntS watchdog has been disabled. No kicks will be scheduled\n");
         return ANTS_OK;
     }
 
-    if (pthread_create(&handle_watchdog, NULL, kprv_ants_watchdog_thread, NULL)
-        != 0)
+    uint32_t period = (uint32_t) ants_wd_timeout * 1000 / 3;
+
+    if (k_watchdog_register("AntS", period, period / 4,
+                            kprv_ants_watchdog_kick, NULL, &ants_watchdog)
+        != WATCHDOG_OK)
     {
-        perror("Failed to create AntS watchdog thread");
-        handle_watchdog = 0;
+        fprintf(stderr, "Failed to start AntS watchdog\n");
+        ants_watchdog = -1;
         return ANTS_ERROR;
     }
 
@@ -494,27 +788,194 @@ KANTSStatus k_ants_watchdog_start()
 
 KANTSStatus k_ants_watchdog_stop()
 {
-    if (handle_watchdog == 0)
+    if (ants_watchdog < 0)
     {
-      perror("AntS watchdog thread has not been started");
-      return ANTS_ERROR;
+        fprintf(stderr, "AntS watchdog has not been started\n");
+        return ANTS_ERROR;
     }
 
-    /* Send the cancel request */
-    if (pthread_cancel(handle_watchdog) != 0)
+    /* No more kicks will be made once this returns */
+    if (k_watchdog_unregister(ants_watchdog) != WATCHDOG_OK)
     {
-        perror("Failed to cancel AntS watchdog thread");
+        fprintf(stderr, "Failed to stop AntS watchdog\n");
         return ANTS_ERROR;
     }
 
-    /* Wait for the cancellation to complete */
-    if (pthread_join(handle_watchdog, NULL) != 0)
+    ants_watchdog = -1;
+
+    return ANTS_OK;
+}
+
+/* Probe one controller's uptime and telemetry. The caller holds ants_mutex */
+static bool kprv_ants_probe(uint8_t addr)
+{
+    ants_health *  health = &ants_status[kprv_ants_controller(addr)];
+    ants_telemetry telem;
+    uint32_t       uptime;
+    uint8_t        cmd;
+    KI2CStatus     status;
+
+    health->probes++;
+
+    cmd    = GET_UPTIME_SYS;
+    status = kprv_ants_xfer(addr, &cmd, 1, (uint8_t *) &uptime, 4);
+    nanosleep(&TRANSFER_DELAY, NULL);
+
+    if (status == I2C_OK)
+    {
+        cmd    = GET_TELEMETRY;
+        status = kprv_ants_xfer(addr, &cmd, 1, (uint8_t *) &telem,
+                                sizeof(ants_telemetry));
+        nanosleep(&TRANSFER_DELAY, NULL);
+    }
+
+    if (status == I2C_OK)
+    {
+        if (uptime < health->uptime)
+        {
+            /* Restarting disarmed it */
+            health->resets++;
+            ants_armed[kprv_ants_controller(addr)] = false;
+        }
+
+        health->uptime = uptime;
+        health->telem  = telem;
+    }
+
+    kprv_ants_record(addr, status == I2C_OK);
+
+    return status == I2C_OK;
+}
+
+static int kprv_ants_health_probe(void * arg)
+{
+    k_power_poll_stats stats;
+    struct timespec    now;
+    bool               ok;
+
+    pthread_mutex_lock(&ants_mutex);
+
+    /*
+     * The scheduler kicks at the normal interval. Kicks can't reschedule
+     * themselves, so skip probes until the power mode's interval is up.
+     * Allow for the kick being brought forward by its slack
+     */
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    uint64_t elapsed = (uint64_t) (now.tv_sec - ants_probe_last.tv_sec) * 1000
+                       + (now.tv_nsec - ants_probe_last.tv_nsec) / 1000000;
+
+    if (ants_probe_poll >= 0
+        && k_power_get_poll_stats(ants_probe_poll, &stats) == POWER_OK
+        && elapsed + ants_probe_interval / 2 < stats.interval)
+    {
+        pthread_mutex_unlock(&ants_mutex);
+        return 0;
+    }
+
+    ants_probe_last = now;
+    k_power_poll(ants_probe_poll);
+
+    ok = kprv_ants_probe(ants_primary);
+
+    if (ants_secondary != 0)
+    {
+        ok = kprv_ants_probe(ants_secondary) && ok;
+    }
+
+    pthread_mutex_unlock(&ants_mutex);
+
+    return ok ? 0 : -1;
+}
+
+KANTSStatus k_ants_health_start(const ants_health_config * config)
+{
+    if (config == NULL)
+    {
+        return ANTS_ERROR_CONFIG;
+    }
+
+    if (ants_probe >= 0)
+    {
+        fprintf(stderr, "AntS health probe already started\n");
+        return ANTS_OK;
+    }
+
+    pthread_mutex_lock(&ants_mutex);
+    ants_max_failures = config->max_failures;
+    pthread_mutex_unlock(&ants_mutex);
+
+    if (config->interval == 0)
+    {
+        return ANTS_OK;
+    }
+
+    /* Probe less often in the power policy's low-power modes */
+    if (k_power_register_poll("AntS health", config->interval, &ants_probe_poll)
+        != POWER_OK)
+    {
+        ants_probe_poll = -1;
+    }
+
+    pthread_mutex_lock(&ants_mutex);
+    ants_probe_interval = config->interval;
+    memset(&ants_probe_last, 0, sizeof(ants_probe_last));
+    pthread_mutex_unlock(&ants_mutex);
+
+    /* Probes share the watchdog scheduler's thread, rather than starting another */
+    if (k_watchdog_register("AntS health", config->interval,
+                            config->interval / 4, kprv_ants_health_probe,
+                            NULL, &ants_probe)
+        != WATCHDOG_OK)
     {
-        perror("Failed to rejoin AntS watchdog thread");
+        fprintf(stderr, "Failed to start AntS health probe\n");
+        ants_probe = -1;
+        k_power_unregister_poll(ants_probe_poll);
+        ants_probe_poll = -1;
         return ANTS_ERROR;
     }
 
-    handle_watchdog = 0;
+    return ANTS_OK;
+}
+
+KANTSStatus k_ants_health_stop(void)
+{
+    KANTSStatus status = ANTS_OK;
+
+    if (ants_probe >= 0)
+    {
+        /* No more probes will be made once this returns */
+        if (k_watchdog_unregister(ants_probe) != WATCHDOG_OK)
+        {
+            fprintf(stderr, "Failed to stop AntS health probe\n");
+            status = ANTS_ERROR;
+        }
+
+        ants_probe = -1;
+    }
+
+    if (ants_probe_poll >= 0)
+    {
+        k_power_unregister_poll(ants_probe_poll);
+        ants_probe_poll = -1;
+    }
+
+    pthread_mutex_lock(&ants_mutex);
+    ants_max_failures = 0;
+    pthread_mutex_unlock(&ants_mutex);
+
+    return status;
+}
+
+KANTSStatus k_ants_get_health(KANTSController controller, ants_health * health)
+{
+    if (health == NULL || (controller != PRIMARY && controller != SECONDARY))
+    {
+        return ANTS_ERROR_CONFIG;
+    }
+
+    pthread_mutex_lock(&ants_mutex);
+    *health = ants_status[controller];
+    pthread_mutex_unlock(&ants_mutex);
 
     return ANTS_OK;
 }
@@ -529,25 +990,12 @@ KANTSStatus k_ants_passthrough(const uint8_t * tx, int tx_len, uint8_t * rx,
 
     KI2CStatus status;
 
-    status = k_i2c_write(ants_bus, ants_addr, (uint8_t *) tx, tx_len);
+    status = kprv_ants_transfer(tx, tx_len, rx, rx_len);
     if (status != I2C_OK)
     {
-        fprintf(stderr, "Failed to send AntS passthrough packet: %d\n", status);
+        fprintf(stderr, "Failed AntS passthrough transfer: %d\n", status);
         return ANTS_ERROR;
     }
 
-    if (rx_len != 0)
-    {
-        status = k_i2c_read(ants_bus, ants_addr, rx, rx_len);
-        if (status != I2C_OK)
-        {
-            fprintf(stderr, "Failed to read AntS passthrough response: %d\n",
-                    status);
-            return ANTS_ERROR;
-        }
-    }
-
-    nanosleep(&TRANSFER_DELAY, NULL);
-
     return ANTS_OK;
 }
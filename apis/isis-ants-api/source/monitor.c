@@ -0,0 +1,429 @@
+/*
+ * Copyright (C) 2018 Kubos Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ants-api.h>
+#include <power-policy.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+
+static struct {
+    bool                started;    /* Thread has been created and not yet joined */
+    bool                stop;       /* Set to ask the thread to exit early */
+    ants_monitor_config config;
+    ants_monitor_cb     callback;
+    void *              arg;
+    int                 fd;
+    int                 poll;       /* Power policy poller ID, or -1 */
+    struct timespec     start;
+    ants_monitor_report report;
+} monitor;
+
+static pthread_t       handle_monitor = { 0 };
+static pthread_mutex_t monitor_mutex  = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  monitor_cond;
+
+KANTSDeployState k_ants_decode_deploy_state(uint16_t status, KANTSAnt antenna)
+{
+    /* Antenna 1's flags are in the top nibble, antenna 4's in the bottom */
+    uint16_t flags = (status >> (12 - (4 * antenna))) & 0xF;
+
+    /* The flag is set while the antenna is *not* deployed */
+    if (!(flags & (ANT_4_NOT_DEPLOYED)))
+    {
+        return ANTS_DEPLOY_DEPLOYED;
+    }
+
+    if (flags & ANT_4_ACTIVE)
+    {
+        return ANTS_DEPLOY_ACTIVE;
+    }
+
+    if (flags & ANT_4_STOPPED_TIME)
+    {
+        return ANTS_DEPLOY_TIMED_OUT;
+    }
+
+    return ANTS_DEPLOY_STOWED;
+}
+
+static uint32_t kprv_ants_monitor_elapsed(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint32_t) ((now.tv_sec - monitor.start.tv_sec) * 1000
+                       + (now.tv_nsec - monitor.start.tv_nsec) / 1000000);
+}
+
+static void kprv_ants_monitor_notify(uint64_t count)
+{
+    if (monitor.fd >= 0 && count > 0)
+    {
+        eventfd_write(monitor.fd, count);
+    }
+}
+
+static void * kprv_ants_monitor_thread(void * args)
+{
+    struct {
+        KANTSAnt         antenna;
+        KANTSDeployState state;
+    } changes[ANTS_MAX_ANTENNAS];
+
+    ants_monitor_report * report   = &monitor.report;
+    uint32_t              interval = monitor.config.min_interval;
+    uint32_t              scaled;
+    bool                  first    = true;
+    uint16_t              status;
+    KANTSStatus           ret;
+
+    pthread_mutex_lock(&monitor_mutex);
+
+    while (!monitor.stop)
+    {
+        int  num_changes = 0;
+        bool busy        = false;
+
+        /* Don't hold the lock while talking to the device */
+        pthread_mutex_unlock(&monitor_mutex);
+        ret = k_ants_get_deploy_status(&status);
+        pthread_mutex_lock(&monitor_mutex);
+
+        uint32_t now = kprv_ants_monitor_elapsed();
+
+        report->polls++;
+        report->elapsed = now;
+
+        if (ret != ANTS_OK)
+        {
+            report->errors++;
+        }
+        else
+        {
+            report->deploy_status = status;
+            report->complete      = true;
+
+            for (int i = 0; i < ANTS_MAX_ANTENNAS; i++)
+            {
+                if (!(monitor.config.antennas & (1 << i)))
+                {
+                    continue;
+                }
+
+                KANTSDeployState state = k_ants_decode_deploy_state(status, i);
+
+                if (first || state != report->state[i])
+                {
+                    report->state[i] = state;
+                    changes[num_changes].antenna = i;
+                    changes[num_changes].state   = state;
+                    num_changes++;
+                }
+
+                if (state == ANTS_DEPLOY_ACTIVE
+                    && report->active_at[i] == ANTS_MONITOR_NEVER)
+                {
+                    report->active_at[i] = now;
+                }
+
+                if (state == ANTS_DEPLOY_ACTIVE || state == ANTS_DEPLOY_STOWED)
+                {
+                    report->complete = false;
+                }
+                else if (report->finished_at[i] == ANTS_MONITOR_NEVER)
+                {
+                    report->finished_at[i] = now;
+                }
+
+                if (state == ANTS_DEPLOY_ACTIVE)
+                {
+                    busy = true;
+                }
+            }
+
+            first = false;
+        }
+
+        bool done = report->complete || now >= monitor.config.timeout;
+
+        /* Callbacks are made without the lock, so they can fetch the report */
+        pthread_mutex_unlock(&monitor_mutex);
+
+        for (int i = 0; i < num_changes; i++)
+        {
+            if (monitor.callback != NULL)
+            {
+                monitor.callback(changes[i].antenna, changes[i].state,
+                                 monitor.arg);
+            }
+        }
+
+        kprv_ants_monitor_notify(num_changes + (done ? 1 : 0));
+
+        pthread_mutex_lock(&monitor_mutex);
+
+        if (done)
+        {
+            break;
+        }
+
+        /* Poll quickly while anything is happening, backing off otherwise */
+        if (busy || num_changes > 0)
+        {
+            interval = monitor.config.min_interval;
+        }
+        else if (interval < monitor.config.max_interval / 2)
+        {
+            interval *= 2;
+        }
+        else
+        {
+            interval = monitor.config.max_interval;
+        }
+
+        /*
+         * The poller is registered at min_interval, so its interval for the
+         * current power mode gives the factor to stretch the backoff by
+         */
+        scaled = interval;
+        uint32_t power_interval = k_power_poll(monitor.poll);
+        if (power_interval != 0)
+        {
+            uint64_t wait = (uint64_t) interval * power_interval
+                            / monitor.config.min_interval;
+            scaled = (wait > UINT32_MAX) ? UINT32_MAX : (uint32_t) wait;
+        }
+
+        struct timespec wake;
+        clock_gettime(CLOCK_MONOTONIC, &wake);
+        wake.tv_sec += scaled / 1000;
+        wake.tv_nsec += (scaled % 1000) * 1000000;
+        if (wake.tv_nsec >= 1000000000)
+        {
+            wake.tv_sec++;
+            wake.tv_nsec -= 1000000000;
+        }
+
+        /* Woken early by k_ants_monitor_stop */
+        while (!monitor.stop
+               && pthread_cond_timedwait(&monitor_cond, &monitor_mutex, &wake)
+                      != ETIMEDOUT)
+        {
+        }
+    }
+
+    report->running = false;
+    pthread_cond_broadcast(&monitor_cond);
+
+    pthread_mutex_unlock(&monitor_mutex);
+
+    return NULL;
+}
+
+KANTSStatus k_ants_monitor_start(const ants_monitor_config * config,
+                                 ants_monitor_cb callback, void * arg, int * fd)
+{
+    pthread_condattr_t attr;
+    int                ret;
+
+    if (config == NULL || config->antennas == 0
+        || config->antennas >= (1 << ANTS_MAX_ANTENNAS)
+        || config->min_interval == 0
+        || config->max_interval < config->min_interval)
+    {
+        return ANTS_ERROR_CONFIG;
+    }
+
+    pthread_mutex_lock(&monitor_mutex);
+
+    if (monitor.started)
+    {
+        fprintf(stderr, "AntS deployment monitor already started\n");
+        pthread_mutex_unlock(&monitor_mutex);
+        return ANTS_ERROR;
+    }
+
+    memset(&monitor, 0, sizeof(monitor));
+    monitor.config   = *config;
+    monitor.callback = callback;
+    monitor.arg      = arg;
+
+    /* Poll less often in the power policy's low-power modes */
+    if (k_power_register_poll("AntS monitor", config->min_interval,
+                              &monitor.poll)
+        != POWER_OK)
+    {
+        monitor.poll = -1;
+    }
+
+    for (int i = 0; i < ANTS_MAX_ANTENNAS; i++)
+    {
+        monitor.report.active_at[i]   = ANTS_MONITOR_NEVER;
+        monitor.report.finished_at[i] = ANTS_MONITOR_NEVER;
+    }
+
+    monitor.fd = eventfd(0, EFD_CLOEXEC);
+    if (monitor.fd < 0)
+    {
+        perror("Failed to create AntS deployment monitor eventfd");
+        k_power_unregister_poll(monitor.poll);
+        pthread_mutex_unlock(&monitor_mutex);
+        return ANTS_ERROR;
+    }
+
+    /* Wait against the monotonic clock, so setting the date can't stall a poll */
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&monitor_cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    clock_gettime(CLOCK_MONOTONIC, &monitor.start);
+    monitor.report.running = true;
+
+    ret = pthread_create(&handle_monitor, NULL, kprv_ants_monitor_thread, NULL);
+    if (ret != 0)
+    {
+        fprintf(stderr, "Failed to create AntS deployment monitor thread: %s\n",
+                strerror(ret));
+        close(monitor.fd);
+        monitor.fd = -1;
+        monitor.report.running = false;
+        pthread_cond_destroy(&monitor_cond);
+        k_power_unregister_poll(monitor.poll);
+        pthread_mutex_unlock(&monitor_mutex);
+        return ANTS_ERROR;
+    }
+
+    monitor.started = true;
+
+    if (fd != NULL)
+    {
+        *fd = monitor.fd;
+    }
+
+    pthread_mutex_unlock(&monitor_mutex);
+
+    return ANTS_OK;
+}
+
+KANTSStatus k_ants_monitor_wait(uint32_t timeout)
+{
+    struct timespec wake;
+    KANTSStatus     status = ANTS_OK;
+
+    clock_gettime(CLOCK_MONOTONIC, &wake);
+    wake.tv_sec += timeout / 1000;
+    wake.tv_nsec += (timeout % 1000) * 1000000;
+    if (wake.tv_nsec >= 1000000000)
+    {
+        wake.tv_sec++;
+        wake.tv_nsec -= 1000000000;
+    }
+
+    pthread_mutex_lock(&monitor_mutex);
+
+    if (!monitor.started)
+    {
+        pthread_mutex_unlock(&monitor_mutex);
+        return ANTS_ERROR_CONFIG;
+    }
+
+    while (monitor.report.running)
+    {
+        if (pthread_cond_timedwait(&monitor_cond, &monitor_mutex, &wake)
+            == ETIMEDOUT)
+        {
+            status = monitor.report.running ? ANTS_ERROR : ANTS_OK;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&monitor_mutex);
+
+    return status;
+}
+
+KANTSStatus k_ants_monitor_get_report(ants_monitor_report * report)
+{
+    if (report == NULL)
+    {
+        return ANTS_ERROR_CONFIG;
+    }
+
+    pthread_mutex_lock(&monitor_mutex);
+
+    if (!monitor.started)
+    {
+        pthread_mutex_unlock(&monitor_mutex);
+        return ANTS_ERROR_CONFIG;
+    }
+
+    *report = monitor.report;
+
+    pthread_mutex_unlock(&monitor_mutex);
+
+    return ANTS_OK;
+}
+
+KANTSStatus k_ants_monitor_stop(ants_monitor_report * report)
+{
+    KANTSStatus status = ANTS_OK;
+
+    pthread_mutex_lock(&monitor_mutex);
+
+    if (!monitor.started)
+    {
+        pthread_mutex_unlock(&monitor_mutex);
+        fprintf(stderr, "AntS deployment monitor has not been started\n");
+        return ANTS_ERROR;
+    }
+
+    monitor.stop = true;
+    pthread_cond_broadcast(&monitor_cond);
+
+    pthread_mutex_unlock(&monitor_mutex);
+
+    if (pthread_join(handle_monitor, NULL) != 0)
+    {
+        perror("Failed to rejoin AntS deployment monitor thread");
+        status = ANTS_ERROR;
+    }
+
+    handle_monitor = 0;
+
+    pthread_mutex_lock(&monitor_mutex);
+
+    if (report != NULL)
+    {
+        *report = monitor.report;
+    }
+
+    close(monitor.fd);
+    monitor.fd      = -1;
+    monitor.started = false;
+    k_power_unregister_poll(monitor.poll);
+    pthread_cond_destroy(&monitor_cond);
+
+    pthread_mutex_unlock(&monitor_mutex);
+
+    return status;
+}
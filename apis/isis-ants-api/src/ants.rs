@@ -29,6 +29,10 @@ pub enum AntsError {
     /// is out-of-bounds.
     #[fail(display = "Configuration error")]
     ConfigError,
+    /// The microcontroller now commanding the system hasn't been armed, ex. after
+    /// failing over to it. Arm the system again before deploying.
+    #[fail(display = "Controller not armed")]
+    NotArmed,
 }
 
 /// Custom result type for antenna operations
@@ -225,6 +229,7 @@ impl IAntS for AntS {
         match unsafe { ffi::k_ants_arm() } {
             ffi::KANTSStatus::AntsOK => Ok(()),
             ffi::KANTSStatus::AntsErrorConfig => Err(AntsError::ConfigError),
+            ffi::KANTSStatus::AntsErrorNotArmed => Err(AntsError::NotArmed),
             _ => Err(AntsError::GenericError),
         }
     }
@@ -283,6 +288,7 @@ impl IAntS for AntS {
         match unsafe { ffi::k_ants_deploy(convert_antenna(&antenna), force, timeout) } {
             ffi::KANTSStatus::AntsOK => Ok(()),
             ffi::KANTSStatus::AntsErrorConfig => Err(AntsError::ConfigError),
+            ffi::KANTSStatus::AntsErrorNotArmed => Err(AntsError::NotArmed),
             _ => Err(AntsError::GenericError),
         }
     }
@@ -313,6 +319,7 @@ impl IAntS for AntS {
         match unsafe { ffi::k_ants_auto_deploy(timeout) } {
             ffi::KANTSStatus::AntsOK => Ok(()),
             ffi::KANTSStatus::AntsErrorConfig => Err(AntsError::ConfigError),
+            ffi::KANTSStatus::AntsErrorNotArmed => Err(AntsError::NotArmed),
             _ => Err(AntsError::GenericError),
         }
     }
@@ -21,6 +21,7 @@ pub enum KANTSStatus {
     AntsError,
     AntsErrorConfig,
     AntsErrorNotImplemented,
+    AntsErrorNotArmed,
 }
 
 #[repr(C)]
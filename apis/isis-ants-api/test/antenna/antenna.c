@@ -16,7 +16,12 @@
  */
 
 #include <ants-api.h>
+#include <power-policy.h>
 #include <cmocka.h>
+#include <sys/eventfd.h>
+
+/* Number of upcoming writes which should fail, from sysfs.c */
+extern int write_failures;
 
 /* Test Data */
 #define ANTS_PRIMARY 0x31
@@ -586,6 +591,446 @@ static void test_get_activation_time_fake(void ** arg)
     assert_int_equal(ret, ANTS_ERROR_CONFIG);
 }
 
+static void test_get_snapshot(void ** arg)
+{
+    ants_snapshot snapshot;
+
+    expect_value(__wrap_ioctl, addr, ANTS_PRIMARY);
+    expect_value(__wrap_write, cmd, GET_TELEMETRY);
+    expect_value(__wrap_ioctl, addr, ANTS_PRIMARY);
+    will_return(__wrap_read, sizeof(system_telem));
+    will_return(__wrap_read, &system_telem);
+
+    for (int i = 0; i < ANT_COUNT; i++)
+    {
+        expect_value(__wrap_ioctl, addr, ANTS_PRIMARY);
+        expect_value(__wrap_write, cmd, GET_COUNT_1 + i);
+        expect_value(__wrap_ioctl, addr, ANTS_PRIMARY);
+        will_return(__wrap_read, sizeof(activation_count));
+        will_return(__wrap_read, &activation_count);
+
+        expect_value(__wrap_ioctl, addr, ANTS_PRIMARY);
+        expect_value(__wrap_write, cmd, GET_UPTIME_1 + i);
+        expect_value(__wrap_ioctl, addr, ANTS_PRIMARY);
+        will_return(__wrap_read, sizeof(activation_time));
+        will_return(__wrap_read, &activation_time);
+    }
+
+    assert_int_equal(k_ants_get_snapshot(&snapshot), ANTS_OK);
+
+    assert_memory_equal(&snapshot.telem, &system_telem, sizeof(system_telem));
+    for (int i = 0; i < ANT_COUNT; i++)
+    {
+        assert_int_equal(snapshot.activation_count[i], activation_count);
+        assert_int_equal(snapshot.activation_time[i], activation_time);
+    }
+
+    /* Uptime and deployment status come from the telemetry */
+    assert_int_equal(snapshot.transfers, 1 + (2 * ANT_COUNT));
+
+    /* Each transaction must still be at least 1ms after the previous one */
+    assert_true(snapshot.wait >= 1000 * 2 * ANT_COUNT);
+    assert_true(snapshot.duration >= snapshot.wait);
+}
+
+static void test_get_snapshot_fail(void ** arg)
+{
+    ants_snapshot snapshot;
+
+    expect_value(__wrap_ioctl, addr, ANTS_PRIMARY);
+    expect_value(__wrap_write, cmd, GET_TELEMETRY);
+    expect_value(__wrap_ioctl, addr, ANTS_PRIMARY);
+    will_return(__wrap_read, sizeof(system_telem));
+    will_return(__wrap_read, &system_telem);
+
+    expect_value(__wrap_ioctl, addr, ANTS_PRIMARY);
+    expect_value(__wrap_write, cmd, GET_COUNT_1);
+    expect_value(__wrap_ioctl, addr, ANTS_PRIMARY);
+    will_return(__wrap_read, -1);
+
+    assert_int_equal(k_ants_get_snapshot(&snapshot), ANTS_ERROR);
+    assert_int_equal(snapshot.transfers, 2);
+}
+
+static void test_get_snapshot_null(void ** arg)
+{
+    assert_int_equal(k_ants_get_snapshot(NULL), ANTS_ERROR_CONFIG);
+}
+
+static void test_decode_deploy_state(void ** arg)
+{
+    uint16_t status = ANT_1_NOT_DEPLOYED | ANT_1_ACTIVE
+                      | ANT_3_NOT_DEPLOYED | ANT_3_STOPPED_TIME
+                      | ANT_4_NOT_DEPLOYED;
+
+    assert_int_equal(k_ants_decode_deploy_state(status, ANT_1), ANTS_DEPLOY_ACTIVE);
+    assert_int_equal(k_ants_decode_deploy_state(status, ANT_2), ANTS_DEPLOY_DEPLOYED);
+    assert_int_equal(k_ants_decode_deploy_state(status, ANT_3), ANTS_DEPLOY_TIMED_OUT);
+    assert_int_equal(k_ants_decode_deploy_state(status, ANT_4), ANTS_DEPLOY_STOWED);
+}
+
+typedef struct {
+    int              count;
+    KANTSAnt         antenna[16];
+    KANTSDeployState state[16];
+} monitor_events;
+
+static void monitor_cb(KANTSAnt antenna, KANTSDeployState state, void * arg)
+{
+    monitor_events * events = arg;
+
+    events->antenna[events->count] = antenna;
+    events->state[events->count]   = state;
+    events->count++;
+}
+
+static void expect_deploy_status(uint16_t * status)
+{
+    expect_value(__wrap_ioctl, addr, ANTS_PRIMARY);
+    expect_value(__wrap_write, cmd, GET_STATUS);
+    expect_value(__wrap_ioctl, addr, ANTS_PRIMARY);
+    will_return(__wrap_read, sizeof(uint16_t));
+    will_return(__wrap_read, status);
+}
+
+static void test_monitor(void ** arg)
+{
+    ants_monitor_config config = {.antennas = 0x0F, .timeout = 5000,
+                                  .min_interval = 1, .max_interval = 10 };
+    ants_monitor_report report;
+    monitor_events      events = { 0 };
+    eventfd_t           count;
+    int                 fd;
+
+    uint16_t status[3] = {
+        ANT_1_NOT_DEPLOYED | ANT_1_ACTIVE | ANT_2_NOT_DEPLOYED | ANT_2_ACTIVE
+            | ANT_3_NOT_DEPLOYED | ANT_3_ACTIVE | ANT_4_NOT_DEPLOYED | ANT_4_ACTIVE,
+        ANT_3_NOT_DEPLOYED | ANT_3_ACTIVE | ANT_4_NOT_DEPLOYED | ANT_4_STOPPED_TIME,
+        ANT_4_NOT_DEPLOYED | ANT_4_STOPPED_TIME
+    };
+
+    for (int i = 0; i < 3; i++)
+    {
+        expect_deploy_status(&status[i]);
+    }
+
+    assert_int_equal(k_ants_monitor_start(&config, monitor_cb, &events, &fd),
+                     ANTS_OK);
+    assert_int_equal(k_ants_monitor_wait(5000), ANTS_OK);
+
+    /* Four initial states, three changes, one change and completion */
+    assert_int_equal(eventfd_read(fd, &count), 0);
+    assert_int_equal(count, 9);
+
+    assert_int_equal(events.count, 8);
+    assert_int_equal(events.antenna[4], ANT_1);
+    assert_int_equal(events.state[4], ANTS_DEPLOY_DEPLOYED);
+    assert_int_equal(events.antenna[6], ANT_4);
+    assert_int_equal(events.state[6], ANTS_DEPLOY_TIMED_OUT);
+    assert_int_equal(events.antenna[7], ANT_3);
+    assert_int_equal(events.state[7], ANTS_DEPLOY_DEPLOYED);
+
+    will_return(__wrap_close, 0);
+    assert_int_equal(k_ants_monitor_stop(&report), ANTS_OK);
+
+    assert_true(report.complete);
+    assert_false(report.running);
+    assert_int_equal(report.polls, 3);
+    assert_int_equal(report.errors, 0);
+    assert_int_equal(report.deploy_status, status[2]);
+    assert_int_equal(report.state[ANT_1], ANTS_DEPLOY_DEPLOYED);
+    assert_int_equal(report.state[ANT_4], ANTS_DEPLOY_TIMED_OUT);
+    assert_true(report.active_at[ANT_3] <= report.finished_at[ANT_3]);
+    assert_true(report.finished_at[ANT_1] <= report.finished_at[ANT_3]);
+    assert_int_not_equal(report.finished_at[ANT_3], ANTS_MONITOR_NEVER);
+}
+
+static void test_monitor_timeout(void ** arg)
+{
+    ants_monitor_config config = {.antennas = 0x01, .timeout = 1,
+                                  .min_interval = 1000, .max_interval = 1000 };
+    ants_monitor_report report;
+    uint16_t            status = ANT_1_NOT_DEPLOYED;
+
+    expect_deploy_status(&status);
+
+    assert_int_equal(k_ants_monitor_start(&config, NULL, NULL, NULL), ANTS_OK);
+    assert_int_equal(k_ants_monitor_wait(5000), ANTS_OK);
+
+    will_return(__wrap_close, 0);
+    assert_int_equal(k_ants_monitor_stop(&report), ANTS_OK);
+
+    assert_false(report.complete);
+    assert_int_equal(report.polls, 1);
+    assert_int_equal(report.state[ANT_1], ANTS_DEPLOY_STOWED);
+    assert_int_equal(report.active_at[ANT_1], ANTS_MONITOR_NEVER);
+    assert_int_equal(report.finished_at[ANT_1], ANTS_MONITOR_NEVER);
+}
+
+static void test_monitor_power(void ** arg)
+{
+    ants_monitor_config config = {.antennas = 0x01, .timeout = 250,
+                                  .min_interval = 100, .max_interval = 100 };
+    ants_monitor_report report;
+    uint16_t            status = ANT_1_NOT_DEPLOYED;
+
+    /* Polls every 400ms in safe mode, so the timeout is hit on the second */
+    assert_int_equal(k_power_update(POWER_MODE_SAFE, 0, NULL), POWER_OK);
+
+    expect_deploy_status(&status);
+    expect_deploy_status(&status);
+
+    assert_int_equal(k_ants_monitor_start(&config, NULL, NULL, NULL), ANTS_OK);
+    assert_int_equal(k_ants_monitor_wait(5000), ANTS_OK);
+
+    will_return(__wrap_close, 0);
+    assert_int_equal(k_ants_monitor_stop(&report), ANTS_OK);
+
+    assert_int_equal(k_power_update(POWER_MODE_NORMAL, 0, NULL), POWER_OK);
+
+    assert_false(report.complete);
+    assert_int_equal(report.polls, 2);
+    assert_true(report.elapsed >= 400);
+}
+
+static void test_monitor_stop(void ** arg)
+{
+    ants_monitor_config config = {.antennas = 0x03, .timeout = 60000,
+                                  .min_interval = 60000, .max_interval = 60000 };
+    ants_monitor_report report;
+    uint16_t            status = ANT_1_NOT_DEPLOYED | ANT_1_ACTIVE | ANT_2_NOT_DEPLOYED;
+    eventfd_t           count;
+    int                 fd;
+
+    expect_deploy_status(&status);
+
+    assert_int_equal(k_ants_monitor_start(&config, NULL, NULL, &fd), ANTS_OK);
+
+    /* Blocks until the first poll has been made */
+    assert_int_equal(eventfd_read(fd, &count), 0);
+    assert_int_equal(count, 2);
+
+    assert_int_equal(k_ants_monitor_wait(1), ANTS_ERROR);
+    assert_int_equal(k_ants_monitor_start(&config, NULL, NULL, &fd), ANTS_ERROR);
+
+    will_return(__wrap_close, 0);
+    assert_int_equal(k_ants_monitor_stop(&report), ANTS_OK);
+
+    assert_false(report.running);
+    assert_false(report.complete);
+    assert_int_equal(report.state[ANT_1], ANTS_DEPLOY_ACTIVE);
+    assert_int_not_equal(report.active_at[ANT_1], ANTS_MONITOR_NEVER);
+}
+
+static void test_monitor_bad_args(void ** arg)
+{
+    ants_monitor_config config = {.antennas = 0, .timeout = 1000,
+                                  .min_interval = 10, .max_interval = 100 };
+
+    assert_int_equal(k_ants_monitor_start(NULL, NULL, NULL, NULL), ANTS_ERROR_CONFIG);
+    assert_int_equal(k_ants_monitor_start(&config, NULL, NULL, NULL), ANTS_ERROR_CONFIG);
+
+    config.antennas = 0x1F;
+    assert_int_equal(k_ants_monitor_start(&config, NULL, NULL, NULL), ANTS_ERROR_CONFIG);
+
+    config.antennas     = 0x01;
+    config.max_interval = 1;
+    assert_int_equal(k_ants_monitor_start(&config, NULL, NULL, NULL), ANTS_ERROR_CONFIG);
+
+    assert_int_equal(k_ants_monitor_wait(1), ANTS_ERROR_CONFIG);
+    assert_int_equal(k_ants_monitor_stop(NULL), ANTS_ERROR);
+}
+
+static void test_failover_disabled(void ** arg)
+{
+    uint32_t resp;
+
+    expect_value(__wrap_ioctl, addr, ANTS_PRIMARY);
+    expect_value(__wrap_write, cmd, GET_UPTIME_SYS);
+    expect_value(__wrap_ioctl, addr, ANTS_PRIMARY);
+    will_return(__wrap_read, -1);
+
+    assert_int_equal(k_ants_get_uptime(&resp), ANTS_ERROR);
+    assert_int_equal(k_ants_get_controller(), PRIMARY);
+}
+
+static void test_failover_command(void ** arg)
+{
+    ants_health_config config = {.interval = 0, .max_failures = 1 };
+    ants_health        health;
+    uint32_t           resp;
+
+    assert_int_equal(k_ants_health_start(&config), ANTS_OK);
+
+    /* The primary doesn't answer, so the command is retried on the secondary */
+    expect_value(__wrap_ioctl, addr, ANTS_PRIMARY);
+    expect_value(__wrap_write, cmd, GET_UPTIME_SYS);
+    expect_value(__wrap_ioctl, addr, ANTS_PRIMARY);
+    will_return(__wrap_read, -1);
+
+    expect_value(__wrap_ioctl, addr, ANTS_SECONDARY);
+    expect_value(__wrap_write, cmd, GET_UPTIME_SYS);
+    expect_value(__wrap_ioctl, addr, ANTS_SECONDARY);
+    will_return(__wrap_read, sizeof(uptime));
+    will_return(__wrap_read, &uptime);
+
+    assert_int_equal(k_ants_get_uptime(&resp), ANTS_OK);
+    assert_int_equal(resp, uptime);
+    assert_int_equal(k_ants_get_controller(), SECONDARY);
+
+    assert_int_equal(k_ants_get_health(PRIMARY, &health), ANTS_OK);
+    assert_false(health.alive);
+    assert_int_equal(health.failures, 1);
+    assert_int_equal(health.failovers, 1);
+
+    /* Later commands go straight to the secondary */
+    expect_value(__wrap_ioctl, addr, ANTS_SECONDARY);
+    expect_value(__wrap_write, cmd, ARM_ANTS);
+    assert_int_equal(k_ants_arm(), ANTS_OK);
+
+    assert_int_equal(k_ants_health_stop(), ANTS_OK);
+}
+
+static void test_failover_deploy(void ** arg)
+{
+    ants_health_config config = {.interval = 0, .max_failures = 1 };
+
+    assert_int_equal(k_ants_health_start(&config), ANTS_OK);
+
+    expect_value(__wrap_ioctl, addr, ANTS_PRIMARY);
+    expect_value(__wrap_write, cmd, ARM_ANTS);
+    assert_int_equal(k_ants_arm(), ANTS_OK);
+
+    /* The primary dies mid-deployment. Only it was armed, so nothing is retried */
+    expect_value(__wrap_ioctl, addr, ANTS_PRIMARY);
+    expect_value(__wrap_write, cmd, DEPLOY_2);
+    write_failures = 1;
+    assert_int_equal(k_ants_deploy(ANT_2, false, 10), ANTS_ERROR_NOT_ARMED);
+    assert_int_equal(k_ants_get_controller(), SECONDARY);
+
+    /* Nothing is sent until the secondary has been armed */
+    assert_int_equal(k_ants_deploy(ANT_2, false, 10), ANTS_ERROR_NOT_ARMED);
+    assert_int_equal(k_ants_auto_deploy(10), ANTS_ERROR_NOT_ARMED);
+
+    expect_value(__wrap_ioctl, addr, ANTS_SECONDARY);
+    expect_value(__wrap_write, cmd, ARM_ANTS);
+    assert_int_equal(k_ants_arm(), ANTS_OK);
+
+    expect_value(__wrap_ioctl, addr, ANTS_SECONDARY);
+    expect_value(__wrap_write, cmd, DEPLOY_2);
+    assert_int_equal(k_ants_deploy(ANT_2, false, 10), ANTS_OK);
+
+    assert_int_equal(k_ants_health_stop(), ANTS_OK);
+}
+
+static void test_failover_arm(void ** arg)
+{
+    ants_health_config config = {.interval = 0, .max_failures = 1 };
+
+    assert_int_equal(k_ants_health_start(&config), ANTS_OK);
+
+    /* Arming isn't retried either, since the caller needs to know which controller is armed */
+    expect_value(__wrap_ioctl, addr, ANTS_PRIMARY);
+    expect_value(__wrap_write, cmd, ARM_ANTS);
+    write_failures = 1;
+    assert_int_equal(k_ants_arm(), ANTS_ERROR_NOT_ARMED);
+    assert_int_equal(k_ants_get_controller(), SECONDARY);
+
+    expect_value(__wrap_ioctl, addr, ANTS_SECONDARY);
+    expect_value(__wrap_write, cmd, ARM_ANTS);
+    assert_int_equal(k_ants_arm(), ANTS_OK);
+
+    expect_value(__wrap_ioctl, addr, ANTS_SECONDARY);
+    expect_value(__wrap_write, cmd, AUTO_DEPLOY);
+    assert_int_equal(k_ants_auto_deploy(10), ANTS_OK);
+
+    assert_int_equal(k_ants_health_stop(), ANTS_OK);
+}
+
+static void test_health_probe(void ** arg)
+{
+    ants_health_config config = {.interval = 60000, .max_failures = 1 };
+    ants_health        health;
+
+    assert_int_equal(k_ants_health_start(NULL), ANTS_ERROR_CONFIG);
+
+    /* The first probe is made before k_ants_health_start returns */
+    expect_value(__wrap_ioctl, addr, ANTS_PRIMARY);
+    expect_value(__wrap_write, cmd, GET_UPTIME_SYS);
+    expect_value(__wrap_ioctl, addr, ANTS_PRIMARY);
+    will_return(__wrap_read, -1);
+
+    expect_value(__wrap_ioctl, addr, ANTS_SECONDARY);
+    expect_value(__wrap_write, cmd, GET_UPTIME_SYS);
+    expect_value(__wrap_ioctl, addr, ANTS_SECONDARY);
+    will_return(__wrap_read, sizeof(uptime));
+    will_return(__wrap_read, &uptime);
+
+    expect_value(__wrap_ioctl, addr, ANTS_SECONDARY);
+    expect_value(__wrap_write, cmd, GET_TELEMETRY);
+    expect_value(__wrap_ioctl, addr, ANTS_SECONDARY);
+    will_return(__wrap_read, sizeof(system_telem));
+    will_return(__wrap_read, &system_telem);
+
+    assert_int_equal(k_ants_health_start(&config), ANTS_OK);
+
+    assert_int_equal(k_ants_get_controller(), SECONDARY);
+
+    assert_int_equal(k_ants_get_health(PRIMARY, &health), ANTS_OK);
+    assert_false(health.alive);
+    assert_int_equal(health.probes, 1);
+    assert_int_equal(health.failovers, 1);
+
+    assert_int_equal(k_ants_get_health(SECONDARY, &health), ANTS_OK);
+    assert_true(health.alive);
+    assert_int_equal(health.probes, 1);
+    assert_int_equal(health.uptime, uptime);
+    assert_memory_equal(&health.telem, &system_telem, sizeof(system_telem));
+
+    assert_int_equal(k_ants_get_health(7, &health), ANTS_ERROR_CONFIG);
+
+    assert_int_equal(k_ants_health_stop(), ANTS_OK);
+}
+
+static void test_health_probe_power(void ** arg)
+{
+    ants_health_config config = {.interval = 40, .max_failures = 0 };
+    ants_health        health;
+    struct timespec    delay  = {.tv_sec = 0, .tv_nsec = 100000000 };
+
+    assert_int_equal(k_power_update(POWER_MODE_SAFE, 0, NULL), POWER_OK);
+
+    for (int i = 0; i < 2; i++)
+    {
+        uint8_t addr = (i == 0) ? ANTS_PRIMARY : ANTS_SECONDARY;
+
+        expect_value(__wrap_ioctl, addr, addr);
+        expect_value(__wrap_write, cmd, GET_UPTIME_SYS);
+        expect_value(__wrap_ioctl, addr, addr);
+        will_return(__wrap_read, sizeof(uptime));
+        will_return(__wrap_read, &uptime);
+
+        expect_value(__wrap_ioctl, addr, addr);
+        expect_value(__wrap_write, cmd, GET_TELEMETRY);
+        expect_value(__wrap_ioctl, addr, addr);
+        will_return(__wrap_read, sizeof(system_telem));
+        will_return(__wrap_read, &system_telem);
+    }
+
+    assert_int_equal(k_ants_health_start(&config), ANTS_OK);
+
+    /* Kicks are still due every 40ms, but probes only every 160ms */
+    nanosleep(&delay, NULL);
+
+    assert_int_equal(k_ants_health_stop(), ANTS_OK);
+    assert_int_equal(k_power_update(POWER_MODE_NORMAL, 0, NULL), POWER_OK);
+
+    assert_int_equal(k_ants_get_health(PRIMARY, &health), ANTS_OK);
+    assert_int_equal(health.probes, 1);
+    assert_int_equal(k_ants_get_health(SECONDARY, &health), ANTS_OK);
+    assert_int_equal(health.probes, 1);
+}
+
 static void test_passthrough_null_tx(void ** arg)
 {
     KANTSStatus ret;
@@ -727,6 +1172,21 @@ int main(void)
         cmocka_unit_test_setup_teardown(test_get_activation_time_4, init, term),
         cmocka_unit_test_setup_teardown(test_get_activation_time_fake, init,
                                         term),
+        cmocka_unit_test_setup_teardown(test_get_snapshot, init, term),
+        cmocka_unit_test_setup_teardown(test_get_snapshot_fail, init, term),
+        cmocka_unit_test_setup_teardown(test_get_snapshot_null, init, term),
+        cmocka_unit_test(test_decode_deploy_state),
+        cmocka_unit_test_setup_teardown(test_monitor, init, term),
+        cmocka_unit_test_setup_teardown(test_monitor_timeout, init, term),
+        cmocka_unit_test_setup_teardown(test_monitor_power, init, term),
+        cmocka_unit_test_setup_teardown(test_monitor_stop, init, term),
+        cmocka_unit_test_setup_teardown(test_monitor_bad_args, init, term),
+        cmocka_unit_test_setup_teardown(test_failover_disabled, init, term),
+        cmocka_unit_test_setup_teardown(test_failover_command, init, term),
+        cmocka_unit_test_setup_teardown(test_failover_deploy, init, term),
+        cmocka_unit_test_setup_teardown(test_failover_arm, init, term),
+        cmocka_unit_test_setup_teardown(test_health_probe, init, term),
+        cmocka_unit_test_setup_teardown(test_health_probe_power, init, term),
         cmocka_unit_test_setup_teardown(test_passthrough_null_tx, init, term),
         cmocka_unit_test_setup_teardown(test_passthrough_zero_tx_len, init,
                                         term),
@@ -48,6 +48,9 @@ int __wrap_ioctl(int fd, unsigned long request, long addr, ...)
     return 0;
 }
 
+/* Number of upcoming writes which should fail */
+int write_failures = 0;
+
 /* Returns number of bytes "written" or -1 on failure */
 ssize_t __wrap_write(int fd, const char * buf, size_t count)
 {
@@ -55,6 +58,13 @@ ssize_t __wrap_write(int fd, const char * buf, size_t count)
     uint8_t cmd = buf[0];
     check_expected(cmd);
 
+    if (write_failures > 0)
+    {
+        write_failures--;
+        errno = EREMOTEIO;
+        return -1;
+    }
+
     return (ssize_t) count;
 }
 
@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2018 Kubos Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * @addtogroup IMTQ_API
+ * @{
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+/**
+ * CBOR telemetry map keys
+ *
+ * The values of these keys are part of the downlink format and must never
+ * be changed. New keys should only ever be added.
+ *
+ * Configuration parameters in ::DEBUG telemetry are keyed by their parameter
+ * ID (ex. ::MTM_SELECT), and self-test results by ::IMTQ_TELEM_TEST_KEY
+ */
+typedef enum {
+    IMTQ_TELEM_SYSTEM_MODE                  = 1,  /**< ::ADCSMode, or `null` if the iMTQ is offline */
+    IMTQ_TELEM_SYSTEM_ERROR                 = 2,  /**< Error encountered during previous iteration (bool) */
+    IMTQ_TELEM_SYSTEM_CONFIGURED            = 3,  /**< Parameter updated since system startup (bool) */
+    IMTQ_TELEM_SYSTEM_UPTIME                = 4,  /**< System uptime in seconds */
+
+    IMTQ_TELEM_SUPPLY_VOLTAGE_DIGITAL_RAW   = 8,  /**< ::imtq_housekeeping_raw.voltage_d */
+    IMTQ_TELEM_SUPPLY_VOLTAGE_ANALOG_RAW    = 9,  /**< ::imtq_housekeeping_raw.voltage_a */
+    IMTQ_TELEM_SUPPLY_CURRENT_DIGITAL_RAW   = 10, /**< ::imtq_housekeeping_raw.current_d */
+    IMTQ_TELEM_SUPPLY_CURRENT_ANALOG_RAW    = 11, /**< ::imtq_housekeeping_raw.current_a */
+    IMTQ_TELEM_COIL_CURRENT_X_RAW           = 12, /**< ::imtq_housekeeping_raw.coil_current */
+    IMTQ_TELEM_COIL_CURRENT_Y_RAW           = 13,
+    IMTQ_TELEM_COIL_CURRENT_Z_RAW           = 14,
+    IMTQ_TELEM_COIL_TEMP_X_RAW              = 15, /**< ::imtq_housekeeping_raw.coil_temp */
+    IMTQ_TELEM_COIL_TEMP_Y_RAW              = 16,
+    IMTQ_TELEM_COIL_TEMP_Z_RAW              = 17,
+    IMTQ_TELEM_MCU_TEMP_RAW                 = 18, /**< ::imtq_housekeeping_raw.mcu_temp */
+
+    IMTQ_TELEM_SUPPLY_VOLTAGE_DIGITAL_ENG   = 24, /**< ::imtq_housekeeping_eng.voltage_d */
+    IMTQ_TELEM_SUPPLY_VOLTAGE_ANALOG_ENG    = 25, /**< ::imtq_housekeeping_eng.voltage_a */
+    IMTQ_TELEM_SUPPLY_CURRENT_DIGITAL_ENG   = 26, /**< ::imtq_housekeeping_eng.current_d */
+    IMTQ_TELEM_SUPPLY_CURRENT_ANALOG_ENG    = 27, /**< ::imtq_housekeeping_eng.current_a */
+    IMTQ_TELEM_COIL_CURRENT_X_ENG           = 28, /**< ::imtq_housekeeping_eng.coil_current */
+    IMTQ_TELEM_COIL_CURRENT_Y_ENG           = 29,
+    IMTQ_TELEM_COIL_CURRENT_Z_ENG           = 30,
+    IMTQ_TELEM_COIL_TEMP_X_ENG              = 31, /**< ::imtq_housekeeping_eng.coil_temp */
+    IMTQ_TELEM_COIL_TEMP_Y_ENG              = 32,
+    IMTQ_TELEM_COIL_TEMP_Z_ENG              = 33,
+    IMTQ_TELEM_MCU_TEMP_ENG                 = 34, /**< ::imtq_housekeeping_eng.mcu_temp */
+
+    IMTQ_TELEM_DETUMBLE_CALIB_MTM_X         = 40, /**< ::imtq_detumble.mtm_calib */
+    IMTQ_TELEM_DETUMBLE_CALIB_MTM_Y         = 41,
+    IMTQ_TELEM_DETUMBLE_CALIB_MTM_Z         = 42,
+    IMTQ_TELEM_DETUMBLE_FILTER_MTM_X        = 43, /**< ::imtq_detumble.mtm_filter */
+    IMTQ_TELEM_DETUMBLE_FILTER_MTM_Y        = 44,
+    IMTQ_TELEM_DETUMBLE_FILTER_MTM_Z        = 45,
+    IMTQ_TELEM_DETUMBLE_BDOT_X              = 46, /**< ::imtq_detumble.bdot */
+    IMTQ_TELEM_DETUMBLE_BDOT_Y              = 47,
+    IMTQ_TELEM_DETUMBLE_BDOT_Z              = 48,
+    IMTQ_TELEM_DETUMBLE_DIPOLE_X            = 49, /**< ::imtq_detumble.dipole */
+    IMTQ_TELEM_DETUMBLE_DIPOLE_Y            = 50,
+    IMTQ_TELEM_DETUMBLE_DIPOLE_Z            = 51,
+    IMTQ_TELEM_DETUMBLE_CMD_CURRENT_X       = 52, /**< ::imtq_detumble.cmd_current */
+    IMTQ_TELEM_DETUMBLE_CMD_CURRENT_Y       = 53,
+    IMTQ_TELEM_DETUMBLE_CMD_CURRENT_Z       = 54,
+    IMTQ_TELEM_DETUMBLE_COIL_CURRENT_X      = 55, /**< ::imtq_detumble.coil_current */
+    IMTQ_TELEM_DETUMBLE_COIL_CURRENT_Y      = 56,
+    IMTQ_TELEM_DETUMBLE_COIL_CURRENT_Z      = 57,
+
+    IMTQ_TELEM_MTM_ACTUATING                = 64, /**< Coils actuating during MTM measurement (bool) */
+    IMTQ_TELEM_MTM_X_RAW                    = 65, /**< Raw MTM measurement */
+    IMTQ_TELEM_MTM_Y_RAW                    = 66,
+    IMTQ_TELEM_MTM_Z_RAW                    = 67,
+    IMTQ_TELEM_MTM_X_CALIB                  = 68, /**< Calibrated MTM measurement */
+    IMTQ_TELEM_MTM_Y_CALIB                  = 69,
+    IMTQ_TELEM_MTM_Z_CALIB                  = 70,
+
+    IMTQ_TELEM_DIPOLE_X                     = 72, /**< Commanded actuation dipole */
+    IMTQ_TELEM_DIPOLE_Y                     = 73,
+    IMTQ_TELEM_DIPOLE_Z                     = 74
+} imtq_telem_key;
+
+/**
+ * Self-test result fields, used to build ::IMTQ_TELEM_TEST_KEY
+ */
+typedef enum {
+    IMTQ_TELEM_TEST_ERROR,                  /**< ::imtq_test_result.error */
+    IMTQ_TELEM_TEST_MTM_RAW_X,              /**< ::imtq_test_result.mtm_raw */
+    IMTQ_TELEM_TEST_MTM_RAW_Y,
+    IMTQ_TELEM_TEST_MTM_RAW_Z,
+    IMTQ_TELEM_TEST_MTM_CALIB_X,            /**< ::imtq_test_result.mtm_calib */
+    IMTQ_TELEM_TEST_MTM_CALIB_Y,
+    IMTQ_TELEM_TEST_MTM_CALIB_Z,
+    IMTQ_TELEM_TEST_COIL_CURRENT_X,         /**< ::imtq_test_result.coil_current */
+    IMTQ_TELEM_TEST_COIL_CURRENT_Y,
+    IMTQ_TELEM_TEST_COIL_CURRENT_Z,
+    IMTQ_TELEM_TEST_COIL_TEMP_X,            /**< ::imtq_test_result.coil_temp */
+    IMTQ_TELEM_TEST_COIL_TEMP_Y,
+    IMTQ_TELEM_TEST_COIL_TEMP_Z
+} imtq_telem_test_field;
+
+/**
+ * CBOR telemetry map key for a self-test result field
+ * @param step ::imtq_test_result.step
+ * @param field ::imtq_telem_test_field
+ */
+#define IMTQ_TELEM_TEST_KEY(step, field) (0x100 | ((step) << 4) | (field))
+
+/**
+ * Read ADCS telemetry values and encode them as a CBOR map
+ *
+ * The map is written directly into `buffer` using the integer keys from
+ * ::imtq_telem_key, rather than building a JSON structure first
+ * @param [in] type Telemetry packet to read
+ * @param [out] buffer Pointer to storage for the encoded telemetry
+ * @param [in] size Size of `buffer`
+ * @param [out] len Number of bytes used. If `buffer` was too small, the number of bytes required
+ * @return KADCSStatus `ADCS_OK` if OK, `ADCS_ERROR_CONFIG` if `buffer` is too small, error otherwise
+ */
+KADCSStatus k_adcs_get_telemetry_cbor(ADCSTelemType type, uint8_t * buffer,
+                                      size_t size, size_t * len);
+/**
+ * Encode the valid groups of a nominal telemetry snapshot as a CBOR map
+ * @param [in] snapshot Pointer to telemetry fetched by ::k_adcs_get_nominal_snapshot
+ * @param [out] buffer Pointer to storage for the encoded telemetry
+ * @param [in] size Size of `buffer`
+ * @param [out] len Number of bytes used. If `buffer` was too small, the number of bytes required
+ * @return KADCSStatus `ADCS_OK` if OK, `ADCS_ERROR_CONFIG` if `buffer` is too small, error otherwise
+ */
+KADCSStatus k_adcs_nominal_to_cbor(const imtq_nominal_snapshot * snapshot,
+                                   uint8_t * buffer, size_t size, size_t * len);
+
+/* @} */
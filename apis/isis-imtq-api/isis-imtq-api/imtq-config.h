@@ -190,6 +190,156 @@ typedef struct {
     imtq_config_value value;        /**< Current value of requested parameter */
 } __attribute__((packed)) imtq_config_resp;
 
+/**
+ * Configuration parameter value types.
+ * The values match the type code held in the top four bits of each parameter ID
+ */
+typedef enum {
+    IMTQ_PARAM_INT8 = 0x1,          /**< Signed single-byte value */
+    IMTQ_PARAM_UINT8,               /**< Unsigned single-byte value */
+    IMTQ_PARAM_INT16,               /**< Signed byte-pair value */
+    IMTQ_PARAM_UINT16,              /**< Unsigned byte-pair value */
+    IMTQ_PARAM_INT32,               /**< Signed four-byte value */
+    IMTQ_PARAM_UINT32,              /**< Unsigned four-byte value */
+    IMTQ_PARAM_FLOAT,               /**< IEEE754 single-precision floating point value */
+    IMTQ_PARAM_INT64,               /**< Signed eight-byte value */
+    IMTQ_PARAM_UINT64,              /**< Unsigned eight-byte value */
+    IMTQ_PARAM_DOUBLE               /**< IEEE754 double-precision floating point value */
+} imtq_param_type;
+
+/** \cond WE DO NOT WANT TO HAVE THESE IN OUR GENERATED DOCS */
+/*
+ * All known configuration parameters, sorted by name: X(NAME, CODE, TYPE)
+ *
+ * The code is written out in lowercase hex because its text is also used as the
+ * parameter's telemetry key
+ */
+#define IMTQ_PARAM_LIST(X) \
+    X(ADC_COIL_CURRENT_BIAS_X, 0x301c, INT16) \
+    X(ADC_COIL_CURRENT_BIAS_Y, 0x301d, INT16) \
+    X(ADC_COIL_CURRENT_BIAS_Z, 0x301e, INT16) \
+    X(ADC_COIL_CURRENT_DIV_X,  0x3022, INT16) \
+    X(ADC_COIL_CURRENT_DIV_Y,  0x3023, INT16) \
+    X(ADC_COIL_CURRENT_DIV_Z,  0x3024, INT16) \
+    X(ADC_COIL_CURRENT_MULT_X, 0x301f, INT16) \
+    X(ADC_COIL_CURRENT_MULT_Y, 0x3020, INT16) \
+    X(ADC_COIL_CURRENT_MULT_Z, 0x3021, INT16) \
+    X(ADC_COIL_TEMP_BIAS_X,    0x3025, INT16) \
+    X(ADC_COIL_TEMP_BIAS_Y,    0x3026, INT16) \
+    X(ADC_COIL_TEMP_BIAS_Z,    0x3027, INT16) \
+    X(ADC_COIL_TEMP_DIV_X,     0x302b, INT16) \
+    X(ADC_COIL_TEMP_DIV_Y,     0x302c, INT16) \
+    X(ADC_COIL_TEMP_DIV_Z,     0x302d, INT16) \
+    X(ADC_COIL_TEMP_MULT_X,    0x3028, INT16) \
+    X(ADC_COIL_TEMP_MULT_Y,    0x3029, INT16) \
+    X(ADC_COIL_TEMP_MULT_Z,    0x302a, INT16) \
+    X(BDOT_GAIN,               0xa000, DOUBLE) \
+    X(COIL_AREA_X,             0xa00f, DOUBLE) \
+    X(COIL_AREA_Y,             0xa010, DOUBLE) \
+    X(COIL_AREA_Z,             0xa011, DOUBLE) \
+    X(COIL_CURRENT_LIMIT,      0x4000, UINT16) \
+    X(CURRENT_FEEDBACK_ENABLE, 0x2001, UINT8) \
+    X(CURRENT_FEEDBACK_GAIN_X, 0x5000, INT32) \
+    X(CURRENT_FEEDBACK_GAIN_Y, 0x5001, INT32) \
+    X(CURRENT_FEEDBACK_GAIN_Z, 0x5002, INT32) \
+    X(CURRENT_MAP_TEMP_T1,     0x3000, INT16) \
+    X(CURRENT_MAP_TEMP_T2,     0x3001, INT16) \
+    X(CURRENT_MAP_TEMP_T3,     0x3002, INT16) \
+    X(CURRENT_MAP_TEMP_T4,     0x3003, INT16) \
+    X(CURRENT_MAP_TEMP_T5,     0x3004, INT16) \
+    X(CURRENT_MAP_TEMP_T6,     0x3005, INT16) \
+    X(CURRENT_MAP_TEMP_T7,     0x3006, INT16) \
+    X(CURRENT_MAX_X_T1,        0x3007, INT16) \
+    X(CURRENT_MAX_X_T2,        0x3008, INT16) \
+    X(CURRENT_MAX_X_T3,        0x3009, INT16) \
+    X(CURRENT_MAX_X_T4,        0x300a, INT16) \
+    X(CURRENT_MAX_X_T5,        0x300b, INT16) \
+    X(CURRENT_MAX_X_T6,        0x300c, INT16) \
+    X(CURRENT_MAX_X_T7,        0x300d, INT16) \
+    X(CURRENT_MAX_Y_T1,        0x300e, INT16) \
+    X(CURRENT_MAX_Y_T2,        0x300f, INT16) \
+    X(CURRENT_MAX_Y_T3,        0x3010, INT16) \
+    X(CURRENT_MAX_Y_T4,        0x3011, INT16) \
+    X(CURRENT_MAX_Y_T5,        0x3012, INT16) \
+    X(CURRENT_MAX_Y_T6,        0x3013, INT16) \
+    X(CURRENT_MAX_Y_T7,        0x3014, INT16) \
+    X(CURRENT_MAX_Z_T1,        0x3015, INT16) \
+    X(CURRENT_MAX_Z_T2,        0x3016, INT16) \
+    X(CURRENT_MAX_Z_T3,        0x3017, INT16) \
+    X(CURRENT_MAX_Z_T4,        0x3018, INT16) \
+    X(CURRENT_MAX_Z_T5,        0x3019, INT16) \
+    X(CURRENT_MAX_Z_T6,        0x301a, INT16) \
+    X(CURRENT_MAX_Z_T7,        0x301b, INT16) \
+    X(DETUMBLE_FREQUENCY,      0x2000, UINT8) \
+    X(HW_CONFIG,               0x2800, UINT8) \
+    X(MTM_BIAS_X,              0xa00a, DOUBLE) \
+    X(MTM_BIAS_Y,              0xa00b, DOUBLE) \
+    X(MTM_BIAS_Z,              0xa00c, DOUBLE) \
+    X(MTM_EXTERNAL_MAP_X,      0x2008, UINT8) \
+    X(MTM_EXTERNAL_MAP_Y,      0x2009, UINT8) \
+    X(MTM_EXTERNAL_MAP_Z,      0x200a, UINT8) \
+    X(MTM_EXTERNAL_TIME,       0x2004, UINT8) \
+    X(MTM_FILTER_SENSITIVITY,  0xa00d, DOUBLE) \
+    X(MTM_FILTER_WEIGHT,       0xa00e, DOUBLE) \
+    X(MTM_INTERNAL_MAP_X,      0x2005, UINT8) \
+    X(MTM_INTERNAL_MAP_Y,      0x2006, UINT8) \
+    X(MTM_INTERNAL_MAP_Z,      0x2007, UINT8) \
+    X(MTM_INTERNAL_TIME,       0x2003, UINT8) \
+    X(MTM_MATRIX_R1_C1,        0xa001, DOUBLE) \
+    X(MTM_MATRIX_R1_C2,        0xa002, DOUBLE) \
+    X(MTM_MATRIX_R1_C3,        0xa003, DOUBLE) \
+    X(MTM_MATRIX_R2_C1,        0xa004, DOUBLE) \
+    X(MTM_MATRIX_R2_C2,        0xa005, DOUBLE) \
+    X(MTM_MATRIX_R2_C3,        0xa006, DOUBLE) \
+    X(MTM_MATRIX_R3_C1,        0xa007, DOUBLE) \
+    X(MTM_MATRIX_R3_C2,        0xa008, DOUBLE) \
+    X(MTM_MATRIX_R3_C3,        0xa009, DOUBLE) \
+    X(MTM_SELECT,              0x2002, UINT8) \
+    X(SLAVE_ADDRESS,           0x4800, UINT16) \
+    X(SOFTWARE_VERSION,        0x6800, UINT32) \
+    X(WATCHDOG_TIMEOUT,        0x2801, UINT8)
+
+/* Value types and the imtq_config_value member which stores them: X(TYPE, C_TYPE, MEMBER) */
+#define IMTQ_PARAM_TYPES(X) \
+    X(INT8,   int8_t,   int8_val) \
+    X(UINT8,  uint8_t,  uint8_val) \
+    X(INT16,  int16_t,  int16_val) \
+    X(UINT16, uint16_t, uint16_val) \
+    X(INT32,  int32_t,  int32_val) \
+    X(UINT32, uint32_t, uint32_val) \
+    X(FLOAT,  float,    float_val) \
+    X(INT64,  int64_t,  int64_val) \
+    X(UINT64, uint64_t, uint64_val) \
+    X(DOUBLE, double,   double_val)
+
+#define IMTQ_PARAM_INDEX(NAME, CODE, TYPE) IMTQ_PARAM_IDX_##NAME,
+/** \endcond */
+
+/**
+ * Position of each parameter in ::imtq_params
+ */
+typedef enum {
+    IMTQ_PARAM_LIST(IMTQ_PARAM_INDEX)
+    IMTQ_NUM_PARAMS                 /**< Number of known configuration parameters */
+} imtq_param_index;
+
+/**
+ * Configuration parameter descriptor
+ */
+typedef struct {
+    uint16_t id;                    /**< Parameter ID */
+    imtq_param_type type;           /**< Parameter value type */
+    const char * name;              /**< Parameter name (ex. "MTM_SELECT") */
+    const char * key;               /**< Parameter telemetry key (ex. "0x2002") */
+    void (*encode)(double value, imtq_config_value * out); /**< Store a value in the parameter's type */
+    double (*decode)(const imtq_config_value * value);     /**< Retrieve the parameter's value */
+} imtq_param_desc;
+
+/**
+ * Descriptors for all known configuration parameters, sorted by name
+ */
+extern const imtq_param_desc imtq_params[IMTQ_NUM_PARAMS];
+
 /* Configuration Commands */
 /**
  * Configure the ADCS
@@ -224,5 +374,25 @@ KADCSStatus k_imtq_set_param(uint16_t param, const imtq_config_value * value,
  * @return KADCSStatus `ADCS_OK` if OK, error otherwise
  */
 KADCSStatus k_imtq_reset_param(uint16_t param, imtq_config_resp * response);
+/**
+ * Look up a configuration parameter by ID
+ * @param [in] param ID of parameter
+ * @return Pointer to parameter descriptor, or `NULL` if the parameter is unknown
+ */
+const imtq_param_desc * k_imtq_find_param(uint16_t param);
+/**
+ * Look up a configuration parameter by name
+ * @param [in] name Name of parameter (ex. "MTM_SELECT")
+ * @return Pointer to parameter descriptor, or `NULL` if the parameter is unknown
+ */
+const imtq_param_desc * k_imtq_find_param_name(const char * name);
+
+/* Private functions */
+/**
+ * Look up a configuration parameter by JSON configuration key
+ * @param [in] key Parameter ID as a hex string (ex. "0x2003") or parameter name
+ * @return Pointer to parameter descriptor, or `NULL` if the parameter is unknown
+ */
+const imtq_param_desc * kprv_imtq_find_param_key(const char * key);
 
 /* @} */
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2018 Kubos Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * @addtogroup IMTQ_API
+ * @{
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+/**
+ * Maximum supported control loop rate, in Hz
+ */
+#define IMTQ_CONTROL_MAX_RATE 50
+
+/**
+ * Time allowed for the coils' field to decay once an actuation ends, before
+ * the next cycle's MTM measurement, in milliseconds
+ */
+#define IMTQ_CONTROL_SETTLE_TIME 4
+
+/**
+ * Control law callback, run once per control cycle
+ *
+ * @param [in] sample Calibrated magnetometer sample taken at the start of the cycle
+ * @param [out] dipole Dipole to actuate for this cycle, in [10<sup>-4</sup> Am<sup>2</sup>]
+ * @param [in] arg User argument given in ::imtq_control_config
+ * @return `true` if `dipole` should be actuated, `false` to skip actuation for this cycle
+ */
+typedef bool (*imtq_control_fn)(const imtq_mtm_sample * sample,
+                                imtq_axis_data * dipole, void * arg);
+
+/**
+ * Control loop configuration used by ::k_imtq_control_start
+ */
+typedef struct {
+    uint16_t rate;              /**< Loop rate in Hz (1 - ::IMTQ_CONTROL_MAX_RATE) */
+    uint16_t actuation_time;    /**< Time the coils should remain on after each actuation, in milliseconds. Must be non-zero, and leave room in the loop period for the cycle's 1ms MTM measurement plus ::IMTQ_CONTROL_SETTLE_TIME, so the coils are never on while measuring */
+    int priority;               /**< `SCHED_FIFO` priority to run the loop at. If zero, the default scheduling policy is used */
+    int cpu;                    /**< CPU to pin the loop thread to. If negative, the thread is not pinned */
+    bool lock_memory;           /**< Lock all current and future pages into memory while the loop runs */
+    imtq_control_fn compute;    /**< Control law callback */
+    void * arg;                 /**< User argument passed to `compute` */
+} imtq_control_config;
+
+/**
+ * Control loop statistics returned by ::k_imtq_control_get_stats
+ */
+typedef struct {
+    uint32_t period;            /**< Configured loop period [microseconds] */
+    uint32_t cycles;            /**< Number of cycles which completed successfully */
+    uint32_t errors;            /**< Number of cycles which failed to measure or actuate */
+    uint32_t skipped;           /**< Number of cycles in which the control law declined to actuate */
+    uint32_t deadline_misses;   /**< Number of cycles which started late enough to skip a period, or which did not finish before the next deadline */
+    uint32_t latency_mean;      /**< Mean delay between a cycle's deadline and the loop waking up [microseconds] */
+    uint32_t latency_max;       /**< Largest delay between a cycle's deadline and the loop waking up [microseconds] */
+    uint32_t jitter_mean;       /**< Mean change in wake-up latency between consecutive cycles [microseconds] */
+    uint32_t jitter_max;        /**< Largest change in wake-up latency between consecutive cycles [microseconds] */
+    uint32_t exec_mean;         /**< Mean time from wake-up to actuation completing [microseconds] */
+    uint32_t exec_max;          /**< Longest time from wake-up to actuation completing [microseconds] */
+} imtq_control_stats;
+
+/**
+ * Start a fixed-rate measure-compute-actuate control loop
+ *
+ * Each cycle is released at an absolute deadline, so timing errors do not
+ * accumulate. The loop thread takes a calibrated MTM measurement, passes it to
+ * the control law and then actuates the resulting dipole.
+ *
+ * @note Real-time priorities and memory locking normally require the
+ * `CAP_SYS_NICE` and `CAP_IPC_LOCK` capabilities
+ * @param [in] config Pointer to loop configuration
+ * @return KADCSStatus `ADCS_OK` if OK, error otherwise
+ */
+KADCSStatus k_imtq_control_start(const imtq_control_config * config);
+/**
+ * Stop the control loop and turn off the coils
+ * @return KADCSStatus `ADCS_OK` if OK, error otherwise
+ */
+KADCSStatus k_imtq_control_stop(void);
+/**
+ * Get the statistics of the current (or most recent) control loop
+ * @param [out] stats Pointer to storage for statistics
+ * @return KADCSStatus `ADCS_OK` if OK, error otherwise
+ */
+KADCSStatus k_imtq_control_get_stats(imtq_control_stats * stats);
+
+/* @} */
@@ -21,6 +21,7 @@
 #pragma once
 
 #include <json.h>
+#include <stdbool.h>
 
 /** \cond WE DO NOT WANT TO HAVE THESE IN OUR GENERATED DOCS */
 /* Data Request Commands */
@@ -193,6 +194,68 @@ typedef struct {
     int16_t mcu_temp;                   /**< MCU temperature in [<sup>o</sup>C] */
 } __attribute__((packed)) imtq_housekeeping_eng;
 
+/**
+ * Conversion from a raw ADC value to an engineering value:
+ * `eng = ((raw - bias) * mult) / div`
+ */
+typedef struct {
+    int32_t bias;                       /**< ADC bias */
+    int32_t mult;                       /**< Pre-multiplier */
+    int32_t div;                        /**< Post-divider */
+} imtq_adc_conversion;
+
+/**
+ * Housekeeping ADC calibration used by ::k_imtq_convert_housekeeping, read
+ * from the `ADC_COIL_*` configuration parameters
+ */
+typedef struct {
+    imtq_adc_conversion coil_current[3];/**< Coil currents (X, Y, Z) */
+    imtq_adc_conversion coil_temp[3];   /**< Coil temperatures (X, Y, Z) */
+} imtq_housekeeping_cal;
+
+/**
+ *  @name Nominal Telemetry Groups
+ *  Field-mask values used to select which groups of measurements
+ *  ::k_adcs_get_nominal_snapshot should fetch
+ */
+/**@{*/
+#define NOMINAL_HOUSEKEEPING  0x01  /**< Raw housekeeping values, with the coil channels converted on the host */
+#define NOMINAL_DETUMBLE      0x02  /**< Data from the last detumble loop iteration */
+#define NOMINAL_MTM           0x04  /**< Current raw and calibrated MTM measurements */
+#define NOMINAL_DIPOLE        0x08  /**< Commanded actuation dipole */
+#define NOMINAL_ALL           0x0F  /**< All nominal telemetry groups */
+/**@}*/
+
+/**
+ * Time spent in each stage of ::k_adcs_get_nominal_snapshot, in microseconds.
+ * Stages which were not requested are reported as zero
+ */
+typedef struct {
+    uint32_t mtm_start;                 /**< Starting the MTM measurement */
+    uint32_t housekeeping;              /**< Fetching housekeeping data */
+    uint32_t detumble;                  /**< Fetching detumble data */
+    uint32_t dipole;                    /**< Fetching the commanded dipole */
+    uint32_t mtm_wait;                  /**< Waiting for the remainder of the MTM measurement time */
+    uint32_t mtm_read;                  /**< Fetching the MTM measurement results */
+    uint32_t total;                     /**< End-to-end collection time */
+} imtq_nominal_timing;
+
+/**
+ * Snapshot of the iMTQ's nominal telemetry returned by
+ * ::k_adcs_get_nominal_snapshot
+ */
+typedef struct {
+    uint8_t valid;                      /**< Mask of groups which were successfully fetched */
+    imtq_housekeeping_raw house_raw;    /**< Housekeeping data (raw ADC values) */
+    imtq_housekeeping_eng house_eng;    /**< Housekeeping data (engineering values) */
+    bool house_converted;               /**< `house_eng` was converted on the host, so only its coil channels are set */
+    imtq_detumble detumble;             /**< Data from the last detumble loop iteration */
+    imtq_mtm_msg mtm_raw;               /**< Current raw MTM measurement */
+    imtq_mtm_msg mtm_calib;             /**< Current calibrated MTM measurement */
+    imtq_dipole dipole;                 /**< Commanded actuation dipole */
+    imtq_nominal_timing timing;         /**< Time spent collecting each group */
+} imtq_nominal_snapshot;
+
 /* Data Request Commands */
 /**
  * Get the ADCS's power status
@@ -223,11 +286,33 @@ KADCSStatus k_adcs_get_spin(adcs_spin * data);
 /**
  * Read ADCS telemetry values
  * @note See specific ADCS API documentation for available telemetry types
+ *
+ * The new nodes are allocated from the same arena as `buffer` (see `json_mkobject_arena`),
+ * so a whole telemetry request can be freed at once with `json_arena_destroy`.
  * @param [in] type Telemetry packet to read
  * @param [out] buffer (Pointer to) structure which data should be copied to
  * @return KADCSStatus ADCS_OK if OK, error otherwise
  */
 KADCSStatus k_adcs_get_telemetry(ADCSTelemType type, JsonNode * buffer);
+/**
+ * Fetch the requested groups of nominal telemetry into a snapshot structure
+ *
+ * If requested, the MTM measurement is started first and its results are read
+ * last, so that the other groups are fetched while the MTM is integrating.
+ *
+ * Groups which fail to be read are not flagged in ::imtq_nominal_snapshot.valid
+ * @param [out] snapshot Pointer to storage for the telemetry
+ * @param [in] mask Bitmask of ::NOMINAL_ALL groups to fetch
+ * @return KADCSStatus `ADCS_OK` if OK, error otherwise
+ */
+KADCSStatus k_adcs_get_nominal_snapshot(imtq_nominal_snapshot * snapshot, uint8_t mask);
+/**
+ * Add the valid groups of a nominal telemetry snapshot to a JSON structure
+ * @param [in] snapshot Pointer to telemetry fetched by ::k_adcs_get_nominal_snapshot
+ * @param [out] buffer Pointer to telemetry JSON structure
+ * @return KADCSStatus `ADCS_OK` if OK, error otherwise
+ */
+KADCSStatus k_adcs_nominal_to_json(const imtq_nominal_snapshot * snapshot, JsonNode * buffer);
 /**
  * Get iMTQ system state
  * @param [out] state Pointer to storage for state data
@@ -310,6 +395,40 @@ KADCSStatus k_imtq_get_raw_housekeeping(imtq_housekeeping_raw * data);
  */
 KADCSStatus k_imtq_get_eng_housekeeping(imtq_housekeeping_eng * data);
 
+/**
+ * Load and cache the calibration needed to convert raw housekeeping data to
+ * engineering values on the host
+ *
+ * The coil current and temperature conversions are read from the
+ * `ADC_COIL_CURRENT_*` and `ADC_COIL_TEMP_*` configuration parameters.
+ * Nominal telemetry loads the calibration itself the first time it's needed,
+ * then only fetches the raw housekeeping data. The cache is discarded if any
+ * of the ADC configuration parameters change, or the iMTQ is reset.
+ * @return KADCSStatus `ADCS_OK` if OK, error otherwise
+ */
+KADCSStatus k_imtq_load_housekeeping_cal(void);
+/**
+ * Get a copy of the cached housekeeping calibration
+ * @param [out] cal Pointer to storage for the calibration
+ * @return KADCSStatus `ADCS_OK` if OK, `ADCS_ERROR` if no calibration has been
+ * loaded
+ */
+KADCSStatus k_imtq_get_housekeeping_cal(imtq_housekeeping_cal * cal);
+/**
+ * Convert raw housekeeping data to engineering values
+ *
+ * Only the coil channels are converted. The supply and MCU channels use
+ * conversions inside the iMTQ which aren't published, so their engineering
+ * fields are set to zero: use the raw values, or ::k_imtq_get_eng_housekeeping
+ * @param [in] raw Pointer to raw housekeeping data
+ * @param [in] cal Pointer to calibration to use for the conversion
+ * @param [out] eng Pointer to storage for the converted data
+ * @return KADCSStatus `ADCS_OK` if OK, error otherwise
+ */
+KADCSStatus k_imtq_convert_housekeeping(const imtq_housekeeping_raw * raw,
+                                        const imtq_housekeeping_cal * cal,
+                                        imtq_housekeeping_eng * eng);
+
 /* Private functions */
 /**
  * Get the current system status and add it to the telemetry JSON
@@ -329,6 +448,21 @@ KADCSStatus kprv_adcs_get_nominal_telemetry(JsonNode * buffer);
  * @return KADCSStatus `ADCS_OK` if OK, error otherwise
  */
 KADCSStatus kprv_adcs_get_debug_telemetry(JsonNode * buffer);
+/**
+ * Fetch the housekeeping data in both raw and engineering units. The raw data
+ * is converted on the host, loading the calibration if needed, unless the
+ * calibration can't be loaded
+ * @param [out] raw Pointer to storage for raw data
+ * @param [out] eng Pointer to storage for engineering data
+ * @param [out] converted Set if `eng` was converted on the host, so only its coil channels are set
+ * @return KADCSStatus `ADCS_OK` if OK, error otherwise
+ */
+KADCSStatus kprv_imtq_get_housekeeping(imtq_housekeeping_raw * raw, imtq_housekeeping_eng * eng,
+                                       bool * converted);
+/**
+ * Discard the cached housekeeping calibration
+ */
+void kprv_imtq_clear_housekeeping_cal(void);
 /**
  * Add a self-test result to the requested JSON structure
  * @param [out] parent Pointer to JSON structure results should be added to
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2018 Kubos Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * @addtogroup IMTQ_API
+ * @{
+ */
+
+#pragma once
+
+/**
+ * Number of rate samples averaged by the spin estimator.
+ * Must be a power of two
+ */
+#define IMTQ_SPIN_WINDOW  16
+/**
+ * Largest gap between two magnetometer samples which will be used to
+ * calculate a rate, in milliseconds. A longer gap discards the rates averaged
+ * so far, and so does going this long without a sample
+ */
+#define IMTQ_SPIN_MAX_GAP 10000
+
+/**
+ * Feed a calibrated magnetometer sample to the spin/orientation estimator
+ *
+ * Samples taken by the magnetometer stream and the control loop are fed to
+ * the estimator automatically.
+ * Samples taken while the coils were actuating are ignored.
+ * @param [in] sample Pointer to timestamped calibrated MTM sample
+ * @param [in] bdot Pointer to the matching B-Dot in [10<sup>-9</sup> T*s<sup>-1</sup>]
+ * (ex. from ::k_imtq_get_detumble), or `NULL` to derive it from the previous sample
+ * @return KADCSStatus `ADCS_OK` if OK, error otherwise
+ */
+KADCSStatus k_imtq_estimator_update(const imtq_mtm_sample * sample,
+                                    const imtq_mtm_data * bdot);
+/**
+ * Discard all of the estimator's history
+ */
+void k_imtq_estimator_reset(void);
+
+/* Private functions */
+/**
+ * Take a fresh calibrated magnetometer sample and feed it to the estimator
+ * @return KADCSStatus `ADCS_OK` if OK, error otherwise
+ */
+KADCSStatus kprv_imtq_estimator_sample(void);
+/**
+ * Get the current spin estimate without taking a new sample
+ * @param [out] data Pointer to storage for the estimate
+ */
+void kprv_imtq_estimator_get_spin(adcs_spin * data);
+
+/* @} */
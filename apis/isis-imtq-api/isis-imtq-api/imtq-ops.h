@@ -21,6 +21,7 @@
 #pragma once
 
 #include <json.h>
+#include <stdbool.h>
 
 /** \cond WE DO NOT WANT TO HAVE THESE IN OUR GENERATED DOCS */
 /* Operational Commands */
@@ -42,6 +43,19 @@ typedef enum {
     SOFT_RESET      /**< Software reset */
 } KADCSReset;
 
+/**
+ * Interval between checks for self-test completion made by ::k_adcs_run_test, in milliseconds
+ */
+#define IMTQ_TEST_POLL_INTERVAL 50
+/**
+ * Maximum amount of time a self-test may take before it is considered failed, in milliseconds
+ */
+#define IMTQ_TEST_TIMEOUT       5000
+/**
+ * Maximum amount of time the iMTQ may take to enter ::SELFTEST mode after a self-test is started, in milliseconds
+ */
+#define IMTQ_TEST_START_TIMEOUT 500
+
 /**
  * Self-Test Axis Options
  */
@@ -97,6 +111,28 @@ KADCSStatus k_adcs_set_mode(ADCSMode mode, const adcs_mode_param * params);
  * @return KADCSStatus ADCS_OK if OK, error otherwise
  */
 KADCSStatus k_adcs_run_test(ADCSTestType test, adcs_test_results buffer);
+/**
+ * Start an iMTQ self-test without waiting for it to complete
+ *
+ * Use ::k_adcs_poll_test to check for completion and retrieve the results
+ * @param [in] test Type of self-test to run
+ * @return KADCSStatus `ADCS_OK` if OK, error otherwise
+ */
+KADCSStatus k_adcs_start_test_async(ADCSTestType test);
+/**
+ * Check whether the self-test started by ::k_adcs_start_test_async has
+ * completed and, if so, retrieve its results
+ *
+ * The test is complete once the iMTQ has entered and then left ::SELFTEST
+ * mode, so this should be polled more often than the test takes to run.
+ * If the iMTQ has not entered ::SELFTEST mode within ::IMTQ_TEST_START_TIMEOUT,
+ * or the test has not completed within ::IMTQ_TEST_TIMEOUT, it is abandoned
+ * and an error is returned.
+ * @param [out] buffer (Pointer to) structure which the test-results should be copied to
+ * @param [out] complete Set to `true` if the test has completed and `buffer` has been populated
+ * @return KADCSStatus `ADCS_OK` if OK, error otherwise
+ */
+KADCSStatus k_adcs_poll_test(adcs_test_results buffer, bool * complete);
 /**
  * Switch to idle mode and cancel any ongoing actuation
  * @return KADCSStatus `ADCS_OK` if OK, error otherwise
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2018 Kubos Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * @addtogroup IMTQ_API
+ * @{
+ */
+
+#pragma once
+
+#include <json.h>
+
+/**
+ * Configuration snapshot file identifier ("IMTQ")
+ */
+#define IMTQ_SNAPSHOT_MAGIC   0x51544D49
+/**
+ * Configuration snapshot file format version
+ */
+#define IMTQ_SNAPSHOT_VERSION 2
+/**
+ * Number of parameters which ::k_imtq_check_config reads back from the iMTQ to
+ * confirm that it still matches a snapshot
+ */
+#define IMTQ_SNAPSHOT_SAMPLES 4
+
+/**
+ * Configuration snapshot file header
+ */
+typedef struct {
+    uint32_t magic;             /**< ::IMTQ_SNAPSHOT_MAGIC */
+    uint16_t version;           /**< ::IMTQ_SNAPSHOT_VERSION */
+    uint16_t count;             /**< Number of parameter entries following the header */
+    uint32_t software_version;  /**< iMTQ ::SOFTWARE_VERSION when the snapshot was taken */
+    uint32_t checksum;          /**< CRC-32 of the parameter entries */
+    uint8_t configured;         /**< iMTQ ::imtq_state.config when the snapshot was taken */
+    uint8_t reserved[7];        /**< Padding. Always zero */
+} imtq_snapshot_header;
+
+/**
+ * Configuration snapshot file parameter entry
+ *
+ * Entries are 8-byte aligned, so the file can be used directly once mapped
+ */
+typedef struct {
+    uint16_t param;             /**< Parameter ID */
+    uint8_t reserved[6];        /**< Padding. Always zero */
+    imtq_config_value value;    /**< Parameter value */
+} imtq_snapshot_entry;
+
+/**
+ * Read the full iMTQ configuration and save it to a snapshot file
+ *
+ * The file is replaced atomically
+ * @param [in] path Path of snapshot file
+ * @return KADCSStatus `ADCS_OK` if OK, error otherwise
+ */
+KADCSStatus k_imtq_save_config(const char * path);
+/**
+ * Check whether the iMTQ still matches a snapshot file
+ *
+ * The iMTQ's ::SOFTWARE_VERSION and ::IMTQ_SNAPSHOT_SAMPLES sampled parameters
+ * are compared against the snapshot. If the iMTQ had been configured when the
+ * snapshot was taken, it must still report so: restarting it reverts every
+ * parameter to its default
+ * @param [in] path Path of snapshot file
+ * @return KADCSStatus `ADCS_OK` if the iMTQ matches the snapshot,
+ * `ADCS_ERROR_CONFIG` if the snapshot is missing or invalid,
+ * `ADCS_ERROR` if the iMTQ doesn't match, error otherwise
+ */
+KADCSStatus k_imtq_check_config(const char * path);
+/**
+ * Configure the ADCS, skipping the configuration if nothing has changed
+ *
+ * If every value in `config` matches the snapshot file, the iMTQ hasn't
+ * restarted or been updated since (see ::k_imtq_check_config) and reading back
+ * every parameter in `config` gives the configured value, no parameters are sent.
+ * Otherwise, `config` is applied with ::k_adcs_configure and a new snapshot
+ * is saved.
+ * @param [in] config ADCS configuration structure
+ * @param [in] path Path of snapshot file
+ * @return KADCSStatus `ADCS_OK` if OK, error otherwise
+ */
+KADCSStatus k_imtq_configure_cached(const JsonNode * config, const char * path);
+
+/* @} */
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2018 Kubos Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * @addtogroup IMTQ_API
+ * @{
+ */
+
+#pragma once
+
+#include <time.h>
+
+/**
+ * Number of samples which can be buffered by the magnetometer stream.
+ * Must be a power of two
+ */
+#define IMTQ_STREAM_DEPTH    64
+/**
+ * Maximum supported magnetometer streaming rate, in Hz
+ */
+#define IMTQ_STREAM_MAX_RATE 50
+
+/**
+ * Timestamped magnetometer sample produced by the magnetometer stream
+ */
+typedef struct {
+    struct timespec timestamp;  /**< Time (`CLOCK_MONOTONIC`) at which the measurement was started */
+    imtq_mtm_msg data;          /**< Calibrated MTM measurement */
+} imtq_mtm_sample;
+
+/**
+ * Magnetometer stream statistics returned by ::k_imtq_stream_get_stats
+ */
+typedef struct {
+    uint32_t period;            /**< Configured sampling period [microseconds] */
+    uint32_t samples;           /**< Number of samples successfully taken */
+    uint32_t errors;            /**< Number of samples which could not be taken */
+    uint32_t overruns;          /**< Number of samples dropped because the buffer was full */
+    uint32_t missed_ticks;      /**< Number of sampling periods skipped because the sampler was running late */
+    uint32_t jitter_mean;       /**< Mean absolute deviation of sample start times from their deadlines [microseconds] */
+    uint32_t jitter_max;        /**< Largest absolute deviation of a sample start time from its deadline [microseconds] */
+} imtq_stream_stats;
+
+/**
+ * Start sampling the magnetometer at a fixed rate
+ *
+ * Samples are taken by a dedicated thread and buffered until they are
+ * retrieved with ::k_imtq_stream_read. If the buffer is full, new samples are
+ * dropped and counted as overruns.
+ * @param [in] rate Sampling rate in Hz (1 - ::IMTQ_STREAM_MAX_RATE)
+ * @return KADCSStatus `ADCS_OK` if OK, error otherwise
+ */
+KADCSStatus k_imtq_stream_start(uint16_t rate);
+/**
+ * Stop the magnetometer stream
+ *
+ * Samples which have not been read yet are discarded
+ * @return KADCSStatus `ADCS_OK` if OK, error otherwise
+ */
+KADCSStatus k_imtq_stream_stop(void);
+/**
+ * Retrieve buffered magnetometer samples, oldest first
+ *
+ * May be called from a single consumer thread while the stream is running
+ * @param [out] samples Pointer to storage for samples
+ * @param [in] max Maximum number of samples to retrieve
+ * @param [out] count Number of samples retrieved
+ * @return KADCSStatus `ADCS_OK` if OK, error otherwise
+ */
+KADCSStatus k_imtq_stream_read(imtq_mtm_sample * samples, uint16_t max,
+                               uint16_t * count);
+/**
+ * Get the statistics of the current (or most recent) magnetometer stream
+ * @param [out] stats Pointer to storage for statistics
+ * @return KADCSStatus `ADCS_OK` if OK, error otherwise
+ */
+KADCSStatus k_imtq_stream_get_stats(imtq_stream_stats * stats);
+
+/* @} */
@@ -95,12 +95,31 @@ typedef enum {
     DETUMBLE        /**< Detumble mode */
 } ADCSMode;
 
+/**
+ * Orientation estimate returned by ::k_adcs_get_orientation
+ *
+ * The iMTQ only carries a magnetometer, so orientation is given as the
+ * direction of the local magnetic field in the body frame
+ */
 typedef struct {
-    /* Not an implemented structure/function. Need for compliance with generic API */
+    float x;                    /**< X-axis component of the magnetic field unit vector */
+    float y;                    /**< Y-axis component of the magnetic field unit vector */
+    float z;                    /**< Z-axis component of the magnetic field unit vector */
+    float field;                /**< Magnetic field strength in [10<sup>-9</sup> T] */
 } adcs_orient;
 
+/**
+ * Spin estimate returned by ::k_adcs_get_spin
+ *
+ * Rotation about the magnetic field vector doesn't change the field seen by
+ * the magnetometer, so only the spin perpendicular to the field is observable
+ */
 typedef struct {
-    /* Not an implemented structure/function. Need for compliance with generic API */
+    float x;                    /**< X-axis spin rate in [rad/s] */
+    float y;                    /**< Y-axis spin rate in [rad/s] */
+    float z;                    /**< Z-axis spin rate in [rad/s] */
+    float rate;                 /**< Total spin rate in [rad/s] */
+    uint16_t samples;           /**< Number of rate samples the estimate is based on */
 } adcs_spin;
 
 /*
@@ -111,12 +130,46 @@ typedef struct {
 #include "imtq-config.h"
 #include "imtq-data.h"
 #include "imtq-ops.h"
+#include "imtq-stream.h"
+#include "imtq-estimator.h"
+#include "imtq-control.h"
+#include "imtq-snapshot.h"
+#include "imtq-cbor.h"
 
 /**
  * System mutex to preserve iMTQ command/response ordering
+ *
+ * Uses the priority inheritance protocol, so a low-priority thread holding
+ * the mutex is boosted while a higher-priority thread waits for it
  */
 extern pthread_mutex_t imtq_mutex;
 
+/**
+ * iMTQ traffic classes
+ *
+ * While a ::IMTQ_TRAFFIC_CONTROL or ::IMTQ_TRAFFIC_WATCHDOG transfer is waiting
+ * for the iMTQ, no new ::IMTQ_TRAFFIC_TELEMETRY transfers will be started
+ */
+typedef enum {
+    IMTQ_TRAFFIC_TELEMETRY,     /**< Telemetry and general requests (default) */
+    IMTQ_TRAFFIC_WATCHDOG,      /**< Watchdog kicks */
+    IMTQ_TRAFFIC_CONTROL,       /**< Control loop measurement and actuation */
+    IMTQ_TRAFFIC_CLASSES        /**< Number of traffic classes */
+} imtq_traffic_class;
+
+/**
+ * iMTQ lock statistics for a traffic class, returned by ::k_imtq_get_lock_stats
+ */
+typedef struct {
+    uint32_t acquisitions;      /**< Number of times the lock was taken */
+    uint32_t contended;         /**< Number of times the lock was not immediately available */
+    uint32_t timeouts;          /**< Number of times the lock could not be taken in time */
+    uint32_t wait_max;          /**< Longest time spent waiting for the lock [microseconds] */
+    uint64_t wait_total;        /**< Total time spent waiting for the lock [microseconds] */
+    uint32_t hold_max;          /**< Longest time the lock was held [microseconds] */
+    uint64_t hold_total;        /**< Total time the lock was held [microseconds] */
+} imtq_lock_stats;
+
 /* Public Functions */
 /**
  * Initialize the ADCS interface
@@ -131,13 +184,15 @@ KADCSStatus k_adcs_init(char * bus, uint16_t addr, int timeout);
  */
 void k_adcs_terminate(void);
 /**
- * Start a thread to kick the iMTQ's watchdog at an interval of
+ * Start kicking the iMTQ's watchdog at an interval of
  * `(timeout/3)` seconds (`timeout` specified in `k_adcs_init`)
+ *
+ * The kicks are made by the shared watchdog scheduler (see ::k_watchdog_register)
  * @return KADCSStatus `ADCS_OK` if OK, error otherwise
  */
 KADCSStatus k_imtq_watchdog_start(void);
 /**
- * Stop the watchdog thread
+ * Stop kicking the iMTQ's watchdog
  * @return KADCSStatus `ADCS_OK` if OK, error otherwise
  */
 KADCSStatus k_imtq_watchdog_stop(void);
@@ -158,6 +213,25 @@ KADCSStatus k_imtq_reset(void);
  * @return KADCSStatus ADCS_OK if OK, error otherwise
  */
 KADCSStatus k_adcs_passthrough(const uint8_t * tx, int tx_len, uint8_t * rx, int rx_len, const struct timespec * delay);
+/**
+ * Set the traffic class used for iMTQ transfers made by the calling thread
+ *
+ * Watchdog kicks and the control loop thread use their own classes
+ * @param [in] traffic Traffic class
+ * @return KADCSStatus `ADCS_OK` if OK, error otherwise
+ */
+KADCSStatus k_imtq_set_traffic_class(imtq_traffic_class traffic);
+/**
+ * Get the iMTQ lock statistics for a traffic class
+ * @param [in] traffic Traffic class
+ * @param [out] stats Pointer to storage for statistics
+ * @return KADCSStatus `ADCS_OK` if OK, error otherwise
+ */
+KADCSStatus k_imtq_get_lock_stats(imtq_traffic_class traffic, imtq_lock_stats * stats);
+/**
+ * Reset the iMTQ lock statistics for all traffic classes
+ */
+void k_imtq_reset_lock_stats(void);
 
 /* Private Functions */
 /**
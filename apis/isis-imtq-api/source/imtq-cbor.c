@@ -0,0 +1,423 @@
+/*
+ * Copyright (C) 2018 Kubos Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * ISIS iMTQ API - CBOR Telemetry Encoding
+ */
+
+#include <imtq.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+/* CBOR major types (RFC 7049) */
+#define CBOR_UINT       0x00
+#define CBOR_NEGINT     0x20
+
+#define CBOR_FALSE      0xF4
+#define CBOR_TRUE       0xF5
+#define CBOR_NULL       0xF6
+#define CBOR_FLOAT32    0xFA
+#define CBOR_FLOAT64    0xFB
+#define CBOR_MAP_START  0xBF    /* Indefinite-length map */
+#define CBOR_BREAK      0xFF
+
+/*
+ * Output buffer. Once the buffer is full, encoding carries on counting bytes
+ * so the caller can be told how much space is needed
+ */
+typedef struct {
+    uint8_t * buffer;
+    size_t    size;
+    size_t    len;
+} imtq_cbor;
+
+static void kprv_imtq_cbor_put(imtq_cbor * cbor, const uint8_t * data, size_t len)
+{
+    if (cbor->len + len <= cbor->size)
+    {
+        memcpy(cbor->buffer + cbor->len, data, len);
+    }
+
+    cbor->len += len;
+}
+
+static void kprv_imtq_cbor_byte(imtq_cbor * cbor, uint8_t byte)
+{
+    kprv_imtq_cbor_put(cbor, &byte, 1);
+}
+
+/* Write an item header using the shortest encoding for the argument */
+static void kprv_imtq_cbor_head(imtq_cbor * cbor, uint8_t major, uint64_t value)
+{
+    uint8_t head[9];
+    int     len;
+
+    if (value < 24)
+    {
+        head[0] = major | value;
+        len     = 0;
+    }
+    else if (value <= UINT8_MAX)
+    {
+        head[0] = major | 24;
+        len     = 1;
+    }
+    else if (value <= UINT16_MAX)
+    {
+        head[0] = major | 25;
+        len     = 2;
+    }
+    else if (value <= UINT32_MAX)
+    {
+        head[0] = major | 26;
+        len     = 4;
+    }
+    else
+    {
+        head[0] = major | 27;
+        len     = 8;
+    }
+
+    /* Arguments are big-endian */
+    for (int i = 0; i < len; i++)
+    {
+        head[len - i] = (uint8_t) (value >> (8 * i));
+    }
+
+    kprv_imtq_cbor_put(cbor, head, len + 1);
+}
+
+static void kprv_imtq_cbor_int(imtq_cbor * cbor, int64_t value)
+{
+    if (value >= 0)
+    {
+        kprv_imtq_cbor_head(cbor, CBOR_UINT, (uint64_t) value);
+    }
+    else
+    {
+        kprv_imtq_cbor_head(cbor, CBOR_NEGINT, (uint64_t) (-1 - value));
+    }
+}
+
+static void kprv_imtq_cbor_bool(imtq_cbor * cbor, bool value)
+{
+    kprv_imtq_cbor_byte(cbor, value ? CBOR_TRUE : CBOR_FALSE);
+}
+
+/* Doubles which survive the round-trip are sent as single-precision */
+static void kprv_imtq_cbor_double(imtq_cbor * cbor, double value)
+{
+    float   single = (float) value;
+    uint8_t head[9];
+
+    if ((double) single == value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &single, sizeof(bits));
+
+        head[0] = CBOR_FLOAT32;
+        for (int i = 0; i < 4; i++)
+        {
+            head[4 - i] = (uint8_t) (bits >> (8 * i));
+        }
+        kprv_imtq_cbor_put(cbor, head, 5);
+    }
+    else
+    {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+
+        head[0] = CBOR_FLOAT64;
+        for (int i = 0; i < 8; i++)
+        {
+            head[8 - i] = (uint8_t) (bits >> (8 * i));
+        }
+        kprv_imtq_cbor_put(cbor, head, 9);
+    }
+}
+
+static void kprv_imtq_cbor_key_int(imtq_cbor * cbor, uint16_t key, int64_t value)
+{
+    kprv_imtq_cbor_head(cbor, CBOR_UINT, key);
+    kprv_imtq_cbor_int(cbor, value);
+}
+
+static void kprv_imtq_cbor_key_bool(imtq_cbor * cbor, uint16_t key, bool value)
+{
+    kprv_imtq_cbor_head(cbor, CBOR_UINT, key);
+    kprv_imtq_cbor_bool(cbor, value);
+}
+
+/* Write an axis triplet to three consecutive keys */
+static void kprv_imtq_cbor_key_axes(imtq_cbor * cbor, uint16_t key,
+                                    int32_t x, int32_t y, int32_t z)
+{
+    kprv_imtq_cbor_key_int(cbor, key, x);
+    kprv_imtq_cbor_key_int(cbor, key + 1, y);
+    kprv_imtq_cbor_key_int(cbor, key + 2, z);
+}
+
+static KADCSStatus kprv_imtq_cbor_finish(const imtq_cbor * cbor, size_t * len)
+{
+    *len = cbor->len;
+
+    if (cbor->len > cbor->size)
+    {
+        fprintf(stderr, "iMTQ CBOR telemetry needs %zu bytes, only %zu available\n",
+                cbor->len, cbor->size);
+        return ADCS_ERROR_CONFIG;
+    }
+
+    return ADCS_OK;
+}
+
+static KADCSStatus kprv_adcs_status_to_cbor(imtq_cbor * cbor)
+{
+    KADCSStatus status;
+    imtq_state  state;
+
+    status = k_imtq_get_system_state(&state);
+    if (status == ADCS_OK)
+    {
+        kprv_imtq_cbor_key_int(cbor, IMTQ_TELEM_SYSTEM_MODE, state.mode);
+        kprv_imtq_cbor_key_bool(cbor, IMTQ_TELEM_SYSTEM_ERROR, state.error);
+        kprv_imtq_cbor_key_bool(cbor, IMTQ_TELEM_SYSTEM_CONFIGURED, state.config);
+        kprv_imtq_cbor_key_int(cbor, IMTQ_TELEM_SYSTEM_UPTIME, state.uptime);
+    }
+    else if (status == ADCS_ERROR)
+    {
+        /* Assume system is offline, so uptime is zero */
+        kprv_imtq_cbor_head(cbor, CBOR_UINT, IMTQ_TELEM_SYSTEM_MODE);
+        kprv_imtq_cbor_byte(cbor, CBOR_NULL);
+        kprv_imtq_cbor_key_int(cbor, IMTQ_TELEM_SYSTEM_UPTIME, 0);
+    }
+
+    return status;
+}
+
+static void kprv_adcs_nominal_to_cbor(imtq_cbor * cbor,
+                                      const imtq_nominal_snapshot * snapshot)
+{
+    if (snapshot->valid & NOMINAL_HOUSEKEEPING)
+    {
+        const imtq_housekeeping_raw * raw = &snapshot->house_raw;
+        const imtq_housekeeping_eng * eng = &snapshot->house_eng;
+
+        kprv_imtq_cbor_key_int(cbor, IMTQ_TELEM_SUPPLY_VOLTAGE_DIGITAL_RAW, raw->voltage_d);
+        kprv_imtq_cbor_key_int(cbor, IMTQ_TELEM_SUPPLY_VOLTAGE_ANALOG_RAW, raw->voltage_a);
+        kprv_imtq_cbor_key_int(cbor, IMTQ_TELEM_SUPPLY_CURRENT_DIGITAL_RAW, raw->current_d);
+        kprv_imtq_cbor_key_int(cbor, IMTQ_TELEM_SUPPLY_CURRENT_ANALOG_RAW, raw->current_a);
+        kprv_imtq_cbor_key_axes(cbor, IMTQ_TELEM_COIL_CURRENT_X_RAW, raw->coil_current.x,
+                                raw->coil_current.y, raw->coil_current.z);
+        kprv_imtq_cbor_key_axes(cbor, IMTQ_TELEM_COIL_TEMP_X_RAW, raw->coil_temp.x,
+                                raw->coil_temp.y, raw->coil_temp.z);
+        kprv_imtq_cbor_key_int(cbor, IMTQ_TELEM_MCU_TEMP_RAW, raw->mcu_temp);
+
+        /* Only the coil channels are converted on the host */
+        if (!snapshot->house_converted)
+        {
+            kprv_imtq_cbor_key_int(cbor, IMTQ_TELEM_SUPPLY_VOLTAGE_DIGITAL_ENG, eng->voltage_d);
+            kprv_imtq_cbor_key_int(cbor, IMTQ_TELEM_SUPPLY_VOLTAGE_ANALOG_ENG, eng->voltage_a);
+            kprv_imtq_cbor_key_int(cbor, IMTQ_TELEM_SUPPLY_CURRENT_DIGITAL_ENG, eng->current_d);
+            kprv_imtq_cbor_key_int(cbor, IMTQ_TELEM_SUPPLY_CURRENT_ANALOG_ENG, eng->current_a);
+        }
+        kprv_imtq_cbor_key_axes(cbor, IMTQ_TELEM_COIL_CURRENT_X_ENG, eng->coil_current.x,
+                                eng->coil_current.y, eng->coil_current.z);
+        kprv_imtq_cbor_key_axes(cbor, IMTQ_TELEM_COIL_TEMP_X_ENG, eng->coil_temp.x,
+                                eng->coil_temp.y, eng->coil_temp.z);
+        if (!snapshot->house_converted)
+        {
+            kprv_imtq_cbor_key_int(cbor, IMTQ_TELEM_MCU_TEMP_ENG, eng->mcu_temp);
+        }
+    }
+
+    if (snapshot->valid & NOMINAL_DETUMBLE)
+    {
+        const imtq_detumble * detumble = &snapshot->detumble;
+
+        kprv_imtq_cbor_key_axes(cbor, IMTQ_TELEM_DETUMBLE_CALIB_MTM_X, detumble->mtm_calib.x,
+                                detumble->mtm_calib.y, detumble->mtm_calib.z);
+        kprv_imtq_cbor_key_axes(cbor, IMTQ_TELEM_DETUMBLE_FILTER_MTM_X, detumble->mtm_filter.x,
+                                detumble->mtm_filter.y, detumble->mtm_filter.z);
+        kprv_imtq_cbor_key_axes(cbor, IMTQ_TELEM_DETUMBLE_BDOT_X, detumble->bdot.x,
+                                detumble->bdot.y, detumble->bdot.z);
+        kprv_imtq_cbor_key_axes(cbor, IMTQ_TELEM_DETUMBLE_DIPOLE_X, detumble->dipole.x,
+                                detumble->dipole.y, detumble->dipole.z);
+        kprv_imtq_cbor_key_axes(cbor, IMTQ_TELEM_DETUMBLE_CMD_CURRENT_X, detumble->cmd_current.x,
+                                detumble->cmd_current.y, detumble->cmd_current.z);
+        kprv_imtq_cbor_key_axes(cbor, IMTQ_TELEM_DETUMBLE_COIL_CURRENT_X, detumble->coil_current.x,
+                                detumble->coil_current.y, detumble->coil_current.z);
+    }
+
+    if (snapshot->valid & NOMINAL_MTM)
+    {
+        const imtq_mtm_msg * raw   = &snapshot->mtm_raw;
+        const imtq_mtm_msg * calib = &snapshot->mtm_calib;
+
+        kprv_imtq_cbor_key_bool(cbor, IMTQ_TELEM_MTM_ACTUATING, raw->act_status);
+        kprv_imtq_cbor_key_axes(cbor, IMTQ_TELEM_MTM_X_RAW, raw->data.x,
+                                raw->data.y, raw->data.z);
+        kprv_imtq_cbor_key_axes(cbor, IMTQ_TELEM_MTM_X_CALIB, calib->data.x,
+                                calib->data.y, calib->data.z);
+    }
+
+    if (snapshot->valid & NOMINAL_DIPOLE)
+    {
+        const imtq_dipole * dipole = &snapshot->dipole;
+
+        kprv_imtq_cbor_key_axes(cbor, IMTQ_TELEM_DIPOLE_X, dipole->data.x,
+                                dipole->data.y, dipole->data.z);
+    }
+}
+
+static void kprv_adcs_test_to_cbor(imtq_cbor * cbor, const imtq_test_result * test)
+{
+    /* See kprv_adcs_process_test */
+    if (test->hdr.cmd != GET_TEST)
+    {
+        return;
+    }
+
+    uint8_t step = test->step;
+
+    kprv_imtq_cbor_key_int(cbor, IMTQ_TELEM_TEST_KEY(step, IMTQ_TELEM_TEST_ERROR),
+                           test->error);
+    kprv_imtq_cbor_key_axes(cbor, IMTQ_TELEM_TEST_KEY(step, IMTQ_TELEM_TEST_MTM_RAW_X),
+                            test->mtm_raw.x, test->mtm_raw.y, test->mtm_raw.z);
+    kprv_imtq_cbor_key_axes(cbor, IMTQ_TELEM_TEST_KEY(step, IMTQ_TELEM_TEST_MTM_CALIB_X),
+                            test->mtm_calib.x, test->mtm_calib.y, test->mtm_calib.z);
+    kprv_imtq_cbor_key_axes(cbor, IMTQ_TELEM_TEST_KEY(step, IMTQ_TELEM_TEST_COIL_CURRENT_X),
+                            test->coil_current.x, test->coil_current.y,
+                            test->coil_current.z);
+    kprv_imtq_cbor_key_axes(cbor, IMTQ_TELEM_TEST_KEY(step, IMTQ_TELEM_TEST_COIL_TEMP_X),
+                            test->coil_temp.x, test->coil_temp.y, test->coil_temp.z);
+}
+
+static KADCSStatus kprv_adcs_debug_to_cbor(imtq_cbor * cbor)
+{
+    KADCSStatus      status = ADCS_OK;
+    KADCSStatus      debug_status;
+    imtq_config_resp config_data;
+
+    /* Get all of the configuration values */
+    for (int i = 0; i < IMTQ_NUM_PARAMS; i++)
+    {
+        const imtq_param_desc * param = &imtq_params[i];
+
+        debug_status = k_imtq_get_param(param->id, &config_data);
+        if (debug_status != ADCS_OK)
+        {
+            fprintf(stderr, "Failed to fetch iMTQ param %s: %d\n", param->name, debug_status);
+            status = ADCS_ERROR;
+            continue;
+        }
+
+        /* The response is packed, so take an aligned copy of the value */
+        imtq_config_value value = config_data.value;
+
+        kprv_imtq_cbor_head(cbor, CBOR_UINT, param->id);
+        if (param->type == IMTQ_PARAM_FLOAT || param->type == IMTQ_PARAM_DOUBLE)
+        {
+            kprv_imtq_cbor_double(cbor, param->decode(&value));
+        }
+        else
+        {
+            kprv_imtq_cbor_int(cbor, (int64_t) param->decode(&value));
+        }
+    }
+
+    /* Get the last-run test results */
+    imtq_test_result_all data = { 0 };
+    debug_status              = k_imtq_get_test_results_all(&data);
+    if (debug_status == ADCS_OK)
+    {
+        kprv_adcs_test_to_cbor(cbor, &data.init);
+        kprv_adcs_test_to_cbor(cbor, &data.x_pos);
+        kprv_adcs_test_to_cbor(cbor, &data.x_neg);
+        kprv_adcs_test_to_cbor(cbor, &data.y_pos);
+        kprv_adcs_test_to_cbor(cbor, &data.y_neg);
+        kprv_adcs_test_to_cbor(cbor, &data.z_pos);
+        kprv_adcs_test_to_cbor(cbor, &data.z_neg);
+        kprv_adcs_test_to_cbor(cbor, &data.final);
+    }
+    else if (debug_status != ADCS_ERROR_INTERNAL
+             && kprv_imtq_check_error(data.init.hdr.status) != IMTQ_ERROR_MODE)
+    {
+        fprintf(stderr, "Encountered an unexpected error: %d\n", debug_status);
+        status = ADCS_ERROR;
+    }
+
+    return status;
+}
+
+KADCSStatus k_adcs_get_telemetry_cbor(ADCSTelemType type, uint8_t * buffer,
+                                      size_t size, size_t * len)
+{
+    KADCSStatus status;
+    KADCSStatus encode_status;
+    imtq_cbor   cbor = {.buffer = buffer, .size = size, .len = 0 };
+
+    if ((buffer == NULL && size != 0) || len == NULL)
+    {
+        return ADCS_ERROR_CONFIG;
+    }
+
+    if (type != NOMINAL && type != DEBUG)
+    {
+        fprintf(stderr, "Unknown iMTQ telemetry type requested: %d\n", type);
+        return ADCS_ERROR_CONFIG;
+    }
+
+    kprv_imtq_cbor_byte(&cbor, CBOR_MAP_START);
+
+    status = kprv_adcs_status_to_cbor(&cbor);
+    if (status == ADCS_OK)
+    {
+        if (type == DEBUG)
+        {
+            status = kprv_adcs_debug_to_cbor(&cbor);
+        }
+        else
+        {
+            imtq_nominal_snapshot snapshot = { 0 };
+
+            status = k_adcs_get_nominal_snapshot(&snapshot, NOMINAL_ALL);
+            kprv_adcs_nominal_to_cbor(&cbor, &snapshot);
+        }
+    }
+
+    kprv_imtq_cbor_byte(&cbor, CBOR_BREAK);
+
+    encode_status = kprv_imtq_cbor_finish(&cbor, len);
+
+    return (status != ADCS_OK) ? status : encode_status;
+}
+
+KADCSStatus k_adcs_nominal_to_cbor(const imtq_nominal_snapshot * snapshot,
+                                   uint8_t * buffer, size_t size, size_t * len)
+{
+    imtq_cbor cbor = {.buffer = buffer, .size = size, .len = 0 };
+
+    if (snapshot == NULL || (buffer == NULL && size != 0) || len == NULL)
+    {
+        return ADCS_ERROR_CONFIG;
+    }
+
+    kprv_imtq_cbor_byte(&cbor, CBOR_MAP_START);
+    kprv_adcs_nominal_to_cbor(&cbor, snapshot);
+    kprv_imtq_cbor_byte(&cbor, CBOR_BREAK);
+
+    return kprv_imtq_cbor_finish(&cbor, len);
+}
@@ -21,14 +21,117 @@
 #include <stdlib.h>
 #include <string.h>
 
+/*
+ * Changing any of the coil ADC parameters invalidates the cached housekeeping
+ * calibration
+ */
+static void kprv_imtq_check_housekeeping_cal(uint16_t param)
+{
+    if (param >= ADC_COIL_CURRENT_BIAS_X && param <= ADC_COIL_TEMP_DIV_Z)
+    {
+        kprv_imtq_clear_housekeeping_cal();
+    }
+}
+
+/*
+ * Typed accessors for each configuration value type. Inline, since not every
+ * type is used by a parameter, and the unused ones can be dropped silently
+ */
+#define IMTQ_PARAM_CODEC(TYPE, C_TYPE, MEMBER)                                 \
+    static inline void kprv_imtq_encode_##TYPE(double value,                   \
+                                               imtq_config_value * out)        \
+    {                                                                          \
+        out->MEMBER = (C_TYPE) value;                                          \
+    }                                                                          \
+    static inline double kprv_imtq_decode_##TYPE(                             \
+        const imtq_config_value * value)                                       \
+    {                                                                          \
+        return (double) value->MEMBER;                                         \
+    }
+IMTQ_PARAM_TYPES(IMTQ_PARAM_CODEC)
+#undef IMTQ_PARAM_CODEC
+
+/* Make sure the table agrees with the documented parameter codes */
+#define IMTQ_PARAM_CHECK(NAME, CODE, TYPE)                                     \
+    _Static_assert(NAME == CODE && (CODE >> 12) == IMTQ_PARAM_##TYPE,          \
+                   #NAME " does not match its parameter table entry");
+IMTQ_PARAM_LIST(IMTQ_PARAM_CHECK)
+#undef IMTQ_PARAM_CHECK
+
+#define IMTQ_PARAM_ENTRY(NAME, CODE, TYPE)                                     \
+    [IMTQ_PARAM_IDX_##NAME] = {                                                \
+        .id     = NAME,                                                        \
+        .type   = IMTQ_PARAM_##TYPE,                                           \
+        .name   = #NAME,                                                       \
+        .key    = #CODE,                                                       \
+        .encode = kprv_imtq_encode_##TYPE,                                     \
+        .decode = kprv_imtq_decode_##TYPE                                      \
+    },
+const imtq_param_desc imtq_params[IMTQ_NUM_PARAMS] = {
+    IMTQ_PARAM_LIST(IMTQ_PARAM_ENTRY)
+};
+#undef IMTQ_PARAM_ENTRY
+
+const imtq_param_desc * k_imtq_find_param(uint16_t param)
+{
+    /* Let the compiler pick the fastest lookup for the set of IDs */
+    switch (param)
+    {
+#define IMTQ_PARAM_CASE(NAME, CODE, TYPE)                                      \
+        case NAME:                                                             \
+            return &imtq_params[IMTQ_PARAM_IDX_##NAME];
+        IMTQ_PARAM_LIST(IMTQ_PARAM_CASE)
+#undef IMTQ_PARAM_CASE
+        default:
+            return NULL;
+    }
+}
+
+static int kprv_imtq_compare_param_name(const void * name, const void * param)
+{
+    return strcmp((const char *) name, ((const imtq_param_desc *) param)->name);
+}
+
+const imtq_param_desc * k_imtq_find_param_name(const char * name)
+{
+    if (name == NULL)
+    {
+        return NULL;
+    }
+
+    return bsearch(name, imtq_params, IMTQ_NUM_PARAMS, sizeof(imtq_param_desc),
+                   kprv_imtq_compare_param_name);
+}
+
+/*
+ * Configuration entries may be keyed either by parameter ID (ex. "0x2003")
+ * or by name (ex. "MTM_INTERNAL_TIME")
+ */
+const imtq_param_desc * kprv_imtq_find_param_key(const char * key)
+{
+    char * end;
+
+    int key_len = strlen(key);
+    if (key_len >= 4 && key_len <= 6)
+    {
+        long param = strtol(key, &end, 16);
+        if (*end == '\0')
+        {
+            return k_imtq_find_param((uint16_t) param);
+        }
+    }
+
+    return k_imtq_find_param_name(key);
+}
+
 KADCSStatus k_adcs_configure(const JsonNode * config)
 {
     KADCSStatus status      = ADCS_OK;
     KADCSStatus imtq_status = ADCS_OK;
 
-    JsonNode *        entry;
-    uint16_t          param;
-    imtq_config_value value = {0};
+    JsonNode *              entry;
+    const imtq_param_desc * param;
+    imtq_config_value       value = {0};
 
     if (config == NULL)
     {
@@ -46,9 +149,8 @@ KADCSStatus k_adcs_configure(const JsonNode * config)
             continue;
         }
 
-        /* Convert parameter string to hex value */
-        int key_len = strlen(entry->key);
-        if (key_len < 4 || key_len > 6)
+        param = kprv_imtq_find_param_key(entry->key);
+        if (param == NULL)
         {
             fprintf(stderr,
                     "Skipping invalid iMTQ configuration parameter: %.10s\n",
@@ -57,56 +159,16 @@ KADCSStatus k_adcs_configure(const JsonNode * config)
             continue;
         }
 
-        param = (uint16_t) strtol(entry->key, NULL, 16);
-
         /* Store the param value appropriately based on its actual size */
-        switch (param >> 12)
-        {
-            case 0x1:
-                value.int8_val = (int8_t) entry->number_;
-                break;
-            case 0x2:
-                value.uint8_val = (uint8_t) entry->number_;
-                break;
-            case 0x3:
-                value.int16_val = (int16_t) entry->number_;
-                break;
-            case 0x4:
-                value.uint16_val = (uint16_t) entry->number_;
-                break;
-            case 0x5:
-                value.int32_val = (int32_t) entry->number_;
-                break;
-            case 0x6:
-                value.uint32_val = (uint32_t) entry->number_;
-                break;
-            case 0x7:
-                value.float_val = (float) entry->number_;
-                break;
-            case 0x8:
-                value.int64_val = (int64_t) entry->number_;
-                break;
-            case 0x9:
-                value.uint64_val = (uint64_t) entry->number_;
-                break;
-            case 0xA:
-                value.double_val = entry->number_;
-                break;
-            default:
-                fprintf(
-                    stderr,
-                    "Unknown iMTQ configuration parameter type passed: %x\n",
-                    param);
-                status = ADCS_ERROR;
-        }
+        param->encode(entry->number_, &value);
 
         /* Send the request */
-        imtq_status = k_imtq_set_param(param, &value, NULL);
+        imtq_status = k_imtq_set_param(param->id, &value, NULL);
         if (imtq_status != ADCS_OK)
         {
             fprintf(stderr,
                     "Failed to set iMTQ configuration parameter (%x): %d\n",
-                    param, imtq_status);
+                    param->id, imtq_status);
             status = ADCS_ERROR;
         }
     }
@@ -182,6 +244,8 @@ KADCSStatus k_imtq_set_param(uint16_t param, const imtq_config_value * value,
         return status;
     }
 
+    kprv_imtq_check_housekeeping_cal(param);
+
     return status;
 }
 
@@ -218,5 +282,7 @@ KADCSStatus k_imtq_reset_param(uint16_t param, imtq_config_resp * response)
         return status;
     }
 
+    kprv_imtq_check_housekeeping_cal(param);
+
     return status;
 }
@@ -0,0 +1,383 @@
+/*
+ * Copyright (C) 2018 Kubos Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * ISIS iMTQ API - Real-Time Control Loop
+ */
+
+#define _GNU_SOURCE
+
+#include <imtq.h>
+#include "imtq-time.h"
+#include <errno.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+/* Time from starting an MTM measurement until its result is ready */
+#define CONTROL_MEASURE_DELAY_US 1001
+
+static imtq_control_config control_config;
+static atomic_bool         control_running;
+static pthread_t           handle_control = { 0 };
+static int                 control_timer  = -1;
+static bool                control_locked = false;
+/* Serializes starting and stopping the loop */
+static pthread_mutex_t     control_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* Absolute time of the first cycle's deadline */
+static struct timespec control_first;
+
+static imtq_control_stats control_stats = { 0 };
+static pthread_mutex_t    control_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* Running totals, used to calculate the means */
+static uint64_t control_latency_total = 0;
+static uint64_t control_jitter_total  = 0;
+static uint64_t control_exec_total    = 0;
+
+static void kprv_imtq_control_update(uint32_t * max, uint64_t * total,
+                                     uint32_t * mean, uint32_t value,
+                                     uint32_t count)
+{
+    *total += value;
+    *mean = (uint32_t) (*total / count);
+    if (value > *max)
+    {
+        *max = value;
+    }
+}
+
+void * kprv_imtq_control_thread(void * args)
+{
+    KADCSStatus     status;
+    uint64_t        expirations;
+    uint64_t        ticks        = 0;
+    int64_t         last_latency = -1;
+    struct timespec deadline;
+    struct timespec done;
+    imtq_mtm_sample sample;
+    imtq_axis_data  dipole;
+
+    const struct timespec MEASURE_DELAY
+        = {.tv_sec = 0, .tv_nsec = CONTROL_MEASURE_DELAY_US * 1000 };
+    const uint32_t        period        = control_stats.period;
+
+    k_imtq_set_traffic_class(IMTQ_TRAFFIC_CONTROL);
+
+    while (atomic_load(&control_running))
+    {
+        if (read(control_timer, &expirations, sizeof(expirations))
+            != sizeof(expirations))
+        {
+            continue;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &sample.timestamp);
+
+        /* The deadline this cycle was released for */
+        ticks += expirations;
+        deadline = control_first;
+        kprv_imtq_timespec_add_us(&deadline, (ticks - 1) * period);
+
+        int64_t latency = kprv_imtq_timespec_diff_us(&sample.timestamp, &deadline);
+        if (latency < 0)
+        {
+            latency = 0;
+        }
+
+        bool actuate = false;
+
+        status = k_imtq_start_measurement();
+        if (status == ADCS_OK)
+        {
+            nanosleep(&MEASURE_DELAY, NULL);
+            status = k_imtq_get_calib_mtm(&sample.data);
+        }
+
+        if (status == ADCS_OK)
+        {
+            k_imtq_estimator_update(&sample, NULL);
+
+            memset(&dipole, 0, sizeof(dipole));
+            actuate = control_config.compute(&sample, &dipole,
+                                             control_config.arg);
+            if (actuate)
+            {
+                status = k_imtq_start_actuation_dipole(
+                    dipole, control_config.actuation_time);
+            }
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &done);
+        kprv_imtq_timespec_add_us(&deadline, period);
+
+        uint32_t exec = (uint32_t) kprv_imtq_timespec_diff_us(&done, &sample.timestamp);
+        bool     late = (expirations > 1)
+                    || kprv_imtq_timespec_diff_us(&done, &deadline) > 0;
+
+        pthread_mutex_lock(&control_stats_mutex);
+        if (late)
+        {
+            control_stats.deadline_misses++;
+        }
+
+        if (status != ADCS_OK)
+        {
+            control_stats.errors++;
+        }
+        else
+        {
+            control_stats.cycles++;
+            if (!actuate)
+            {
+                control_stats.skipped++;
+            }
+
+            kprv_imtq_control_update(&control_stats.latency_max,
+                                     &control_latency_total,
+                                     &control_stats.latency_mean,
+                                     (uint32_t) latency, control_stats.cycles);
+            kprv_imtq_control_update(&control_stats.exec_max,
+                                     &control_exec_total,
+                                     &control_stats.exec_mean, exec,
+                                     control_stats.cycles);
+
+            if (last_latency >= 0)
+            {
+                int64_t jitter = latency - last_latency;
+                if (jitter < 0)
+                {
+                    jitter = -jitter;
+                }
+
+                /* No jitter sample exists for the first cycle */
+                kprv_imtq_control_update(&control_stats.jitter_max,
+                                         &control_jitter_total,
+                                         &control_stats.jitter_mean,
+                                         (uint32_t) jitter,
+                                         control_stats.cycles - 1);
+            }
+            last_latency = latency;
+        }
+        pthread_mutex_unlock(&control_stats_mutex);
+    }
+
+    return NULL;
+}
+
+static void kprv_imtq_control_cleanup(void)
+{
+    if (control_timer >= 0)
+    {
+        close(control_timer);
+        control_timer = -1;
+    }
+
+    if (control_locked)
+    {
+        munlockall();
+        control_locked = false;
+    }
+}
+
+KADCSStatus k_imtq_control_start(const imtq_control_config * config)
+{
+    pthread_attr_t     attr;
+    struct sched_param param = { 0 };
+    int                ret;
+
+    if (config == NULL || config->compute == NULL)
+    {
+        return ADCS_ERROR_CONFIG;
+    }
+
+    if (config->rate == 0 || config->rate > IMTQ_CONTROL_MAX_RATE)
+    {
+        fprintf(stderr, "Invalid iMTQ control loop rate requested: %d\n",
+                config->rate);
+        return ADCS_ERROR_CONFIG;
+    }
+
+    uint32_t period = 1000000 / config->rate;
+
+    /*
+     * Each cycle actuates after measuring, and the coils' field has to decay
+     * before the next cycle measures. Otherwise every sample is corrupted
+     */
+    if (config->actuation_time == 0
+        || (uint32_t) config->actuation_time * 1000
+               > period - CONTROL_MEASURE_DELAY_US - IMTQ_CONTROL_SETTLE_TIME * 1000)
+    {
+        fprintf(stderr,
+                "iMTQ control actuation time (%dms) must be non-zero and leave "
+                "time to measure in the loop period\n",
+                config->actuation_time);
+        return ADCS_ERROR_CONFIG;
+    }
+
+    if (config->priority < 0 || config->priority > sched_get_priority_max(SCHED_FIFO))
+    {
+        fprintf(stderr, "Invalid iMTQ control loop priority requested: %d\n",
+                config->priority);
+        return ADCS_ERROR_CONFIG;
+    }
+
+    pthread_mutex_lock(&control_mutex);
+
+    if (handle_control != 0)
+    {
+        fprintf(stderr, "iMTQ control loop already started\n");
+        pthread_mutex_unlock(&control_mutex);
+        return ADCS_ERROR;
+    }
+
+    control_config = *config;
+
+    if (config->lock_memory)
+    {
+        /* Keep page faults out of the loop */
+        if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+        {
+            perror("Failed to lock iMTQ control loop memory");
+            pthread_mutex_unlock(&control_mutex);
+            return ADCS_ERROR;
+        }
+        control_locked = true;
+    }
+
+    control_timer = timerfd_create(CLOCK_MONOTONIC, 0);
+    if (control_timer < 0)
+    {
+        perror("Failed to create iMTQ control timer");
+        kprv_imtq_control_cleanup();
+        pthread_mutex_unlock(&control_mutex);
+        return ADCS_ERROR;
+    }
+
+    pthread_mutex_lock(&control_stats_mutex);
+    memset(&control_stats, 0, sizeof(control_stats));
+    control_stats.period  = period;
+    control_latency_total = 0;
+    control_jitter_total  = 0;
+    control_exec_total    = 0;
+    pthread_mutex_unlock(&control_stats_mutex);
+
+    pthread_attr_init(&attr);
+
+    if (config->priority > 0)
+    {
+        param.sched_priority = config->priority;
+        pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+        pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+        pthread_attr_setschedparam(&attr, &param);
+    }
+
+    if (config->cpu >= 0)
+    {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(config->cpu, &cpus);
+        pthread_attr_setaffinity_np(&attr, sizeof(cpus), &cpus);
+    }
+
+    /*
+     * Deadlines are absolute, so the loop stays locked to its original
+     * schedule no matter how long each cycle takes
+     */
+    clock_gettime(CLOCK_MONOTONIC, &control_first);
+    kprv_imtq_timespec_add_us(&control_first, period);
+
+    struct itimerspec timer = {
+        .it_interval = {.tv_sec = period / 1000000, .tv_nsec = (period % 1000000) * 1000 },
+        .it_value    = control_first
+    };
+
+    if (timerfd_settime(control_timer, TFD_TIMER_ABSTIME, &timer, NULL) != 0)
+    {
+        perror("Failed to start iMTQ control timer");
+        pthread_attr_destroy(&attr);
+        kprv_imtq_control_cleanup();
+        pthread_mutex_unlock(&control_mutex);
+        return ADCS_ERROR;
+    }
+
+    atomic_store(&control_running, true);
+
+    ret = pthread_create(&handle_control, &attr, kprv_imtq_control_thread, NULL);
+    pthread_attr_destroy(&attr);
+    if (ret != 0)
+    {
+        fprintf(stderr, "Failed to create iMTQ control thread: %s\n",
+                strerror(ret));
+        handle_control = 0;
+        atomic_store(&control_running, false);
+        kprv_imtq_control_cleanup();
+        pthread_mutex_unlock(&control_mutex);
+        return ADCS_ERROR;
+    }
+
+    pthread_mutex_unlock(&control_mutex);
+
+    return ADCS_OK;
+}
+
+KADCSStatus k_imtq_control_stop(void)
+{
+    pthread_mutex_lock(&control_mutex);
+
+    if (handle_control == 0)
+    {
+        fprintf(stderr, "iMTQ control loop has not been started\n");
+        pthread_mutex_unlock(&control_mutex);
+        return ADCS_ERROR;
+    }
+
+    /* Let the current cycle finish so the iMTQ mutex is never left held */
+    atomic_store(&control_running, false);
+
+    if (pthread_join(handle_control, NULL) != 0)
+    {
+        perror("Failed to rejoin iMTQ control thread");
+        pthread_mutex_unlock(&control_mutex);
+        return ADCS_ERROR;
+    }
+
+    handle_control = 0;
+
+    kprv_imtq_control_cleanup();
+
+    pthread_mutex_unlock(&control_mutex);
+
+    /* Don't leave the coils running with the last commanded dipole */
+    return k_imtq_cancel_op();
+}
+
+KADCSStatus k_imtq_control_get_stats(imtq_control_stats * stats)
+{
+    if (stats == NULL)
+    {
+        return ADCS_ERROR_CONFIG;
+    }
+
+    pthread_mutex_lock(&control_stats_mutex);
+    *stats = control_stats;
+    pthread_mutex_unlock(&control_stats_mutex);
+
+    return ADCS_OK;
+}
@@ -17,9 +17,13 @@
  */
 
 #include <imtq.h>
+#include <errno.h>
 #include <i2c.h>
+#include <watchdog.h>
 #include <pthread.h>
+#include <stdbool.h>
 #include <stdio.h>
+#include <string.h>
 #include <sys/syscall.h>
 #include <time.h>
 #include <unistd.h>
@@ -41,6 +45,159 @@ static uint16_t imqt_addr = 0x10;
  */
 static int wd_timeout = 60;
 
+/**
+ * How long to wait for the iMTQ mutex before giving up (in seconds)
+ */
+#define IMTQ_LOCK_TIMEOUT 1
+
+/**
+ * Traffic class of the transfers made by the current thread
+ */
+static __thread imtq_traffic_class imtq_traffic = IMTQ_TRAFFIC_TELEMETRY;
+
+/*
+ * Priority gate. Counts the control and watchdog transfers which are waiting
+ * for the iMTQ, so that new telemetry transfers can hold off until they're done
+ */
+static pthread_mutex_t gate_mutex       = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  gate_cond        = PTHREAD_COND_INITIALIZER;
+static int             priority_waiting = 0;
+
+/*
+ * Lock statistics for each traffic class
+ */
+static imtq_lock_stats lock_stats[IMTQ_TRAFFIC_CLASSES] = { 0 };
+static pthread_mutex_t lock_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * When the current holder took the iMTQ mutex. Only touched by the holder
+ */
+static struct timespec lock_acquired;
+
+static uint32_t kprv_imtq_elapsed_us(const struct timespec * start,
+                                     const struct timespec * end)
+{
+    return (uint32_t) ((end->tv_sec - start->tv_sec) * 1000000
+                       + (end->tv_nsec - start->tv_nsec) / 1000);
+}
+
+/* pthread timed waits take absolute CLOCK_REALTIME deadlines */
+static void kprv_imtq_lock_deadline(struct timespec * deadline)
+{
+    clock_gettime(CLOCK_REALTIME, deadline);
+    deadline->tv_sec += IMTQ_LOCK_TIMEOUT;
+}
+
+static KADCSStatus kprv_imtq_lock(void)
+{
+    struct timespec    start;
+    struct timespec    now;
+    struct timespec    deadline;
+    imtq_traffic_class traffic   = imtq_traffic;
+    bool               priority  = (traffic != IMTQ_TRAFFIC_TELEMETRY);
+    bool               contended = false;
+    int                ret       = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    kprv_imtq_lock_deadline(&deadline);
+
+    pthread_mutex_lock(&gate_mutex);
+    if (priority)
+    {
+        priority_waiting++;
+    }
+    else
+    {
+        /* Let any waiting control or watchdog transfers go first */
+        while (priority_waiting > 0 && ret == 0)
+        {
+            contended = true;
+            ret = pthread_cond_timedwait(&gate_cond, &gate_mutex, &deadline);
+        }
+    }
+    pthread_mutex_unlock(&gate_mutex);
+
+    if (ret == 0)
+    {
+        ret = pthread_mutex_trylock(&imtq_mutex);
+        if (ret == EBUSY)
+        {
+            contended = true;
+            ret = pthread_mutex_timedlock(&imtq_mutex, &deadline);
+        }
+    }
+
+    if (priority)
+    {
+        pthread_mutex_lock(&gate_mutex);
+        if (--priority_waiting == 0)
+        {
+            pthread_cond_broadcast(&gate_cond);
+        }
+        pthread_mutex_unlock(&gate_mutex);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    uint32_t wait = kprv_imtq_elapsed_us(&start, &now);
+
+    pthread_mutex_lock(&lock_stats_mutex);
+    imtq_lock_stats * stats = &lock_stats[traffic];
+    if (contended)
+    {
+        stats->contended++;
+    }
+    if (ret == 0)
+    {
+        stats->acquisitions++;
+        stats->wait_total += wait;
+        if (wait > stats->wait_max)
+        {
+            stats->wait_max = wait;
+        }
+    }
+    else if (ret == ETIMEDOUT)
+    {
+        stats->timeouts++;
+    }
+    pthread_mutex_unlock(&lock_stats_mutex);
+
+    if (ret != 0)
+    {
+        errno = ret;
+        perror("Failed to take MTQ mutex");
+        fprintf(stderr, "PID: %d TID: %ld", getpid(), syscall(SYS_gettid));
+        return ADCS_ERROR_MUTEX;
+    }
+
+    lock_acquired = now;
+
+    return ADCS_OK;
+}
+
+static void kprv_imtq_unlock(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    uint32_t hold = kprv_imtq_elapsed_us(&lock_acquired, &now);
+
+    if (pthread_mutex_unlock(&imtq_mutex) != 0)
+    {
+        perror("Failed to unlock MTQ mutex");
+        fprintf(stderr, "PID: %d TID: %ld", getpid(), syscall(SYS_gettid));
+        return;
+    }
+
+    pthread_mutex_lock(&lock_stats_mutex);
+    imtq_lock_stats * stats = &lock_stats[imtq_traffic];
+    stats->hold_total += hold;
+    if (hold > stats->hold_max)
+    {
+        stats->hold_max = hold;
+    }
+    pthread_mutex_unlock(&lock_stats_mutex);
+}
+
 KADCSStatus k_adcs_init(char * bus, uint16_t addr, int timeout)
 {
     imqt_addr = addr;
@@ -55,7 +212,9 @@ KADCSStatus k_adcs_init(char * bus, uint16_t addr, int timeout)
     }
 
     pthread_mutexattr_t mutex_attr;
-    if (pthread_mutexattr_settype(&mutex_attr, PTHREAD_MUTEX_ERRORCHECK) != 0)
+    if (pthread_mutexattr_init(&mutex_attr) != 0
+        || pthread_mutexattr_settype(&mutex_attr, PTHREAD_MUTEX_ERRORCHECK) != 0
+        || pthread_mutexattr_setprotocol(&mutex_attr, PTHREAD_PRIO_INHERIT) != 0)
     {
         perror("Failed to set up MTQ mutex attr");
         k_adcs_terminate();
@@ -64,9 +223,11 @@ KADCSStatus k_adcs_init(char * bus, uint16_t addr, int timeout)
     if (pthread_mutex_init(&imtq_mutex, &mutex_attr) != 0)
     {
         perror("Failed to set up MTQ mutex");
+        pthread_mutexattr_destroy(&mutex_attr);
         k_adcs_terminate();
         return ADCS_ERROR_MUTEX;
     }
+    pthread_mutexattr_destroy(&mutex_attr);
 
     KADCSStatus imtq_status;
 
@@ -84,10 +245,12 @@ KADCSStatus k_adcs_init(char * bus, uint16_t addr, int timeout)
 
 void k_adcs_terminate(void)
 {
-    const struct timespec MUTEX_TIMEOUT = {.tv_sec = 1, .tv_nsec = 0 };
+    struct timespec deadline;
+
+    kprv_imtq_lock_deadline(&deadline);
 
     /* Destroy the mutex */
-    if (pthread_mutex_timedlock(&imtq_mutex, &MUTEX_TIMEOUT) != 0)
+    if (pthread_mutex_timedlock(&imtq_mutex, &deadline) != 0)
     {
         perror("Failed to take MTQ mutex");
         fprintf(stderr, "PID: %d TID: %ld", getpid(), syscall(SYS_gettid));
@@ -106,6 +269,9 @@ void k_adcs_terminate(void)
     /* Close the I2C bus */
     k_i2c_terminate(&i2c_bus);
 
+    kprv_imtq_clear_housekeeping_cal();
+    k_imtq_estimator_reset();
+
     return;
 }
 
@@ -123,27 +289,27 @@ KADCSStatus k_adcs_passthrough(const uint8_t * tx, int tx_len, uint8_t * rx,
  * to get a response (since the system was rebooting)
  */
 
-void * kprv_imtq_watchdog_thread(void * args)
+static int kprv_imtq_watchdog_kick(void * arg)
 {
-    KADCSStatus status;
+    KADCSStatus        status;
+    imtq_traffic_class traffic = imtq_traffic;
 
-    while (1)
-    {
-        k_adcs_noop();
+    /* The first kick is made from the thread which started the watchdog */
+    imtq_traffic = IMTQ_TRAFFIC_WATCHDOG;
+    status = k_adcs_noop();
+    imtq_traffic = traffic;
 
-        sleep(wd_timeout / 3);
-    }
-
-    return NULL;
+    return status;
 }
 
-pthread_t handle_watchdog = { 0 };
+/* Watchdog scheduler ID, or -1 if not started */
+static int imtq_watchdog = -1;
 
 KADCSStatus k_imtq_watchdog_start(void)
 {
-    if (handle_watchdog != 0)
+    if (imtq_watchdog >= 0)
     {
-        fprintf(stderr, "ADCS watchdog thread already started\n");
+        fprintf(stderr, "ADCS watchdog already started\n");
         return ADCS_OK;
     }
 
@@ -151,15 +317,18 @@ KADCSStatus k_imtq_watchdog_start(void)
     {
         fprintf(
             stderr,
-            "ADCS watchdog has been disabled. No thread will be startd\n");
+            "ADCS watchdog has been disabled. No kicks will be scheduled\n");
         return ADCS_OK;
     }
 
-    if (pthread_create(&handle_watchdog, NULL, kprv_imtq_watchdog_thread, NULL)
-        != 0)
+    uint32_t period = (uint32_t) wd_timeout * 1000 / 3;
+
+    if (k_watchdog_register("iMTQ", period, period / 4,
+                            kprv_imtq_watchdog_kick, NULL, &imtq_watchdog)
+        != WATCHDOG_OK)
     {
-        perror("Failed to create ADCS watchdog thread");
-        handle_watchdog = 0;
+        fprintf(stderr, "Failed to start ADCS watchdog\n");
+        imtq_watchdog = -1;
         return ADCS_ERROR;
     }
 
@@ -168,42 +337,67 @@ KADCSStatus k_imtq_watchdog_start(void)
 
 KADCSStatus k_imtq_watchdog_stop(void)
 {
-    if (handle_watchdog == 0)
+    if (imtq_watchdog < 0)
     {
-        perror("ADCS watchdog has not been started");
+        fprintf(stderr, "ADCS watchdog has not been started\n");
         return ADCS_ERROR;
     }
 
-    /* Send the cancel request */
-    if (pthread_cancel(handle_watchdog) != 0)
+    /* No more kicks will be made once this returns */
+    if (k_watchdog_unregister(imtq_watchdog) != WATCHDOG_OK)
     {
-        perror("Failed to cancel ADCS watchdog thread");
+        fprintf(stderr, "Failed to stop ADCS watchdog\n");
         return ADCS_ERROR;
     }
 
-    /* Wait for the cancellation to complete */
-    if (pthread_join(handle_watchdog, NULL) != 0)
+    imtq_watchdog = -1;
+
+    return ADCS_OK;
+}
+
+KADCSStatus k_imtq_reset(void)
+{
+    return k_adcs_reset(SOFT_RESET);
+}
+
+KADCSStatus k_imtq_set_traffic_class(imtq_traffic_class traffic)
+{
+    if (traffic >= IMTQ_TRAFFIC_CLASSES)
     {
-        perror("Failed to rejoin ADCS watchdog thread");
-        return ADCS_ERROR;
+        return ADCS_ERROR_CONFIG;
     }
 
-    handle_watchdog = 0;
+    imtq_traffic = traffic;
 
     return ADCS_OK;
 }
 
-KADCSStatus k_imtq_reset(void)
+KADCSStatus k_imtq_get_lock_stats(imtq_traffic_class traffic, imtq_lock_stats * stats)
 {
-    return k_adcs_reset(SOFT_RESET);
+    if (traffic >= IMTQ_TRAFFIC_CLASSES || stats == NULL)
+    {
+        return ADCS_ERROR_CONFIG;
+    }
+
+    pthread_mutex_lock(&lock_stats_mutex);
+    *stats = lock_stats[traffic];
+    pthread_mutex_unlock(&lock_stats_mutex);
+
+    return ADCS_OK;
+}
+
+void k_imtq_reset_lock_stats(void)
+{
+    pthread_mutex_lock(&lock_stats_mutex);
+    memset(lock_stats, 0, sizeof(lock_stats));
+    pthread_mutex_unlock(&lock_stats_mutex);
 }
 
 KADCSStatus kprv_imtq_transfer(const uint8_t * tx, int tx_len, uint8_t * rx,
                                int rx_len, const struct timespec * delay)
 {
-    KI2CStatus status;
-
-    const struct timespec MUTEX_TIMEOUT = {.tv_sec = 1, .tv_nsec = 0 };
+    KI2CStatus  status;
+    KADCSStatus lock_status;
 
     if (tx == NULL || tx_len < 1 || rx == NULL
         || rx_len < (int) sizeof(imtq_resp_header))
@@ -211,22 +405,17 @@ KADCSStatus kprv_imtq_transfer(const uint8_t * tx, int tx_len, uint8_t * rx,
         return ADCS_ERROR_CONFIG;
     }
 
-    if (pthread_mutex_timedlock(&imtq_mutex, &MUTEX_TIMEOUT) != 0)
+    lock_status = kprv_imtq_lock();
+    if (lock_status != ADCS_OK)
     {
-        perror("Failed to take MTQ mutex");
-        fprintf(stderr, "PID: %d TID: %ld", getpid(), syscall(SYS_gettid));
-        return ADCS_ERROR_MUTEX;
+        return lock_status;
     }
 
     status = k_i2c_write(i2c_bus, imqt_addr, (uint8_t *) tx, tx_len);
     if (status != I2C_OK)
     {
         fprintf(stderr, "Failed to send MTQ command: %d\n", status);
-        if (pthread_mutex_unlock(&imtq_mutex) != 0)
-        {
-            perror("Failed to unlock MTQ mutex");
-            fprintf(stderr, "PID: %d TID: %ld", getpid(), syscall(SYS_gettid));
-        }
+        kprv_imtq_unlock();
         return ADCS_ERROR;
     }
 
@@ -246,11 +435,7 @@ KADCSStatus kprv_imtq_transfer(const uint8_t * tx, int tx_len, uint8_t * rx,
 
     status = k_i2c_read(i2c_bus, imqt_addr, rx, rx_len);
 
-    if (pthread_mutex_unlock(&imtq_mutex) != 0)
-    {
-        perror("Failed to unlock MTQ mutex");
-        fprintf(stderr, "PID: %d TID: %ld", getpid(), syscall(SYS_gettid));
-    }
+    kprv_imtq_unlock();
 
     if (status != I2C_OK)
     {
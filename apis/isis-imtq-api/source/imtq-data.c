@@ -17,37 +17,21 @@
  */
 
 #include <imtq.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 
 /*
- * Array of all possible iMTQ configuration parameters. Used for fetching the
- * current configuration settings for debug telemetry
+ * Minimum amount of time to wait between starting an MTM measurement and
+ * requesting its results, in microseconds
  */
-const uint16_t adcs_config_params[] = {
-        MTM_SELECT,
-        MTM_INTERNAL_TIME, MTM_EXTERNAL_TIME,
-        MTM_INTERNAL_MAP_X, MTM_INTERNAL_MAP_Y, MTM_INTERNAL_MAP_Z,
-        MTM_EXTERNAL_MAP_X, MTM_EXTERNAL_MAP_Y, MTM_EXTERNAL_MAP_Z,
-        MTM_MATRIX_R1_C1, MTM_MATRIX_R1_C2, MTM_MATRIX_R1_C3, MTM_MATRIX_R2_C1, MTM_MATRIX_R2_C2, MTM_MATRIX_R2_C3, MTM_MATRIX_R3_C1, MTM_MATRIX_R3_C2, MTM_MATRIX_R3_C3,
-        MTM_BIAS_X, MTM_BIAS_Y, MTM_BIAS_Z,
-        ADC_COIL_CURRENT_BIAS_X, ADC_COIL_CURRENT_BIAS_Y, ADC_COIL_CURRENT_BIAS_Z,
-        ADC_COIL_CURRENT_MULT_X, ADC_COIL_CURRENT_MULT_Y, ADC_COIL_CURRENT_MULT_Z,
-        ADC_COIL_CURRENT_DIV_X, ADC_COIL_CURRENT_DIV_Y, ADC_COIL_CURRENT_DIV_Z,
-        ADC_COIL_TEMP_BIAS_X, ADC_COIL_TEMP_BIAS_Y, ADC_COIL_TEMP_BIAS_Z,
-        ADC_COIL_TEMP_MULT_X, ADC_COIL_TEMP_MULT_Y, ADC_COIL_TEMP_MULT_Z,
-        ADC_COIL_TEMP_DIV_X, ADC_COIL_TEMP_DIV_Y, ADC_COIL_TEMP_DIV_Z,
-        DETUMBLE_FREQUENCY, BDOT_GAIN, MTM_FILTER_SENSITIVITY, MTM_FILTER_WEIGHT,
-        COIL_AREA_X, COIL_AREA_Y, COIL_AREA_Z,
-        COIL_CURRENT_LIMIT,
-        CURRENT_FEEDBACK_ENABLE,
-        CURRENT_FEEDBACK_GAIN_X, CURRENT_FEEDBACK_GAIN_Y, CURRENT_FEEDBACK_GAIN_Z,
-        CURRENT_MAP_TEMP_T1, CURRENT_MAP_TEMP_T2, CURRENT_MAP_TEMP_T3, CURRENT_MAP_TEMP_T4, CURRENT_MAP_TEMP_T5, CURRENT_MAP_TEMP_T6, CURRENT_MAP_TEMP_T7,
-        CURRENT_MAX_X_T1, CURRENT_MAX_X_T2, CURRENT_MAX_X_T3, CURRENT_MAX_X_T4, CURRENT_MAX_X_T5, CURRENT_MAX_X_T6, CURRENT_MAX_X_T7,
-        CURRENT_MAX_Y_T1, CURRENT_MAX_Y_T2, CURRENT_MAX_Y_T3, CURRENT_MAX_Y_T4, CURRENT_MAX_Y_T5, CURRENT_MAX_Y_T6, CURRENT_MAX_Y_T7,
-        CURRENT_MAX_Z_T1, CURRENT_MAX_Z_T2, CURRENT_MAX_Z_T3, CURRENT_MAX_Z_T4, CURRENT_MAX_Z_T5, CURRENT_MAX_Z_T6, CURRENT_MAX_Z_T7,
-        HW_CONFIG, WATCHDOG_TIMEOUT, SLAVE_ADDRESS, SOFTWARE_VERSION
-};
+#define MTM_MEASURE_DELAY_US 1001
+
+/* Cached housekeeping calibration for host-side conversion */
+static imtq_housekeeping_cal hk_cal;
+static bool                  hk_cal_valid = false;
+static pthread_mutex_t       hk_cal_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 /* Human-readable names for the axis tested in a self-test step */
 const char test_step[8][5] = {
@@ -139,16 +123,6 @@ KADCSStatus k_adcs_get_telemetry(ADCSTelemType type, JsonNode * buffer)
     return status;
 }
 
-KADCSStatus k_adcs_get_orientation(adcs_orient * data)
-{
-    return ADCS_ERROR_NOT_IMPLEMENTED;
-}
-
-KADCSStatus k_adcs_get_spin(adcs_spin * data)
-{
-    return ADCS_ERROR_NOT_IMPLEMENTED;
-}
-
 KADCSStatus kprv_adcs_get_status_telemetry(JsonNode * buffer)
 {
     KADCSStatus status;
@@ -165,27 +139,27 @@ KADCSStatus kprv_adcs_get_status_telemetry(JsonNode * buffer)
         switch (state.mode)
         {
             case IDLE:
-                json_append_member(buffer, "system_mode", json_mkstring("IDLE"));
+                json_append_member(buffer, "system_mode", json_mkstring_arena(buffer->arena, "IDLE"));
                 break;
             case DETUMBLE:
-                json_append_member(buffer, "system_mode", json_mkstring("DETUMBLE"));
+                json_append_member(buffer, "system_mode", json_mkstring_arena(buffer->arena, "DETUMBLE"));
                 break;
             case SELFTEST:
-                json_append_member(buffer, "system_mode", json_mkstring("SELFTEST"));
+                json_append_member(buffer, "system_mode", json_mkstring_arena(buffer->arena, "SELFTEST"));
                 break;
         }
 
-        json_append_member(buffer, "system_error", json_mkstring((state.error) ? "yes" : "no"));
-        json_append_member(buffer, "system_configured", json_mkstring((state.config) ? "yes" : "no"));
-        json_append_member(buffer, "system_uptime", json_mknumber((double) state.uptime));
+        json_append_member(buffer, "system_error", json_mkstring_arena(buffer->arena, (state.error) ? "yes" : "no"));
+        json_append_member(buffer, "system_configured", json_mkstring_arena(buffer->arena, (state.config) ? "yes" : "no"));
+        json_append_member(buffer, "system_uptime", json_mknumber_arena(buffer->arena, (double) state.uptime));
 
 
     }
     else if (status == ADCS_ERROR)
     {
         /* Assume system is offline, so uptime is zero */
-        json_append_member(buffer, "system_mode", json_mkstring("OFFLINE"));
-        json_append_member(buffer, "system_uptime", json_mknumber(0));
+        json_append_member(buffer, "system_mode", json_mkstring_arena(buffer->arena, "OFFLINE"));
+        json_append_member(buffer, "system_uptime", json_mknumber_arena(buffer->arena, 0));
     }
 
     return status;
@@ -194,100 +168,151 @@ KADCSStatus kprv_adcs_get_status_telemetry(JsonNode * buffer)
 
 KADCSStatus kprv_adcs_get_nominal_telemetry(JsonNode * buffer)
 {
-    KADCSStatus status = ADCS_OK;
-    KADCSStatus nom_status;
-
-    imtq_housekeeping_raw house_raw = { 0 };
-    imtq_housekeeping_eng house_eng = { 0 };
-    imtq_detumble         detumble  = { 0 };
-    imtq_mtm_msg          mtm_raw   = { 0 };
-    imtq_mtm_msg          mtm_calib = { 0 };
-    imtq_dipole           dipole    = { 0 };
+    KADCSStatus           status;
+    imtq_nominal_snapshot snapshot = { 0 };
 
     if (buffer == NULL)
     {
         return ADCS_ERROR_CONFIG;
     }
 
-    /* Housekeeping data */
-    nom_status = k_imtq_get_raw_housekeeping(&house_raw);
-    nom_status |= k_imtq_get_eng_housekeeping(&house_eng);
-    if (nom_status != ADCS_OK)
+    status = k_adcs_get_nominal_snapshot(&snapshot, NOMINAL_ALL);
+
+    k_adcs_nominal_to_json(&snapshot, buffer);
+
+    return status;
+}
+
+/*
+ * Number of microseconds which have passed since the given start time.
+ * Also moves the start time forward, so that consecutive calls measure
+ * consecutive stages
+ */
+static uint32_t kprv_adcs_stage_time(struct timespec * start)
+{
+    struct timespec now;
+    uint32_t        elapsed;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    elapsed = (uint32_t) ((now.tv_sec - start->tv_sec) * 1000000
+                          + (now.tv_nsec - start->tv_nsec) / 1000);
+
+    *start = now;
+
+    return elapsed;
+}
+
+/*
+ * The MTM measurement is started before anything else is requested, so that
+ * the other requests can be made while the MTM is integrating. The MTM
+ * results are then read last.
+ */
+KADCSStatus k_adcs_get_nominal_snapshot(imtq_nominal_snapshot * snapshot, uint8_t mask)
+{
+    KADCSStatus     status = ADCS_OK;
+    KADCSStatus     nom_status;
+    KADCSStatus     measure_status = ADCS_ERROR;
+    struct timespec begin;
+    struct timespec stage;
+    struct timespec measure_done;
+
+    if (snapshot == NULL)
     {
-        status = ADCS_ERROR;
+        return ADCS_ERROR_CONFIG;
     }
-    else
+
+    snapshot->valid = 0;
+    memset(&snapshot->timing, 0, sizeof(snapshot->timing));
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    stage        = begin;
+    measure_done = begin;
+
+    /* Kick off the magnetometer measurement */
+    if (mask & NOMINAL_MTM)
     {
-        /* Raw ADC values */
-        json_append_member(buffer, "supply_voltage_digital_raw", json_mknumber((double) house_raw.voltage_d));
-        json_append_member(buffer, "supply_voltage_analog_raw", json_mknumber((double) house_raw.voltage_a));
-        json_append_member(buffer, "supply_current_digital_raw", json_mknumber((double) house_raw.current_d));
-        json_append_member(buffer, "supply_current_analog_raw", json_mknumber((double) house_raw.current_a));
-        json_append_member(buffer, "coil_current_x_raw", json_mknumber((double) house_raw.coil_current.x));
-        json_append_member(buffer, "coil_current_y_raw", json_mknumber((double) house_raw.coil_current.y));
-        json_append_member(buffer, "coil_current_z_raw", json_mknumber((double) house_raw.coil_current.z));
-        json_append_member(buffer, "coil_temp_x_raw", json_mknumber((double) house_raw.coil_temp.x));
-        json_append_member(buffer, "coil_temp_y_raw", json_mknumber((double) house_raw.coil_temp.y));
-        json_append_member(buffer, "coil_temp_z_raw", json_mknumber((double) house_raw.coil_temp.z));
-        json_append_member(buffer, "mcu_temp_raw", json_mknumber((double) house_raw.mcu_temp));
-
-        /* Converted values */
-        json_append_member(buffer, "supply_voltage_digital_eng", json_mknumber((double) house_eng.voltage_d));
-        json_append_member(buffer, "supply_voltage_analog_eng", json_mknumber((double) house_eng.voltage_a));
-        json_append_member(buffer, "supply_current_digital_eng", json_mknumber((double) house_eng.current_d));
-        json_append_member(buffer, "supply_current_analog_eng", json_mknumber((double) house_eng.current_a));
-        json_append_member(buffer, "coil_current_x_eng", json_mknumber((double) house_eng.coil_current.x));
-        json_append_member(buffer, "coil_current_y_eng", json_mknumber((double) house_eng.coil_current.y));
-        json_append_member(buffer, "coil_current_z_eng", json_mknumber((double) house_eng.coil_current.z));
-        json_append_member(buffer, "coil_temp_x_eng", json_mknumber((double) house_eng.coil_temp.x));
-        json_append_member(buffer, "coil_temp_y_eng", json_mknumber((double) house_eng.coil_temp.y));
-        json_append_member(buffer, "coil_temp_z_eng", json_mknumber((double) house_eng.coil_temp.z));
-        json_append_member(buffer, "mcu_temp_eng", json_mknumber((double) house_eng.mcu_temp));
+        measure_status = k_imtq_start_measurement();
+        if (measure_status != ADCS_OK)
+        {
+            status = ADCS_ERROR;
+        }
+
+        snapshot->timing.mtm_start = kprv_adcs_stage_time(&stage);
+        measure_done = stage;
     }
 
-    /* Data during last detumble loop */
-    nom_status = k_imtq_get_detumble(&detumble);
-    if (nom_status != ADCS_OK)
+    /* Housekeeping data */
+    if (mask & NOMINAL_HOUSEKEEPING)
     {
-        status = ADCS_ERROR;
+        nom_status = kprv_imtq_get_housekeeping(&snapshot->house_raw,
+                                                &snapshot->house_eng,
+                                                &snapshot->house_converted);
+        if (nom_status != ADCS_OK)
+        {
+            status = ADCS_ERROR;
+        }
+        else
+        {
+            snapshot->valid |= NOMINAL_HOUSEKEEPING;
+        }
+
+        snapshot->timing.housekeeping = kprv_adcs_stage_time(&stage);
     }
-    else
+
+    /* Data during last detumble loop */
+    if (mask & NOMINAL_DETUMBLE)
     {
-        json_append_member(buffer, "detumble_calib_mtm_x", json_mknumber((double) detumble.mtm_calib.x));
-        json_append_member(buffer, "detumble_calib_mtm_y", json_mknumber((double) detumble.mtm_calib.y));
-        json_append_member(buffer, "detumble_calib_mtm_z", json_mknumber((double) detumble.mtm_calib.z));
-        json_append_member(buffer, "detumble_filter_mtm_x", json_mknumber((double) detumble.mtm_filter.x));
-        json_append_member(buffer, "detumble_filter_mtm_y", json_mknumber((double) detumble.mtm_filter.y));
-        json_append_member(buffer, "detumble_filter_mtm_z", json_mknumber((double) detumble.mtm_filter.z));
-        json_append_member(buffer, "detumble_bdot_x", json_mknumber((double) detumble.bdot.x));
-        json_append_member(buffer, "detumble_bdot_y", json_mknumber((double) detumble.bdot.y));
-        json_append_member(buffer, "detumble_bdot_z", json_mknumber((double) detumble.bdot.z));
-        json_append_member(buffer, "detumble_dipole_x", json_mknumber((double) detumble.dipole.x));
-        json_append_member(buffer, "detumble_dipole_y", json_mknumber((double) detumble.dipole.y));
-        json_append_member(buffer, "detumble_dipole_z", json_mknumber((double) detumble.dipole.z));
-        json_append_member(buffer, "detumble_cmd_current_x", json_mknumber((double) detumble.cmd_current.x));
-        json_append_member(buffer, "detumble_cmd_current_y", json_mknumber((double) detumble.cmd_current.y));
-        json_append_member(buffer, "detumble_cmd_current_z", json_mknumber((double) detumble.cmd_current.z));
-        json_append_member(buffer, "detumble_coil_current_x", json_mknumber((double) detumble.coil_current.x));
-        json_append_member(buffer, "detumble_coil_current_y", json_mknumber((double) detumble.coil_current.y));
-        json_append_member(buffer, "detumble_coil_current_z", json_mknumber((double) detumble.coil_current.z));
+        nom_status = k_imtq_get_detumble(&snapshot->detumble);
+        if (nom_status != ADCS_OK)
+        {
+            status = ADCS_ERROR;
+        }
+        else
+        {
+            snapshot->valid |= NOMINAL_DETUMBLE;
+        }
+
+        snapshot->timing.detumble = kprv_adcs_stage_time(&stage);
     }
 
-    /* Current magnetometer measurements */
-    nom_status = k_imtq_start_measurement();
-    if (nom_status != ADCS_OK)
+    /* Commanded actuation dipole */
+    if (mask & NOMINAL_DIPOLE)
     {
-        status = ADCS_ERROR;
+        nom_status = k_imtq_get_dipole(&snapshot->dipole);
+        if (nom_status != ADCS_OK)
+        {
+            status = ADCS_ERROR;
+        }
+        else
+        {
+            snapshot->valid |= NOMINAL_DIPOLE;
+        }
+
+        snapshot->timing.dipole = kprv_adcs_stage_time(&stage);
     }
-    else
+
+    /* Current magnetometer measurements */
+    if ((mask & NOMINAL_MTM) && measure_status == ADCS_OK)
     {
-        const struct timespec TRANSFER_DELAY
-            = {.tv_sec = 0, .tv_nsec = 1000001 };
+        /*
+         * Only sleep for whatever part of the measurement time wasn't
+         * already covered by the other requests
+         */
+        uint32_t since_measure = kprv_adcs_stage_time(&measure_done);
+        if (since_measure < MTM_MEASURE_DELAY_US)
+        {
+            const struct timespec TRANSFER_DELAY
+                = {.tv_sec = 0,
+                   .tv_nsec = (MTM_MEASURE_DELAY_US - since_measure) * 1000 };
+
+            nanosleep(&TRANSFER_DELAY, NULL);
+        }
 
-        nanosleep(&TRANSFER_DELAY, NULL);
+        snapshot->timing.mtm_wait = kprv_adcs_stage_time(&stage);
 
-        nom_status = k_imtq_get_raw_mtm(&mtm_raw);
-        nom_status |= k_imtq_get_calib_mtm(&mtm_calib);
+        nom_status = k_imtq_get_raw_mtm(&snapshot->mtm_raw);
+        nom_status |= k_imtq_get_calib_mtm(&snapshot->mtm_calib);
 
         if (nom_status != ADCS_OK)
         {
@@ -295,30 +320,105 @@ KADCSStatus kprv_adcs_get_nominal_telemetry(JsonNode * buffer)
         }
         else
         {
-            json_append_member(buffer, "mtm_actuating", json_mkstring((mtm_raw.act_status) ? "yes" : "no"));
-            json_append_member(buffer, "mtm_x_raw", json_mknumber((double) mtm_raw.data.x));
-            json_append_member(buffer, "mtm_y_raw", json_mknumber((double) mtm_raw.data.y));
-            json_append_member(buffer, "mtm_z_raw", json_mknumber((double) mtm_raw.data.z));
-            json_append_member(buffer, "mtm_x_calib", json_mknumber((double) mtm_calib.data.x));
-            json_append_member(buffer, "mtm_y_calib", json_mknumber((double) mtm_calib.data.y));
-            json_append_member(buffer, "mtm_z_calib", json_mknumber((double) mtm_calib.data.z));
+            snapshot->valid |= NOMINAL_MTM;
         }
+
+        snapshot->timing.mtm_read = kprv_adcs_stage_time(&stage);
     }
 
-    /* Commanded actuation dipole */
-    nom_status = k_imtq_get_dipole(&dipole);
-    if (nom_status != ADCS_OK)
+    snapshot->timing.total = kprv_adcs_stage_time(&begin);
+
+    return status;
+}
+
+KADCSStatus k_adcs_nominal_to_json(const imtq_nominal_snapshot * snapshot, JsonNode * buffer)
+{
+    if (snapshot == NULL || buffer == NULL)
     {
-        status = ADCS_ERROR;
+        return ADCS_ERROR_CONFIG;
     }
-    else
+
+    if (snapshot->valid & NOMINAL_HOUSEKEEPING)
+    {
+        const imtq_housekeeping_raw * house_raw = &snapshot->house_raw;
+        const imtq_housekeeping_eng * house_eng = &snapshot->house_eng;
+
+        /* Raw ADC values */
+        json_append_member(buffer, "supply_voltage_digital_raw", json_mknumber_arena(buffer->arena, (double) house_raw->voltage_d));
+        json_append_member(buffer, "supply_voltage_analog_raw", json_mknumber_arena(buffer->arena, (double) house_raw->voltage_a));
+        json_append_member(buffer, "supply_current_digital_raw", json_mknumber_arena(buffer->arena, (double) house_raw->current_d));
+        json_append_member(buffer, "supply_current_analog_raw", json_mknumber_arena(buffer->arena, (double) house_raw->current_a));
+        json_append_member(buffer, "coil_current_x_raw", json_mknumber_arena(buffer->arena, (double) house_raw->coil_current.x));
+        json_append_member(buffer, "coil_current_y_raw", json_mknumber_arena(buffer->arena, (double) house_raw->coil_current.y));
+        json_append_member(buffer, "coil_current_z_raw", json_mknumber_arena(buffer->arena, (double) house_raw->coil_current.z));
+        json_append_member(buffer, "coil_temp_x_raw", json_mknumber_arena(buffer->arena, (double) house_raw->coil_temp.x));
+        json_append_member(buffer, "coil_temp_y_raw", json_mknumber_arena(buffer->arena, (double) house_raw->coil_temp.y));
+        json_append_member(buffer, "coil_temp_z_raw", json_mknumber_arena(buffer->arena, (double) house_raw->coil_temp.z));
+        json_append_member(buffer, "mcu_temp_raw", json_mknumber_arena(buffer->arena, (double) house_raw->mcu_temp));
+
+        /* Converted values. Only the coil channels are converted on the host */
+        if (!snapshot->house_converted)
+        {
+            json_append_member(buffer, "supply_voltage_digital_eng", json_mknumber_arena(buffer->arena, (double) house_eng->voltage_d));
+            json_append_member(buffer, "supply_voltage_analog_eng", json_mknumber_arena(buffer->arena, (double) house_eng->voltage_a));
+            json_append_member(buffer, "supply_current_digital_eng", json_mknumber_arena(buffer->arena, (double) house_eng->current_d));
+            json_append_member(buffer, "supply_current_analog_eng", json_mknumber_arena(buffer->arena, (double) house_eng->current_a));
+        }
+        json_append_member(buffer, "coil_current_x_eng", json_mknumber_arena(buffer->arena, (double) house_eng->coil_current.x));
+        json_append_member(buffer, "coil_current_y_eng", json_mknumber_arena(buffer->arena, (double) house_eng->coil_current.y));
+        json_append_member(buffer, "coil_current_z_eng", json_mknumber_arena(buffer->arena, (double) house_eng->coil_current.z));
+        json_append_member(buffer, "coil_temp_x_eng", json_mknumber_arena(buffer->arena, (double) house_eng->coil_temp.x));
+        json_append_member(buffer, "coil_temp_y_eng", json_mknumber_arena(buffer->arena, (double) house_eng->coil_temp.y));
+        json_append_member(buffer, "coil_temp_z_eng", json_mknumber_arena(buffer->arena, (double) house_eng->coil_temp.z));
+        if (!snapshot->house_converted)
+        {
+            json_append_member(buffer, "mcu_temp_eng", json_mknumber_arena(buffer->arena, (double) house_eng->mcu_temp));
+        }
+    }
+
+    if (snapshot->valid & NOMINAL_DETUMBLE)
     {
-        json_append_member(buffer, "dipole_x", json_mknumber((double) dipole.data.x));
-        json_append_member(buffer, "dipole_y", json_mknumber((double) dipole.data.y));
-        json_append_member(buffer, "dipole_z", json_mknumber((double) dipole.data.z));
+        const imtq_detumble * detumble = &snapshot->detumble;
+
+        json_append_member(buffer, "detumble_calib_mtm_x", json_mknumber_arena(buffer->arena, (double) detumble->mtm_calib.x));
+        json_append_member(buffer, "detumble_calib_mtm_y", json_mknumber_arena(buffer->arena, (double) detumble->mtm_calib.y));
+        json_append_member(buffer, "detumble_calib_mtm_z", json_mknumber_arena(buffer->arena, (double) detumble->mtm_calib.z));
+        json_append_member(buffer, "detumble_filter_mtm_x", json_mknumber_arena(buffer->arena, (double) detumble->mtm_filter.x));
+        json_append_member(buffer, "detumble_filter_mtm_y", json_mknumber_arena(buffer->arena, (double) detumble->mtm_filter.y));
+        json_append_member(buffer, "detumble_filter_mtm_z", json_mknumber_arena(buffer->arena, (double) detumble->mtm_filter.z));
+        json_append_member(buffer, "detumble_bdot_x", json_mknumber_arena(buffer->arena, (double) detumble->bdot.x));
+        json_append_member(buffer, "detumble_bdot_y", json_mknumber_arena(buffer->arena, (double) detumble->bdot.y));
+        json_append_member(buffer, "detumble_bdot_z", json_mknumber_arena(buffer->arena, (double) detumble->bdot.z));
+        json_append_member(buffer, "detumble_dipole_x", json_mknumber_arena(buffer->arena, (double) detumble->dipole.x));
+        json_append_member(buffer, "detumble_dipole_y", json_mknumber_arena(buffer->arena, (double) detumble->dipole.y));
+        json_append_member(buffer, "detumble_dipole_z", json_mknumber_arena(buffer->arena, (double) detumble->dipole.z));
+        json_append_member(buffer, "detumble_cmd_current_x", json_mknumber_arena(buffer->arena, (double) detumble->cmd_current.x));
+        json_append_member(buffer, "detumble_cmd_current_y", json_mknumber_arena(buffer->arena, (double) detumble->cmd_current.y));
+        json_append_member(buffer, "detumble_cmd_current_z", json_mknumber_arena(buffer->arena, (double) detumble->cmd_current.z));
+        json_append_member(buffer, "detumble_coil_current_x", json_mknumber_arena(buffer->arena, (double) detumble->coil_current.x));
+        json_append_member(buffer, "detumble_coil_current_y", json_mknumber_arena(buffer->arena, (double) detumble->coil_current.y));
+        json_append_member(buffer, "detumble_coil_current_z", json_mknumber_arena(buffer->arena, (double) detumble->coil_current.z));
     }
 
-    return status;
+    if (snapshot->valid & NOMINAL_MTM)
+    {
+        json_append_member(buffer, "mtm_actuating", json_mkstring_arena(buffer->arena, (snapshot->mtm_raw.act_status) ? "yes" : "no"));
+        json_append_member(buffer, "mtm_x_raw", json_mknumber_arena(buffer->arena, (double) snapshot->mtm_raw.data.x));
+        json_append_member(buffer, "mtm_y_raw", json_mknumber_arena(buffer->arena, (double) snapshot->mtm_raw.data.y));
+        json_append_member(buffer, "mtm_z_raw", json_mknumber_arena(buffer->arena, (double) snapshot->mtm_raw.data.z));
+        json_append_member(buffer, "mtm_x_calib", json_mknumber_arena(buffer->arena, (double) snapshot->mtm_calib.data.x));
+        json_append_member(buffer, "mtm_y_calib", json_mknumber_arena(buffer->arena, (double) snapshot->mtm_calib.data.y));
+        json_append_member(buffer, "mtm_z_calib", json_mknumber_arena(buffer->arena, (double) snapshot->mtm_calib.data.z));
+    }
+
+    if (snapshot->valid & NOMINAL_DIPOLE)
+    {
+        json_append_member(buffer, "dipole_x", json_mknumber_arena(buffer->arena, (double) snapshot->dipole.data.x));
+        json_append_member(buffer, "dipole_y", json_mknumber_arena(buffer->arena, (double) snapshot->dipole.data.y));
+        json_append_member(buffer, "dipole_z", json_mknumber_arena(buffer->arena, (double) snapshot->dipole.data.z));
+    }
+
+    return ADCS_OK;
 }
 
 KADCSStatus kprv_adcs_get_debug_telemetry(JsonNode * buffer)
@@ -333,61 +433,22 @@ KADCSStatus kprv_adcs_get_debug_telemetry(JsonNode * buffer)
     }
 
     /* Get all of the configuration values */
-    int num_config_params
-        = sizeof(adcs_config_params) / sizeof(adcs_config_params[0]);
-    for (int i = 0; i < num_config_params; i++)
+    for (int i = 0; i < IMTQ_NUM_PARAMS; i++)
     {
-        debug_status = k_imtq_get_param(adcs_config_params[i], &config_data);
+        const imtq_param_desc * param = &imtq_params[i];
+
+        debug_status = k_imtq_get_param(param->id, &config_data);
         if (debug_status == ADCS_OK)
         {
-            char param[7] = { 0 };
-            sprintf(param, "%#x", adcs_config_params[i]);
-
-            /* Convert the param value to a double and add a new JSON element
-             * to the return buffer */
-            switch (adcs_config_params[i] >> 12)
-            {
-                case 0x1:
-                    json_append_member(buffer, param, json_mknumber((double) config_data.value.int8_val));
-                    break;
-                case 0x2:
-                    json_append_member(buffer, param, json_mknumber((double) config_data.value.uint8_val));
-                    break;
-                case 0x3:
-                    json_append_member(buffer, param, json_mknumber((double) config_data.value.int16_val));
-                    break;
-                case 0x4:
-                    json_append_member(buffer, param, json_mknumber((double) config_data.value.uint16_val));
-                    break;
-                case 0x5:
-                    json_append_member(buffer, param, json_mknumber((double) config_data.value.int32_val));
-                    break;
-                case 0x6:
-                    json_append_member(buffer, param, json_mknumber((double) config_data.value.uint32_val));
-                    break;
-                case 0x7:
-                    json_append_member(buffer, param, json_mknumber((double) config_data.value.float_val));
-                    break;
-                case 0x8:
-                    json_append_member(buffer, param, json_mknumber((double) config_data.value.int64_val));
-                    break;
-                case 0x9:
-                    json_append_member(buffer, param, json_mknumber((double) config_data.value.uint64_val));
-                    break;
-                case 0xA:
-                    json_append_member(buffer, param, json_mknumber(config_data.value.double_val));
-                    break;
-                default:
-                    /* We shouldn't ever get here... */
-                    fprintf(stderr, "Unknown iMTQ configuration parameter "
-                                    "type passed: %s\n",
-                            param);
-                    status = ADCS_ERROR;
-            }
+            /* The response is packed, so take an aligned copy of the value */
+            imtq_config_value value = config_data.value;
+
+            json_append_member(buffer, param->key,
+                               json_mknumber_arena(buffer->arena, param->decode(&value)));
         }
         else
         {
-            fprintf(stderr, "Failed to fetch iMTQ param %#x: %d\n", adcs_config_params[i], status);
+            fprintf(stderr, "Failed to fetch iMTQ param %s: %d\n", param->name, debug_status);
             status = ADCS_ERROR;
             continue;
         }
@@ -477,19 +538,19 @@ void kprv_adcs_process_test(JsonNode * parent, imtq_test_result test)
     sprintf(coil_temp_y, "tr_%s_coil_temp_y", step);
     sprintf(coil_temp_z, "tr_%s_coil_temp_z", step);
 
-    json_append_member(parent, error, json_mknumber((double) test.error));
-    json_append_member(parent, mtm_raw_x, json_mknumber((double) test.mtm_raw.x));
-    json_append_member(parent, mtm_raw_y, json_mknumber((double) test.mtm_raw.y));
-    json_append_member(parent, mtm_raw_z, json_mknumber((double) test.mtm_raw.z));
-    json_append_member(parent, mtm_calib_x, json_mknumber((double) test.mtm_calib.x));
-    json_append_member(parent, mtm_calib_y, json_mknumber((double) test.mtm_calib.y));
-    json_append_member(parent, mtm_calib_z, json_mknumber((double) test.mtm_calib.z));
-    json_append_member(parent, coil_current_x, json_mknumber((double) test.coil_current.x));
-    json_append_member(parent, coil_current_y, json_mknumber((double) test.coil_current.y));
-    json_append_member(parent, coil_current_z, json_mknumber((double) test.coil_current.z));
-    json_append_member(parent, coil_temp_x, json_mknumber((double) test.coil_temp.x));
-    json_append_member(parent, coil_temp_y, json_mknumber((double) test.coil_temp.y));
-    json_append_member(parent, coil_temp_z, json_mknumber((double) test.coil_temp.z));
+    json_append_member(parent, error, json_mknumber_arena(parent->arena, (double) test.error));
+    json_append_member(parent, mtm_raw_x, json_mknumber_arena(parent->arena, (double) test.mtm_raw.x));
+    json_append_member(parent, mtm_raw_y, json_mknumber_arena(parent->arena, (double) test.mtm_raw.y));
+    json_append_member(parent, mtm_raw_z, json_mknumber_arena(parent->arena, (double) test.mtm_raw.z));
+    json_append_member(parent, mtm_calib_x, json_mknumber_arena(parent->arena, (double) test.mtm_calib.x));
+    json_append_member(parent, mtm_calib_y, json_mknumber_arena(parent->arena, (double) test.mtm_calib.y));
+    json_append_member(parent, mtm_calib_z, json_mknumber_arena(parent->arena, (double) test.mtm_calib.z));
+    json_append_member(parent, coil_current_x, json_mknumber_arena(parent->arena, (double) test.coil_current.x));
+    json_append_member(parent, coil_current_y, json_mknumber_arena(parent->arena, (double) test.coil_current.y));
+    json_append_member(parent, coil_current_z, json_mknumber_arena(parent->arena, (double) test.coil_current.z));
+    json_append_member(parent, coil_temp_x, json_mknumber_arena(parent->arena, (double) test.coil_temp.x));
+    json_append_member(parent, coil_temp_y, json_mknumber_arena(parent->arena, (double) test.coil_temp.y));
+    json_append_member(parent, coil_temp_z, json_mknumber_arena(parent->arena, (double) test.coil_temp.z));
 }
 
 /* iMTQ-specific functions */
@@ -525,7 +586,7 @@ KADCSStatus k_imtq_get_raw_mtm(imtq_mtm_msg * data)
     }
 
     status = kprv_imtq_transfer(&cmd, 1, (uint8_t *) data,
-                                sizeof(imtq_mtm_data), NULL);
+                                sizeof(imtq_mtm_msg), NULL);
     if (status != ADCS_OK)
     {
         fprintf(stderr, "Failed to get iMTQ MTM data (raw): %d\n", status);
@@ -546,7 +607,7 @@ KADCSStatus k_imtq_get_calib_mtm(imtq_mtm_msg * data)
     }
 
     status = kprv_imtq_transfer(&cmd, 1, (uint8_t *) data,
-                                sizeof(imtq_mtm_data), NULL);
+                                sizeof(imtq_mtm_msg), NULL);
     if (status != ADCS_OK)
     {
         fprintf(stderr, "Failed to get iMTQ MTM data (calibrated): %d\n",
@@ -731,3 +792,160 @@ KADCSStatus k_imtq_get_eng_housekeeping(imtq_housekeeping_eng * data)
 
     return ADCS_OK;
 }
+
+/* Host-side housekeeping conversion */
+
+static int32_t kprv_imtq_convert_adc(int32_t raw, const imtq_adc_conversion * conv)
+{
+    if (conv->div == 0)
+    {
+        return 0;
+    }
+
+    return ((raw - conv->bias) * conv->mult) / conv->div;
+}
+
+KADCSStatus k_imtq_load_housekeeping_cal(void)
+{
+    KADCSStatus           status;
+    imtq_config_resp      config_data;
+    imtq_housekeeping_cal cal = { 0 };
+
+    /*
+     * The coil ADC parameters are contiguous: bias, pre-multiplier and
+     * post-divider for each axis of the coil currents, then the same for the
+     * coil temperatures
+     */
+    const int num_params = ADC_COIL_TEMP_DIV_Z - ADC_COIL_CURRENT_BIAS_X + 1;
+    for (int i = 0; i < num_params; i++)
+    {
+        uint16_t param = ADC_COIL_CURRENT_BIAS_X + i;
+
+        status = k_imtq_get_param(param, &config_data);
+        if (status != ADCS_OK)
+        {
+            fprintf(stderr, "Failed to fetch iMTQ ADC param %#x: %d\n", param,
+                    status);
+            return status;
+        }
+
+        int axis = i % 3;
+        imtq_adc_conversion * conv = (i < 9) ? &cal.coil_current[axis]
+                                             : &cal.coil_temp[axis];
+
+        switch ((i / 3) % 3)
+        {
+            case 0:
+                conv->bias = config_data.value.int16_val;
+                break;
+            case 1:
+                conv->mult = config_data.value.int16_val;
+                break;
+            default:
+                conv->div = config_data.value.int16_val;
+        }
+    }
+
+    pthread_mutex_lock(&hk_cal_mutex);
+    hk_cal       = cal;
+    hk_cal_valid = true;
+    pthread_mutex_unlock(&hk_cal_mutex);
+
+    return ADCS_OK;
+}
+
+KADCSStatus k_imtq_get_housekeeping_cal(imtq_housekeeping_cal * cal)
+{
+    KADCSStatus status = ADCS_OK;
+
+    if (cal == NULL)
+    {
+        return ADCS_ERROR_CONFIG;
+    }
+
+    pthread_mutex_lock(&hk_cal_mutex);
+    if (hk_cal_valid)
+    {
+        *cal = hk_cal;
+    }
+    else
+    {
+        status = ADCS_ERROR;
+    }
+    pthread_mutex_unlock(&hk_cal_mutex);
+
+    return status;
+}
+
+KADCSStatus k_imtq_convert_housekeeping(const imtq_housekeeping_raw * raw,
+                                        const imtq_housekeeping_cal * cal,
+                                        imtq_housekeeping_eng * eng)
+{
+    if (raw == NULL || cal == NULL || eng == NULL)
+    {
+        return ADCS_ERROR_CONFIG;
+    }
+
+    memset(eng, 0, sizeof(imtq_housekeeping_eng));
+
+    eng->hdr.cmd    = GET_HOUSE_ENG;
+    eng->hdr.status = raw->hdr.status;
+
+    eng->coil_current.x = (int16_t) kprv_imtq_convert_adc(raw->coil_current.x, &cal->coil_current[0]);
+    eng->coil_current.y = (int16_t) kprv_imtq_convert_adc(raw->coil_current.y, &cal->coil_current[1]);
+    eng->coil_current.z = (int16_t) kprv_imtq_convert_adc(raw->coil_current.z, &cal->coil_current[2]);
+
+    eng->coil_temp.x = (int16_t) kprv_imtq_convert_adc(raw->coil_temp.x, &cal->coil_temp[0]);
+    eng->coil_temp.y = (int16_t) kprv_imtq_convert_adc(raw->coil_temp.y, &cal->coil_temp[1]);
+    eng->coil_temp.z = (int16_t) kprv_imtq_convert_adc(raw->coil_temp.z, &cal->coil_temp[2]);
+
+    return ADCS_OK;
+}
+
+KADCSStatus kprv_imtq_get_housekeeping(imtq_housekeeping_raw * raw, imtq_housekeeping_eng * eng,
+                                       bool * converted)
+{
+    KADCSStatus           status;
+    imtq_housekeeping_cal cal;
+
+    if (raw == NULL || eng == NULL || converted == NULL)
+    {
+        return ADCS_ERROR_CONFIG;
+    }
+
+    /* The calibration is dropped whenever the iMTQ or its ADC params change */
+    status = k_imtq_get_housekeeping_cal(&cal);
+    if (status != ADCS_OK && k_imtq_load_housekeeping_cal() == ADCS_OK)
+    {
+        status = k_imtq_get_housekeeping_cal(&cal);
+    }
+
+    *converted = (status == ADCS_OK);
+    if (*converted)
+    {
+        /* Both values come from the same sample, in a single transfer */
+        status = k_imtq_get_raw_housekeeping(raw);
+        if (status != ADCS_OK)
+        {
+            return status;
+        }
+
+        return k_imtq_convert_housekeeping(raw, &cal, eng);
+    }
+
+    status = k_imtq_get_raw_housekeeping(raw);
+    status |= k_imtq_get_eng_housekeeping(eng);
+    if (status != ADCS_OK)
+    {
+        return ADCS_ERROR;
+    }
+
+    return ADCS_OK;
+}
+
+void kprv_imtq_clear_housekeeping_cal(void)
+{
+    pthread_mutex_lock(&hk_cal_mutex);
+    hk_cal_valid = false;
+    pthread_mutex_unlock(&hk_cal_mutex);
+}
@@ -0,0 +1,294 @@
+/*
+ * Copyright (C) 2018 Kubos Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * ISIS iMTQ API - Spin and Orientation Estimator
+ */
+
+#include <imtq.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef struct {
+    float x;
+    float y;
+    float z;
+} imtq_vector;
+
+/*
+ * Estimator state. Everything is fixed-size, so updating the estimate never
+ * allocates
+ */
+static struct {
+    bool            have_field;
+    imtq_vector     field;                      /* Last magnetic field sample [nT] */
+    struct timespec field_time;                 /* When the last sample was taken */
+    imtq_vector     rates[IMTQ_SPIN_WINDOW];    /* Recent rate samples [rad/s] */
+    uint32_t        count;                      /* Total number of rate samples */
+} estimator;
+
+static pthread_mutex_t estimator_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static imtq_vector kprv_imtq_vector_cross(imtq_vector a, imtq_vector b)
+{
+    imtq_vector result = {
+        .x = a.y * b.z - a.z * b.y,
+        .y = a.z * b.x - a.x * b.z,
+        .z = a.x * b.y - a.y * b.x
+    };
+
+    return result;
+}
+
+static float kprv_imtq_vector_dot(imtq_vector a, imtq_vector b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+static imtq_vector kprv_imtq_vector_from_mtm(const imtq_mtm_data * data)
+{
+    imtq_vector result = {
+        .x = (float) data->x,
+        .y = (float) data->y,
+        .z = (float) data->z
+    };
+
+    return result;
+}
+
+/* Time between two samples, in seconds */
+static float kprv_imtq_estimator_elapsed(const struct timespec * end,
+                                         const struct timespec * start)
+{
+    return (float) (end->tv_sec - start->tv_sec)
+           + (float) (end->tv_nsec - start->tv_nsec) / 1e9f;
+}
+
+/* Add a new rate sample to the moving average, replacing the oldest one */
+static void kprv_imtq_estimator_add_rate(imtq_vector rate)
+{
+    estimator.rates[estimator.count & (IMTQ_SPIN_WINDOW - 1)] = rate;
+    estimator.count++;
+}
+
+KADCSStatus k_imtq_estimator_update(const imtq_mtm_sample * sample,
+                                    const imtq_mtm_data * bdot)
+{
+    imtq_vector field;
+    imtq_vector field_rate;
+
+    if (sample == NULL)
+    {
+        return ADCS_ERROR_CONFIG;
+    }
+
+    /* The coils corrupt the magnetometer measurements */
+    if (sample->data.act_status != 0)
+    {
+        return ADCS_OK;
+    }
+
+    imtq_mtm_data data = sample->data.data;
+    field = kprv_imtq_vector_from_mtm(&data);
+
+    pthread_mutex_lock(&estimator_mutex);
+
+    bool        have_rate = false;
+    imtq_vector midpoint  = field;
+
+    if (bdot != NULL)
+    {
+        imtq_mtm_data bdot_data = *bdot;
+        field_rate = kprv_imtq_vector_from_mtm(&bdot_data);
+        have_rate  = true;
+    }
+    else if (estimator.have_field)
+    {
+        float dt = kprv_imtq_estimator_elapsed(&sample->timestamp,
+                                               &estimator.field_time);
+
+        if (dt > 0 && dt * 1000 <= IMTQ_SPIN_MAX_GAP)
+        {
+            field_rate.x = (field.x - estimator.field.x) / dt;
+            field_rate.y = (field.y - estimator.field.y) / dt;
+            field_rate.z = (field.z - estimator.field.z) / dt;
+
+            midpoint.x = (field.x + estimator.field.x) / 2;
+            midpoint.y = (field.y + estimator.field.y) / 2;
+            midpoint.z = (field.z + estimator.field.z) / 2;
+
+            have_rate = true;
+        }
+        else
+        {
+            /* The spin may have changed in the gap, so start averaging afresh */
+            estimator.count = 0;
+        }
+    }
+
+    /*
+     * In the body frame, dB/dt = -w x B, so the spin perpendicular to the
+     * field is (dB/dt x B) / |B|^2
+     */
+    float magnitude = kprv_imtq_vector_dot(midpoint, midpoint);
+    if (have_rate && magnitude > 0)
+    {
+        imtq_vector rate = kprv_imtq_vector_cross(field_rate, midpoint);
+
+        rate.x /= magnitude;
+        rate.y /= magnitude;
+        rate.z /= magnitude;
+
+        kprv_imtq_estimator_add_rate(rate);
+    }
+
+    estimator.field      = field;
+    estimator.field_time = sample->timestamp;
+    estimator.have_field = true;
+
+    pthread_mutex_unlock(&estimator_mutex);
+
+    return ADCS_OK;
+}
+
+void k_imtq_estimator_reset(void)
+{
+    pthread_mutex_lock(&estimator_mutex);
+    memset(&estimator, 0, sizeof(estimator));
+    pthread_mutex_unlock(&estimator_mutex);
+}
+
+KADCSStatus kprv_imtq_estimator_sample(void)
+{
+    KADCSStatus     status;
+    imtq_mtm_sample sample;
+
+    const struct timespec MEASURE_DELAY = {.tv_sec = 0, .tv_nsec = 1000001 };
+
+    clock_gettime(CLOCK_MONOTONIC, &sample.timestamp);
+
+    status = k_imtq_start_measurement();
+    if (status != ADCS_OK)
+    {
+        fprintf(stderr, "Failed to start MTM measurement: %d\n", status);
+        return status;
+    }
+
+    nanosleep(&MEASURE_DELAY, NULL);
+
+    status = k_imtq_get_calib_mtm(&sample.data);
+    if (status != ADCS_OK)
+    {
+        fprintf(stderr, "Failed to get calibrated MTM data: %d\n", status);
+        return status;
+    }
+
+    return k_imtq_estimator_update(&sample, NULL);
+}
+
+KADCSStatus k_adcs_get_orientation(adcs_orient * data)
+{
+    KADCSStatus status;
+
+    if (data == NULL)
+    {
+        return ADCS_ERROR_CONFIG;
+    }
+
+    status = kprv_imtq_estimator_sample();
+    if (status != ADCS_OK)
+    {
+        return status;
+    }
+
+    pthread_mutex_lock(&estimator_mutex);
+    imtq_vector field = estimator.field;
+    pthread_mutex_unlock(&estimator_mutex);
+
+    data->field = sqrtf(kprv_imtq_vector_dot(field, field));
+    if (data->field > 0)
+    {
+        data->x = field.x / data->field;
+        data->y = field.y / data->field;
+        data->z = field.z / data->field;
+    }
+    else
+    {
+        data->x = data->y = data->z = 0;
+    }
+
+    return ADCS_OK;
+}
+
+void kprv_imtq_estimator_get_spin(adcs_spin * data)
+{
+    imtq_vector     sum = { 0 };
+    uint16_t        samples;
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    pthread_mutex_lock(&estimator_mutex);
+    samples = (estimator.count < IMTQ_SPIN_WINDOW) ? estimator.count
+                                                   : IMTQ_SPIN_WINDOW;
+
+    /* Once updates stop, the window goes stale just as it would across a gap */
+    if (kprv_imtq_estimator_elapsed(&now, &estimator.field_time) * 1000
+        > IMTQ_SPIN_MAX_GAP)
+    {
+        samples = 0;
+    }
+
+    for (int i = 0; i < samples; i++)
+    {
+        sum.x += estimator.rates[i].x;
+        sum.y += estimator.rates[i].y;
+        sum.z += estimator.rates[i].z;
+    }
+    pthread_mutex_unlock(&estimator_mutex);
+
+    memset(data, 0, sizeof(adcs_spin));
+    data->samples = samples;
+
+    if (samples > 0)
+    {
+        data->x    = sum.x / samples;
+        data->y    = sum.y / samples;
+        data->z    = sum.z / samples;
+        data->rate = sqrtf(data->x * data->x + data->y * data->y
+                           + data->z * data->z);
+    }
+}
+
+KADCSStatus k_adcs_get_spin(adcs_spin * data)
+{
+    KADCSStatus status;
+
+    if (data == NULL)
+    {
+        return ADCS_ERROR_CONFIG;
+    }
+
+    status = kprv_imtq_estimator_sample();
+    if (status != ADCS_OK)
+    {
+        return status;
+    }
+
+    kprv_imtq_estimator_get_spin(data);
+
+    return ADCS_OK;
+}
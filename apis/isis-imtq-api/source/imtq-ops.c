@@ -17,6 +17,7 @@
  */
 
 #include <imtq.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -70,6 +71,9 @@ KADCSStatus k_adcs_reset(KADCSReset type)
         return ADCS_ERROR;
     }
 
+    /* The iMTQ's configuration has been reset to the defaults */
+    kprv_imtq_clear_housekeeping_cal();
+
     return ADCS_OK;
 }
 
@@ -108,32 +112,21 @@ KADCSStatus k_adcs_set_mode(ADCSMode mode, const adcs_mode_param * duration)
     return status;
 }
 
-KADCSStatus k_adcs_run_test(ADCSTestType axis, adcs_test_results buffer)
+/* Self-test currently in progress */
+static ADCSTestType    test_axis;
+static bool            test_pending = false;
+static bool            test_running = false;
+static struct timespec test_start;
+static pthread_mutex_t test_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static KADCSStatus kprv_adcs_get_test_results(ADCSTestType axis, adcs_test_results buffer)
 {
     KADCSStatus status;
 
-    if (buffer == NULL)
-    {
-        return ADCS_ERROR_CONFIG;
-    }
-
-    status = k_imtq_start_test(axis);
-    if (status != ADCS_OK)
-    {
-        fprintf(stderr, "Failed to start iMTQ self-test for %d axis: %d\n",
-                axis, status);
-        return status;
-    }
-
-    /* Wait an appropriate time for the test to finish */
-    const struct timespec TRANSFER_DELAY = {.tv_sec = 1, .tv_nsec = 300000000 };
-
-    nanosleep(&TRANSFER_DELAY, NULL);
-
     if (axis == TEST_ALL)
     {
         imtq_test_result_all data = { 0 };
-        
+
         status = k_imtq_get_test_results_all(&data);
         if (status != ADCS_OK)
         {
@@ -153,7 +146,7 @@ KADCSStatus k_adcs_run_test(ADCSTestType axis, adcs_test_results buffer)
     else
     {
         imtq_test_result_single data = { 0 };
-        
+
         status = k_imtq_get_test_results_single(&data);
         if (status != ADCS_OK)
         {
@@ -170,6 +163,154 @@ KADCSStatus k_adcs_run_test(ADCSTestType axis, adcs_test_results buffer)
     return status;
 }
 
+KADCSStatus k_adcs_start_test_async(ADCSTestType axis)
+{
+    KADCSStatus status;
+
+    status = k_imtq_start_test(axis);
+    if (status != ADCS_OK)
+    {
+        fprintf(stderr, "Failed to start iMTQ self-test for %d axis: %d\n",
+                axis, status);
+        return status;
+    }
+
+    pthread_mutex_lock(&test_mutex);
+    test_axis    = axis;
+    test_pending = true;
+    test_running = false;
+    clock_gettime(CLOCK_MONOTONIC, &test_start);
+    pthread_mutex_unlock(&test_mutex);
+
+    return ADCS_OK;
+}
+
+KADCSStatus k_adcs_poll_test(adcs_test_results buffer, bool * complete)
+{
+    KADCSStatus     status;
+    ADCSTestType    axis;
+    struct timespec start;
+    struct timespec now;
+    imtq_state      state = { 0 };
+
+    if (buffer == NULL || complete == NULL)
+    {
+        return ADCS_ERROR_CONFIG;
+    }
+
+    *complete = false;
+
+    pthread_mutex_lock(&test_mutex);
+    bool pending = test_pending;
+    bool running = test_running;
+    axis  = test_axis;
+    start = test_start;
+    pthread_mutex_unlock(&test_mutex);
+
+    if (!pending)
+    {
+        fprintf(stderr, "No iMTQ self-test is in progress\n");
+        return ADCS_ERROR;
+    }
+
+    status = k_imtq_get_system_state(&state);
+    if (status != ADCS_OK)
+    {
+        fprintf(stderr, "Failed to get iMTQ self-test state: %d\n", status);
+        return status;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    int64_t elapsed = (int64_t) (now.tv_sec - start.tv_sec) * 1000
+                      + (now.tv_nsec - start.tv_nsec) / 1000000;
+
+    if (state.mode == SELFTEST)
+    {
+        pthread_mutex_lock(&test_mutex);
+        test_running = true;
+        pthread_mutex_unlock(&test_mutex);
+
+        /* Still running. Make sure it hasn't gotten stuck */
+        if (elapsed > IMTQ_TEST_TIMEOUT)
+        {
+            fprintf(stderr, "iMTQ self-test did not complete within %dms\n",
+                    IMTQ_TEST_TIMEOUT);
+            pthread_mutex_lock(&test_mutex);
+            test_pending = false;
+            pthread_mutex_unlock(&test_mutex);
+            return ADCS_ERROR;
+        }
+
+        return ADCS_OK;
+    }
+
+    /*
+     * The iMTQ may not have switched to self-test mode yet. Until it has, the
+     * results it holds are from the previous test
+     */
+    if (!running)
+    {
+        if (elapsed > IMTQ_TEST_START_TIMEOUT)
+        {
+            fprintf(stderr, "iMTQ did not enter self-test mode within %dms\n",
+                    IMTQ_TEST_START_TIMEOUT);
+            pthread_mutex_lock(&test_mutex);
+            test_pending = false;
+            pthread_mutex_unlock(&test_mutex);
+            return ADCS_ERROR;
+        }
+
+        return ADCS_OK;
+    }
+
+    /* The iMTQ leaves self-test mode once the test has finished */
+    pthread_mutex_lock(&test_mutex);
+    test_pending = false;
+    pthread_mutex_unlock(&test_mutex);
+
+    status = kprv_adcs_get_test_results(axis, buffer);
+    if (status == ADCS_OK)
+    {
+        *complete = true;
+    }
+
+    return status;
+}
+
+KADCSStatus k_adcs_run_test(ADCSTestType axis, adcs_test_results buffer)
+{
+    KADCSStatus status;
+    bool        complete = false;
+
+    const struct timespec POLL_DELAY
+        = {.tv_sec = 0, .tv_nsec = IMTQ_TEST_POLL_INTERVAL * 1000000 };
+
+    if (buffer == NULL)
+    {
+        return ADCS_ERROR_CONFIG;
+    }
+
+    status = k_adcs_start_test_async(axis);
+    if (status != ADCS_OK)
+    {
+        return status;
+    }
+
+    /* Wait for the test to finish, giving the iMTQ time to start it first */
+    while (1)
+    {
+        nanosleep(&POLL_DELAY, NULL);
+
+        status = k_adcs_poll_test(buffer, &complete);
+        if (status != ADCS_OK || complete)
+        {
+            break;
+        }
+    }
+
+    return status;
+}
+
 KADCSStatus k_imtq_cancel_op(void)
 {
     KADCSStatus      status = ADCS_OK;
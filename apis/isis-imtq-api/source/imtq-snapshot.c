@@ -0,0 +1,392 @@
+/*
+ * Copyright (C) 2018 Kubos Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * ISIS iMTQ API - Configuration Snapshots
+ */
+
+#include <crc.h>
+#include <imtq.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* A mapped snapshot file */
+typedef struct {
+    void *                      base;
+    size_t                      size;
+    const imtq_snapshot_header * header;
+    const imtq_snapshot_entry *  entries;
+} imtq_snapshot;
+
+static bool kprv_imtq_values_equal(const imtq_param_desc * param,
+                                   const imtq_config_value * a,
+                                   const imtq_config_value * b)
+{
+    return param->decode(a) == param->decode(b);
+}
+
+/* Map and validate a snapshot file */
+static KADCSStatus kprv_imtq_snapshot_open(const char * path,
+                                           imtq_snapshot * snapshot)
+{
+    struct stat info;
+
+    FILE * file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return ADCS_ERROR_CONFIG;
+    }
+
+    if (fstat(fileno(file), &info) != 0
+        || info.st_size < (off_t) sizeof(imtq_snapshot_header))
+    {
+        fclose(file);
+        return ADCS_ERROR_CONFIG;
+    }
+
+    snapshot->size = info.st_size;
+    snapshot->base = mmap(NULL, snapshot->size, PROT_READ, MAP_PRIVATE,
+                          fileno(file), 0);
+    fclose(file);
+
+    if (snapshot->base == MAP_FAILED)
+    {
+        perror("Failed to map iMTQ configuration snapshot");
+        return ADCS_ERROR_CONFIG;
+    }
+
+    snapshot->header  = snapshot->base;
+    snapshot->entries = (const imtq_snapshot_entry *) (snapshot->header + 1);
+
+    size_t entries_len = snapshot->header->count * sizeof(imtq_snapshot_entry);
+
+    if (snapshot->header->magic != IMTQ_SNAPSHOT_MAGIC
+        || snapshot->header->version != IMTQ_SNAPSHOT_VERSION
+        || snapshot->size != sizeof(imtq_snapshot_header) + entries_len
+        || snapshot->header->checksum
+               != k_crc32(0, snapshot->entries, entries_len))
+    {
+        fprintf(stderr, "Invalid iMTQ configuration snapshot: %s\n", path);
+        munmap(snapshot->base, snapshot->size);
+        return ADCS_ERROR_CONFIG;
+    }
+
+    return ADCS_OK;
+}
+
+static void kprv_imtq_snapshot_close(imtq_snapshot * snapshot)
+{
+    munmap(snapshot->base, snapshot->size);
+}
+
+static const imtq_snapshot_entry * kprv_imtq_snapshot_find(const imtq_snapshot * snapshot,
+                                                           uint16_t param)
+{
+    for (int i = 0; i < snapshot->header->count; i++)
+    {
+        if (snapshot->entries[i].param == param)
+        {
+            return &snapshot->entries[i];
+        }
+    }
+
+    return NULL;
+}
+
+static KADCSStatus kprv_imtq_get_software_version(uint32_t * version)
+{
+    KADCSStatus      status;
+    imtq_config_resp response;
+
+    status = k_imtq_get_param(SOFTWARE_VERSION, &response);
+    if (status == ADCS_OK)
+    {
+        *version = response.value.uint32_val;
+    }
+
+    return status;
+}
+
+/* Read a parameter back from the iMTQ and compare it against a snapshot entry */
+static KADCSStatus kprv_imtq_snapshot_verify_entry(const imtq_snapshot_entry * entry)
+{
+    KADCSStatus      status;
+    imtq_config_resp response;
+
+    const imtq_param_desc * param = k_imtq_find_param(entry->param);
+    if (param == NULL)
+    {
+        return ADCS_ERROR;
+    }
+
+    status = k_imtq_get_param(entry->param, &response);
+    if (status != ADCS_OK)
+    {
+        return status;
+    }
+
+    imtq_config_value value = response.value;
+    if (!kprv_imtq_values_equal(param, &value, &entry->value))
+    {
+        return ADCS_ERROR;
+    }
+
+    return ADCS_OK;
+}
+
+/*
+ * Compare the iMTQ against an open snapshot. The parameters in `config` are
+ * read back, or a spread of the snapshot's if there's no configuration
+ */
+static KADCSStatus kprv_imtq_snapshot_verify(const imtq_snapshot * snapshot,
+                                             const JsonNode * config)
+{
+    KADCSStatus status;
+    imtq_state  state;
+    uint32_t    version;
+    JsonNode *  entry;
+
+    /* A restart reverts every parameter to its default, and clears the flag */
+    status = k_imtq_get_system_state(&state);
+    if (status != ADCS_OK)
+    {
+        return status;
+    }
+
+    if (snapshot->header->configured && !state.config)
+    {
+        return ADCS_ERROR;
+    }
+
+    status = kprv_imtq_get_software_version(&version);
+    if (status != ADCS_OK)
+    {
+        return status;
+    }
+
+    if (version != snapshot->header->software_version)
+    {
+        return ADCS_ERROR;
+    }
+
+    if (config != NULL)
+    {
+        json_foreach(entry, config)
+        {
+            const imtq_param_desc *     param = kprv_imtq_find_param_key(entry->key);
+            const imtq_snapshot_entry * saved
+                = (param != NULL) ? kprv_imtq_snapshot_find(snapshot, param->id)
+                                  : NULL;
+            if (saved == NULL)
+            {
+                return ADCS_ERROR;
+            }
+
+            status = kprv_imtq_snapshot_verify_entry(saved);
+            if (status != ADCS_OK)
+            {
+                return status;
+            }
+        }
+
+        return ADCS_OK;
+    }
+
+    /* Spot-check parameters spread across the snapshot */
+    int count = snapshot->header->count;
+    for (int i = 0; i < IMTQ_SNAPSHOT_SAMPLES && i < count; i++)
+    {
+        status = kprv_imtq_snapshot_verify_entry(
+            &snapshot->entries[(i * count) / IMTQ_SNAPSHOT_SAMPLES]);
+        if (status != ADCS_OK)
+        {
+            return status;
+        }
+    }
+
+    return ADCS_OK;
+}
+
+KADCSStatus k_imtq_save_config(const char * path)
+{
+    KADCSStatus          status;
+    imtq_config_resp     response;
+    imtq_state           state;
+    imtq_snapshot_header header  = { 0 };
+    imtq_snapshot_entry  entries[IMTQ_NUM_PARAMS];
+    char                 tmp_path[PATH_MAX];
+
+    if (path == NULL)
+    {
+        return ADCS_ERROR_CONFIG;
+    }
+
+    memset(entries, 0, sizeof(entries));
+
+    status = k_imtq_get_system_state(&state);
+    if (status != ADCS_OK)
+    {
+        return status;
+    }
+
+    header.configured = (state.config != 0);
+
+    for (int i = 0; i < IMTQ_NUM_PARAMS; i++)
+    {
+        status = k_imtq_get_param(imtq_params[i].id, &response);
+        if (status != ADCS_OK)
+        {
+            fprintf(stderr, "Failed to fetch iMTQ param %s: %d\n",
+                    imtq_params[i].name, status);
+            return status;
+        }
+
+        entries[i].param = imtq_params[i].id;
+        entries[i].value = response.value;
+
+        if (imtq_params[i].id == SOFTWARE_VERSION)
+        {
+            header.software_version = response.value.uint32_val;
+        }
+    }
+
+    header.magic    = IMTQ_SNAPSHOT_MAGIC;
+    header.version  = IMTQ_SNAPSHOT_VERSION;
+    header.count    = IMTQ_NUM_PARAMS;
+    header.checksum = k_crc32(0, entries, sizeof(entries));
+
+    /* Write to a temporary file first, so a crash never leaves a partial snapshot */
+    if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path) >= (int) sizeof(tmp_path))
+    {
+        return ADCS_ERROR_CONFIG;
+    }
+
+    FILE * file = fopen(tmp_path, "wb");
+    if (file == NULL)
+    {
+        perror("Failed to create iMTQ configuration snapshot");
+        return ADCS_ERROR;
+    }
+
+    if (fwrite(&header, sizeof(header), 1, file) != 1
+        || fwrite(entries, sizeof(entries), 1, file) != 1
+        || fflush(file) != 0 || fsync(fileno(file)) != 0)
+    {
+        perror("Failed to write iMTQ configuration snapshot");
+        fclose(file);
+        remove(tmp_path);
+        return ADCS_ERROR;
+    }
+
+    fclose(file);
+
+    if (rename(tmp_path, path) != 0)
+    {
+        perror("Failed to save iMTQ configuration snapshot");
+        remove(tmp_path);
+        return ADCS_ERROR;
+    }
+
+    return ADCS_OK;
+}
+
+KADCSStatus k_imtq_check_config(const char * path)
+{
+    KADCSStatus   status;
+    imtq_snapshot snapshot;
+
+    if (path == NULL)
+    {
+        return ADCS_ERROR_CONFIG;
+    }
+
+    status = kprv_imtq_snapshot_open(path, &snapshot);
+    if (status != ADCS_OK)
+    {
+        return status;
+    }
+
+    status = kprv_imtq_snapshot_verify(&snapshot, NULL);
+
+    kprv_imtq_snapshot_close(&snapshot);
+
+    return status;
+}
+
+KADCSStatus k_imtq_configure_cached(const JsonNode * config, const char * path)
+{
+    KADCSStatus   status;
+    imtq_snapshot snapshot;
+    JsonNode *    entry;
+
+    if (config == NULL || path == NULL)
+    {
+        return ADCS_ERROR_CONFIG;
+    }
+
+    status = kprv_imtq_snapshot_open(path, &snapshot);
+    if (status == ADCS_OK)
+    {
+        bool matches = true;
+
+        /* Has the requested configuration changed? This doesn't need the bus */
+        json_foreach(entry, config)
+        {
+            const imtq_param_desc *     param;
+            const imtq_snapshot_entry * saved;
+            imtq_config_value           value = { 0 };
+
+            param = (entry->tag == JSON_NUMBER)
+                        ? kprv_imtq_find_param_key(entry->key)
+                        : NULL;
+            saved = (param != NULL) ? kprv_imtq_snapshot_find(&snapshot, param->id)
+                                    : NULL;
+            if (saved == NULL)
+            {
+                matches = false;
+                break;
+            }
+
+            param->encode(entry->number_, &value);
+            if (!kprv_imtq_values_equal(param, &value, &saved->value))
+            {
+                matches = false;
+                break;
+            }
+        }
+
+        /* Has the iMTQ been changed (or reset) behind our back? */
+        if (matches && kprv_imtq_snapshot_verify(&snapshot, config) == ADCS_OK)
+        {
+            kprv_imtq_snapshot_close(&snapshot);
+            return ADCS_OK;
+        }
+
+        kprv_imtq_snapshot_close(&snapshot);
+    }
+
+    status = k_adcs_configure(config);
+    if (status != ADCS_OK)
+    {
+        return status;
+    }
+
+    return k_imtq_save_config(path);
+}
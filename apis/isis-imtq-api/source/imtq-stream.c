@@ -0,0 +1,287 @@
+/*
+ * Copyright (C) 2018 Kubos Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * ISIS iMTQ API - Magnetometer Streaming
+ */
+
+#include <imtq.h>
+#include "imtq-time.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+/*
+ * Single-producer/single-consumer sample buffer.
+ * Only the sampler thread moves `head` and only the consumer moves `tail`,
+ * so no lock is needed to pass samples between them.
+ */
+static imtq_mtm_sample stream_buffer[IMTQ_STREAM_DEPTH];
+static atomic_uint     stream_head;
+static atomic_uint     stream_tail;
+
+static atomic_bool     stream_running;
+static pthread_t       handle_stream = { 0 };
+static int             stream_timer  = -1;
+/* Serializes starting and stopping the stream */
+static pthread_mutex_t stream_control_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* Absolute time of the first sample's deadline */
+static struct timespec stream_first;
+
+static imtq_stream_stats stream_stats = { 0 };
+static pthread_mutex_t   stream_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* Sum of the absolute jitter values, used to calculate the mean */
+static uint64_t stream_jitter_total = 0;
+
+static void kprv_imtq_stream_push(const imtq_mtm_sample * sample)
+{
+    unsigned int head = atomic_load_explicit(&stream_head, memory_order_relaxed);
+    unsigned int tail = atomic_load_explicit(&stream_tail, memory_order_acquire);
+
+    if (head - tail >= IMTQ_STREAM_DEPTH)
+    {
+        /* Consumer isn't keeping up. Drop the new sample */
+        pthread_mutex_lock(&stream_stats_mutex);
+        stream_stats.overruns++;
+        pthread_mutex_unlock(&stream_stats_mutex);
+        return;
+    }
+
+    stream_buffer[head & (IMTQ_STREAM_DEPTH - 1)] = *sample;
+
+    atomic_store_explicit(&stream_head, head + 1, memory_order_release);
+}
+
+void * kprv_imtq_stream_thread(void * args)
+{
+    KADCSStatus     status;
+    uint64_t        expirations;
+    uint64_t        ticks = 0;
+    struct timespec deadline;
+    imtq_mtm_sample sample;
+
+    const struct timespec MEASURE_DELAY = {.tv_sec = 0, .tv_nsec = 1000001 };
+
+    while (atomic_load(&stream_running))
+    {
+        if (read(stream_timer, &expirations, sizeof(expirations))
+            != sizeof(expirations))
+        {
+            continue;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &sample.timestamp);
+
+        /* Compare when we woke up against when we should have */
+        ticks += expirations;
+        deadline = stream_first;
+        kprv_imtq_timespec_add_us(&deadline, (ticks - 1) * stream_stats.period);
+
+        int64_t jitter
+            = kprv_imtq_timespec_diff_us(&sample.timestamp, &deadline);
+        if (jitter < 0)
+        {
+            jitter = -jitter;
+        }
+
+        status = k_imtq_start_measurement();
+        if (status == ADCS_OK)
+        {
+            nanosleep(&MEASURE_DELAY, NULL);
+            status = k_imtq_get_calib_mtm(&sample.data);
+        }
+
+        pthread_mutex_lock(&stream_stats_mutex);
+        stream_stats.missed_ticks += (uint32_t) (expirations - 1);
+        if (status == ADCS_OK)
+        {
+            stream_stats.samples++;
+            stream_jitter_total += (uint64_t) jitter;
+            stream_stats.jitter_mean
+                = (uint32_t) (stream_jitter_total / stream_stats.samples);
+            if ((uint32_t) jitter > stream_stats.jitter_max)
+            {
+                stream_stats.jitter_max = (uint32_t) jitter;
+            }
+        }
+        else
+        {
+            stream_stats.errors++;
+        }
+        pthread_mutex_unlock(&stream_stats_mutex);
+
+        if (status == ADCS_OK)
+        {
+            kprv_imtq_stream_push(&sample);
+            k_imtq_estimator_update(&sample, NULL);
+        }
+    }
+
+    return NULL;
+}
+
+KADCSStatus k_imtq_stream_start(uint16_t rate)
+{
+    if (rate == 0 || rate > IMTQ_STREAM_MAX_RATE)
+    {
+        fprintf(stderr, "Invalid iMTQ stream rate requested: %d\n", rate);
+        return ADCS_ERROR_CONFIG;
+    }
+
+    pthread_mutex_lock(&stream_control_mutex);
+
+    if (handle_stream != 0)
+    {
+        fprintf(stderr, "iMTQ stream already started\n");
+        pthread_mutex_unlock(&stream_control_mutex);
+        return ADCS_ERROR;
+    }
+
+    uint32_t period = 1000000 / rate;
+
+    stream_timer = timerfd_create(CLOCK_MONOTONIC, 0);
+    if (stream_timer < 0)
+    {
+        perror("Failed to create iMTQ stream timer");
+        pthread_mutex_unlock(&stream_control_mutex);
+        return ADCS_ERROR;
+    }
+
+    pthread_mutex_lock(&stream_stats_mutex);
+    memset(&stream_stats, 0, sizeof(stream_stats));
+    stream_stats.period = period;
+    stream_jitter_total = 0;
+    pthread_mutex_unlock(&stream_stats_mutex);
+
+    atomic_store(&stream_head, 0);
+    atomic_store(&stream_tail, 0);
+    atomic_store(&stream_running, true);
+
+    /*
+     * Jitter is measured against absolute deadlines, which the thread's own
+     * start-up time mustn't shift
+     */
+    clock_gettime(CLOCK_MONOTONIC, &stream_first);
+    kprv_imtq_timespec_add_us(&stream_first, period);
+
+    struct itimerspec timer = {
+        .it_interval = {.tv_sec = period / 1000000, .tv_nsec = (period % 1000000) * 1000 },
+        .it_value    = stream_first
+    };
+
+    if (timerfd_settime(stream_timer, TFD_TIMER_ABSTIME, &timer, NULL) != 0)
+    {
+        perror("Failed to start iMTQ stream timer");
+        close(stream_timer);
+        stream_timer = -1;
+        pthread_mutex_unlock(&stream_control_mutex);
+        return ADCS_ERROR;
+    }
+
+    if (pthread_create(&handle_stream, NULL, kprv_imtq_stream_thread, NULL)
+        != 0)
+    {
+        perror("Failed to create iMTQ stream thread");
+        handle_stream = 0;
+        atomic_store(&stream_running, false);
+        close(stream_timer);
+        stream_timer = -1;
+        pthread_mutex_unlock(&stream_control_mutex);
+        return ADCS_ERROR;
+    }
+
+    pthread_mutex_unlock(&stream_control_mutex);
+
+    return ADCS_OK;
+}
+
+KADCSStatus k_imtq_stream_stop(void)
+{
+    pthread_mutex_lock(&stream_control_mutex);
+
+    if (handle_stream == 0)
+    {
+        fprintf(stderr, "iMTQ stream has not been started\n");
+        pthread_mutex_unlock(&stream_control_mutex);
+        return ADCS_ERROR;
+    }
+
+    /*
+     * Let the thread finish its current sample rather than cancelling it,
+     * so that it never leaves the iMTQ mutex held
+     */
+    atomic_store(&stream_running, false);
+
+    if (pthread_join(handle_stream, NULL) != 0)
+    {
+        perror("Failed to rejoin iMTQ stream thread");
+        pthread_mutex_unlock(&stream_control_mutex);
+        return ADCS_ERROR;
+    }
+
+    handle_stream = 0;
+
+    close(stream_timer);
+    stream_timer = -1;
+
+    atomic_store(&stream_tail, atomic_load(&stream_head));
+
+    pthread_mutex_unlock(&stream_control_mutex);
+
+    return ADCS_OK;
+}
+
+KADCSStatus k_imtq_stream_read(imtq_mtm_sample * samples, uint16_t max,
+                               uint16_t * count)
+{
+    if (samples == NULL || count == NULL)
+    {
+        return ADCS_ERROR_CONFIG;
+    }
+
+    unsigned int tail = atomic_load_explicit(&stream_tail, memory_order_relaxed);
+    unsigned int head = atomic_load_explicit(&stream_head, memory_order_acquire);
+    uint16_t     num  = 0;
+
+    while (tail != head && num < max)
+    {
+        samples[num++] = stream_buffer[tail & (IMTQ_STREAM_DEPTH - 1)];
+        tail++;
+    }
+
+    atomic_store_explicit(&stream_tail, tail, memory_order_release);
+
+    *count = num;
+
+    return ADCS_OK;
+}
+
+KADCSStatus k_imtq_stream_get_stats(imtq_stream_stats * stats)
+{
+    if (stats == NULL)
+    {
+        return ADCS_ERROR_CONFIG;
+    }
+
+    pthread_mutex_lock(&stream_stats_mutex);
+    *stats = stream_stats;
+    pthread_mutex_unlock(&stream_stats_mutex);
+
+    return ADCS_OK;
+}
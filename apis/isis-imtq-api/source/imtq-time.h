@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2018 Kubos Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * ISIS iMTQ API - Timing helpers shared by the stream and control loop
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+
+static inline void kprv_imtq_timespec_add_us(struct timespec * time, uint64_t us)
+{
+    time->tv_sec += us / 1000000;
+    time->tv_nsec += (us % 1000000) * 1000;
+    if (time->tv_nsec >= 1000000000)
+    {
+        time->tv_sec++;
+        time->tv_nsec -= 1000000000;
+    }
+}
+
+static inline int64_t kprv_imtq_timespec_diff_us(const struct timespec * end,
+                                                 const struct timespec * start)
+{
+    return (int64_t) (end->tv_sec - start->tv_sec) * 1000000
+           + (end->tv_nsec - start->tv_nsec) / 1000;
+}
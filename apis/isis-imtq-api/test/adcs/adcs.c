@@ -19,6 +19,7 @@
 
 #include <imtq.h>
 #include <cmocka.h>
+#include <math.h>
 
 static char * bus = "/dev/i2c-1";
 static uint16_t addr = 0x40;
@@ -36,6 +37,14 @@ imtq_state state = {
         .uptime = 35
     };
 
+imtq_state idle_state = {
+        .hdr = {0},
+        .mode = IDLE,
+        .error = 0,
+        .config = 1,
+        .uptime = 36
+    };
+
 /* Self-test structs */
 imtq_test_result_all    test_results_all    = { 0 };
 imtq_test_result_single test_results_single = { 0 };
@@ -44,7 +53,7 @@ imtq_test_result_single test_results_single = { 0 };
 imtq_housekeeping_raw house_raw = { 0 };
 imtq_housekeeping_eng house_eng = { 0 };
 imtq_detumble         detumble  = { 0 };
-imtq_mtm_data         mtm       = { 0 };
+imtq_mtm_msg          mtm       = { 0 };
 imtq_dipole           dipole    = { 0 };
 
 /* Debug telemetry structs */
@@ -103,6 +112,37 @@ static void test_configure(void ** arg)
     assert_int_equal(ret, ADCS_OK);
 }
 
+static void test_configure_name(void ** arg)
+{
+    KADCSStatus ret;
+
+    JsonNode * config = json_decode("{\"MTM_INTERNAL_TIME\": 1}");
+
+    expect_value(__wrap_write, cmd, SET_PARAM);
+    expect_value(__wrap_read, len, sizeof(imtq_resp_header));
+    will_return(__wrap_read, &response);
+
+    ret = k_adcs_configure(config);
+
+    json_delete(config);
+
+    assert_int_equal(ret, ADCS_OK);
+}
+
+static void test_configure_unknown(void ** arg)
+{
+    KADCSStatus ret;
+
+    /* Unknown parameters should be skipped */
+    JsonNode * config = json_decode("{\"0x1234\": 1, \"NOT_A_PARAM\": 2}");
+
+    ret = k_adcs_configure(config);
+
+    json_delete(config);
+
+    assert_int_equal(ret, ADCS_ERROR);
+}
+
 static void test_reset(void ** arg)
 {
     KADCSStatus ret;
@@ -159,6 +199,12 @@ static void test_run_test_all(void ** arg)
     expect_value(__wrap_write, cmd, START_TEST);
     expect_value(__wrap_read, len, sizeof(imtq_resp_header));
     will_return(__wrap_read, &response);
+    expect_value(__wrap_write, cmd, GET_STATE);
+    expect_value(__wrap_read, len, sizeof(state));
+    will_return(__wrap_read, &state);
+    expect_value(__wrap_write, cmd, GET_STATE);
+    expect_value(__wrap_read, len, sizeof(idle_state));
+    will_return(__wrap_read, &idle_state);
     expect_value(__wrap_write, cmd, GET_TEST);
     expect_value(__wrap_read, len, sizeof(test_results_all));
     will_return(__wrap_read, &test_results_all);
@@ -182,6 +228,12 @@ static void test_run_test_single(void ** arg)
     expect_value(__wrap_read, len, sizeof(imtq_resp_header));
     will_return(__wrap_read, &response);
 
+    expect_value(__wrap_write, cmd, GET_STATE);
+    expect_value(__wrap_read, len, sizeof(state));
+    will_return(__wrap_read, &state);
+    expect_value(__wrap_write, cmd, GET_STATE);
+    expect_value(__wrap_read, len, sizeof(idle_state));
+    will_return(__wrap_read, &idle_state);
     expect_value(__wrap_write, cmd, GET_TEST);
     expect_value(__wrap_read, len, sizeof(test_results_single));
     will_return(__wrap_read, &test_results_single);
@@ -195,6 +247,105 @@ static void test_run_test_single(void ** arg)
     assert_true(json_ret);
 }
 
+static void test_run_test_not_started(void ** arg)
+{
+    KADCSStatus ret;
+    bool        complete = true;
+
+    adcs_test_results results = json_mkobject();
+
+    expect_value(__wrap_write, cmd, START_TEST);
+    expect_value(__wrap_read, len, sizeof(imtq_resp_header));
+    will_return(__wrap_read, &response);
+    ret = k_adcs_start_test_async(TEST_ALL);
+    assert_int_equal(ret, ADCS_OK);
+
+    /*
+     * The iMTQ hasn't switched to self-test mode yet, so the results it holds
+     * are stale and shouldn't be fetched
+     */
+    expect_value(__wrap_write, cmd, GET_STATE);
+    expect_value(__wrap_read, len, sizeof(idle_state));
+    will_return(__wrap_read, &idle_state);
+    ret = k_adcs_poll_test(results, &complete);
+    assert_int_equal(ret, ADCS_OK);
+    assert_false(complete);
+
+    expect_value(__wrap_write, cmd, GET_STATE);
+    expect_value(__wrap_read, len, sizeof(state));
+    will_return(__wrap_read, &state);
+    ret = k_adcs_poll_test(results, &complete);
+    assert_int_equal(ret, ADCS_OK);
+    assert_false(complete);
+
+    /* Only leaving self-test mode finishes the test */
+    expect_value(__wrap_write, cmd, GET_STATE);
+    expect_value(__wrap_read, len, sizeof(idle_state));
+    will_return(__wrap_read, &idle_state);
+    expect_value(__wrap_write, cmd, GET_TEST);
+    expect_value(__wrap_read, len, sizeof(test_results_all));
+    will_return(__wrap_read, &test_results_all);
+    ret = k_adcs_poll_test(results, &complete);
+
+    int json_ret = json_check(results, NULL);
+    json_delete(results);
+
+    assert_int_equal(ret, ADCS_OK);
+    assert_true(complete);
+    assert_true(json_ret);
+}
+
+static void test_run_test_async(void ** arg)
+{
+    KADCSStatus ret;
+    bool        complete = true;
+
+    adcs_test_results results = json_mkobject();
+
+    expect_value(__wrap_write, cmd, START_TEST);
+    expect_value(__wrap_read, len, sizeof(imtq_resp_header));
+    will_return(__wrap_read, &response);
+    ret = k_adcs_start_test_async(TEST_ALL);
+    assert_int_equal(ret, ADCS_OK);
+
+    /* Still in self-test mode */
+    expect_value(__wrap_write, cmd, GET_STATE);
+    expect_value(__wrap_read, len, sizeof(state));
+    will_return(__wrap_read, &state);
+    ret = k_adcs_poll_test(results, &complete);
+    assert_int_equal(ret, ADCS_OK);
+    assert_false(complete);
+
+    /* Test finished */
+    expect_value(__wrap_write, cmd, GET_STATE);
+    expect_value(__wrap_read, len, sizeof(idle_state));
+    will_return(__wrap_read, &idle_state);
+    expect_value(__wrap_write, cmd, GET_TEST);
+    expect_value(__wrap_read, len, sizeof(test_results_all));
+    will_return(__wrap_read, &test_results_all);
+    ret = k_adcs_poll_test(results, &complete);
+
+    int json_ret = json_check(results, NULL);
+    json_delete(results);
+
+    assert_int_equal(ret, ADCS_OK);
+    assert_true(complete);
+    assert_true(json_ret);
+}
+
+static void test_poll_test_not_started(void ** arg)
+{
+    bool complete = true;
+
+    adcs_test_results results = json_mkobject();
+
+    KADCSStatus ret = k_adcs_poll_test(results, &complete);
+    json_delete(results);
+
+    assert_int_equal(ret, ADCS_ERROR);
+    assert_false(complete);
+}
+
 static void test_get_power_status(void ** arg)
 {
     KADCSStatus       ret;
@@ -223,22 +374,141 @@ static void test_get_mode(void ** arg)
     assert_int_equal(mode, SELFTEST);
 }
 
-static void test_get_orientation(void ** arg)
+static void test_get_orientation_null(void ** arg)
 {
     KADCSStatus ret;
 
     ret = k_adcs_get_orientation(NULL);
 
-    assert_int_equal(ret, ADCS_ERROR_NOT_IMPLEMENTED);
+    assert_int_equal(ret, ADCS_ERROR_CONFIG);
+}
+
+static void test_get_orientation(void ** arg)
+{
+    KADCSStatus  ret;
+    adcs_orient  orient = { 0 };
+    imtq_mtm_msg field  = {.data = {.x = 0, .y = -30000, .z = 40000 } };
+
+    expect_value(__wrap_write, cmd, START_MEASURE);
+    expect_value(__wrap_read, len, sizeof(imtq_resp_header));
+    will_return(__wrap_read, &response);
+    expect_value(__wrap_write, cmd, GET_MTM_CALIB);
+    expect_value(__wrap_read, len, sizeof(field));
+    will_return(__wrap_read, &field);
+
+    ret = k_adcs_get_orientation(&orient);
+
+    assert_int_equal(ret, ADCS_OK);
+    assert_true(fabsf(orient.field - 50000) < 1);
+    assert_true(fabsf(orient.y + 0.6f) < 0.0001f);
+    assert_true(fabsf(orient.z - 0.8f) < 0.0001f);
 }
 
-static void test_get_spin(void ** arg)
+static void test_get_spin_null(void ** arg)
 {
     KADCSStatus ret;
 
     ret = k_adcs_get_spin(NULL);
 
-    assert_int_equal(ret, ADCS_ERROR_NOT_IMPLEMENTED);
+    assert_int_equal(ret, ADCS_ERROR_CONFIG);
+}
+
+static void test_get_spin_first_sample(void ** arg)
+{
+    KADCSStatus  ret;
+    adcs_spin    spin  = { 0 };
+    imtq_mtm_msg field = {.data = {.x = 30000, .y = 0, .z = 0 } };
+
+    expect_value(__wrap_write, cmd, START_MEASURE);
+    expect_value(__wrap_read, len, sizeof(imtq_resp_header));
+    will_return(__wrap_read, &response);
+    expect_value(__wrap_write, cmd, GET_MTM_CALIB);
+    expect_value(__wrap_read, len, sizeof(field));
+    will_return(__wrap_read, &field);
+
+    ret = k_adcs_get_spin(&spin);
+
+    /* One sample isn't enough to calculate a rate */
+    assert_int_equal(ret, ADCS_OK);
+    assert_int_equal(spin.samples, 0);
+    assert_true(spin.rate == 0);
+}
+
+/* Feed the field seen by a body spinning about its z-axis, sampled at 10Hz */
+static void feed_spin(float rate, const struct timespec * start, int first, int last)
+{
+    imtq_mtm_sample sample = { 0 };
+
+    for (int i = first; i <= last; i++)
+    {
+        float angle = -rate * i / 10;
+
+        sample.timestamp.tv_sec  = start->tv_sec + i / 10;
+        sample.timestamp.tv_nsec = (i % 10) * 100000000;
+        sample.data.data.x       = (int32_t) (40000 * cosf(angle));
+        sample.data.data.y       = (int32_t) (40000 * sinf(angle));
+        sample.data.data.z       = 0;
+
+        assert_int_equal(k_imtq_estimator_update(&sample, NULL), ADCS_OK);
+    }
+}
+
+static void test_estimator_spin(void ** arg)
+{
+    imtq_mtm_sample sample = { 0 };
+    adcs_spin       spin;
+    struct timespec start;
+
+    const float rate = 0.1;
+
+    /* Timestamps are on the monotonic clock, ending just before now */
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    start.tv_sec -= 3;
+
+    /*
+     * The field is perpendicular to the spin axis so all of the spin is
+     * observable
+     */
+    feed_spin(rate, &start, 0, 20);
+
+    kprv_imtq_estimator_get_spin(&spin);
+
+    assert_int_equal(spin.samples, IMTQ_SPIN_WINDOW);
+    assert_true(fabsf(spin.z - rate) < 0.001f);
+    assert_true(fabsf(spin.x) < 0.001f);
+
+    /* Samples taken while actuating should be ignored */
+    sample.data.act_status = 1;
+    sample.timestamp.tv_sec = start.tv_sec + 3;
+    k_imtq_estimator_update(&sample, NULL);
+
+    kprv_imtq_estimator_get_spin(&spin);
+    assert_true(fabsf(spin.z - rate) < 0.001f);
+}
+
+static void test_estimator_gap(void ** arg)
+{
+    adcs_spin       spin;
+    struct timespec start;
+
+    const float rate = 0.1;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    start.tv_sec -= 30;
+
+    feed_spin(rate, &start, 0, 20);
+
+    /* Nothing has been sampled for much longer than the largest gap */
+    kprv_imtq_estimator_get_spin(&spin);
+    assert_int_equal(spin.samples, 0);
+    assert_true(spin.rate == 0);
+
+    /* After the gap, only the new rates are averaged */
+    feed_spin(-rate, &start, 270, 273);
+
+    kprv_imtq_estimator_get_spin(&spin);
+    assert_int_equal(spin.samples, 3);
+    assert_true(fabsf(spin.z + rate) < 0.001f);
 }
 
 static void test_get_telemetry_nominal(void ** arg)
@@ -253,22 +523,26 @@ static void test_get_telemetry_nominal(void ** arg)
     will_return(__wrap_read, &state);
 
     /* Nominal Telemetry: */
+    /* (Prep for measurement requests) */
+    expect_value(__wrap_write, cmd, START_MEASURE);
+    expect_value(__wrap_read, len, sizeof(imtq_resp_header));
+    will_return(__wrap_read, &response);
+    /* Coil ADC parameters, to convert the housekeeping data */
+    expect_value_count(__wrap_write, cmd, GET_PARAM, 18);
+    expect_value_count(__wrap_read, len, sizeof(config_resp), 18);
+    will_return_count(__wrap_read, &config_resp, 18);
     /* Raw Housekeeping */
     expect_value(__wrap_write, cmd, GET_HOUSE_RAW);
     expect_value(__wrap_read, len, sizeof(house_raw));
     will_return(__wrap_read, &house_raw);
-    /* Engineering Housekeeping */
-    expect_value(__wrap_write, cmd, GET_HOUSE_ENG);
-    expect_value(__wrap_read, len, sizeof(house_eng));
-    will_return(__wrap_read, &house_eng);
     /* Last Detumble Data */
     expect_value(__wrap_write, cmd, GET_DETUMBLE);
     expect_value(__wrap_read, len, sizeof(detumble));
     will_return(__wrap_read, &detumble);
-    /* (Prep for measurement requests) */
-    expect_value(__wrap_write, cmd, START_MEASURE);
-    expect_value(__wrap_read, len, sizeof(imtq_resp_header));
-    will_return(__wrap_read, &response);
+    /* Last Dipole Data */
+    expect_value(__wrap_write, cmd, GET_DIPOLE);
+    expect_value(__wrap_read, len, sizeof(dipole));
+    will_return(__wrap_read, &dipole);
     /* Current Raw MTM Measurement */
     expect_value(__wrap_write, cmd, GET_MTM_RAW);
     expect_value(__wrap_read, len, sizeof(mtm));
@@ -277,10 +551,6 @@ static void test_get_telemetry_nominal(void ** arg)
     expect_value(__wrap_write, cmd, GET_MTM_CALIB);
     expect_value(__wrap_read, len, sizeof(mtm));
     will_return(__wrap_read, &mtm);
-    /* Last Dipole Data */
-    expect_value(__wrap_write, cmd, GET_DIPOLE);
-    expect_value(__wrap_read, len, sizeof(dipole));
-    will_return(__wrap_read, &dipole);
 
     ret = k_adcs_get_telemetry(NOMINAL, results);
 
@@ -323,6 +593,248 @@ static void test_get_telemetry_debug(void ** arg)
     assert_true(json_ret);
 }
 
+static void test_get_telemetry_cbor(void ** arg)
+{
+    KADCSStatus ret;
+    uint8_t     buffer[256];
+    size_t      len;
+
+    /* System State */
+    expect_value(__wrap_write, cmd, GET_STATE);
+    expect_value(__wrap_read, len, sizeof(imtq_state));
+    will_return(__wrap_read, &idle_state);
+
+    /* Nominal Telemetry */
+    expect_value(__wrap_write, cmd, START_MEASURE);
+    expect_value(__wrap_read, len, sizeof(imtq_resp_header));
+    will_return(__wrap_read, &response);
+    expect_value_count(__wrap_write, cmd, GET_PARAM, 18);
+    expect_value_count(__wrap_read, len, sizeof(config_resp), 18);
+    will_return_count(__wrap_read, &config_resp, 18);
+    expect_value(__wrap_write, cmd, GET_HOUSE_RAW);
+    expect_value(__wrap_read, len, sizeof(house_raw));
+    will_return(__wrap_read, &house_raw);
+    expect_value(__wrap_write, cmd, GET_DETUMBLE);
+    expect_value(__wrap_read, len, sizeof(detumble));
+    will_return(__wrap_read, &detumble);
+    expect_value(__wrap_write, cmd, GET_DIPOLE);
+    expect_value(__wrap_read, len, sizeof(dipole));
+    will_return(__wrap_read, &dipole);
+    expect_value(__wrap_write, cmd, GET_MTM_RAW);
+    expect_value(__wrap_read, len, sizeof(mtm));
+    will_return(__wrap_read, &mtm);
+    expect_value(__wrap_write, cmd, GET_MTM_CALIB);
+    expect_value(__wrap_read, len, sizeof(mtm));
+    will_return(__wrap_read, &mtm);
+
+    ret = k_adcs_get_telemetry_cbor(NOMINAL, buffer, sizeof(buffer), &len);
+
+    assert_int_equal(ret, ADCS_OK);
+
+    /* {1: 0 (IDLE), 2: false, 3: true, 4: 36, ... } */
+    const uint8_t status[] = { 0xBF, 0x01, 0x00, 0x02, 0xF4, 0x03, 0xF5, 0x04, 0x18, 36 };
+    assert_memory_equal(buffer, status, sizeof(status));
+
+    /*
+     * 45 zero-valued entries, with no engineering supply or MCU values since
+     * the housekeeping data was converted on the host. The raw housekeeping
+     * keys fit in one byte, the rest need two
+     */
+    assert_int_equal(len, sizeof(status) + 11 * 2 + 34 * 3 + 1);
+    assert_int_equal(buffer[len - 1], 0xFF);
+}
+
+static void test_nominal_to_cbor(void ** arg)
+{
+    KADCSStatus           ret;
+    imtq_nominal_snapshot snapshot = { 0 };
+    uint8_t               buffer[16];
+    size_t                len;
+
+    snapshot.valid         = NOMINAL_DIPOLE;
+    snapshot.dipole.data.x = 5;
+    snapshot.dipole.data.y = -300;
+    snapshot.dipole.data.z = 1000;
+
+    ret = k_adcs_nominal_to_cbor(&snapshot, buffer, sizeof(buffer), &len);
+
+    /* {72: 5, 73: -300, 74: 1000} */
+    const uint8_t expected[] = { 0xBF, 0x18, 72, 0x05, 0x18, 73, 0x39, 0x01, 0x2B,
+                                 0x18, 74, 0x19, 0x03, 0xE8, 0xFF };
+
+    assert_int_equal(ret, ADCS_OK);
+    assert_int_equal(len, sizeof(expected));
+    assert_memory_equal(buffer, expected, sizeof(expected));
+
+    /* The required size should be reported if the buffer is too small */
+    ret = k_adcs_nominal_to_cbor(&snapshot, buffer, 4, &len);
+
+    assert_int_equal(ret, ADCS_ERROR_CONFIG);
+    assert_int_equal(len, sizeof(expected));
+
+    ret = k_adcs_nominal_to_cbor(NULL, buffer, sizeof(buffer), &len);
+
+    assert_int_equal(ret, ADCS_ERROR_CONFIG);
+}
+
+static void test_get_nominal_snapshot_null(void ** arg)
+{
+    KADCSStatus ret;
+
+    ret = k_adcs_get_nominal_snapshot(NULL, NOMINAL_ALL);
+
+    assert_int_equal(ret, ADCS_ERROR_CONFIG);
+}
+
+static void test_get_nominal_snapshot_mask(void ** arg)
+{
+    KADCSStatus           ret;
+    imtq_nominal_snapshot snapshot = { 0 };
+
+    JsonNode * results = json_mkobject();
+
+    /* Only the requested group should be fetched */
+    expect_value(__wrap_write, cmd, GET_DIPOLE);
+    expect_value(__wrap_read, len, sizeof(dipole));
+    will_return(__wrap_read, &dipole);
+
+    ret = k_adcs_get_nominal_snapshot(&snapshot, NOMINAL_DIPOLE);
+
+    k_adcs_nominal_to_json(&snapshot, results);
+
+    JsonNode * dipole_x = json_find_member(results, "dipole_x");
+    JsonNode * mtm_x    = json_find_member(results, "mtm_x_raw");
+    json_delete(results);
+
+    assert_int_equal(ret, ADCS_OK);
+    assert_int_equal(snapshot.valid, NOMINAL_DIPOLE);
+    assert_int_equal(snapshot.timing.mtm_read, 0);
+    assert_non_null(dipole_x);
+    assert_null(mtm_x);
+}
+
+static void test_convert_housekeeping(void ** arg)
+{
+    KADCSStatus           ret;
+    imtq_housekeeping_cal cal = { 0 };
+    imtq_housekeeping_raw raw = { 0 };
+    imtq_housekeeping_eng eng = { 0 };
+
+    cal.coil_current[0] = (imtq_adc_conversion){.bias = 2048, .mult = 10, .div = 4 };
+    cal.coil_temp[2]    = (imtq_adc_conversion){.bias = -10, .mult = 1, .div = 1 };
+
+    raw.voltage_d      = 1000;
+    raw.coil_current.x = 2148;
+    raw.coil_temp.z    = 15;
+    raw.mcu_temp       = 2650;
+    eng.mcu_temp       = 99;
+
+    ret = k_imtq_convert_housekeeping(&raw, &cal, &eng);
+
+    assert_int_equal(ret, ADCS_OK);
+    assert_int_equal(eng.coil_current.x, 250);
+    assert_int_equal(eng.coil_temp.z, 25);
+    /* Zero divider shouldn't blow up */
+    assert_int_equal(eng.coil_current.y, 0);
+    /* The supply and MCU channels aren't converted */
+    assert_int_equal(eng.voltage_d, 0);
+    assert_int_equal(eng.mcu_temp, 0);
+}
+
+static void test_housekeeping_cal(void ** arg)
+{
+    KADCSStatus           ret;
+    imtq_housekeeping_cal cal      = { 0 };
+    imtq_nominal_snapshot snapshot = { 0 };
+    imtq_config_resp      coil_div = { 0 };
+    imtq_housekeeping_raw raw      = { 0 };
+
+    /* Every coil ADC parameter reads 2, so each coil channel is (raw - 2) */
+    coil_div.value.int16_val = 2;
+
+    raw.voltage_d      = 1000;
+    raw.mcu_temp       = 2500;
+    raw.coil_current.x = 102;
+    raw.coil_temp.z    = 27;
+
+    assert_int_equal(k_imtq_get_housekeeping_cal(&cal), ADCS_ERROR);
+
+    /* The first request loads the coil ADC parameters itself */
+    expect_value_count(__wrap_write, cmd, GET_PARAM, 18);
+    expect_value_count(__wrap_read, len, sizeof(coil_div), 18);
+    will_return_count(__wrap_read, &coil_div, 18);
+    expect_value(__wrap_write, cmd, GET_HOUSE_RAW);
+    expect_value(__wrap_read, len, sizeof(raw));
+    will_return(__wrap_read, &raw);
+
+    ret = k_adcs_get_nominal_snapshot(&snapshot, NOMINAL_HOUSEKEEPING);
+
+    assert_int_equal(ret, ADCS_OK);
+    assert_int_equal(snapshot.valid, NOMINAL_HOUSEKEEPING);
+    assert_true(snapshot.house_converted);
+    assert_int_equal(snapshot.house_raw.voltage_d, 1000);
+    assert_int_equal(snapshot.house_raw.mcu_temp, 2500);
+    assert_int_equal(snapshot.house_eng.coil_current.x, 100);
+    assert_int_equal(snapshot.house_eng.coil_temp.z, 25);
+    assert_int_equal(snapshot.house_eng.voltage_d, 0);
+
+    ret = k_imtq_get_housekeeping_cal(&cal);
+    assert_int_equal(ret, ADCS_OK);
+    assert_int_equal(cal.coil_temp[2].div, 2);
+
+    /* After which only the raw housekeeping data should be requested */
+    expect_value(__wrap_write, cmd, GET_HOUSE_RAW);
+    expect_value(__wrap_read, len, sizeof(raw));
+    will_return(__wrap_read, &raw);
+
+    ret = k_adcs_get_nominal_snapshot(&snapshot, NOMINAL_HOUSEKEEPING);
+
+    assert_int_equal(ret, ADCS_OK);
+    assert_true(snapshot.house_converted);
+    assert_int_equal(snapshot.house_eng.coil_current.x, 100);
+
+    JsonNode * results = json_mkobject();
+    k_adcs_nominal_to_json(&snapshot, results);
+
+    JsonNode * coil_eng = json_find_member(results, "coil_current_x_eng");
+    JsonNode * mcu_raw  = json_find_member(results, "mcu_temp_raw");
+    JsonNode * mcu_eng  = json_find_member(results, "mcu_temp_eng");
+    json_delete(results);
+
+    assert_non_null(coil_eng);
+    assert_non_null(mcu_raw);
+    assert_null(mcu_eng);
+}
+
+static void test_housekeeping_cal_fail(void ** arg)
+{
+    KADCSStatus           ret;
+    imtq_nominal_snapshot snapshot = { 0 };
+    imtq_config_resp      rejected = {.hdr.status = IMTQ_ERROR_BAD_PARAM };
+
+    house_eng.mcu_temp = 25;
+
+    /* Without a calibration, both housekeeping blocks are requested */
+    expect_value(__wrap_write, cmd, GET_PARAM);
+    expect_value(__wrap_read, len, sizeof(rejected));
+    will_return(__wrap_read, &rejected);
+    expect_value(__wrap_write, cmd, GET_HOUSE_RAW);
+    expect_value(__wrap_read, len, sizeof(house_raw));
+    will_return(__wrap_read, &house_raw);
+    expect_value(__wrap_write, cmd, GET_HOUSE_ENG);
+    expect_value(__wrap_read, len, sizeof(house_eng));
+    will_return(__wrap_read, &house_eng);
+
+    ret = k_adcs_get_nominal_snapshot(&snapshot, NOMINAL_HOUSEKEEPING);
+
+    house_eng.mcu_temp = 0;
+
+    assert_int_equal(ret, ADCS_OK);
+    assert_int_equal(snapshot.valid, NOMINAL_HOUSEKEEPING);
+    assert_false(snapshot.house_converted);
+    assert_int_equal(snapshot.house_eng.mcu_temp, 25);
+}
+
 static void test_passthrough(void ** arg)
 {
     KADCSStatus ret;
@@ -365,18 +877,34 @@ int main(void)
         cmocka_unit_test(test_no_init_noop),
         cmocka_unit_test_setup_teardown(test_noop, init, term),
         cmocka_unit_test_setup_teardown(test_configure, init, term),
+        cmocka_unit_test_setup_teardown(test_configure_name, init, term),
+        cmocka_unit_test_setup_teardown(test_configure_unknown, init, term),
         cmocka_unit_test_setup_teardown(test_reset, init, term),
         cmocka_unit_test_setup_teardown(test_set_mode_detumble, init, term),
         cmocka_unit_test_setup_teardown(test_set_mode_detumble_null, init, term),
         cmocka_unit_test_setup_teardown(test_set_mode_idle, init, term),
         cmocka_unit_test_setup_teardown(test_run_test_all, init, term),
         cmocka_unit_test_setup_teardown(test_run_test_single, init, term),
+        cmocka_unit_test_setup_teardown(test_run_test_not_started, init, term),
+        cmocka_unit_test_setup_teardown(test_run_test_async, init, term),
+        cmocka_unit_test_setup_teardown(test_poll_test_not_started, init, term),
         cmocka_unit_test_setup_teardown(test_get_power_status, init, term),
         cmocka_unit_test_setup_teardown(test_get_mode, init, term),
+        cmocka_unit_test_setup_teardown(test_get_orientation_null, init, term),
         cmocka_unit_test_setup_teardown(test_get_orientation, init, term),
-        cmocka_unit_test_setup_teardown(test_get_spin, init, term),
+        cmocka_unit_test_setup_teardown(test_get_spin_null, init, term),
+        cmocka_unit_test_setup_teardown(test_get_spin_first_sample, init, term),
+        cmocka_unit_test_setup_teardown(test_estimator_spin, init, term),
+        cmocka_unit_test_setup_teardown(test_estimator_gap, init, term),
         cmocka_unit_test_setup_teardown(test_get_telemetry_nominal, init, term),
         cmocka_unit_test_setup_teardown(test_get_telemetry_debug, init, term),
+        cmocka_unit_test_setup_teardown(test_get_telemetry_cbor, init, term),
+        cmocka_unit_test(test_nominal_to_cbor),
+        cmocka_unit_test_setup_teardown(test_get_nominal_snapshot_null, init, term),
+        cmocka_unit_test_setup_teardown(test_get_nominal_snapshot_mask, init, term),
+        cmocka_unit_test(test_convert_housekeeping),
+        cmocka_unit_test_setup_teardown(test_housekeeping_cal, init, term),
+        cmocka_unit_test_setup_teardown(test_housekeeping_cal_fail, init, term),
         cmocka_unit_test_setup_teardown(test_passthrough, init, term),
     };
 
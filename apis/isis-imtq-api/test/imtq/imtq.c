@@ -17,6 +17,8 @@
 
 #include <imtq.h>
 #include <cmocka.h>
+#include <errno.h>
+#include <pthread.h>
 
 static char * bus = "/dev/i2c-1";
 static uint16_t addr = 0x40;
@@ -51,7 +53,7 @@ imtq_test_result_single test_results_single = { 0 };
 imtq_housekeeping_raw   house_raw           = { 0 };
 imtq_housekeeping_eng   house_eng           = { 0 };
 imtq_detumble           detumble            = { 0 };
-imtq_mtm_data           mtm                 = { 0 };
+imtq_mtm_msg            mtm                 = { 0 };
 imtq_dipole             dipole              = { 0 };
 imtq_coil_current       coil_current        = { 0 };
 imtq_coil_temp          coil_temp           = { 0 };
@@ -681,6 +683,656 @@ static void test_watchdog_stop_no_start(void ** arg)
     assert_int_equal(ret, ADCS_ERROR);
 }
 
+/*
+ * Scripted device, for the tests which talk to the iMTQ from a background
+ * thread. Measurement `n` returns a field with x = n * 100
+ */
+extern void (*device_response)(const uint8_t * tx, size_t tx_len, uint8_t * rx,
+                               size_t rx_len);
+
+static pthread_mutex_t device_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  device_cond  = PTHREAD_COND_INITIALIZER;
+static int             device_measurements;
+static int             device_fail;     /* Measurement to fail, or 0 */
+static int             device_hold;     /* Measurement to hold until released, or 0 */
+static bool            device_held;
+static int             device_commands;
+static uint8_t         device_last_cmd;
+static int             device_actuations;
+static int16_t         device_dipole_x[16];
+static uint16_t        device_dipole_time[16];
+
+static void device_scripted(const uint8_t * tx, size_t tx_len, uint8_t * rx,
+                            size_t rx_len)
+{
+    imtq_resp_header hdr = {.cmd = tx[0], .status = 0 };
+
+    pthread_mutex_lock(&device_mutex);
+
+    memset(rx, 0, rx_len);
+
+    device_commands++;
+    device_last_cmd = tx[0];
+
+    if (tx[0] == START_DIPOLE && tx_len == 9 && device_actuations < 16)
+    {
+        device_dipole_x[device_actuations]    = (int16_t) (tx[1] | tx[2] << 8);
+        device_dipole_time[device_actuations] = (uint16_t) (tx[7] | tx[8] << 8);
+        device_actuations++;
+    }
+
+    if (tx[0] == GET_MTM_CALIB)
+    {
+        int n = ++device_measurements;
+
+        if (n == device_hold)
+        {
+            /* Freeze the calling thread mid-cycle, so the test sees a stable state */
+            device_held = true;
+            pthread_cond_broadcast(&device_cond);
+            while (device_held)
+            {
+                pthread_cond_wait(&device_cond, &device_mutex);
+            }
+        }
+
+        imtq_mtm_msg msg = {.hdr = hdr, .data = {.x = n * 100, .y = 0, .z = 40000 } };
+        if (n == device_fail)
+        {
+            msg.hdr.status = IMTQ_ERROR_BAD_PARAM;
+        }
+
+        memcpy(rx, &msg, (rx_len < sizeof(msg)) ? rx_len : sizeof(msg));
+    }
+    else
+    {
+        memcpy(rx, &hdr, sizeof(hdr));
+    }
+
+    pthread_mutex_unlock(&device_mutex);
+}
+
+static void device_start(int fail, int hold)
+{
+    pthread_mutex_lock(&device_mutex);
+    device_measurements = 0;
+    device_commands     = 0;
+    device_actuations   = 0;
+    device_fail         = fail;
+    device_hold         = hold;
+    device_held         = false;
+    pthread_mutex_unlock(&device_mutex);
+
+    device_response = device_scripted;
+}
+
+/* Wait for the device to hold a measurement, giving up after 10 seconds */
+static void device_wait_held(void)
+{
+    struct timespec limit;
+    bool            held;
+
+    clock_gettime(CLOCK_REALTIME, &limit);
+    limit.tv_sec += 10;
+
+    pthread_mutex_lock(&device_mutex);
+    while (!device_held
+           && pthread_cond_timedwait(&device_cond, &device_mutex, &limit) != ETIMEDOUT)
+    {
+    }
+    held = device_held;
+    pthread_mutex_unlock(&device_mutex);
+
+    assert_true(held);
+}
+
+static void device_release(void)
+{
+    pthread_mutex_lock(&device_mutex);
+    device_hold = 0;
+    device_held = false;
+    pthread_cond_broadcast(&device_cond);
+    pthread_mutex_unlock(&device_mutex);
+}
+
+static int64_t timespec_diff_us(const struct timespec * end,
+                                const struct timespec * start)
+{
+    return (int64_t) (end->tv_sec - start->tv_sec) * 1000000
+           + (end->tv_nsec - start->tv_nsec) / 1000;
+}
+
+/* Streaming Tests */
+
+static void test_stream_start_bad_rate(void ** arg)
+{
+    assert_int_equal(k_imtq_stream_start(0), ADCS_ERROR_CONFIG);
+    assert_int_equal(k_imtq_stream_start(IMTQ_STREAM_MAX_RATE + 1),
+                     ADCS_ERROR_CONFIG);
+}
+
+static void test_stream_stop_no_start(void ** arg)
+{
+    KADCSStatus ret;
+
+    ret = k_imtq_stream_stop();
+
+    assert_int_equal(ret, ADCS_ERROR);
+}
+
+static void test_stream_read_empty(void ** arg)
+{
+    KADCSStatus     ret;
+    imtq_mtm_sample samples[4];
+    uint16_t        count = 1;
+
+    ret = k_imtq_stream_read(samples, 4, &count);
+
+    assert_int_equal(ret, ADCS_OK);
+    assert_int_equal(count, 0);
+}
+
+static void test_stream_read_null(void ** arg)
+{
+    KADCSStatus ret;
+    uint16_t    count;
+
+    ret = k_imtq_stream_read(NULL, 4, &count);
+
+    assert_int_equal(ret, ADCS_ERROR_CONFIG);
+}
+
+static void test_stream_get_stats_null(void ** arg)
+{
+    KADCSStatus ret;
+
+    ret = k_imtq_stream_get_stats(NULL);
+
+    assert_int_equal(ret, ADCS_ERROR_CONFIG);
+}
+
+static void test_stream_samples(void ** arg)
+{
+    imtq_mtm_sample   samples[IMTQ_STREAM_DEPTH + 1];
+    imtq_stream_stats stats;
+    uint16_t          count;
+
+    const uint32_t period = 1000000 / IMTQ_STREAM_MAX_RATE;
+
+    /* The third measurement fails, and nothing is read until the buffer overflows */
+    device_start(3, IMTQ_STREAM_DEPTH + 4);
+
+    assert_int_equal(k_imtq_stream_start(IMTQ_STREAM_MAX_RATE), ADCS_OK);
+    device_wait_held();
+
+    assert_int_equal(k_imtq_stream_read(samples, IMTQ_STREAM_DEPTH + 1, &count),
+                     ADCS_OK);
+    assert_int_equal(k_imtq_stream_get_stats(&stats), ADCS_OK);
+
+    device_release();
+    assert_int_equal(k_imtq_stream_stop(), ADCS_OK);
+    device_response = NULL;
+
+    /* The newest samples are dropped once the buffer is full */
+    assert_int_equal(count, IMTQ_STREAM_DEPTH);
+    assert_int_equal(stats.period, period);
+    assert_int_equal(stats.samples, IMTQ_STREAM_DEPTH + 2);
+    assert_int_equal(stats.errors, 1);
+    assert_int_equal(stats.overruns, 2);
+    assert_true(stats.jitter_max >= stats.jitter_mean);
+
+    /* Oldest first, without the failed measurement */
+    for (int i = 0; i < count; i++)
+    {
+        int n = (i < 2) ? i + 1 : i + 2;
+
+        assert_int_equal(samples[i].data.data.x, n * 100);
+        if (i > 0)
+        {
+            assert_true(timespec_diff_us(&samples[i].timestamp,
+                                         &samples[i - 1].timestamp) > 0);
+        }
+    }
+
+    /*
+     * No sample starts before its deadline, and the first starts at most
+     * jitter_max after its own, so the samples span at least count periods
+     */
+    int64_t span = timespec_diff_us(&samples[count - 1].timestamp,
+                                    &samples[0].timestamp);
+    assert_true(span + stats.jitter_max >= (int64_t) count * period);
+}
+
+static void test_lock_stats(void ** arg)
+{
+    KADCSStatus     ret;
+    imtq_lock_stats stats;
+
+    k_imtq_reset_lock_stats();
+
+    expect_value(__wrap_write, cmd, NOOP);
+    expect_value(__wrap_read, len, sizeof(imtq_resp_header));
+    will_return(__wrap_read, &response);
+    ret = k_adcs_noop();
+    assert_int_equal(ret, ADCS_OK);
+
+    /* Transfers are counted against the calling thread's traffic class */
+    assert_int_equal(k_imtq_set_traffic_class(IMTQ_TRAFFIC_CONTROL), ADCS_OK);
+
+    expect_value(__wrap_write, cmd, NOOP);
+    expect_value(__wrap_read, len, sizeof(imtq_resp_header));
+    will_return(__wrap_read, &response);
+    ret = k_adcs_noop();
+    assert_int_equal(ret, ADCS_OK);
+
+    k_imtq_set_traffic_class(IMTQ_TRAFFIC_TELEMETRY);
+
+    ret = k_imtq_get_lock_stats(IMTQ_TRAFFIC_TELEMETRY, &stats);
+    assert_int_equal(ret, ADCS_OK);
+    assert_int_equal(stats.acquisitions, 1);
+    assert_int_equal(stats.contended, 0);
+    assert_int_equal(stats.timeouts, 0);
+    /* Each transfer holds the lock across the 1ms response delay */
+    assert_true(stats.hold_total >= 1000);
+
+    ret = k_imtq_get_lock_stats(IMTQ_TRAFFIC_CONTROL, &stats);
+    assert_int_equal(ret, ADCS_OK);
+    assert_int_equal(stats.acquisitions, 1);
+
+    ret = k_imtq_get_lock_stats(IMTQ_TRAFFIC_WATCHDOG, &stats);
+    assert_int_equal(ret, ADCS_OK);
+    assert_int_equal(stats.acquisitions, 0);
+}
+
+static void test_lock_stats_bad_args(void ** arg)
+{
+    imtq_lock_stats stats;
+
+    assert_int_equal(k_imtq_get_lock_stats(IMTQ_TRAFFIC_CLASSES, &stats),
+                     ADCS_ERROR_CONFIG);
+    assert_int_equal(k_imtq_get_lock_stats(IMTQ_TRAFFIC_CONTROL, NULL),
+                     ADCS_ERROR_CONFIG);
+    assert_int_equal(k_imtq_set_traffic_class(IMTQ_TRAFFIC_CLASSES),
+                     ADCS_ERROR_CONFIG);
+}
+
+static void test_find_param(void ** arg)
+{
+    const imtq_param_desc * param = k_imtq_find_param(MTM_MATRIX_R1_C1);
+
+    assert_non_null(param);
+    assert_int_equal(param->type, IMTQ_PARAM_DOUBLE);
+    assert_string_equal(param->name, "MTM_MATRIX_R1_C1");
+    assert_string_equal(param->key, "0xa001");
+
+    assert_null(k_imtq_find_param(0x1234));
+}
+
+static void test_find_param_name(void ** arg)
+{
+    const imtq_param_desc * param = k_imtq_find_param_name("WATCHDOG_TIMEOUT");
+
+    assert_non_null(param);
+    assert_int_equal(param->id, WATCHDOG_TIMEOUT);
+    assert_int_equal(param->type, IMTQ_PARAM_UINT8);
+
+    assert_null(k_imtq_find_param_name("NOT_A_PARAM"));
+    assert_null(k_imtq_find_param_name(NULL));
+}
+
+static void test_param_table_sorted(void ** arg)
+{
+    /* Name lookups rely on the table being sorted */
+    for (int i = 1; i < IMTQ_NUM_PARAMS; i++)
+    {
+        assert_true(strcmp(imtq_params[i - 1].name, imtq_params[i].name) < 0);
+    }
+
+    for (int i = 0; i < IMTQ_NUM_PARAMS; i++)
+    {
+        assert_ptr_equal(k_imtq_find_param_name(imtq_params[i].name),
+                         &imtq_params[i]);
+        assert_ptr_equal(k_imtq_find_param(imtq_params[i].id), &imtq_params[i]);
+    }
+}
+
+static void test_param_encode_decode(void ** arg)
+{
+    imtq_config_value value = { 0 };
+
+    const imtq_param_desc * param = k_imtq_find_param(ADC_COIL_TEMP_BIAS_X);
+
+    param->encode(-1234, &value);
+    assert_int_equal(value.int16_val, -1234);
+    assert_true(param->decode(&value) == -1234.0);
+
+    param = k_imtq_find_param(BDOT_GAIN);
+
+    param->encode(-0.5, &value);
+    assert_true(value.double_val == -0.5);
+    assert_true(param->decode(&value) == -0.5);
+}
+
+/* Snapshot Tests */
+
+static const char * snapshot_path = "/tmp/imtq-snapshot-test.bin";
+
+static void expect_get_params(int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        expect_value(__wrap_write, cmd, GET_PARAM);
+        expect_value(__wrap_read, len, sizeof(imtq_config_resp));
+        will_return(__wrap_read, &config_resp);
+    }
+}
+
+static void expect_get_state(imtq_state * resp)
+{
+    expect_value(__wrap_write, cmd, GET_STATE);
+    expect_value(__wrap_read, len, sizeof(imtq_state));
+    will_return(__wrap_read, resp);
+}
+
+static void expect_set_param(void)
+{
+    expect_value(__wrap_write, cmd, SET_PARAM);
+    expect_value(__wrap_read, len, sizeof(imtq_resp_header));
+    will_return(__wrap_read, &response);
+}
+
+static void expect_save_config(void)
+{
+    expect_get_state(&state);
+    expect_get_params(IMTQ_NUM_PARAMS);
+}
+
+static void test_save_config(void ** arg)
+{
+    KADCSStatus ret;
+
+    expect_save_config();
+    ret = k_imtq_save_config(snapshot_path);
+    assert_int_equal(ret, ADCS_OK);
+
+    /* State, software version + sampled params */
+    expect_get_state(&state);
+    expect_get_params(1 + IMTQ_SNAPSHOT_SAMPLES);
+    ret = k_imtq_check_config(snapshot_path);
+    assert_int_equal(ret, ADCS_OK);
+
+    remove(snapshot_path);
+}
+
+static void test_check_config_changed(void ** arg)
+{
+    KADCSStatus ret;
+
+    expect_save_config();
+    ret = k_imtq_save_config(snapshot_path);
+    assert_int_equal(ret, ADCS_OK);
+
+    /* The software version no longer matches, so nothing else is read */
+    config_resp.value.uint8_val = 4;
+    expect_get_state(&state);
+    expect_get_params(1);
+    ret = k_imtq_check_config(snapshot_path);
+    config_resp.value.uint8_val = 3;
+
+    assert_int_equal(ret, ADCS_ERROR);
+
+    remove(snapshot_path);
+}
+
+static void test_check_config_missing(void ** arg)
+{
+    remove(snapshot_path);
+
+    assert_int_equal(k_imtq_check_config(snapshot_path), ADCS_ERROR_CONFIG);
+    assert_int_equal(k_imtq_check_config(NULL), ADCS_ERROR_CONFIG);
+}
+
+static void test_check_config_corrupt(void ** arg)
+{
+    KADCSStatus ret;
+
+    expect_save_config();
+    ret = k_imtq_save_config(snapshot_path);
+    assert_int_equal(ret, ADCS_OK);
+
+    /* Flip a bit in the last parameter entry */
+    FILE * file = fopen(snapshot_path, "r+b");
+    assert_non_null(file);
+    fseek(file, -1, SEEK_END);
+    int byte = fgetc(file);
+    fseek(file, -1, SEEK_END);
+    fputc(byte ^ 0x01, file);
+    fclose(file);
+
+    ret = k_imtq_check_config(snapshot_path);
+    assert_int_equal(ret, ADCS_ERROR_CONFIG);
+
+    remove(snapshot_path);
+}
+
+static void test_configure_cached(void ** arg)
+{
+    KADCSStatus ret;
+    JsonNode *  config;
+
+    expect_save_config();
+    ret = k_imtq_save_config(snapshot_path);
+    assert_int_equal(ret, ADCS_OK);
+
+    /* Same as the snapshot, so the configured params are only read back */
+    config = json_decode("{\"0x2003\": 3, \"MTM_INTERNAL_TIME\": 3}");
+    expect_get_state(&state);
+    expect_get_params(1 + 2);
+    ret = k_imtq_configure_cached(config, snapshot_path);
+    json_delete(config);
+    assert_int_equal(ret, ADCS_OK);
+
+    /* Changed, so the parameter is sent and a new snapshot is saved */
+    config = json_decode("{\"0x2003\": 1}");
+    expect_set_param();
+    expect_save_config();
+    ret = k_imtq_configure_cached(config, snapshot_path);
+    json_delete(config);
+    assert_int_equal(ret, ADCS_OK);
+
+    remove(snapshot_path);
+}
+
+static void test_configure_cached_reset(void ** arg)
+{
+    KADCSStatus ret;
+    JsonNode *  config;
+
+    /* The iMTQ has restarted, so its parameters are back to their defaults */
+    imtq_state reset = state;
+    reset.config     = 0;
+
+    config = json_decode("{\"0x2003\": 3, \"MTM_INTERNAL_TIME\": 3}");
+
+    expect_save_config();
+    ret = k_imtq_save_config(snapshot_path);
+    assert_int_equal(ret, ADCS_OK);
+
+    /* Nothing is read back, since the whole configuration must be sent again */
+    expect_get_state(&reset);
+    expect_set_param();
+    expect_set_param();
+    expect_save_config();
+    ret = k_imtq_configure_cached(config, snapshot_path);
+    assert_int_equal(ret, ADCS_OK);
+
+    json_delete(config);
+    remove(snapshot_path);
+}
+
+static void test_configure_cached_readback(void ** arg)
+{
+    KADCSStatus ret;
+    JsonNode *  config;
+
+    /* A configured parameter which no longer has the configured value */
+    imtq_config_resp changed = config_resp;
+    changed.value.uint8_val  = 1;
+
+    config = json_decode("{\"0x2003\": 3, \"MTM_INTERNAL_TIME\": 3}");
+
+    expect_save_config();
+    ret = k_imtq_save_config(snapshot_path);
+    assert_int_equal(ret, ADCS_OK);
+
+    expect_get_state(&state);
+    expect_get_params(1 + 1);
+    expect_value(__wrap_write, cmd, GET_PARAM);
+    expect_value(__wrap_read, len, sizeof(imtq_config_resp));
+    will_return(__wrap_read, &changed);
+    expect_set_param();
+    expect_set_param();
+    expect_save_config();
+    ret = k_imtq_configure_cached(config, snapshot_path);
+    assert_int_equal(ret, ADCS_OK);
+
+    json_delete(config);
+    remove(snapshot_path);
+}
+
+static bool test_control_law(const imtq_mtm_sample * sample,
+                             imtq_axis_data * dipole, void * arg)
+{
+    return false;
+}
+
+static void test_control_start_bad_config(void ** arg)
+{
+    imtq_control_config config = {
+        .rate = 10,
+        .actuation_time = 10,
+        .priority = 0,
+        .cpu = -1,
+        .lock_memory = false,
+        .compute = test_control_law,
+        .arg = NULL
+    };
+
+    assert_int_equal(k_imtq_control_start(NULL), ADCS_ERROR_CONFIG);
+
+    config.rate = IMTQ_CONTROL_MAX_RATE + 1;
+    assert_int_equal(k_imtq_control_start(&config), ADCS_ERROR_CONFIG);
+
+    /* The coils must switch off... */
+    config.rate = 10;
+    config.actuation_time = 0;
+    assert_int_equal(k_imtq_control_start(&config), ADCS_ERROR_CONFIG);
+
+    /* ...and settle before the next measurement, 100ms after this one */
+    config.actuation_time = 100 - 1 - IMTQ_CONTROL_SETTLE_TIME;
+    assert_int_equal(k_imtq_control_start(&config), ADCS_ERROR_CONFIG);
+
+    config.actuation_time = 10;
+    config.compute = NULL;
+    assert_int_equal(k_imtq_control_start(&config), ADCS_ERROR_CONFIG);
+}
+
+/* Commands a dipole of a tenth of the field, on every other cycle */
+static int             control_calls;
+static struct timespec control_times[16];
+
+static bool test_control_alternate(const imtq_mtm_sample * sample,
+                                   imtq_axis_data * dipole, void * arg)
+{
+    if (control_calls < 16)
+    {
+        control_times[control_calls] = sample->timestamp;
+    }
+    control_calls++;
+
+    dipole->x = (int16_t) (sample->data.data.x / 10);
+
+    return (control_calls % 2) == 1;
+}
+
+static void test_control_loop(void ** arg)
+{
+    imtq_control_stats stats;
+    int                calls;
+    int                commands;
+    uint8_t            last_cmd;
+
+    const struct timespec SETTLE = {.tv_sec = 0, .tv_nsec = 50000000 };
+
+    imtq_control_config config = {
+        .rate = 50,
+        .actuation_time = 10,
+        .priority = 0,
+        .cpu = -1,
+        .lock_memory = false,
+        .compute = test_control_alternate,
+        .arg = NULL
+    };
+
+    /* Freeze the loop mid-way through its seventh cycle */
+    control_calls = 0;
+    device_start(0, 7);
+
+    assert_int_equal(k_imtq_control_start(&config), ADCS_OK);
+    assert_int_equal(k_imtq_control_start(&config), ADCS_ERROR);
+    device_wait_held();
+
+    calls = control_calls;
+    assert_int_equal(k_imtq_control_get_stats(&stats), ADCS_OK);
+
+    device_release();
+    assert_int_equal(k_imtq_control_stop(), ADCS_OK);
+
+    /* The loop has been joined, so nothing else reaches the iMTQ */
+    pthread_mutex_lock(&device_mutex);
+    commands = device_commands;
+    pthread_mutex_unlock(&device_mutex);
+    nanosleep(&SETTLE, NULL);
+    pthread_mutex_lock(&device_mutex);
+    assert_int_equal(device_commands, commands);
+    last_cmd = device_last_cmd;
+    pthread_mutex_unlock(&device_mutex);
+
+    device_response = NULL;
+
+    /* Stopping switches the coils off */
+    assert_int_equal(last_cmd, CANCEL_OP);
+
+    assert_int_equal(calls, 6);
+    assert_int_equal(stats.period, 20000);
+    assert_int_equal(stats.cycles, 6);
+    assert_int_equal(stats.skipped, 3);
+    assert_int_equal(stats.errors, 0);
+    assert_true(stats.latency_max >= stats.latency_mean);
+
+    /* Cycles 1, 3 and 5 actuated, plus the released seventh */
+    assert_int_equal(device_actuations, 4);
+    for (int i = 0; i < device_actuations; i++)
+    {
+        assert_int_equal(device_dipole_x[i], (2 * i + 1) * 10);
+        assert_int_equal(device_dipole_time[i], 10);
+    }
+
+    /* Cycles are released on the period, however late the first one ran */
+    int64_t span = timespec_diff_us(&control_times[5], &control_times[0]);
+    assert_true(span + stats.latency_max >= 5 * (int64_t) stats.period);
+}
+
+static void test_control_stop_not_started(void ** arg)
+{
+    assert_int_equal(k_imtq_control_stop(), ADCS_ERROR);
+}
+
+static void test_control_stats_null(void ** arg)
+{
+    assert_int_equal(k_imtq_control_get_stats(NULL), ADCS_ERROR_CONFIG);
+}
+
 static void test_transfer_null_tx(void ** arg)
 {
     KADCSStatus           ret;
@@ -883,6 +1535,29 @@ int main(void)
             cmocka_unit_test_setup_teardown(test_watchdog, init, term),
             cmocka_unit_test_setup_teardown(test_watchdog_twice, init, term),
             cmocka_unit_test_setup_teardown(test_watchdog_stop_no_start, init, term),
+            cmocka_unit_test_setup_teardown(test_stream_start_bad_rate, init, term),
+            cmocka_unit_test_setup_teardown(test_stream_stop_no_start, init, term),
+            cmocka_unit_test_setup_teardown(test_stream_read_empty, init, term),
+            cmocka_unit_test_setup_teardown(test_stream_read_null, init, term),
+            cmocka_unit_test_setup_teardown(test_stream_get_stats_null, init, term),
+            cmocka_unit_test_setup_teardown(test_stream_samples, init, term),
+            cmocka_unit_test_setup_teardown(test_lock_stats, init, term),
+            cmocka_unit_test(test_lock_stats_bad_args),
+            cmocka_unit_test(test_find_param),
+            cmocka_unit_test(test_find_param_name),
+            cmocka_unit_test(test_param_table_sorted),
+            cmocka_unit_test(test_param_encode_decode),
+            cmocka_unit_test_setup_teardown(test_save_config, init, term),
+            cmocka_unit_test_setup_teardown(test_check_config_changed, init, term),
+            cmocka_unit_test(test_check_config_missing),
+            cmocka_unit_test_setup_teardown(test_check_config_corrupt, init, term),
+            cmocka_unit_test_setup_teardown(test_configure_cached, init, term),
+            cmocka_unit_test_setup_teardown(test_configure_cached_reset, init, term),
+            cmocka_unit_test_setup_teardown(test_configure_cached_readback, init, term),
+            cmocka_unit_test_setup_teardown(test_control_start_bad_config, init, term),
+            cmocka_unit_test_setup_teardown(test_control_loop, init, term),
+            cmocka_unit_test_setup_teardown(test_control_stop_not_started, init, term),
+            cmocka_unit_test_setup_teardown(test_control_stats_null, init, term),
             cmocka_unit_test_setup_teardown(test_transfer_null_tx, init, term),
             cmocka_unit_test_setup_teardown(test_transfer_zero_tx_len, init, term),
             cmocka_unit_test_setup_teardown(test_transfer_null_rx, init, term),
@@ -22,15 +22,38 @@
 uint8_t  last_cmd;
 uint16_t last_param;
 
+/*
+ * Scripted iMTQ, for tests whose traffic comes from a background thread.
+ * cmocka's mocks can only be used from the test's own thread, so while this is
+ * set it answers every transfer instead: `tx` is the last command written
+ */
+void (*device_response)(const uint8_t * tx, size_t tx_len, uint8_t * rx,
+                        size_t rx_len) = NULL;
+
+static uint8_t device_tx[16];
+static size_t  device_tx_len;
+
+/* Only the I2C bus is mocked. Anything else (ex. a timerfd) is real */
+static int i2c_fd = -1;
+
+ssize_t __real_read(int fd, void * buf, size_t count);
+int     __real_close(int fd);
+
 /* Returns a file descriptor or -1 on failure */
 int __wrap_open(const char * filename, int flags)
 {
-    return mock_type(int);
+    i2c_fd = mock_type(int);
+    return i2c_fd;
 }
 
 /* Returns 0 on success and -1 on failure */
 int __wrap_close(int fd)
 {
+    if (fd != i2c_fd)
+    {
+        return __real_close(fd);
+    }
+
     return mock_type(int);
 }
 
@@ -46,6 +69,13 @@ int __wrap_ioctl(int fd, unsigned long request, ...)
 /* Returns number of bytes "written" or -1 on failure */
 ssize_t __wrap_write(int fd, const char * buf, size_t count)
 {
+    if (device_response != NULL)
+    {
+        device_tx_len = (count < sizeof(device_tx)) ? count : sizeof(device_tx);
+        memcpy(device_tx, buf, device_tx_len);
+        return (ssize_t) count;
+    }
+
     /* Verify that we're sending the correct command */
     uint8_t cmd = buf[0];
     check_expected(cmd);
@@ -78,6 +108,17 @@ ssize_t __wrap_read(int fd, char * buf, size_t count)
 {
     ssize_t len = (ssize_t) count;
 
+    if (fd != i2c_fd)
+    {
+        return __real_read(fd, buf, count);
+    }
+
+    if (device_response != NULL)
+    {
+        device_response(device_tx, device_tx_len, (uint8_t *) buf, count);
+        return len;
+    }
+
     if (len < 0)
     {
         /* Only relevant when we make the read call fail */
@@ -25,6 +25,7 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <time.h>
 
 /** Length of emergency reset. */
 #define LENGTH_EMERGENCY_RESET 10
@@ -251,6 +252,103 @@ typedef union __attribute__((__packed__))  {
     } /** Individual housekeeping fields */ fields;
 } supervisor_housekeeping_t;
 
+/**
+ * Supervisor ADC channels, in the order they appear in supervisor_housekeeping_t::adc_data
+ */
+typedef enum {
+    SUPERVISOR_ADC_TEMPERATURE = 0,     /**< Supervisor temperature [0.1 degrees C] */
+    SUPERVISOR_ADC_3V3_IN,              /**< 3.3 V input voltage */
+    SUPERVISOR_ADC_2V5_REF,             /**< 2.5 V reference voltage */
+    SUPERVISOR_ADC_RTC,                 /**< RTC supply voltage */
+    SUPERVISOR_ADC_3V3,                 /**< 3.3 V rail voltage */
+    SUPERVISOR_ADC_1V8,                 /**< 1.8 V rail voltage */
+    SUPERVISOR_ADC_1V0,                 /**< 1.0 V rail voltage */
+    SUPERVISOR_ADC_3V3_CURRENT,         /**< 3.3 V rail current */
+    SUPERVISOR_ADC_1V8_CURRENT,         /**< 1.8 V rail current */
+    SUPERVISOR_ADC_1V0_CURRENT          /**< 1.0 V rail current */
+} supervisor_adc_channel_t;
+
+/**
+ * Conversion from a raw ADC count to engineering units:
+ * `value = raw * multiplier / divisor + offset`
+ */
+typedef struct {
+    int32_t multiplier;     /**< Scale numerator */
+    int32_t divisor;        /**< Scale denominator. Must not be 0 */
+    int32_t offset;         /**< Added after scaling */
+} supervisor_adc_scale_t;
+
+/** Scale giving the voltage at the ADC input [mV] (10-bit ADC, 3.3 V reference) */
+#define SUPERVISOR_ADC_SCALE_MV { 3300, 1024, 0 }
+/** Scale for an LM60 temperature sensor (424 mV + 6.25 mV/degree) [0.1 degrees C] */
+#define SUPERVISOR_ADC_SCALE_LM60 { 5280, 1024, -678 }
+
+/**
+ * Housekeeping sampler configuration
+ */
+typedef struct {
+    /** Time between samples [milliseconds] */
+    uint32_t interval;
+    /** Conversion for each ADC channel */
+    supervisor_adc_scale_t scale[SUPERVISOR_NUMBER_OF_ADC_CHANNELS];
+    /** Smallest change in a decoded value which is flagged in supervisor_sample_t::adc_changed */
+    uint16_t deadband[SUPERVISOR_NUMBER_OF_ADC_CHANNELS];
+} supervisor_sampler_config_t;
+
+/**
+ * Default housekeeping sampler configuration
+ *
+ * The temperature is decoded in tenths of a degree. The other channels give the
+ * voltage at the ADC input [mV]. Set the board's divider and sense resistor
+ * ratios in their scales to get the rail voltages [mV] and currents [mA].
+ */
+#define SUPERVISOR_SAMPLER_DEFAULT_CONFIG                               \
+    {                                                                   \
+        .interval = 1000,                                               \
+        .scale = {                                                      \
+            SUPERVISOR_ADC_SCALE_LM60, SUPERVISOR_ADC_SCALE_MV,         \
+            SUPERVISOR_ADC_SCALE_MV, SUPERVISOR_ADC_SCALE_MV,           \
+            SUPERVISOR_ADC_SCALE_MV, SUPERVISOR_ADC_SCALE_MV,           \
+            SUPERVISOR_ADC_SCALE_MV, SUPERVISOR_ADC_SCALE_MV,           \
+            SUPERVISOR_ADC_SCALE_MV, SUPERVISOR_ADC_SCALE_MV            \
+        },                                                              \
+        .deadband = { 10, 20, 20, 20, 20, 20, 20, 20, 20, 20 }          \
+    }
+
+/**
+ * Latest housekeeping sample, returned by supervisor_sampler_read()
+ */
+typedef struct {
+    /** Number of successful samples, including this one */
+    uint32_t sequence;
+    /** Number of failed samples */
+    uint32_t errors;
+    /** Time the sample was taken (CLOCK_MONOTONIC) */
+    struct timespec timestamp;
+    /** Raw housekeeping, as returned by supervisor_get_housekeeping() */
+    supervisor_housekeeping_t housekeeping;
+    /** Decoded ADC channels, indexed by ::supervisor_adc_channel_t */
+    int32_t adc[SUPERVISOR_NUMBER_OF_ADC_CHANNELS];
+    /** Bitmask of ADC channels which have moved by more than their deadband since they were last flagged */
+    uint16_t adc_changed;
+    /** The enable status or iOBC reset count differ from the previous sample */
+    bool status_changed;
+} supervisor_sample_t;
+
+/**
+ * @brief Open a persistent session with the Supervisor Controller.
+ * The SPI device is opened and configured once, and then used by every supervisor_* call
+ * until supervisor_close() is called. Without a session, each call opens and closes the device itself.
+ *
+ * @return true if the device is open, otherwise false
+ */
+bool supervisor_open();
+
+/**
+ * @brief Close the session opened by supervisor_open().
+ */
+void supervisor_close();
+
 /**
  * @brief Performs a software reset of the microcontroller directly without shutting down its components.
  * As this command is considered unsafe for the hardware and the software of the IOBC-S, use supervisor_reset() instead.
@@ -290,4 +388,39 @@ bool supervisor_get_version(supervisor_version_t * version);
  */
 bool supervisor_get_housekeeping(supervisor_housekeeping_t * housekeeping);
 
+/**
+ * @brief Decode the ADC channels of a housekeeping reply to engineering units.
+ * The scales passed to supervisor_sampler_start() are used, or the defaults if the sampler has never been started.
+ *
+ * @param[in] housekeeping Housekeeping read back from the Supervisor Controller.
+ * @param[out] values Decoded values, indexed by ::supervisor_adc_channel_t. Must hold SUPERVISOR_NUMBER_OF_ADC_CHANNELS entries.
+ */
+void supervisor_decode_adc(const supervisor_housekeeping_t * housekeeping, int32_t * values);
+
+/**
+ * @brief Start sampling housekeeping in the background.
+ * A thread fetches and decodes the housekeeping every `config->interval` ms, using a session
+ * opened with supervisor_open(). The session is left open by supervisor_sampler_stop().
+ *
+ * @param[in] config Sampler configuration. May be NULL to use ::SUPERVISOR_SAMPLER_DEFAULT_CONFIG.
+ * @return true if the sampler was started, otherwise false
+ */
+bool supervisor_sampler_start(const supervisor_sampler_config_t * config);
+
+/**
+ * @brief Stop the background sampler, waiting for any sample in progress to finish.
+ *
+ * @return true if the sampler was stopped, otherwise false
+ */
+bool supervisor_sampler_stop();
+
+/**
+ * @brief Get the latest housekeeping sample.
+ * This never waits for the SPI bus or for the sampler thread, so it can be called as often as needed.
+ *
+ * @param[out] sample Latest sample.
+ * @return true if a sample was returned, or false if no sample has been taken yet
+ */
+bool supervisor_sampler_read(supervisor_sample_t * sample);
+
 /* @} */
\ No newline at end of file
@@ -0,0 +1,306 @@
+/*
+ * Copyright (C) 2018 Kubos Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <supervisor.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Decoding tables, precomputed from the configured scales so each channel is
+ * a multiply and a shift: value = (raw * gain) >> 16 + offset
+ */
+static int64_t sampler_gain[SUPERVISOR_NUMBER_OF_ADC_CHANNELS];
+static int32_t sampler_offset[SUPERVISOR_NUMBER_OF_ADC_CHANNELS];
+static pthread_once_t sampler_tables_once = PTHREAD_ONCE_INIT;
+
+static supervisor_sampler_config_t sampler_config = SUPERVISOR_SAMPLER_DEFAULT_CONFIG;
+static bool sampler_started = false;
+static bool sampler_stop = false;
+static pthread_t handle_sampler = { 0 };
+/* Protects the tables and the state above. Never held while talking to the supervisor */
+static pthread_mutex_t sampler_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sampler_cond;
+
+/*
+ * Latest sample, published with a sequence lock. The sequence is odd while
+ * the sampler thread is writing, and readers retry if it changed under them
+ */
+static atomic_uint sampler_seq;
+static supervisor_sample_t sampler_sample;
+
+static void build_tables(const supervisor_adc_scale_t * scale)
+{
+    for (int i = 0; i < SUPERVISOR_NUMBER_OF_ADC_CHANNELS; i++)
+    {
+        sampler_gain[i] = ((int64_t) scale[i].multiplier << 16) / scale[i].divisor;
+        sampler_offset[i] = scale[i].offset;
+    }
+}
+
+static void build_default_tables(void)
+{
+    supervisor_sampler_config_t config = SUPERVISOR_SAMPLER_DEFAULT_CONFIG;
+
+    build_tables(config.scale);
+}
+
+void supervisor_decode_adc(const supervisor_housekeeping_t * housekeeping, int32_t * values)
+{
+    pthread_once(&sampler_tables_once, build_default_tables);
+
+    pthread_mutex_lock(&sampler_mutex);
+
+    for (int i = 0; i < SUPERVISOR_NUMBER_OF_ADC_CHANNELS; i++)
+    {
+        int64_t scaled = (int64_t) housekeeping->fields.adc_data[i] * sampler_gain[i];
+
+        /* Round to nearest */
+        values[i] = (int32_t) ((scaled + (1 << 15)) >> 16) + sampler_offset[i];
+    }
+
+    pthread_mutex_unlock(&sampler_mutex);
+}
+
+static void publish(const supervisor_sample_t * sample)
+{
+    unsigned int seq = atomic_load_explicit(&sampler_seq, memory_order_relaxed);
+
+    atomic_store_explicit(&sampler_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    memcpy(&sampler_sample, sample, sizeof(sampler_sample));
+
+    atomic_store_explicit(&sampler_seq, seq + 2, memory_order_release);
+}
+
+bool supervisor_sampler_read(supervisor_sample_t * sample)
+{
+    unsigned int seq;
+
+    if (sample == NULL)
+    {
+        return false;
+    }
+
+    do
+    {
+        seq = atomic_load_explicit(&sampler_seq, memory_order_acquire);
+        if (seq & 1)
+        {
+            /* Mid-update. Let the sampler thread finish, since it may share our CPU */
+            sched_yield();
+            continue;
+        }
+
+        memcpy(sample, &sampler_sample, sizeof(*sample));
+        atomic_thread_fence(memory_order_acquire);
+    } while ((seq & 1) || seq != atomic_load_explicit(&sampler_seq, memory_order_relaxed));
+
+    return sample->sequence != 0;
+}
+
+static void * sampler_thread(void * args)
+{
+    supervisor_sample_t sample = { 0 };
+    supervisor_housekeeping_t housekeeping;
+    int32_t reference[SUPERVISOR_NUMBER_OF_ADC_CHANNELS];
+    struct timespec wake;
+    bool first = true;
+
+    /* Carry on from any previous run, so the sequence never goes backwards */
+    supervisor_sampler_read(&sample);
+
+    clock_gettime(CLOCK_MONOTONIC, &wake);
+
+    pthread_mutex_lock(&sampler_mutex);
+
+    while (!sampler_stop)
+    {
+        pthread_mutex_unlock(&sampler_mutex);
+
+        /* Sample, wait 10 ms and obtain. Other supervisor calls are held off meanwhile */
+        bool ok = supervisor_get_housekeeping(&housekeeping);
+
+        sample.adc_changed = 0;
+        sample.status_changed = false;
+
+        if (!ok)
+        {
+            sample.errors++;
+        }
+        else
+        {
+            clock_gettime(CLOCK_MONOTONIC, &sample.timestamp);
+
+            sample.status_changed = !first
+                && (housekeeping.fields.enable_status.raw_value
+                        != sample.housekeeping.fields.enable_status.raw_value
+                    || housekeeping.fields.iobc_reset_count
+                        != sample.housekeeping.fields.iobc_reset_count);
+
+            sample.housekeeping = housekeeping;
+            supervisor_decode_adc(&housekeeping, sample.adc);
+
+            /* Compare against the last flagged value, so slow drifts are still caught */
+            for (int i = 0; i < SUPERVISOR_NUMBER_OF_ADC_CHANNELS; i++)
+            {
+                if (first || abs(sample.adc[i] - reference[i]) > sampler_config.deadband[i])
+                {
+                    reference[i] = sample.adc[i];
+                    if (!first)
+                    {
+                        sample.adc_changed |= 1 << i;
+                    }
+                }
+            }
+
+            sample.sequence++;
+            first = false;
+        }
+
+        publish(&sample);
+
+        /* Absolute deadlines, so the SPI time doesn't stretch the interval */
+        wake.tv_sec += sampler_config.interval / 1000;
+        wake.tv_nsec += (sampler_config.interval % 1000) * 1000000;
+        if (wake.tv_nsec >= 1000000000)
+        {
+            wake.tv_sec++;
+            wake.tv_nsec -= 1000000000;
+        }
+
+        pthread_mutex_lock(&sampler_mutex);
+
+        /* Woken early by supervisor_sampler_stop */
+        while (!sampler_stop
+               && pthread_cond_timedwait(&sampler_cond, &sampler_mutex, &wake) != ETIMEDOUT)
+        {
+        }
+    }
+
+    pthread_mutex_unlock(&sampler_mutex);
+
+    return NULL;
+}
+
+bool supervisor_sampler_start(const supervisor_sampler_config_t * config)
+{
+    supervisor_sampler_config_t defaults = SUPERVISOR_SAMPLER_DEFAULT_CONFIG;
+    pthread_condattr_t attr;
+    int ret;
+
+    if (config == NULL)
+    {
+        config = &defaults;
+    }
+
+    if (config->interval == 0)
+    {
+        printf("Invalid supervisor sampler interval\n");
+        return false;
+    }
+
+    for (int i = 0; i < SUPERVISOR_NUMBER_OF_ADC_CHANNELS; i++)
+    {
+        if (config->scale[i].divisor == 0)
+        {
+            printf("Invalid scale for supervisor ADC channel %d\n", i);
+            return false;
+        }
+    }
+
+    if (!supervisor_open())
+    {
+        printf("Failed to open supervisor session\n");
+        return false;
+    }
+
+    pthread_once(&sampler_tables_once, build_default_tables);
+
+    pthread_mutex_lock(&sampler_mutex);
+
+    if (sampler_started)
+    {
+        printf("Supervisor sampler already started\n");
+        pthread_mutex_unlock(&sampler_mutex);
+        return false;
+    }
+
+    sampler_config = *config;
+    sampler_stop = false;
+    build_tables(sampler_config.scale);
+
+    /* Wait against the monotonic clock, so setting the date can't stall sampling */
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&sampler_cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    ret = pthread_create(&handle_sampler, NULL, sampler_thread, NULL);
+    if (ret != 0)
+    {
+        printf("Failed to create supervisor sampler thread: %s\n", strerror(ret));
+        pthread_cond_destroy(&sampler_cond);
+        pthread_mutex_unlock(&sampler_mutex);
+        return false;
+    }
+
+    sampler_started = true;
+
+    pthread_mutex_unlock(&sampler_mutex);
+
+    return true;
+}
+
+bool supervisor_sampler_stop()
+{
+    bool status = true;
+
+    pthread_mutex_lock(&sampler_mutex);
+
+    if (!sampler_started)
+    {
+        printf("Supervisor sampler has not been started\n");
+        pthread_mutex_unlock(&sampler_mutex);
+        return false;
+    }
+
+    sampler_stop = true;
+    pthread_cond_broadcast(&sampler_cond);
+
+    pthread_mutex_unlock(&sampler_mutex);
+
+    if (pthread_join(handle_sampler, NULL) != 0)
+    {
+        perror("Failed to rejoin supervisor sampler thread");
+        status = false;
+    }
+
+    pthread_mutex_lock(&sampler_mutex);
+
+    handle_sampler = 0;
+    sampler_started = false;
+    pthread_cond_destroy(&sampler_cond);
+
+    pthread_mutex_unlock(&sampler_mutex);
+
+    return status;
+}
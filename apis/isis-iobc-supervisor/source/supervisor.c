@@ -18,12 +18,21 @@
 #include <checksum.h>
 #include <fcntl.h>
 #include <linux/spi/spidev.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <string.h>
 #include <sys/ioctl.h>
 #include <unistd.h>
 
 #define SPI_DEV "/dev/spidev0.2"
+#define SPI_SPEED 1000000
+/*
+ * Inter-byte delay, as per discussion with ISIS on 3/31.
+ * They suggested at least 1 ms between bytes.
+ */
+#define SPI_BYTE_DELAY 1000
+/* Longest message exchanged with the Supervisor Controller */
+#define SPI_MAX_LENGTH LENGTH_TELEMETRY_HOUSEKEEPING
 
 /** Emergency Reset in hexadecimal. */
 #define CMD_SUPERVISOR_EMERGENCY_RESET 0x45
@@ -38,22 +47,20 @@
 /** Obtain Version and Configuration Command in hexadecimal. */
 #define CMD_SUPERVISOR_OBTAIN_VERSION_CONFIG 0x55
 
-static bool spi_comms(const uint8_t * tx_buffer, uint8_t * rx_buffer, uint16_t tx_length)
+/* SPI device opened by supervisor_open, or -1 if there's no session */
+static int supervisor_fd = -1;
+/* Serializes exchanges, including the sample/obtain pairs */
+static pthread_mutex_t supervisor_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static int spi_open(void)
 {
     int fd, ret;
-    static uint32_t speed = 1000000;
-
-    if ((tx_buffer == NULL) || (rx_buffer == NULL))
-    {
-        return false;
-    }
-
-    char checksum = supervisor_calculate_CRC(tx_buffer, tx_length - 1);
+    uint32_t speed = SPI_SPEED;
 
     fd = open(SPI_DEV, O_RDWR);
     if (fd < 0) {
         perror("Can't open device ");
-        return false;
+        return -1;
     }
 
     /*
@@ -62,55 +69,98 @@ static bool spi_comms(const uint8_t * tx_buffer, uint8_t * rx_buffer, uint16_t t
     ret = ioctl(fd, SPI_IOC_WR_MAX_SPEED_HZ, &speed);
     if (ret == -1) {
         perror("Can't set max speed hz");
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+/* The caller must hold supervisor_mutex */
+static bool spi_comms(const uint8_t * tx_buffer, uint8_t * rx_buffer, uint16_t tx_length)
+{
+    struct spi_ioc_transfer tr[SPI_MAX_LENGTH];
+    uint8_t tx[SPI_MAX_LENGTH];
+    int fd, ret;
+
+    if ((tx_buffer == NULL) || (rx_buffer == NULL)
+        || (tx_length < 1) || (tx_length > SPI_MAX_LENGTH))
+    {
         return false;
     }
 
-    /**
-     * Messages are sent across one byte per ioctl call
-     * This is to introduce inter-byte delays, as per
-     * discussion with ISIS on 3/31. They suggested
-     * at least 1 ms between bytes.
+    /* Send checksum last */
+    memcpy(tx, tx_buffer, tx_length - 1);
+    tx[tx_length - 1] = supervisor_calculate_CRC(tx_buffer, tx_length - 1);
+
+    /*
+     * Each byte is its own transfer, so the kernel can insert the inter-byte
+     * delay. The whole message goes in a single ioctl call, with chip select
+     * held throughout
      */
-    for (uint16_t i = 0; i < tx_length - 1; i++)
-    {
-        struct spi_ioc_transfer tr = {
-            .tx_buf = (unsigned long)&tx_buffer[i],
-            .rx_buf = (unsigned long)&rx_buffer[i],
-            .len = 1,
-            .delay_usecs = 0,
-            .cs_change = 1
-        };
-        ret = ioctl(fd, SPI_IOC_MESSAGE(1), &tr);
-        if (ret < 1)
+    memset(tr, 0, sizeof(tr));
+    for (uint16_t i = 0; i < tx_length; i++)
+    {
+        tr[i].tx_buf = (unsigned long)&tx[i];
+        tr[i].rx_buf = (unsigned long)&rx_buffer[i];
+        tr[i].len = 1;
+        tr[i].delay_usecs = (i < tx_length - 1) ? SPI_BYTE_DELAY : 0;
+    }
+    tr[tx_length - 1].cs_change = 1;
+
+    fd = supervisor_fd;
+    if (fd < 0)
+    {
+        fd = spi_open();
+        if (fd < 0)
         {
-            perror("Can't send spi message ");
             return false;
         }
-        usleep(1000);
     }
 
-    /**
-     * Send checksum last
-     */
-    struct spi_ioc_transfer tr = {
-        .tx_buf = (unsigned long)&checksum,
-        .rx_buf = (unsigned long)&rx_buffer[tx_length - 1],
-        .len = 1,
-        .delay_usecs = 0,
-        .cs_change = 1
-    };
-    ret = ioctl(fd, SPI_IOC_MESSAGE(1), &tr);
-    if (ret < 1)
+    ret = ioctl(fd, SPI_IOC_MESSAGE(tx_length), tr);
+
+    if (supervisor_fd < 0)
+    {
+        close(fd);
+    }
+
+    if (ret < tx_length)
     {
         perror("Can't send spi message ");
         return false;
     }
 
-    close(fd);
-
     return true;
 }
 
+bool supervisor_open()
+{
+    pthread_mutex_lock(&supervisor_mutex);
+
+    if (supervisor_fd < 0)
+    {
+        supervisor_fd = spi_open();
+    }
+
+    pthread_mutex_unlock(&supervisor_mutex);
+
+    return supervisor_fd >= 0;
+}
+
+void supervisor_close()
+{
+    pthread_mutex_lock(&supervisor_mutex);
+
+    if (supervisor_fd >= 0)
+    {
+        close(supervisor_fd);
+        supervisor_fd = -1;
+    }
+
+    pthread_mutex_unlock(&supervisor_mutex);
+}
+
 static bool verify_checksum(const uint8_t * buffer, int buffer_length)
 {
     uint8_t checksum = supervisor_calculate_CRC(buffer + 1, buffer_length - 2);
@@ -124,9 +174,12 @@ bool supervisor_get_version(supervisor_version_t * version)
     uint8_t bytesToSendObtainVersion[LENGTH_TELEMETRY_GET_VERSION] = { 0 };
     uint8_t bytesToReceiveObtainVersion[LENGTH_TELEMETRY_GET_VERSION] = { 0 };
 
+    pthread_mutex_lock(&supervisor_mutex);
+
     if (!spi_comms(bytesToSendSampleVersion, bytesToReceiveSampleVersion, LENGTH_TELEMETRY_SAMPLE_VERSION))
     {
         printf("Failed to sample version\n");
+        pthread_mutex_unlock(&supervisor_mutex);
         return false;
     }
 
@@ -135,17 +188,21 @@ bool supervisor_get_version(supervisor_version_t * version)
     if (!spi_comms(bytesToSendObtainVersion, bytesToReceiveObtainVersion, LENGTH_TELEMETRY_GET_VERSION))
     {
         printf("Failed to obtain version\n");
+        pthread_mutex_unlock(&supervisor_mutex);
         return false;
     }
 
     if (!verify_checksum(bytesToReceiveObtainVersion, LENGTH_TELEMETRY_GET_VERSION))
     {
         printf("Checksum failed\n");
+        pthread_mutex_unlock(&supervisor_mutex);
         return false;
     }
 
     memcpy(version, bytesToReceiveObtainVersion, LENGTH_TELEMETRY_GET_VERSION);
 
+    pthread_mutex_unlock(&supervisor_mutex);
+
     return true;
 }
 
@@ -156,9 +213,12 @@ bool supervisor_get_housekeeping(supervisor_housekeeping_t * housekeeping)
     uint8_t bytesToSendObtainHousekeepingTelemetry[LENGTH_TELEMETRY_HOUSEKEEPING] = { 0 };
     uint8_t bytesToReceiveObtainHousekeepingTelemetry[LENGTH_TELEMETRY_HOUSEKEEPING] = { 0 };
 
+    pthread_mutex_lock(&supervisor_mutex);
+
     if (!spi_comms(bytesToSendSampleHousekeepingTelemetry, bytesToReceiveSampleHousekeepingTelemetry, LENGTH_TELEMETRY_SAMPLE_HOUSEKEEPING))
     {
         printf("Failed to sample housekeeping\n");
+        pthread_mutex_unlock(&supervisor_mutex);
         return false;
     }
 
@@ -167,17 +227,21 @@ bool supervisor_get_housekeeping(supervisor_housekeeping_t * housekeeping)
     if (!spi_comms(bytesToSendObtainHousekeepingTelemetry, bytesToReceiveObtainHousekeepingTelemetry, LENGTH_TELEMETRY_HOUSEKEEPING))
     {
         printf("Failed to obtain housekeeping\n");
+        pthread_mutex_unlock(&supervisor_mutex);
         return false;
     }
 
     if (!verify_checksum(bytesToReceiveObtainHousekeepingTelemetry, LENGTH_TELEMETRY_HOUSEKEEPING))
     {
         printf("Checksum failed\n");
+        pthread_mutex_unlock(&supervisor_mutex);
         return false;
     }
 
     memcpy(housekeeping, bytesToReceiveObtainHousekeepingTelemetry, LENGTH_TELEMETRY_HOUSEKEEPING);
 
+    pthread_mutex_unlock(&supervisor_mutex);
+
     return true;
 }
 
@@ -185,8 +249,13 @@ bool supervisor_powercycle()
 {
     uint8_t bytesToSendPowerCycleIobc[LENGTH_POWER_CYCLE_IOBC] = { CMD_SUPERVISOR_POWER_CYCLE_IOBC, 0x00, 0x00 };
     uint8_t bytesToReceivePowerCycleIobc[LENGTH_POWER_CYCLE_IOBC] = { 0 };
+    bool ret;
 
-    if (!spi_comms(bytesToSendPowerCycleIobc, bytesToReceivePowerCycleIobc, LENGTH_POWER_CYCLE_IOBC))
+    pthread_mutex_lock(&supervisor_mutex);
+    ret = spi_comms(bytesToSendPowerCycleIobc, bytesToReceivePowerCycleIobc, LENGTH_POWER_CYCLE_IOBC);
+    pthread_mutex_unlock(&supervisor_mutex);
+
+    if (!ret)
     {
         printf("Failed to send power cycle\n");
         return false;
@@ -198,8 +267,13 @@ bool supervisor_reset()
 {
     uint8_t bytesToSendReset[LENGTH_RESET] = { CMD_SUPERVISOR_RESET, 0x00, 0x00 };
     uint8_t bytesToReceiveReset[LENGTH_RESET] = { 0 };
+    bool ret;
+
+    pthread_mutex_lock(&supervisor_mutex);
+    ret = spi_comms(bytesToSendReset, bytesToReceiveReset, LENGTH_RESET);
+    pthread_mutex_unlock(&supervisor_mutex);
 
-    if (!spi_comms(bytesToSendReset, bytesToReceiveReset, LENGTH_RESET))
+    if (!ret)
     {
         printf("Failed to send reset\n");
         return false;
@@ -211,8 +285,13 @@ bool supervisor_emergency_reset()
 {
     uint8_t bytesToSendEmergencyReset[LENGTH_EMERGENCY_RESET] = { CMD_SUPERVISOR_EMERGENCY_RESET, 'M', 'E', 'R', 'G', 'E', 'N', 'C', 'Y', 0x00 };
     uint8_t bytesToReceiveEmergencyReset[LENGTH_EMERGENCY_RESET] = { 0 };
+    bool ret;
+
+    pthread_mutex_lock(&supervisor_mutex);
+    ret = spi_comms(bytesToSendEmergencyReset, bytesToReceiveEmergencyReset, LENGTH_EMERGENCY_RESET);
+    pthread_mutex_unlock(&supervisor_mutex);
 
-    if (!spi_comms(bytesToSendEmergencyReset, bytesToReceiveEmergencyReset, LENGTH_EMERGENCY_RESET))
+    if (!ret)
     {
         printf("Failed to send emergency reset\n");
         return false;
@@ -225,12 +225,14 @@ typedef struct
 KRadioStatus k_radio_watchdog_kick(void);
 
 /**
- * Start a thread to kick the radio's watchdogs at an interval of (timeout/3) seconds
+ * Start kicking the radio's watchdogs at an interval of (timeout/3) seconds
+ *
+ * The kicks are made by the shared watchdog scheduler (see ::k_watchdog_register)
  * @return KRadioStatus `RADIO_OK` if OK, error otherwise
  */
 KRadioStatus k_radio_watchdog_start(void);
 /**
- * Stop the watchdog thread
+ * Stop kicking the radio's watchdogs
  * @return KRadioStatus `RADIO_OK` if OK, error otherwise
  */
 KRadioStatus k_radio_watchdog_stop(void);
@@ -364,9 +366,11 @@ KRadioStatus k_radio_get_telemetry(radio_telem * buffer, RadioTelemType type);
  */
 
 /**
- * Thread which kicks the radio's watchdogs every (timeout/3) seconds
+ * Watchdog scheduler callback which kicks the radio's watchdogs
+ * @param [in] arg Unused
+ * @return int 0 if OK, non-zero otherwise
  */
-void * kprv_radio_watchdog_thread(void * args);
+int kprv_radio_watchdog_kick(void * arg);
 
 /**
  * Set the transmitter beacon's interval and message
@@ -16,6 +16,7 @@
 
 #include <i2c.h>
 #include <trxvu.h>
+#include <watchdog.h>
 #include <stdio.h>
 #include <unistd.h>
 
@@ -105,28 +106,19 @@ KRadioStatus k_radio_watchdog_kick()
     return status;
 }
 
-void * kprv_radio_watchdog_thread(void * args)
+int kprv_radio_watchdog_kick(void * arg)
 {
-    KRadioStatus status;
-
-    while (1)
-    {
-        kprv_radio_tx_watchdog_kick();
-        kprv_radio_rx_watchdog_kick();
-
-        sleep(wd_timeout / 3);
-    }
-
-    return NULL;
+    return k_radio_watchdog_kick();
 }
 
-pthread_t handle_watchdog = { 0 };
+/* Watchdog scheduler ID, or -1 if not started */
+static int radio_watchdog = -1;
 
 KRadioStatus k_radio_watchdog_start()
 {
-    if (handle_watchdog != 0)
+    if (radio_watchdog >= 0)
     {
-        fprintf(stderr, "TRXVU watchdog thread already started\n");
+        fprintf(stderr, "TRXVU watchdog already started\n");
         return RADIO_OK;
     }
 
@@ -134,15 +126,18 @@ KRadioStatus k_radio_watchdog_start()
     {
         fprintf(
             stderr,
-            "TRXVU watchdog has been disabled. No thread will be started\n");
+            "TRXVU watchdog has been disabled. No kicks will be scheduled\n");
         return RADIO_OK;
     }
 
-    if (pthread_create(&handle_watchdog, NULL, kprv_radio_watchdog_thread, NULL)
-        != 0)
+    uint32_t period = (uint32_t) wd_timeout * 1000 / 3;
+
+    if (k_watchdog_register("TRXVU", period, period / 4,
+                            kprv_radio_watchdog_kick, NULL, &radio_watchdog)
+        != WATCHDOG_OK)
     {
-        perror("Failed to create TRXVU watchdog thread");
-        handle_watchdog = 0;
+        fprintf(stderr, "Failed to start TRXVU watchdog\n");
+        radio_watchdog = -1;
         return RADIO_ERROR;
     }
 
@@ -151,27 +146,20 @@ KRadioStatus k_radio_watchdog_start()
 
 KRadioStatus k_radio_watchdog_stop()
 {
-    if (handle_watchdog == 0)
-    {
-        perror("TRXVU watchdog thread has not been started");
-        return RADIO_ERROR;
-    }
-    
-    /* Send the cancel request */
-    if (pthread_cancel(handle_watchdog) != 0)
+    if (radio_watchdog < 0)
     {
-        perror("Failed to cancel TRXVU watchdog thread");
+        fprintf(stderr, "TRXVU watchdog has not been started\n");
         return RADIO_ERROR;
     }
 
-    /* Wait for the cancellation to complete */
-    if (pthread_join(handle_watchdog, NULL) != 0)
+    /* No more kicks will be made once this returns */
+    if (k_watchdog_unregister(radio_watchdog) != WATCHDOG_OK)
     {
-        perror("Failed to rejoin TRXVU watchdog thread");
+        fprintf(stderr, "Failed to stop TRXVU watchdog\n");
         return RADIO_ERROR;
     }
 
-    handle_watchdog = 0;
+    radio_watchdog = -1;
 
     return RADIO_OK;
 }
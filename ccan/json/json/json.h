@@ -37,6 +37,8 @@ typedef enum {
 } JsonTag;
 
 typedef struct JsonNode JsonNode;
+typedef struct JsonArena JsonArena;
+typedef struct JsonIndex JsonIndex;
 
 struct JsonNode
 {
@@ -47,6 +49,9 @@ struct JsonNode
 	/* only if parent is an object (NULL otherwise) */
 	char *key; /* Must be valid UTF-8. */
 	
+	/* Arena the node, its key and its string were allocated from (NULL if malloc'd) */
+	JsonArena *arena;
+	
 	JsonTag tag;
 	union {
 		/* JSON_BOOL */
@@ -62,6 +67,14 @@ struct JsonNode
 		/* JSON_OBJECT */
 		struct {
 			JsonNode *head, *tail;
+			
+			/*
+			 * Built by json_find_element and json_find_member once a
+			 * lookup has to walk past a few children (NULL until then).
+			 * Kept up to date by the functions below, so children must
+			 * not be linked or unlinked by hand once it exists.
+			 */
+			JsonIndex *index;
 		} children;
 	};
 };
@@ -78,6 +91,12 @@ bool        json_validate       (const char *json);
 
 /*** Lookup and traversal ***/
 
+/*
+ * Lookups in objects and arrays with more than a few children build an index
+ * on the node (see JsonNode.children.index), so later lookups take constant
+ * time rather than walking the children.
+ */
+
 JsonNode   *json_find_element   (JsonNode *array, int index);
 JsonNode   *json_find_member    (JsonNode *object, const char *key);
 
@@ -104,6 +123,29 @@ void json_prepend_member(JsonNode *object, const char *key, JsonNode *value);
 
 void json_remove_from_parent(JsonNode *node);
 
+/*** Arena allocation ***/
+
+/*
+ * Nodes made with the _arena functions, along with their keys and strings,
+ * are bump-allocated from chunks of @chunk_size bytes (0 for the default).
+ * Nothing is freed until json_arena_destroy, which frees the whole arena at
+ * once rather than walking the tree.  json_delete only unlinks arena nodes.
+ *
+ * Arena nodes may only be linked to nodes from the same arena.  Passing a
+ * NULL arena gives ordinary malloc'd nodes, as from the functions above.
+ */
+JsonArena *json_arena_create    (size_t chunk_size);
+void       json_arena_destroy   (JsonArena *arena);
+
+JsonNode   *json_decode_arena   (JsonArena *arena, const char *json);
+
+JsonNode *json_mknull_arena(JsonArena *arena);
+JsonNode *json_mkbool_arena(JsonArena *arena, bool b);
+JsonNode *json_mkstring_arena(JsonArena *arena, const char *s);
+JsonNode *json_mknumber_arena(JsonArena *arena, double n);
+JsonNode *json_mkarray_arena(JsonArena *arena);
+JsonNode *json_mkobject_arena(JsonArena *arena);
+
 /*** Debugging ***/
 
 /*
@@ -0,0 +1,197 @@
+/* Decode and build trees in an arena, and check they match the malloc'd equivalents. */
+
+#include "common.h"
+
+static bool trees_equal(const JsonNode *a, const JsonNode *b)
+{
+	const JsonNode *ca, *cb;
+
+	if (a->tag != b->tag)
+		return false;
+	if ((a->key == NULL) != (b->key == NULL))
+		return false;
+	if (a->key != NULL && strcmp(a->key, b->key) != 0)
+		return false;
+
+	switch (a->tag) {
+		case JSON_BOOL:
+			return a->bool_ == b->bool_;
+		case JSON_STRING:
+			return strcmp(a->string_, b->string_) == 0;
+		case JSON_NUMBER:
+			return a->number_ == b->number_;
+		case JSON_ARRAY:
+		case JSON_OBJECT:
+			for (ca = a->children.head, cb = b->children.head;
+				 ca != NULL && cb != NULL;
+				 ca = ca->next, cb = cb->next)
+				if (!trees_equal(ca, cb))
+					return false;
+			return ca == NULL && cb == NULL;
+		default:
+			return true;
+	}
+}
+
+static bool all_in_arena(const JsonNode *node, const JsonArena *arena)
+{
+	const JsonNode *child;
+
+	if (node->arena != arena)
+		return false;
+	json_foreach(child, (JsonNode*) node)
+		if (!all_in_arena(child, arena))
+			return false;
+	return true;
+}
+
+/* Every line of test-strings, with chunks small enough that most values span several. */
+static void test_decode(void)
+{
+	const char *strings_file = "test/test-strings";
+	JsonArena *arena = json_arena_create(64);
+	char buffer[1024];
+	FILE *f;
+
+	f = fopen(strings_file, "rb");
+	if (f == NULL) {
+		diag("Could not open %s: %s", strings_file, strerror(errno));
+		exit(1);
+	}
+
+	while (fgets(buffer, sizeof(buffer), f)) {
+		const char *s = chomp(buffer);
+		JsonNode *heap, *node;
+		char errmsg[256];
+		bool valid;
+
+		if (expect_literal(&s, "valid ")) {
+			valid = true;
+		} else if (expect_literal(&s, "invalid ")) {
+			valid = false;
+		} else {
+			fail("Invalid line in test-strings: %s", buffer);
+			continue;
+		}
+
+		heap = json_decode(s);
+		node = json_decode_arena(arena, s);
+
+		if (!valid) {
+			ok(node == NULL, "%s is rejected", s);
+			continue;
+		}
+
+		if (node == NULL || heap == NULL) {
+			fail("%s is valid, but json_decode_arena returned NULL", s);
+			json_delete(heap);
+			continue;
+		}
+
+		if (!json_check(node, errmsg)) {
+			fail("Corrupt tree produced by json_decode_arena: %s", errmsg);
+			json_delete(heap);
+			continue;
+		}
+
+		ok(trees_equal(node, heap) && all_in_arena(node, arena), "decode %s", s);
+
+		json_delete(heap);
+	}
+
+	fclose(f);
+	json_arena_destroy(arena);
+}
+
+static void test_strings(void)
+{
+	JsonArena *arena = json_arena_create(64);
+	char long_string[300];
+	char long_json[sizeof(long_string) + 2];
+	JsonNode *node;
+
+	node = json_decode_arena(arena, "\"tab\\there \\u00e9 \\ud834\\udd1e \\\"\\\\\"");
+	ok1(node != NULL && strcmp(node->string_, "tab\there \xC3\xA9 \xF0\x9D\x84\x9E \"\\") == 0);
+
+	/* Larger than a chunk, so it gets one of its own */
+	memset(long_string, 'x', sizeof(long_string) - 1);
+	long_string[sizeof(long_string) - 1] = 0;
+	snprintf(long_json, sizeof(long_json), "\"%s\"", long_string);
+
+	node = json_decode_arena(arena, long_json);
+	ok1(node != NULL && strcmp(node->string_, long_string) == 0);
+
+	node = json_mkstring_arena(arena, long_string);
+	ok1(node->arena == arena && strcmp(node->string_, long_string) == 0);
+
+	/* A failed decode leaves the arena usable */
+	ok1(json_decode_arena(arena, "[\"unterminated") == NULL);
+	node = json_decode_arena(arena, "[\"after\"]");
+	ok1(node != NULL && strcmp(node->children.head->string_, "after") == 0);
+
+	json_arena_destroy(arena);
+}
+
+static void test_construction(void)
+{
+	JsonArena *arena = json_arena_create(0);
+	JsonNode *object, *array, *child;
+	char key[] = "first";
+	char errmsg[256];
+
+	object = json_mkobject_arena(arena);
+	array = json_mkarray_arena(arena);
+
+	json_append_element(array, json_mknumber_arena(arena, 1));
+	json_append_element(array, json_mkbool_arena(arena, true));
+	json_prepend_element(array, json_mknull_arena(arena));
+
+	json_append_member(object, key, json_mkstring_arena(arena, "one"));
+	json_append_member(object, "array", array);
+	json_prepend_member(object, "zeroth", json_mknumber_arena(arena, 0));
+
+	/* Keys are copied into the arena */
+	key[0] = 'F';
+	ok1(json_find_member(object, "first") != NULL);
+	ok1(strcmp(object->children.head->key, "zeroth") == 0);
+
+	ok1(json_check(object, errmsg));
+	ok1(all_in_arena(object, arena));
+
+	ok1(json_find_element(array, 0)->tag == JSON_NULL);
+	ok1(json_find_element(array, 1)->number_ == 1);
+	ok1(json_find_element(array, 2)->bool_ == true);
+
+	/* json_delete just unlinks arena nodes */
+	child = json_find_member(object, "first");
+	json_delete(child);
+	ok1(json_find_member(object, "first") == NULL);
+	ok1(child->parent == NULL && child->key == NULL);
+
+	json_remove_from_parent(array);
+	ok1(json_find_member(object, "array") == NULL);
+	json_append_member(object, "array", array);
+	ok1(json_find_member(object, "array") == array);
+
+	ok1(json_check(object, errmsg));
+
+	json_arena_destroy(arena);
+
+	/* A NULL arena gives malloc'd nodes */
+	child = json_mknumber_arena(NULL, 5);
+	ok1(child->arena == NULL);
+	json_delete(child);
+
+	json_arena_destroy(NULL);
+}
+
+int main(void)
+{
+	plan_tests(224 + 5 + 13);
+
+	test_decode();
+	test_strings();
+	test_construction();
+
+	return exit_status();
+}
@@ -0,0 +1,197 @@
+/* Check that lookups through the member and element indexes agree with walking the children, while the children are changed underneath them. */
+
+#include "common.h"
+
+#define OPS 2000
+
+static JsonNode *walk_member(JsonNode *object, const char *key)
+{
+	JsonNode *member;
+
+	json_foreach(member, object)
+		if (strcmp(member->key, key) == 0)
+			return member;
+	return NULL;
+}
+
+static JsonNode *walk_element(JsonNode *array, int index)
+{
+	JsonNode *element;
+
+	json_foreach(element, array)
+		if (index-- == 0)
+			return element;
+	return NULL;
+}
+
+static int count_children(JsonNode *node)
+{
+	JsonNode *child;
+	int count = 0;
+
+	json_foreach(child, node)
+		count++;
+	return count;
+}
+
+/* Random appends, prepends and removals, with a small key space so there are plenty of duplicates. */
+static bool exercise_object(JsonArena *arena)
+{
+	JsonNode *object = json_mkobject_arena(arena);
+	char key[16], errmsg[256];
+	int i, k;
+
+	for (i = 0; i < 120; i++) {
+		snprintf(key, sizeof(key), "key%d", i);
+		json_append_member(object, key, json_mknumber_arena(arena, i));
+	}
+
+	/* Builds the index */
+	if (json_find_member(object, "key100") != walk_member(object, "key100"))
+		return false;
+	if (object->children.index == NULL)
+		return false;
+
+	for (i = 0; i < OPS; i++) {
+		int op = rand() % 4;
+
+		snprintf(key, sizeof(key), "key%d", rand() % 150);
+
+		if (op == 0) {
+			json_append_member(object, key, json_mknumber_arena(arena, i));
+		} else if (op == 1) {
+			json_prepend_member(object, key, json_mknumber_arena(arena, i));
+		} else if (count_children(object) > 0) {
+			int n = rand() % count_children(object);
+			json_delete(walk_element(object, n));
+		}
+
+		if (!json_check(object, errmsg)) {
+			diag("%s", errmsg);
+			return false;
+		}
+
+		for (k = 0; k < 150; k += 7) {
+			snprintf(key, sizeof(key), "key%d", k);
+			if (json_find_member(object, key) != walk_member(object, key))
+				return false;
+		}
+	}
+
+	if (arena == NULL)
+		json_delete(object);
+	return true;
+}
+
+static bool exercise_array(JsonArena *arena)
+{
+	JsonNode *array = json_mkarray_arena(arena);
+	char errmsg[256];
+	int i, k, count;
+
+	for (i = 0; i < 100; i++)
+		json_append_element(array, json_mknumber_arena(arena, i));
+
+	if (json_find_element(array, 50) != walk_element(array, 50))
+		return false;
+	if (array->children.index == NULL)
+		return false;
+
+	for (i = 0; i < OPS; i++) {
+		int op = rand() % 4;
+
+		count = count_children(array);
+		if (op == 0)
+			json_append_element(array, json_mknumber_arena(arena, i));
+		else if (op == 1)
+			json_prepend_element(array, json_mknumber_arena(arena, i));
+		else if (count > 0)
+			json_delete(walk_element(array, rand() % count));
+
+		if (!json_check(array, errmsg)) {
+			diag("%s", errmsg);
+			return false;
+		}
+
+		count = count_children(array);
+		for (k = -1; k <= count; k += 5)
+			if (json_find_element(array, k) != walk_element(array, k))
+				return false;
+		if (json_find_element(array, count) != NULL)
+			return false;
+	}
+
+	if (arena == NULL)
+		json_delete(array);
+	return true;
+}
+
+static void test_small(void)
+{
+	JsonNode *object = json_mkobject();
+	JsonNode *array = json_mkarray();
+
+	json_append_member(object, "a", json_mknull());
+	json_append_element(array, json_mknull());
+
+	/* Short lists are still walked */
+	ok1(json_find_member(object, "a") != NULL);
+	ok1(json_find_member(object, "b") == NULL);
+	ok1(json_find_element(array, 0) != NULL);
+	ok1(json_find_element(array, 1) == NULL);
+	ok1(object->children.index == NULL && array->children.index == NULL);
+
+	json_delete(object);
+	json_delete(array);
+}
+
+static void test_decoded(void)
+{
+	JsonNode *node;
+	char json[4096];
+	char key[16];
+	size_t len = 0;
+	int i;
+
+	len += snprintf(json + len, sizeof(json) - len, "{");
+	for (i = 0; i < 200; i++)
+		len += snprintf(json + len, sizeof(json) - len, "%s\"m%d\":%d", i ? "," : "", i, i);
+	snprintf(json + len, sizeof(json) - len, "}");
+
+	node = json_decode(json);
+	ok1(node != NULL);
+
+	for (i = 0; i < 200; i++) {
+		snprintf(key, sizeof(key), "m%d", i);
+		if (json_find_member(node, key) == NULL || json_find_member(node, key)->number_ != i)
+			break;
+	}
+	ok(i == 200, "all 200 decoded members found");
+	ok1(json_find_member(node, "m200") == NULL);
+
+	json_delete(node);
+}
+
+int main(void)
+{
+	JsonArena *arena;
+
+	(void) chomp;
+
+	plan_tests(5 + 3 + 4);
+
+	srand(1);
+
+	test_small();
+	test_decoded();
+
+	ok(exercise_object(NULL), "object index matches walking the members");
+	ok(exercise_array(NULL), "array index matches walking the elements");
+
+	arena = json_arena_create(0);
+	ok(exercise_object(arena), "arena object index matches walking the members");
+	ok(exercise_array(arena), "arena array index matches walking the elements");
+	json_arena_destroy(arena);
+
+	return exit_status();
+}
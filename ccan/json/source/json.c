@@ -44,6 +44,404 @@ static char *json_strdup(const char *str)
 	return ret;
 }
 
+/* Arena allocation */
+
+#define ARENA_DEFAULT_CHUNK 4096
+
+/* Allocations are aligned for any member of a JsonNode */
+typedef union
+{
+	void *p;
+	double d;
+	long long ll;
+} arena_align_t;
+
+#define ARENA_ALIGN sizeof(arena_align_t)
+#define arena_round(size) (((size) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1))
+
+typedef struct ArenaChunk ArenaChunk;
+
+struct ArenaChunk
+{
+	ArenaChunk *next;
+};
+
+#define ARENA_HEADER arena_round(sizeof(ArenaChunk))
+
+struct JsonArena
+{
+	/* Most recently started chunk first */
+	ArenaChunk *chunks;
+	
+	/* Free space in the head chunk */
+	char *cur;
+	char *end;
+	
+	size_t chunk_size;
+};
+
+JsonArena *json_arena_create(size_t chunk_size)
+{
+	JsonArena *arena = (JsonArena*) calloc(1, sizeof(JsonArena));
+	if (arena == NULL)
+		out_of_memory();
+	arena->chunk_size = chunk_size != 0 ? arena_round(chunk_size) : ARENA_DEFAULT_CHUNK;
+	return arena;
+}
+
+void json_arena_destroy(JsonArena *arena)
+{
+	ArenaChunk *chunk, *next;
+	
+	if (arena == NULL)
+		return;
+	
+	for (chunk = arena->chunks; chunk != NULL; chunk = next) {
+		next = chunk->next;
+		free(chunk);
+	}
+	free(arena);
+}
+
+static void *arena_alloc(JsonArena *arena, size_t size)
+{
+	ArenaChunk *chunk;
+	char *ret;
+	
+	size = arena_round(size);
+	
+	if ((size_t)(arena->end - arena->cur) < size) {
+		if (size > arena->chunk_size / 4) {
+			/*
+			 * Large allocations get a chunk to themselves, behind the head
+			 * chunk, so the space left in the head chunk isn't wasted.
+			 */
+			chunk = (ArenaChunk*) malloc(ARENA_HEADER + size);
+			if (chunk == NULL)
+				out_of_memory();
+			if (arena->chunks != NULL) {
+				chunk->next = arena->chunks->next;
+				arena->chunks->next = chunk;
+			} else {
+				chunk->next = NULL;
+				arena->chunks = chunk;
+			}
+			return (char*) chunk + ARENA_HEADER;
+		}
+		
+		chunk = (ArenaChunk*) malloc(ARENA_HEADER + arena->chunk_size);
+		if (chunk == NULL)
+			out_of_memory();
+		chunk->next = arena->chunks;
+		arena->chunks = chunk;
+		arena->cur = (char*) chunk + ARENA_HEADER;
+		arena->end = arena->cur + arena->chunk_size;
+	}
+	
+	ret = arena->cur;
+	arena->cur += size;
+	return ret;
+}
+
+/* Shrink the most recent allocation from @size to @used bytes, if it's at the top of the head chunk. */
+static void arena_trim(JsonArena *arena, char *start, size_t size, size_t used)
+{
+	if (start + arena_round(size) == arena->cur)
+		arena->cur = start + arena_round(used);
+}
+
+/* Copy a string into @arena, or onto the heap if @arena is NULL. */
+static char *arena_strdup(JsonArena *arena, const char *str)
+{
+	size_t len;
+	char *ret;
+	
+	if (arena == NULL)
+		return json_strdup(str);
+	
+	len = strlen(str) + 1;
+	ret = (char*) arena_alloc(arena, len);
+	memcpy(ret, str, len);
+	return ret;
+}
+
+/* Lookup indexes */
+
+/* Lookups which get this far down a list build an index. */
+#define INDEX_MIN_CHILDREN 8
+#define INDEX_MIN_CAPACITY 16
+
+typedef struct
+{
+	uint32_t hash;
+	JsonNode *node; /* NULL if the slot is empty */
+} IndexSlot;
+
+struct JsonIndex
+{
+	/* Objects: open-addressed hash table of keys, with linear probing */
+	IndexSlot *members;
+	/* Number of members not in the table, because an earlier member has the same key */
+	size_t duplicates;
+	
+	/* Arrays: element pointers, in order */
+	JsonNode **elements;
+	
+	/* Occupied slots or elements */
+	size_t count;
+	size_t capacity;
+};
+
+/* Index memory comes from the same place as the node. */
+static void *index_alloc(JsonNode *node, size_t size)
+{
+	void *ret;
+	
+	if (node->arena != NULL)
+		return arena_alloc(node->arena, size);
+	
+	ret = malloc(size);
+	if (ret == NULL)
+		out_of_memory();
+	return ret;
+}
+
+static void index_release(JsonNode *node, void *ptr)
+{
+	if (node->arena == NULL)
+		free(ptr);
+}
+
+static void index_free(JsonNode *node)
+{
+	JsonIndex *index = node->children.index;
+	
+	if (index != NULL) {
+		index_release(node, index->members);
+		index_release(node, index->elements);
+		index_release(node, index);
+		node->children.index = NULL;
+	}
+}
+
+static JsonIndex *index_new(JsonNode *node)
+{
+	JsonIndex *index = (JsonIndex*) index_alloc(node, sizeof(JsonIndex));
+	memset(index, 0, sizeof(JsonIndex));
+	node->children.index = index;
+	return index;
+}
+
+/* FNV-1a */
+static uint32_t hash_key(const char *key)
+{
+	uint32_t hash = 2166136261u;
+	
+	while (*key != 0) {
+		hash ^= (unsigned char) *key++;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+/* Find the slot holding @key, or the empty slot where it would go. */
+static IndexSlot *member_slot(JsonIndex *index, const char *key, uint32_t hash)
+{
+	size_t mask = index->capacity - 1;
+	size_t i = hash & mask;
+	
+	for (;;) {
+		IndexSlot *slot = &index->members[i];
+		if (slot->node == NULL || (slot->hash == hash && strcmp(slot->node->key, key) == 0))
+			return slot;
+		i = (i + 1) & mask;
+	}
+}
+
+static void members_resize(JsonNode *object, size_t capacity)
+{
+	JsonIndex *index = object->children.index;
+	IndexSlot *old = index->members;
+	size_t old_capacity = index->capacity;
+	size_t i;
+	
+	index->members = (IndexSlot*) index_alloc(object, capacity * sizeof(IndexSlot));
+	memset(index->members, 0, capacity * sizeof(IndexSlot));
+	index->capacity = capacity;
+	
+	for (i = 0; i < old_capacity; i++)
+		if (old[i].node != NULL)
+			*member_slot(index, old[i].node->key, old[i].hash) = old[i];
+	
+	index_release(object, old);
+}
+
+/*
+ * Index @member, which has just been linked into @object.  Only the first
+ * member with a given key is in the table, which is the one json_find_member
+ * returns, so a prepended member replaces any it now precedes.
+ */
+static void index_add_member(JsonNode *object, JsonNode *member, bool prepended)
+{
+	JsonIndex *index = object->children.index;
+	IndexSlot *slot;
+	uint32_t hash;
+	
+	if (index == NULL)
+		return;
+	
+	if ((index->count + 1) * 2 > index->capacity)
+		members_resize(object, index->capacity * 2);
+	
+	hash = hash_key(member->key);
+	slot = member_slot(index, member->key, hash);
+	
+	if (slot->node == NULL) {
+		slot->hash = hash;
+		slot->node = member;
+		index->count++;
+	} else {
+		if (prepended)
+			slot->node = member;
+		index->duplicates++;
+	}
+}
+
+/* Unindex @member, which is about to be unlinked from @object. */
+static void index_remove_member(JsonNode *object, JsonNode *member)
+{
+	JsonIndex *index = object->children.index;
+	IndexSlot *slot;
+	JsonNode *other;
+	size_t mask, hole, i;
+	
+	if (index == NULL)
+		return;
+	
+	slot = member_slot(index, member->key, hash_key(member->key));
+	
+	if (slot->node != member) {
+		/* An earlier member has the same key, so this one wasn't in the table. */
+		index->duplicates--;
+		return;
+	}
+	
+	if (index->duplicates > 0) {
+		for (other = member->next; other != NULL; other = other->next) {
+			if (strcmp(other->key, member->key) == 0) {
+				slot->node = other;
+				index->duplicates--;
+				return;
+			}
+		}
+	}
+	
+	/*
+	 * Empty the slot, then move back any later entries in the same probe
+	 * run which would no longer be reachable across the gap.
+	 */
+	mask = index->capacity - 1;
+	hole = (size_t)(slot - index->members);
+	for (i = (hole + 1) & mask; index->members[i].node != NULL; i = (i + 1) & mask) {
+		size_t home = index->members[i].hash & mask;
+		
+		/* Leave the entry alone if its home is cyclically within (hole, i]. */
+		if (hole <= i ? (home > hole && home <= i) : (home > hole || home <= i))
+			continue;
+		
+		index->members[hole] = index->members[i];
+		hole = i;
+	}
+	index->members[hole].node = NULL;
+	index->count--;
+}
+
+static void build_member_index(JsonNode *object)
+{
+	JsonIndex *index = index_new(object);
+	JsonNode *member;
+	size_t count = 0;
+	
+	json_foreach(member, object)
+		count++;
+	
+	index->capacity = INDEX_MIN_CAPACITY;
+	while (index->capacity < count * 2)
+		index->capacity *= 2;
+	index->members = (IndexSlot*) index_alloc(object, index->capacity * sizeof(IndexSlot));
+	memset(index->members, 0, index->capacity * sizeof(IndexSlot));
+	
+	json_foreach(member, object)
+		index_add_member(object, member, false);
+}
+
+/* Index @element, which has just been linked into @array. */
+static void index_add_element(JsonNode *array, JsonNode *element, bool prepended)
+{
+	JsonIndex *index = array->children.index;
+	
+	if (index == NULL)
+		return;
+	
+	if (index->count == index->capacity) {
+		JsonNode **old = index->elements;
+		
+		index->capacity *= 2;
+		index->elements = (JsonNode**) index_alloc(array, index->capacity * sizeof(JsonNode*));
+		memcpy(index->elements, old, index->count * sizeof(JsonNode*));
+		index_release(array, old);
+	}
+	
+	if (prepended) {
+		memmove(index->elements + 1, index->elements, index->count * sizeof(JsonNode*));
+		index->elements[0] = element;
+	} else {
+		index->elements[index->count] = element;
+	}
+	index->count++;
+}
+
+/* Unindex @element, which is about to be unlinked from @array. */
+static void index_remove_element(JsonNode *array, JsonNode *element)
+{
+	JsonIndex *index = array->children.index;
+	size_t i;
+	
+	if (index == NULL)
+		return;
+	
+	/* Elements are usually removed from one end or the other. */
+	if (element->next == NULL) {
+		index->count--;
+		return;
+	}
+	
+	for (i = 0; i < index->count; i++) {
+		if (index->elements[i] == element) {
+			memmove(index->elements + i, index->elements + i + 1,
+			        (index->count - i - 1) * sizeof(JsonNode*));
+			index->count--;
+			return;
+		}
+	}
+}
+
+static void build_element_index(JsonNode *array)
+{
+	JsonIndex *index = index_new(array);
+	JsonNode *element;
+	size_t count = 0;
+	
+	json_foreach(element, array)
+		count++;
+	
+	index->capacity = count > INDEX_MIN_CAPACITY ? count : INDEX_MIN_CAPACITY;
+	index->elements = (JsonNode**) index_alloc(array, index->capacity * sizeof(JsonNode*));
+	
+	json_foreach(element, array)
+		index->elements[index->count++] = element;
+}
+
 /* String buffer */
 
 typedef struct
@@ -328,11 +726,11 @@ static void to_surrogate_pair(uchar_t unicode, uint16_t *uc, uint16_t *lc)
 #define is_space(c) ((c) == '\t' || (c) == '\n' || (c) == '\r' || (c) == ' ')
 #define is_digit(c) ((c) >= '0' && (c) <= '9')
 
-static bool parse_value     (const char **sp, JsonNode        **out);
-static bool parse_string    (const char **sp, char            **out);
+static bool parse_value     (JsonArena *arena, const char **sp, JsonNode **out);
+static bool parse_string    (JsonArena *arena, const char **sp, char     **out);
 static bool parse_number    (const char **sp, double           *out);
-static bool parse_array     (const char **sp, JsonNode        **out);
-static bool parse_object    (const char **sp, JsonNode        **out);
+static bool parse_array     (JsonArena *arena, const char **sp, JsonNode **out);
+static bool parse_object    (JsonArena *arena, const char **sp, JsonNode **out);
 static bool parse_hex16     (const char **sp, uint16_t         *out);
 
 static bool expect_literal  (const char **sp, const char *str);
@@ -349,7 +747,7 @@ static void emit_object_indented    (SB *out, const JsonNode *object, const char
 
 static int write_hex16(char *out, uint16_t val);
 
-static JsonNode *mknode(JsonTag tag);
+static JsonNode *mknode(JsonArena *arena, JsonTag tag);
 static void append_node(JsonNode *parent, JsonNode *child);
 static void prepend_node(JsonNode *parent, JsonNode *child);
 static void append_member(JsonNode *object, char *key, JsonNode *value);
@@ -359,6 +757,11 @@ static bool tag_is_valid(unsigned int tag);
 static bool number_is_valid(const char *num);
 
 JsonNode *json_decode(const char *json)
+{
+	return json_decode_arena(NULL, json);
+}
+
+JsonNode *json_decode_arena(JsonArena *arena, const char *json)
 {
     if (json == NULL) {
         return NULL;
@@ -368,7 +771,7 @@ JsonNode *json_decode(const char *json)
 	JsonNode *ret = NULL;
 	
 	skip_space(&s);
-	if (!parse_value(&s, &ret)) {
+	if (!parse_value(arena, &s, &ret)) {
 	    json_delete(ret);
 		return NULL;
 	}
@@ -427,6 +830,10 @@ void json_delete(JsonNode *node)
 	if (node != NULL) {
 		json_remove_from_parent(node);
 		
+		/* Arena nodes are freed along with their arena. */
+		if (node->arena != NULL)
+			return;
+		
 		switch (node->tag) {
 			case JSON_STRING:
 				free(node->string_);
@@ -435,6 +842,9 @@ void json_delete(JsonNode *node)
 			case JSON_OBJECT:
 			{
 				JsonNode *child, *next;
+				
+				/* Rather than updating it for every child */
+				index_free(node);
 				for (child = node->children.head; child != NULL; child = next) {
 					next = child->next;
 					json_delete(child);
@@ -457,7 +867,7 @@ bool json_validate(const char *json)
 	const char *s = json;
 	
 	skip_space(&s);
-	if (!parse_value(&s, NULL))
+	if (!parse_value(NULL, &s, NULL))
 		return false;
 	
 	skip_space(&s);
@@ -476,16 +886,24 @@ JsonNode *json_find_element(JsonNode *array, int index)
 	JsonNode *element;
 	int i = 0;
 	
-	if (array == NULL || array->tag != JSON_ARRAY)
+	if (array == NULL || array->tag != JSON_ARRAY || index < 0)
 		return NULL;
 	
-	json_foreach(element, array) {
-		if (i == index)
-			return element;
-		i++;
+	if (array->children.index == NULL) {
+		json_foreach(element, array) {
+			if (i == index)
+				return element;
+			if (++i == INDEX_MIN_CHILDREN)
+				break;
+		}
+		if (element == NULL)
+			return NULL;
+		build_element_index(array);
 	}
 	
-	return NULL;
+	if ((size_t) index >= array->children.index->count)
+		return NULL;
+	return array->children.index->elements[index];
 }
 
 JsonNode *json_find_member(JsonNode *object, const char *name)
@@ -495,15 +913,24 @@ JsonNode *json_find_member(JsonNode *object, const char *name)
     }
 
 	JsonNode *member;
+	int i = 0;
 	
 	if (object == NULL || object->tag != JSON_OBJECT)
 		return NULL;
 	
-	json_foreach(member, object)
-		if (strcmp(member->key, name) == 0)
-			return member;
+	if (object->children.index == NULL) {
+		json_foreach(member, object) {
+			if (strcmp(member->key, name) == 0)
+				return member;
+			if (++i == INDEX_MIN_CHILDREN)
+				break;
+		}
+		if (member == NULL)
+			return NULL;
+		build_member_index(object);
+	}
 	
-	return NULL;
+	return member_slot(object->children.index, name, hash_key(name))->node;
 }
 
 JsonNode *json_first_child(const JsonNode *node)
@@ -513,54 +940,92 @@ JsonNode *json_first_child(const JsonNode *node)
 	return NULL;
 }
 
-static JsonNode *mknode(JsonTag tag)
+static JsonNode *mknode(JsonArena *arena, JsonTag tag)
 {
-	JsonNode *ret = (JsonNode*) calloc(1, sizeof(JsonNode));
-	if (ret == NULL)
-		out_of_memory();
+	JsonNode *ret;
+	
+	if (arena != NULL) {
+		ret = (JsonNode*) arena_alloc(arena, sizeof(JsonNode));
+		memset(ret, 0, sizeof(JsonNode));
+		ret->arena = arena;
+	} else {
+		ret = (JsonNode*) calloc(1, sizeof(JsonNode));
+		if (ret == NULL)
+			out_of_memory();
+	}
 	ret->tag = tag;
 	return ret;
 }
 
 JsonNode *json_mknull(void)
 {
-	return mknode(JSON_NULL);
+	return json_mknull_arena(NULL);
 }
 
 JsonNode *json_mkbool(bool b)
 {
-	JsonNode *ret = mknode(JSON_BOOL);
-	ret->bool_ = b;
-	return ret;
+	return json_mkbool_arena(NULL, b);
 }
 
-static JsonNode *mkstring(char *s)
+static JsonNode *mkstring(JsonArena *arena, char *s)
 {
-	JsonNode *ret = mknode(JSON_STRING);
+	JsonNode *ret = mknode(arena, JSON_STRING);
 	ret->string_ = s;
 	return ret;
 }
 
 JsonNode *json_mkstring(const char *s)
 {
-	return mkstring(json_strdup(s));
+	return json_mkstring_arena(NULL, s);
 }
 
 JsonNode *json_mknumber(double n)
 {
-	JsonNode *node = mknode(JSON_NUMBER);
-	node->number_ = n;
-	return node;
+	return json_mknumber_arena(NULL, n);
 }
 
 JsonNode *json_mkarray(void)
 {
-	return mknode(JSON_ARRAY);
+	return json_mkarray_arena(NULL);
 }
 
 JsonNode *json_mkobject(void)
 {
-	return mknode(JSON_OBJECT);
+	return json_mkobject_arena(NULL);
+}
+
+JsonNode *json_mknull_arena(JsonArena *arena)
+{
+	return mknode(arena, JSON_NULL);
+}
+
+JsonNode *json_mkbool_arena(JsonArena *arena, bool b)
+{
+	JsonNode *ret = mknode(arena, JSON_BOOL);
+	ret->bool_ = b;
+	return ret;
+}
+
+JsonNode *json_mkstring_arena(JsonArena *arena, const char *s)
+{
+	return mkstring(arena, arena_strdup(arena, s));
+}
+
+JsonNode *json_mknumber_arena(JsonArena *arena, double n)
+{
+	JsonNode *node = mknode(arena, JSON_NUMBER);
+	node->number_ = n;
+	return node;
+}
+
+JsonNode *json_mkarray_arena(JsonArena *arena)
+{
+	return mknode(arena, JSON_ARRAY);
+}
+
+JsonNode *json_mkobject_arena(JsonArena *arena)
+{
+	return mknode(arena, JSON_OBJECT);
 }
 
 static void append_node(JsonNode *parent, JsonNode *child)
@@ -593,6 +1058,7 @@ static void append_member(JsonNode *object, char *key, JsonNode *value)
 {
 	value->key = key;
 	append_node(object, value);
+	index_add_member(object, value, false);
 }
 
 void json_append_element(JsonNode *array, JsonNode *element)
@@ -603,8 +1069,10 @@ void json_append_element(JsonNode *array, JsonNode *element)
 
 	assert(array->tag == JSON_ARRAY);
 	assert(element->parent == NULL);
+	assert(element->arena == array->arena);
 	
 	append_node(array, element);
+	index_add_element(array, element, false);
 }
 
 void json_prepend_element(JsonNode *array, JsonNode *element)
@@ -615,8 +1083,10 @@ void json_prepend_element(JsonNode *array, JsonNode *element)
 
 	assert(array->tag == JSON_ARRAY);
 	assert(element->parent == NULL);
+	assert(element->arena == array->arena);
 	
 	prepend_node(array, element);
+	index_add_element(array, element, true);
 }
 
 void json_append_member(JsonNode *object, const char *key, JsonNode *value)
@@ -627,8 +1097,9 @@ void json_append_member(JsonNode *object, const char *key, JsonNode *value)
 
 	assert(object->tag == JSON_OBJECT);
 	assert(value->parent == NULL);
+	assert(value->arena == object->arena);
 	
-	append_member(object, json_strdup(key), value);
+	append_member(object, arena_strdup(object->arena, key), value);
 }
 
 void json_prepend_member(JsonNode *object, const char *key, JsonNode *value)
@@ -639,9 +1110,11 @@ void json_prepend_member(JsonNode *object, const char *key, JsonNode *value)
 
 	assert(object->tag == JSON_OBJECT);
 	assert(value->parent == NULL);
+	assert(value->arena == object->arena);
 	
-	value->key = json_strdup(key);
+	value->key = arena_strdup(object->arena, key);
 	prepend_node(object, value);
+	index_add_member(object, value, true);
 }
 
 void json_remove_from_parent(JsonNode *node)
@@ -653,6 +1126,11 @@ void json_remove_from_parent(JsonNode *node)
 	JsonNode *parent = node->parent;
 	
 	if (parent != NULL) {
+		if (parent->tag == JSON_OBJECT)
+			index_remove_member(parent, node);
+		else
+			index_remove_element(parent, node);
+		
 		if (node->prev != NULL)
 			node->prev->next = node->next;
 		else
@@ -662,7 +1140,8 @@ void json_remove_from_parent(JsonNode *node)
 		else
 			parent->children.tail = node->prev;
 		
-		free(node->key);
+		if (node->arena == NULL)
+			free(node->key);
 		
 		node->parent = NULL;
 		node->prev = node->next = NULL;
@@ -670,7 +1149,7 @@ void json_remove_from_parent(JsonNode *node)
 	}
 }
 
-static bool parse_value(const char **sp, JsonNode **out)
+static bool parse_value(JsonArena *arena, const char **sp, JsonNode **out)
 {
 	const char *s = *sp;
 	
@@ -678,7 +1157,7 @@ static bool parse_value(const char **sp, JsonNode **out)
 		case 'n':
 			if (expect_literal(&s, "null")) {
 				if (out)
-					*out = json_mknull();
+					*out = json_mknull_arena(arena);
 				*sp = s;
 				return true;
 			}
@@ -687,7 +1166,7 @@ static bool parse_value(const char **sp, JsonNode **out)
 		case 'f':
 			if (expect_literal(&s, "false")) {
 				if (out)
-					*out = json_mkbool(false);
+					*out = json_mkbool_arena(arena, false);
 				*sp = s;
 				return true;
 			}
@@ -696,7 +1175,7 @@ static bool parse_value(const char **sp, JsonNode **out)
 		case 't':
 			if (expect_literal(&s, "true")) {
 				if (out)
-					*out = json_mkbool(true);
+					*out = json_mkbool_arena(arena, true);
 				*sp = s;
 				return true;
 			}
@@ -704,9 +1183,9 @@ static bool parse_value(const char **sp, JsonNode **out)
 		
 		case '"': {
 			char *str;
-			if (parse_string(&s, out ? &str : NULL)) {
+			if (parse_string(arena, &s, out ? &str : NULL)) {
 				if (out)
-					*out = mkstring(str);
+					*out = mkstring(arena, str);
 				*sp = s;
 				return true;
 			}
@@ -714,14 +1193,14 @@ static bool parse_value(const char **sp, JsonNode **out)
 		}
 		
 		case '[':
-			if (parse_array(&s, out)) {
+			if (parse_array(arena, &s, out)) {
 				*sp = s;
 				return true;
 			}
 			return false;
 		
 		case '{':
-			if (parse_object(&s, out)) {
+			if (parse_object(arena, &s, out)) {
 				*sp = s;
 				return true;
 			}
@@ -731,7 +1210,7 @@ static bool parse_value(const char **sp, JsonNode **out)
 			double num;
 			if (parse_number(&s, out ? &num : NULL)) {
 				if (out)
-					*out = json_mknumber(num);
+					*out = json_mknumber_arena(arena, num);
 				*sp = s;
 				return true;
 			}
@@ -740,10 +1219,10 @@ static bool parse_value(const char **sp, JsonNode **out)
 	}
 }
 
-static bool parse_array(const char **sp, JsonNode **out)
+static bool parse_array(JsonArena *arena, const char **sp, JsonNode **out)
 {
 	const char *s = *sp;
-	JsonNode *ret = out ? json_mkarray() : NULL;
+	JsonNode *ret = out ? json_mkarray_arena(arena) : NULL;
 	JsonNode *element;
 	
 	if (*s++ != '[')
@@ -756,7 +1235,7 @@ static bool parse_array(const char **sp, JsonNode **out)
 	}
 	
 	for (;;) {
-		if (!parse_value(&s, out ? &element : NULL))
+		if (!parse_value(arena, &s, out ? &element : NULL))
 			goto failure;
 		skip_space(&s);
 		
@@ -784,10 +1263,10 @@ failure:
 	return false;
 }
 
-static bool parse_object(const char **sp, JsonNode **out)
+static bool parse_object(JsonArena *arena, const char **sp, JsonNode **out)
 {
 	const char *s = *sp;
-	JsonNode *ret = out ? json_mkobject() : NULL;
+	JsonNode *ret = out ? json_mkobject_arena(arena) : NULL;
 	char *key;
 	JsonNode *value;
 	
@@ -801,7 +1280,7 @@ static bool parse_object(const char **sp, JsonNode **out)
 	}
 	
 	for (;;) {
-		if (!parse_string(&s, out ? &key : NULL))
+		if (!parse_string(arena, &s, out ? &key : NULL))
 			goto failure;
 		skip_space(&s);
 		
@@ -809,7 +1288,7 @@ static bool parse_object(const char **sp, JsonNode **out)
 			goto failure_free_key;
 		skip_space(&s);
 		
-		if (!parse_value(&s, out ? &value : NULL))
+		if (!parse_value(arena, &s, out ? &value : NULL))
 			goto failure_free_key;
 		skip_space(&s);
 		
@@ -833,25 +1312,39 @@ success:
 	return true;
 
 failure_free_key:
-	if (out)
+	if (out && arena == NULL)
 		free(key);
 failure:
 	json_delete(ret);
 	return false;
 }
 
-bool parse_string(const char **sp, char **out)
+bool parse_string(JsonArena *arena, const char **sp, char **out)
 {
 	const char *s = *sp;
 	SB sb;
 	char throwaway_buffer[4];
 		/* enough space for a UTF-8 character */
 	char *b;
+	char *start = NULL;
+	size_t reserved = 0;
 	
 	if (*s++ != '"')
 		return false;
 	
-	if (out) {
+	if (out && arena) {
+		/*
+		 * Every escape sequence is longer than the UTF-8 it decodes to,
+		 * so the string fits in as many bytes as it spans in the input.
+		 * Reserve that much, and give back what isn't used.
+		 */
+		const char *e;
+		for (e = s; *e != '"' && *e != 0; e++)
+			if (*e == '\\' && e[1] != 0)
+				e++;
+		reserved = (size_t)(e - s) + 1;
+		start = b = (char*) arena_alloc(arena, reserved);
+	} else if (out) {
 		sb_init(&sb);
 		sb_need(&sb, 4);
 		b = sb.cur;
@@ -934,23 +1427,30 @@ bool parse_string(const char **sp, char **out)
 		 * Update sb to know about the new bytes,
 		 * and set up b to write another character.
 		 */
-		if (out) {
+		if (!out) {
+			b = throwaway_buffer;
+		} else if (!arena) {
 			sb.cur = b;
 			sb_need(&sb, 4);
 			b = sb.cur;
-		} else {
-			b = throwaway_buffer;
 		}
 	}
 	s++;
 	
-	if (out)
+	if (out && arena) {
+		*b++ = 0;
+		arena_trim(arena, start, reserved, (size_t)(b - start));
+		*out = start;
+	} else if (out) {
 		*out = sb_finish(&sb);
+	}
 	*sp = s;
 	return true;
 
 failed:
-	if (out)
+	if (out && arena)
+		arena_trim(arena, start, reserved, 0);
+	else if (out)
 		sb_free(&sb);
 	return false;
 }
@@ -1411,6 +1911,8 @@ bool json_check(const JsonNode *node, char errmsg[256])
 				
 				if (child->parent != node)
 					problem("child does not point back to parent");
+				if (child->arena != node->arena)
+					problem("child is not from the same arena as its parent");
 				if (child->next != NULL && child->next->prev != child)
 					problem("child->next does not point back to child");
 				
@@ -1426,6 +1928,30 @@ bool json_check(const JsonNode *node, char errmsg[256])
 			if (last != tail)
 				problem("tail does not match pointer found by starting at head and following next links");
 		}
+		
+		if (node->children.index != NULL) {
+			JsonIndex *index = node->children.index;
+			JsonNode *child;
+			size_t count = 0;
+			
+			json_foreach(child, (JsonNode*) node) {
+				if (node->tag == JSON_ARRAY) {
+					if (count >= index->count || index->elements[count] != child)
+						problem("Array index does not match element %zu", count);
+				} else {
+					JsonNode *found = member_slot(index, child->key, hash_key(child->key))->node;
+					if (found == NULL || strcmp(found->key, child->key) != 0)
+						problem("Object index is missing key \"%s\"", child->key);
+				}
+				count++;
+			}
+			
+			if (node->tag == JSON_ARRAY && count != index->count)
+				problem("Array index has %zu elements, but the array has %zu", index->count, count);
+			if (node->tag == JSON_OBJECT && count != index->count + index->duplicates)
+				problem("Object index has %zu keys and %zu duplicates, but the object has %zu members",
+				        index->count, index->duplicates, count);
+		}
 	}
 	
 	return true;
@@ -0,0 +1,106 @@
+/*
+ * KubOS HAL
+ * Copyright (C) 2018 Kubos Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * @defgroup CRC HAL CRC Functions
+ * @addtogroup CRC
+ * @{
+ */
+
+#ifndef K_CRC_H
+#define K_CRC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * All of the functions take the CRC of any preceding data, so a checksum can
+ * be built up a block at a time:
+ * @code
+uint32_t crc = 0;
+while ((len = read(fd, buffer, sizeof(buffer))) > 0)
+{
+    crc = k_crc32(crc, buffer, len);
+}
+ * @endcode
+ *
+ * Pass 0 as the starting CRC. Any initial value and final XOR required by the
+ * algorithm are applied internally.
+ *
+ * Where the compiler is targeting a processor with CRC instructions (ARMv8
+ * with `+crc`, or x86 with SSE4.2), those are used for ::k_crc32 and
+ * ::k_crc32c. Otherwise, and for the other algorithms, the data is processed
+ * with slicing-by-8 (32-bit CRCs) or slicing-by-4 (8 and 16-bit CRCs) lookup
+ * tables.
+ */
+
+/**
+ * @brief Calculate a CRC-8 (polynomial 0x07, initial value 0x00, not reflected)
+ *
+ * This is the CRC used by the iOBC supervisor and SMBus. The check value for
+ * "123456789" is 0xF4.
+ *
+ * @param [in] crc CRC of the preceding data, or 0
+ * @param [in] data Pointer to the data
+ * @param [in] len Length of the data
+ * @return uint8_t Updated CRC
+ */
+uint8_t k_crc8(uint8_t crc, const void * data, size_t len);
+/**
+ * @brief Calculate a CRC-16-CCITT, as used for the AX.25 and HDLC frame check sequence
+ *
+ * Polynomial 0x1021, reflected, initial value 0xFFFF, final XOR 0xFFFF
+ * (CRC-16/X-25). The check value for "123456789" is 0x906E.
+ *
+ * The result is transmitted least significant byte first.
+ *
+ * @param [in] crc CRC of the preceding data, or 0
+ * @param [in] data Pointer to the data
+ * @param [in] len Length of the data
+ * @return uint16_t Updated CRC
+ */
+uint16_t k_crc16_ccitt(uint16_t crc, const void * data, size_t len);
+/**
+ * @brief Calculate a CRC-32, as used by Ethernet, zlib and PNG
+ *
+ * Polynomial 0x04C11DB7, reflected, initial value 0xFFFFFFFF, final XOR
+ * 0xFFFFFFFF. The check value for "123456789" is 0xCBF43926.
+ *
+ * @param [in] crc CRC of the preceding data, or 0
+ * @param [in] data Pointer to the data
+ * @param [in] len Length of the data
+ * @return uint32_t Updated CRC
+ */
+uint32_t k_crc32(uint32_t crc, const void * data, size_t len);
+/**
+ * @brief Calculate a CRC-32C (Castagnoli), as used by iSCSI and SCTP
+ *
+ * Polynomial 0x1EDC6F41, reflected, initial value 0xFFFFFFFF, final XOR
+ * 0xFFFFFFFF. The check value for "123456789" is 0xE3069283.
+ *
+ * This is the CRC calculated by the x86 `crc32` instruction, so it is the
+ * fastest option for new protocols which will be checked on both the flight
+ * and ground sides.
+ *
+ * @param [in] crc CRC of the preceding data, or 0
+ * @param [in] data Pointer to the data
+ * @param [in] len Length of the data
+ * @return uint32_t Updated CRC
+ */
+uint32_t k_crc32c(uint32_t crc, const void * data, size_t len);
+
+#endif
+/* @} */
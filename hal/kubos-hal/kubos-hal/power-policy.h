@@ -0,0 +1,176 @@
+/*
+ * KubOS HAL
+ * Copyright (C) 2018 Kubos Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * @defgroup POWER_POLICY HAL Power Policy
+ * @addtogroup POWER_POLICY
+ * @{
+ */
+
+#ifndef K_POWER_POLICY_H
+#define K_POWER_POLICY_H
+
+#include <stdint.h>
+
+/**
+ * Maximum number of pollers which can be registered at once
+ */
+#define K_POWER_MAX_POLLS    16
+/**
+ * Maximum length of a poller's name, including the terminating NULL
+ */
+#define K_POWER_NAME_LEN     16
+
+/**
+ * Power policy function status
+ */
+typedef enum {
+    POWER_OK = 0,
+    POWER_ERROR,
+    POWER_ERROR_CONFIG,
+    POWER_ERROR_FULL
+} KPowerStatus;
+
+/**
+ * Power modes, in order of increasing severity
+ */
+typedef enum {
+    POWER_MODE_NORMAL,          /**< Battery is healthy. Poll at the requested rates */
+    POWER_MODE_SAFE,            /**< Battery is low */
+    POWER_MODE_CRITICAL,        /**< Battery is almost exhausted */
+    POWER_MODE_COUNT            /**< Number of power modes */
+} KPowerMode;
+
+/**
+ * Power policy configuration
+ */
+typedef struct {
+    uint16_t interval_scale[POWER_MODE_COUNT];  /**< Polling interval multiplier for each mode [percent] */
+    uint16_t slack_scale[POWER_MODE_COUNT];     /**< Watchdog slack multiplier for each mode [percent] */
+    uint16_t vbatt_safe;                        /**< Battery voltage below which ::POWER_MODE_SAFE is used [mV]. 0 to disable */
+    uint16_t vbatt_critical;                    /**< Battery voltage below which ::POWER_MODE_CRITICAL is used [mV]. 0 to disable */
+    uint16_t hysteresis;                        /**< Amount the battery voltage must recover by before leaving a mode [mV] */
+} k_power_config;
+
+/**
+ * Default power policy configuration
+ *
+ * The battery voltage thresholds are disabled, so only the mode reported by
+ * the EPS is used
+ */
+#define K_POWER_DEFAULT_CONFIG                  \
+    {                                           \
+        .interval_scale = { 100, 400, 1000 },   \
+        .slack_scale    = { 100, 200, 400 },    \
+        .vbatt_safe     = 0,                    \
+        .vbatt_critical = 0,                    \
+        .hysteresis     = 0                     \
+    }
+
+/**
+ * Poller statistics, returned by ::k_power_get_poll_stats
+ */
+typedef struct {
+    uint32_t interval;          /**< Current interval for the poller's mode [milliseconds] */
+    uint32_t polls;             /**< Number of polls made */
+    uint32_t polls_by_mode[POWER_MODE_COUNT];   /**< Number of polls made in each mode */
+    uint32_t interval_mean;     /**< Mean measured time between polls [milliseconds] */
+} k_power_poll_stats;
+
+/**
+ * Power policy statistics, returned by ::k_power_get_stats
+ */
+typedef struct {
+    KPowerMode mode;            /**< Current power mode */
+    uint32_t mode_changes;      /**< Number of times the mode has changed */
+    uint64_t time_in_mode[POWER_MODE_COUNT];    /**< Time spent in each mode [milliseconds] */
+} k_power_stats;
+
+/**
+ * @brief Set the power policy configuration
+ *
+ * The new polling intervals and watchdog slack take effect immediately
+ *
+ * @param [in] config Pointer to the new configuration
+ * @return KPowerStatus `POWER_OK` if OK, error otherwise
+ */
+KPowerStatus k_power_configure(const k_power_config * config);
+/**
+ * @brief Update the power mode from the EPS's state
+ *
+ * The resulting mode is the more severe of `reported` and the mode selected by
+ * the configured battery voltage thresholds. Watchdog slack is scaled to match
+ * with ::k_watchdog_set_slack_scale.
+ *
+ * @param [in] reported Mode reported by the EPS
+ * @param [in] vbatt Battery voltage [mV]
+ * @param [out] mode Pointer to storage for the resulting mode. May be `NULL`
+ * @return KPowerStatus `POWER_OK` if OK, error otherwise
+ */
+KPowerStatus k_power_update(KPowerMode reported, uint16_t vbatt, KPowerMode * mode);
+/**
+ * @brief Get the current power mode
+ * @return KPowerMode Current power mode
+ */
+KPowerMode k_power_get_mode(void);
+/**
+ * @brief Register a poller, such as a telemetry collection loop
+ * @param [in] name Poller name
+ * @param [in] interval Time between polls in ::POWER_MODE_NORMAL [milliseconds]
+ * @param [out] id Pointer to storage for the poller's ID
+ * @return KPowerStatus `POWER_OK` if OK, error otherwise
+ */
+KPowerStatus k_power_register_poll(const char * name, uint32_t interval, int * id);
+/**
+ * @brief Unregister a poller
+ * @param [in] id Poller ID returned by ::k_power_register_poll
+ * @return KPowerStatus `POWER_OK` if OK, error otherwise
+ */
+KPowerStatus k_power_unregister_poll(int id);
+/**
+ * @brief Record that a poller has polled, and get the time to wait until its next poll
+ *
+ * Example usage:
+ * @code
+int id;
+k_power_register_poll("TRXVU", 1000, &id);
+while (running)
+{
+    k_radio_get_telemetry(&telem, RADIO_RX_TELEM_ALL);
+    usleep(k_power_poll(id) * 1000);
+}
+ * @endcode
+ *
+ * @param [in] id Poller ID returned by ::k_power_register_poll
+ * @return uint32_t Interval for the current power mode [milliseconds], or 0 if `id` is invalid
+ */
+uint32_t k_power_poll(int id);
+/**
+ * @brief Get a poller's statistics
+ * @param [in] id Poller ID returned by ::k_power_register_poll
+ * @param [out] stats Pointer to storage for the statistics
+ * @return KPowerStatus `POWER_OK` if OK, error otherwise
+ */
+KPowerStatus k_power_get_poll_stats(int id, k_power_poll_stats * stats);
+/**
+ * @brief Get the power policy's statistics
+ * @param [out] stats Pointer to storage for the statistics
+ * @return KPowerStatus `POWER_OK` if OK, error otherwise
+ */
+KPowerStatus k_power_get_stats(k_power_stats * stats);
+
+#endif
+/* @} */
@@ -0,0 +1,136 @@
+/*
+ * KubOS HAL
+ * Copyright (C) 2018 Kubos Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * @defgroup WATCHDOG HAL Watchdog Scheduler
+ * @addtogroup WATCHDOG
+ * @{
+ */
+
+#ifndef K_WATCHDOG_H
+#define K_WATCHDOG_H
+
+#include <stdint.h>
+
+/**
+ * Maximum number of watchdogs which can be registered at once
+ */
+#define K_WATCHDOG_MAX      8
+/**
+ * Maximum length of a watchdog's name, including the terminating NULL
+ */
+#define K_WATCHDOG_NAME_LEN 16
+
+/**
+ * Watchdog scheduler function status
+ */
+typedef enum {
+    WATCHDOG_OK = 0,
+    WATCHDOG_ERROR,
+    WATCHDOG_ERROR_CONFIG,
+    WATCHDOG_ERROR_FULL
+} KWatchdogStatus;
+
+/**
+ * Watchdog kick callback
+ * @param [in] arg Argument given to ::k_watchdog_register
+ * @return int 0 if the kick succeeded, non-zero otherwise
+ */
+typedef int (*k_watchdog_kick_fn)(void * arg);
+
+/**
+ * Watchdog kick statistics, returned by ::k_watchdog_get_stats
+ */
+typedef struct {
+    uint32_t kicks;             /**< Number of kicks attempted */
+    uint32_t failures;          /**< Number of kicks which returned an error */
+    uint32_t latency_max;       /**< Longest delay between a kick's due time and the kick [microseconds] */
+    uint32_t latency_mean;      /**< Mean delay between a kick's due time and the kick [microseconds] */
+} k_watchdog_stats;
+
+/**
+ * @brief Register a watchdog with the shared scheduler
+ *
+ * The watchdog is kicked once before this function returns, and then every
+ * `period` milliseconds by the scheduler thread. The thread is started when
+ * the first watchdog is registered and exits when the last is unregistered.
+ *
+ * A kick may be brought forward by up to `slack` milliseconds so that it can
+ * share a wakeup with the kicks of other watchdogs. An early kick restarts the
+ * period, so the time between kicks never exceeds `period` (less any
+ * scheduling latency). The slack is capped at half the period.
+ *
+ * Kicks are made from the scheduler thread, one at a time, and must not call
+ * any of the `k_watchdog_*` functions.
+ *
+ * @param [in] name Watchdog name, used in error messages
+ * @param [in] period Time between kicks [milliseconds]
+ * @param [in] slack Time a kick may be brought forward by [milliseconds]
+ * @param [in] kick Function which kicks the watchdog
+ * @param [in] arg Argument passed to `kick`
+ * @param [out] id Pointer to storage for the watchdog's ID
+ * @return KWatchdogStatus `WATCHDOG_OK` if OK, error otherwise
+ */
+KWatchdogStatus k_watchdog_register(const char * name, uint32_t period,
+                                    uint32_t slack, k_watchdog_kick_fn kick,
+                                    void * arg, int * id);
+/**
+ * @brief Unregister a watchdog
+ *
+ * Once this function returns, the watchdog's kick function will not be called
+ * again
+ *
+ * @param [in] id Watchdog ID returned by ::k_watchdog_register
+ * @return KWatchdogStatus `WATCHDOG_OK` if OK, error otherwise
+ */
+KWatchdogStatus k_watchdog_unregister(int id);
+/**
+ * @brief Change a registered watchdog's kick schedule
+ *
+ * The next kick is rescheduled relative to the previous one
+ *
+ * @param [in] id Watchdog ID returned by ::k_watchdog_register
+ * @param [in] period Time between kicks [milliseconds]
+ * @param [in] slack Time a kick may be brought forward by [milliseconds]
+ * @return KWatchdogStatus `WATCHDOG_OK` if OK, error otherwise
+ */
+KWatchdogStatus k_watchdog_set_period(int id, uint32_t period, uint32_t slack);
+/**
+ * @brief Scale the slack of every registered watchdog
+ *
+ * Larger slack lets more kicks share a wakeup, at the cost of kicking some
+ * watchdogs early. Slack never moves a kick past its deadline, and is capped
+ * at half of each watchdog's period
+ *
+ * @param [in] scale Slack multiplier [percent]. 100 uses the slack given at registration
+ */
+void k_watchdog_set_slack_scale(uint16_t scale);
+/**
+ * @brief Get a watchdog's kick statistics
+ * @param [in] id Watchdog ID returned by ::k_watchdog_register
+ * @param [out] stats Pointer to storage for the statistics
+ * @return KWatchdogStatus `WATCHDOG_OK` if OK, error otherwise
+ */
+KWatchdogStatus k_watchdog_get_stats(int id, k_watchdog_stats * stats);
+/**
+ * @brief Get the number of times the scheduler thread has woken up to kick
+ * watchdogs
+ * @return uint32_t Number of wakeups since the scheduler was first started
+ */
+uint32_t k_watchdog_get_wakeups(void);
+
+#endif
+/* @} */
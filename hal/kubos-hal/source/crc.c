@@ -0,0 +1,190 @@
+/*
+ * KubOS HAL
+ * Copyright (C) 2018 Kubos Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "crc.h"
+#include "crc-tables.h"
+#include <string.h>
+
+#if defined(__ARM_FEATURE_CRC32) && !defined(__ARM_BIG_ENDIAN)
+#include <arm_acle.h>
+#define K_CRC_ARM
+#elif defined(__SSE4_2__)
+#include <nmmintrin.h>
+#define K_CRC_SSE42
+#endif
+
+uint8_t k_crc8(uint8_t crc, const void * data, size_t len)
+{
+    const uint8_t * buf = data;
+
+    while (len >= 4)
+    {
+        crc = crc8_table[3][crc ^ buf[0]] ^ crc8_table[2][buf[1]]
+              ^ crc8_table[1][buf[2]] ^ crc8_table[0][buf[3]];
+        buf += 4;
+        len -= 4;
+    }
+
+    while (len--)
+    {
+        crc = crc8_table[0][crc ^ *buf++];
+    }
+
+    return crc;
+}
+
+uint16_t k_crc16_ccitt(uint16_t crc, const void * data, size_t len)
+{
+    const uint8_t * buf = data;
+
+    crc = ~crc;
+
+    while (len >= 4)
+    {
+        crc ^= buf[0] | (buf[1] << 8);
+        crc = crc16_ccitt_table[3][crc & 0xFF] ^ crc16_ccitt_table[2][crc >> 8]
+              ^ crc16_ccitt_table[1][buf[2]] ^ crc16_ccitt_table[0][buf[3]];
+        buf += 4;
+        len -= 4;
+    }
+
+    while (len--)
+    {
+        crc = (crc >> 8) ^ crc16_ccitt_table[0][(crc ^ *buf++) & 0xFF];
+    }
+
+    return ~crc;
+}
+
+#ifndef K_CRC_ARM
+/*
+ * Slicing-by-8 for the reflected 32-bit CRCs. The bytes are combined one at a
+ * time, rather than loaded as a word, so this works at any alignment and
+ * endianness (the compiler merges them into a single load where it can).
+ */
+static uint32_t kprv_crc32_slice8(const uint32_t table[8][256], uint32_t crc,
+                                  const uint8_t * buf, size_t len)
+{
+    while (len >= 8)
+    {
+        crc ^= (uint32_t) buf[0] | ((uint32_t) buf[1] << 8)
+               | ((uint32_t) buf[2] << 16) | ((uint32_t) buf[3] << 24);
+        crc = table[7][crc & 0xFF] ^ table[6][(crc >> 8) & 0xFF]
+              ^ table[5][(crc >> 16) & 0xFF] ^ table[4][crc >> 24]
+              ^ table[3][buf[4]] ^ table[2][buf[5]]
+              ^ table[1][buf[6]] ^ table[0][buf[7]];
+        buf += 8;
+        len -= 8;
+    }
+
+    while (len--)
+    {
+        crc = (crc >> 8) ^ table[0][(crc ^ *buf++) & 0xFF];
+    }
+
+    return crc;
+}
+#endif
+
+uint32_t k_crc32(uint32_t crc, const void * data, size_t len)
+{
+    const uint8_t * buf = data;
+
+    crc = ~crc;
+
+#ifdef K_CRC_ARM
+    uint64_t word;
+
+    while (len >= 8)
+    {
+        memcpy(&word, buf, sizeof(word));
+        crc = __crc32d(crc, word);
+        buf += 8;
+        len -= 8;
+    }
+
+    while (len--)
+    {
+        crc = __crc32b(crc, *buf++);
+    }
+#else
+    crc = kprv_crc32_slice8(crc32_table, crc, buf, len);
+#endif
+
+    return ~crc;
+}
+
+uint32_t k_crc32c(uint32_t crc, const void * data, size_t len)
+{
+    const uint8_t * buf = data;
+
+    crc = ~crc;
+
+#if defined(K_CRC_ARM)
+    uint64_t word;
+
+    while (len >= 8)
+    {
+        memcpy(&word, buf, sizeof(word));
+        crc = __crc32cd(crc, word);
+        buf += 8;
+        len -= 8;
+    }
+
+    while (len--)
+    {
+        crc = __crc32cb(crc, *buf++);
+    }
+#elif defined(K_CRC_SSE42) && defined(__x86_64__)
+    uint64_t word;
+    uint64_t crc64 = crc;
+
+    while (len >= 8)
+    {
+        memcpy(&word, buf, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+        buf += 8;
+        len -= 8;
+    }
+
+    crc = (uint32_t) crc64;
+
+    while (len--)
+    {
+        crc = _mm_crc32_u8(crc, *buf++);
+    }
+#elif defined(K_CRC_SSE42)
+    uint32_t word;
+
+    while (len >= 4)
+    {
+        memcpy(&word, buf, sizeof(word));
+        crc = _mm_crc32_u32(crc, word);
+        buf += 4;
+        len -= 4;
+    }
+
+    while (len--)
+    {
+        crc = _mm_crc32_u8(crc, *buf++);
+    }
+#else
+    crc = kprv_crc32_slice8(crc32c_table, crc, buf, len);
+#endif
+
+    return ~crc;
+}
@@ -0,0 +1,299 @@
+/*
+ * KubOS HAL
+ * Copyright (C) 2018 Kubos Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "power-policy.h"
+#include "watchdog.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+    bool               used;
+    char               name[K_POWER_NAME_LEN];
+    uint32_t           interval;        /* Interval in POWER_MODE_NORMAL */
+    struct timespec    last;            /* Time of the previous poll */
+    uint64_t           elapsed_total;   /* Used to calculate the mean */
+    k_power_poll_stats stats;
+} k_power_poll_entry;
+
+static k_power_poll_entry polls[K_POWER_MAX_POLLS];
+static k_power_config     power_config = K_POWER_DEFAULT_CONFIG;
+static KPowerMode         power_mode   = POWER_MODE_NORMAL;
+static k_power_stats      power_stats  = { 0 };
+static struct timespec    power_mode_start = { 0 };
+static pthread_mutex_t    power_mutex  = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t kprv_power_diff_ms(const struct timespec * end,
+                                   const struct timespec * start)
+{
+    return (uint64_t) (end->tv_sec - start->tv_sec) * 1000
+           + (end->tv_nsec - start->tv_nsec) / 1000000;
+}
+
+static uint32_t kprv_power_interval(const k_power_poll_entry * entry)
+{
+    uint64_t interval = (uint64_t) entry->interval
+                        * power_config.interval_scale[power_mode] / 100;
+
+    return (interval > UINT32_MAX) ? UINT32_MAX : (uint32_t) interval;
+}
+
+/* Select a mode from the battery voltage, with hysteresis on the way back up */
+static KPowerMode kprv_power_vbatt_mode(uint16_t vbatt)
+{
+    KPowerMode mode = POWER_MODE_NORMAL;
+    uint32_t   safe = power_config.vbatt_safe;
+    uint32_t   critical = power_config.vbatt_critical;
+
+    if (power_mode >= POWER_MODE_SAFE)
+    {
+        safe += power_config.hysteresis;
+    }
+
+    if (power_mode == POWER_MODE_CRITICAL)
+    {
+        critical += power_config.hysteresis;
+    }
+
+    if (power_config.vbatt_safe != 0 && vbatt < safe)
+    {
+        mode = POWER_MODE_SAFE;
+    }
+
+    if (power_config.vbatt_critical != 0 && vbatt < critical)
+    {
+        mode = POWER_MODE_CRITICAL;
+    }
+
+    return mode;
+}
+
+/* Account for the time spent in the current mode, up to now */
+static void kprv_power_account(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    if (power_mode_start.tv_sec != 0 || power_mode_start.tv_nsec != 0)
+    {
+        power_stats.time_in_mode[power_mode]
+            += kprv_power_diff_ms(&now, &power_mode_start);
+    }
+
+    power_mode_start = now;
+}
+
+KPowerStatus k_power_configure(const k_power_config * config)
+{
+    if (config == NULL)
+    {
+        return POWER_ERROR_CONFIG;
+    }
+
+    for (int i = 0; i < POWER_MODE_COUNT; i++)
+    {
+        if (config->interval_scale[i] == 0)
+        {
+            fprintf(stderr, "Invalid polling interval scale for power mode %d\n", i);
+            return POWER_ERROR_CONFIG;
+        }
+    }
+
+    if (config->vbatt_critical > config->vbatt_safe && config->vbatt_safe != 0)
+    {
+        fprintf(stderr, "Critical battery voltage must be below safe voltage\n");
+        return POWER_ERROR_CONFIG;
+    }
+
+    pthread_mutex_lock(&power_mutex);
+    power_config = *config;
+    k_watchdog_set_slack_scale(power_config.slack_scale[power_mode]);
+    pthread_mutex_unlock(&power_mutex);
+
+    return POWER_OK;
+}
+
+KPowerStatus k_power_update(KPowerMode reported, uint16_t vbatt, KPowerMode * mode)
+{
+    if (reported >= POWER_MODE_COUNT)
+    {
+        return POWER_ERROR_CONFIG;
+    }
+
+    pthread_mutex_lock(&power_mutex);
+
+    KPowerMode new_mode = kprv_power_vbatt_mode(vbatt);
+    if (reported > new_mode)
+    {
+        new_mode = reported;
+    }
+
+    kprv_power_account();
+
+    if (new_mode != power_mode)
+    {
+        power_mode = new_mode;
+        power_stats.mode_changes++;
+
+        k_watchdog_set_slack_scale(power_config.slack_scale[power_mode]);
+    }
+
+    if (mode != NULL)
+    {
+        *mode = power_mode;
+    }
+
+    pthread_mutex_unlock(&power_mutex);
+
+    return POWER_OK;
+}
+
+KPowerMode k_power_get_mode(void)
+{
+    KPowerMode mode;
+
+    pthread_mutex_lock(&power_mutex);
+    mode = power_mode;
+    pthread_mutex_unlock(&power_mutex);
+
+    return mode;
+}
+
+KPowerStatus k_power_register_poll(const char * name, uint32_t interval, int * id)
+{
+    if (name == NULL || interval == 0 || id == NULL)
+    {
+        return POWER_ERROR_CONFIG;
+    }
+
+    pthread_mutex_lock(&power_mutex);
+
+    for (int i = 0; i < K_POWER_MAX_POLLS; i++)
+    {
+        if (!polls[i].used)
+        {
+            memset(&polls[i], 0, sizeof(polls[i]));
+            snprintf(polls[i].name, sizeof(polls[i].name), "%s", name);
+            polls[i].interval = interval;
+            polls[i].used     = true;
+
+            pthread_mutex_unlock(&power_mutex);
+
+            *id = i;
+            return POWER_OK;
+        }
+    }
+
+    pthread_mutex_unlock(&power_mutex);
+
+    fprintf(stderr, "No room to register %s poller\n", name);
+    return POWER_ERROR_FULL;
+}
+
+KPowerStatus k_power_unregister_poll(int id)
+{
+    KPowerStatus status = POWER_ERROR_CONFIG;
+
+    pthread_mutex_lock(&power_mutex);
+
+    if (id >= 0 && id < K_POWER_MAX_POLLS && polls[id].used)
+    {
+        polls[id].used = false;
+        status = POWER_OK;
+    }
+
+    pthread_mutex_unlock(&power_mutex);
+
+    return status;
+}
+
+uint32_t k_power_poll(int id)
+{
+    struct timespec now;
+    uint32_t        interval = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    pthread_mutex_lock(&power_mutex);
+
+    if (id >= 0 && id < K_POWER_MAX_POLLS && polls[id].used)
+    {
+        k_power_poll_entry * entry = &polls[id];
+
+        /* The measured rate, rather than the requested one */
+        if (entry->stats.polls > 0)
+        {
+            entry->elapsed_total += kprv_power_diff_ms(&now, &entry->last);
+            entry->stats.interval_mean
+                = (uint32_t) (entry->elapsed_total / entry->stats.polls);
+        }
+
+        entry->last = now;
+        entry->stats.polls++;
+        entry->stats.polls_by_mode[power_mode]++;
+
+        interval = kprv_power_interval(entry);
+    }
+
+    pthread_mutex_unlock(&power_mutex);
+
+    return interval;
+}
+
+KPowerStatus k_power_get_poll_stats(int id, k_power_poll_stats * stats)
+{
+    KPowerStatus status = POWER_ERROR_CONFIG;
+
+    if (stats == NULL)
+    {
+        return POWER_ERROR_CONFIG;
+    }
+
+    pthread_mutex_lock(&power_mutex);
+
+    if (id >= 0 && id < K_POWER_MAX_POLLS && polls[id].used)
+    {
+        *stats          = polls[id].stats;
+        stats->interval = kprv_power_interval(&polls[id]);
+        status          = POWER_OK;
+    }
+
+    pthread_mutex_unlock(&power_mutex);
+
+    return status;
+}
+
+KPowerStatus k_power_get_stats(k_power_stats * stats)
+{
+    if (stats == NULL)
+    {
+        return POWER_ERROR_CONFIG;
+    }
+
+    pthread_mutex_lock(&power_mutex);
+
+    kprv_power_account();
+    power_stats.mode = power_mode;
+    *stats = power_stats;
+
+    pthread_mutex_unlock(&power_mutex);
+
+    return POWER_OK;
+}
@@ -0,0 +1,433 @@
+/*
+ * KubOS HAL
+ * Copyright (C) 2018 Kubos Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "watchdog.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+    bool               used;
+    char               name[K_WATCHDOG_NAME_LEN];
+    uint32_t           period;
+    uint32_t           slack;
+    k_watchdog_kick_fn kick;
+    void *             arg;
+    struct timespec    last;            /* Time the next kick is scheduled from */
+    struct timespec    due;             /* Deadline for the next kick */
+    k_watchdog_stats   stats;
+    uint64_t           latency_total;   /* Used to calculate the mean */
+} k_watchdog_entry;
+
+/*
+ * Registered watchdogs. There are only ever a handful (one per device API),
+ * so each wakeup simply scans the whole table
+ */
+static k_watchdog_entry watchdogs[K_WATCHDOG_MAX];
+
+/* Protects the table. Held by the scheduler thread while it kicks */
+static pthread_mutex_t watchdog_mutex = PTHREAD_MUTEX_INITIALIZER;
+/* Serializes registration, so the thread can be started and joined safely */
+static pthread_mutex_t watchdog_control_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  watchdog_cond;
+static pthread_once_t  watchdog_once = PTHREAD_ONCE_INIT;
+
+static pthread_t handle_watchdog = { 0 };
+static bool      watchdog_running = false;
+static uint32_t  watchdog_wakeups = 0;
+static uint16_t  watchdog_slack_scale = 100;
+
+static void kprv_watchdog_init(void)
+{
+    pthread_condattr_t attr;
+
+    /* Wait against the monotonic clock, so setting the date can't stall a kick */
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&watchdog_cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+static void kprv_watchdog_add_ms(struct timespec * time, uint32_t ms)
+{
+    time->tv_sec += ms / 1000;
+    time->tv_nsec += (ms % 1000) * 1000000;
+    if (time->tv_nsec >= 1000000000)
+    {
+        time->tv_sec++;
+        time->tv_nsec -= 1000000000;
+    }
+}
+
+static int64_t kprv_watchdog_diff_us(const struct timespec * end,
+                                     const struct timespec * start)
+{
+    return (int64_t) (end->tv_sec - start->tv_sec) * 1000000
+           + (end->tv_nsec - start->tv_nsec) / 1000;
+}
+
+static void kprv_watchdog_kick(k_watchdog_entry * entry)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    int64_t latency = kprv_watchdog_diff_us(&now, &entry->due);
+    if (latency < 0)
+    {
+        latency = 0;
+    }
+
+    if (entry->kick(entry->arg) != 0)
+    {
+        entry->stats.failures++;
+    }
+
+    entry->stats.kicks++;
+    entry->latency_total += latency;
+    entry->stats.latency_mean = (uint32_t) (entry->latency_total / entry->stats.kicks);
+    if ((uint32_t) latency > entry->stats.latency_max)
+    {
+        entry->stats.latency_max = (uint32_t) latency;
+    }
+
+    /*
+     * An early kick restarts the period from the kick itself, so the time
+     * between kicks never exceeds the period. A late one keeps to the original
+     * schedule, unless a whole period has been missed. There's no point in
+     * kicking several times to catch up
+     */
+    entry->last = (latency > 0) ? entry->due : now;
+    entry->due  = entry->last;
+    kprv_watchdog_add_ms(&entry->due, entry->period);
+    if (kprv_watchdog_diff_us(&entry->due, &now) < 0)
+    {
+        entry->last = now;
+        entry->due  = now;
+        kprv_watchdog_add_ms(&entry->due, entry->period);
+    }
+}
+
+/*
+ * Scaled slack, capped at half the period so an early kick can't more than
+ * double the kick rate
+ */
+static uint32_t kprv_watchdog_slack(const k_watchdog_entry * entry)
+{
+    uint64_t slack = (uint64_t) entry->slack * watchdog_slack_scale / 100;
+
+    if (slack > entry->period / 2)
+    {
+        slack = entry->period / 2;
+    }
+
+    return (uint32_t) slack;
+}
+
+/* Whether a watchdog's kick window, [due - slack, due], has opened */
+static bool kprv_watchdog_ready(const k_watchdog_entry * entry,
+                                const struct timespec * now)
+{
+    int64_t remaining = kprv_watchdog_diff_us(&entry->due, now);
+
+    return remaining <= (int64_t) kprv_watchdog_slack(entry) * 1000;
+}
+
+/*
+ * Find the next time the scheduler needs to wake up: the earliest deadline.
+ * Any other watchdog whose window is open by then is kicked at the same time
+ */
+static bool kprv_watchdog_next_wake(struct timespec * wake)
+{
+    bool found = false;
+
+    for (int i = 0; i < K_WATCHDOG_MAX; i++)
+    {
+        if (!watchdogs[i].used)
+        {
+            continue;
+        }
+
+        if (!found || kprv_watchdog_diff_us(&watchdogs[i].due, wake) < 0)
+        {
+            *wake = watchdogs[i].due;
+            found = true;
+        }
+    }
+
+    return found;
+}
+
+static void * kprv_watchdog_thread(void * args)
+{
+    struct timespec now;
+    struct timespec wake;
+
+    pthread_mutex_lock(&watchdog_mutex);
+
+    while (watchdog_running)
+    {
+        if (!kprv_watchdog_next_wake(&wake))
+        {
+            pthread_cond_wait(&watchdog_cond, &watchdog_mutex);
+            continue;
+        }
+
+        /* Woken early if the table changes, so the wake time is recalculated */
+        if (pthread_cond_timedwait(&watchdog_cond, &watchdog_mutex, &wake)
+            != ETIMEDOUT)
+        {
+            continue;
+        }
+
+        watchdog_wakeups++;
+
+        /* Kick everything within its window, not just the watchdog that woke us */
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        for (int i = 0; i < K_WATCHDOG_MAX; i++)
+        {
+            if (watchdogs[i].used && kprv_watchdog_ready(&watchdogs[i], &now))
+            {
+                kprv_watchdog_kick(&watchdogs[i]);
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&watchdog_mutex);
+
+    return NULL;
+}
+
+static bool kprv_watchdog_valid(int id)
+{
+    return id >= 0 && id < K_WATCHDOG_MAX && watchdogs[id].used;
+}
+
+KWatchdogStatus k_watchdog_register(const char * name, uint32_t period,
+                                    uint32_t slack, k_watchdog_kick_fn kick,
+                                    void * arg, int * id)
+{
+    k_watchdog_entry entry = { 0 };
+    int              slot  = -1;
+    int              ret;
+
+    if (name == NULL || period == 0 || kick == NULL || id == NULL)
+    {
+        return WATCHDOG_ERROR_CONFIG;
+    }
+
+    pthread_once(&watchdog_once, kprv_watchdog_init);
+
+    pthread_mutex_lock(&watchdog_control_mutex);
+
+    /* Only registration changes which slots are in use */
+    for (int i = 0; i < K_WATCHDOG_MAX; i++)
+    {
+        if (!watchdogs[i].used)
+        {
+            slot = i;
+            break;
+        }
+    }
+
+    if (slot < 0)
+    {
+        fprintf(stderr, "No room to register %s watchdog\n", name);
+        pthread_mutex_unlock(&watchdog_control_mutex);
+        return WATCHDOG_ERROR_FULL;
+    }
+
+    snprintf(entry.name, sizeof(entry.name), "%s", name);
+    entry.period = period;
+    entry.slack  = slack;
+    entry.kick   = kick;
+    entry.arg    = arg;
+    entry.used   = true;
+
+    /* The first kick is made right away, from the caller's thread */
+    clock_gettime(CLOCK_MONOTONIC, &entry.due);
+    kprv_watchdog_kick(&entry);
+
+    pthread_mutex_lock(&watchdog_mutex);
+
+    watchdogs[slot] = entry;
+
+    if (!watchdog_running)
+    {
+        watchdog_running = true;
+
+        ret = pthread_create(&handle_watchdog, NULL, kprv_watchdog_thread, NULL);
+        if (ret != 0)
+        {
+            fprintf(stderr, "Failed to create watchdog thread: %s\n",
+                    strerror(ret));
+            watchdogs[slot].used = false;
+            watchdog_running     = false;
+            handle_watchdog      = 0;
+            pthread_mutex_unlock(&watchdog_mutex);
+            pthread_mutex_unlock(&watchdog_control_mutex);
+            return WATCHDOG_ERROR;
+        }
+    }
+
+    pthread_cond_signal(&watchdog_cond);
+    pthread_mutex_unlock(&watchdog_mutex);
+
+    pthread_mutex_unlock(&watchdog_control_mutex);
+
+    *id = slot;
+
+    return WATCHDOG_OK;
+}
+
+KWatchdogStatus k_watchdog_unregister(int id)
+{
+    KWatchdogStatus status = WATCHDOG_OK;
+    bool            stop   = true;
+
+    pthread_mutex_lock(&watchdog_control_mutex);
+
+    /* Waits for any kick in progress to finish */
+    pthread_mutex_lock(&watchdog_mutex);
+
+    if (!kprv_watchdog_valid(id))
+    {
+        pthread_mutex_unlock(&watchdog_mutex);
+        pthread_mutex_unlock(&watchdog_control_mutex);
+        return WATCHDOG_ERROR_CONFIG;
+    }
+
+    watchdogs[id].used = false;
+
+    for (int i = 0; i < K_WATCHDOG_MAX; i++)
+    {
+        if (watchdogs[i].used)
+        {
+            stop = false;
+            break;
+        }
+    }
+
+    /* Nothing left to kick, so let the thread exit */
+    if (stop)
+    {
+        watchdog_running = false;
+    }
+
+    pthread_cond_signal(&watchdog_cond);
+    pthread_mutex_unlock(&watchdog_mutex);
+
+    if (stop)
+    {
+        if (pthread_join(handle_watchdog, NULL) != 0)
+        {
+            perror("Failed to rejoin watchdog thread");
+            status = WATCHDOG_ERROR;
+        }
+
+        handle_watchdog = 0;
+    }
+
+    pthread_mutex_unlock(&watchdog_control_mutex);
+
+    return status;
+}
+
+KWatchdogStatus k_watchdog_set_period(int id, uint32_t period, uint32_t slack)
+{
+    struct timespec now;
+
+    if (period == 0)
+    {
+        return WATCHDOG_ERROR_CONFIG;
+    }
+
+    pthread_mutex_lock(&watchdog_mutex);
+
+    if (!kprv_watchdog_valid(id))
+    {
+        pthread_mutex_unlock(&watchdog_mutex);
+        return WATCHDOG_ERROR_CONFIG;
+    }
+
+    k_watchdog_entry * entry = &watchdogs[id];
+
+    entry->period = period;
+    entry->slack  = slack;
+    entry->due    = entry->last;
+    kprv_watchdog_add_ms(&entry->due, period);
+
+    /* A shorter period may mean the next kick is already overdue */
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (kprv_watchdog_diff_us(&entry->due, &now) < 0)
+    {
+        entry->due = now;
+    }
+
+    pthread_cond_signal(&watchdog_cond);
+    pthread_mutex_unlock(&watchdog_mutex);
+
+    return WATCHDOG_OK;
+}
+
+void k_watchdog_set_slack_scale(uint16_t scale)
+{
+    pthread_once(&watchdog_once, kprv_watchdog_init);
+
+    pthread_mutex_lock(&watchdog_mutex);
+
+    /* Only changes which watchdogs share a wakeup, never the deadlines */
+    watchdog_slack_scale = scale;
+
+    pthread_mutex_unlock(&watchdog_mutex);
+}
+
+KWatchdogStatus k_watchdog_get_stats(int id, k_watchdog_stats * stats)
+{
+    if (stats == NULL)
+    {
+        return WATCHDOG_ERROR_CONFIG;
+    }
+
+    pthread_mutex_lock(&watchdog_mutex);
+
+    if (!kprv_watchdog_valid(id))
+    {
+        pthread_mutex_unlock(&watchdog_mutex);
+        return WATCHDOG_ERROR_CONFIG;
+    }
+
+    *stats = watchdogs[id].stats;
+
+    pthread_mutex_unlock(&watchdog_mutex);
+
+    return WATCHDOG_OK;
+}
+
+uint32_t k_watchdog_get_wakeups(void)
+{
+    uint32_t wakeups;
+
+    pthread_mutex_lock(&watchdog_mutex);
+    wakeups = watchdog_wakeups;
+    pthread_mutex_unlock(&watchdog_mutex);
+
+    return wakeups;
+}
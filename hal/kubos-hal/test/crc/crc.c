@@ -0,0 +1,171 @@
+/*
+ * KubOS HAL
+ * Copyright (C) 2018 Kubos Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cmocka.h>
+#include <stdlib.h>
+#include "crc.h"
+
+static const char check[] = "123456789";
+
+static uint8_t buffer[1031];
+
+/* Bit-at-a-time reference implementations */
+static uint8_t ref_crc8(const uint8_t * data, size_t len)
+{
+    uint8_t crc = 0;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+        }
+    }
+
+    return crc;
+}
+
+static uint16_t ref_crc16_ccitt(const uint8_t * data, size_t len)
+{
+    uint16_t crc = 0xFFFF;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 1) ? (crc >> 1) ^ 0x8408 : crc >> 1;
+        }
+    }
+
+    return ~crc;
+}
+
+static uint32_t ref_crc32(uint32_t poly, const uint8_t * data, size_t len)
+{
+    uint32_t crc = 0xFFFFFFFF;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc >> 1) ^ (poly & -(crc & 1));
+        }
+    }
+
+    return ~crc;
+}
+
+static int setup(void ** state)
+{
+    srand(1);
+
+    for (size_t i = 0; i < sizeof(buffer); i++)
+    {
+        buffer[i] = rand();
+    }
+
+    return 0;
+}
+
+static void test_check_values(void ** arg)
+{
+    assert_int_equal(k_crc8(0, check, 9), 0xF4);
+    assert_int_equal(k_crc16_ccitt(0, check, 9), 0x906E);
+    assert_int_equal(k_crc32(0, check, 9), 0xCBF43926);
+    assert_int_equal(k_crc32c(0, check, 9), 0xE3069283);
+}
+
+static void test_empty(void ** arg)
+{
+    assert_int_equal(k_crc8(0, NULL, 0), 0);
+    assert_int_equal(k_crc16_ccitt(0, NULL, 0), 0);
+    assert_int_equal(k_crc32(0, NULL, 0), 0);
+    assert_int_equal(k_crc32c(0, NULL, 0), 0);
+
+    /* A zero-length update leaves the CRC alone */
+    assert_int_equal(k_crc32(0xCBF43926, NULL, 0), 0xCBF43926);
+}
+
+/* Every length and offset, to cover each path through the slicing loops */
+static void test_reference(void ** arg)
+{
+    for (size_t offset = 0; offset < 8; offset++)
+    {
+        for (size_t len = 0; len <= 64; len++)
+        {
+            const uint8_t * data = buffer + offset;
+
+            assert_int_equal(k_crc8(0, data, len), ref_crc8(data, len));
+            assert_int_equal(k_crc16_ccitt(0, data, len),
+                             ref_crc16_ccitt(data, len));
+            assert_int_equal(k_crc32(0, data, len),
+                             ref_crc32(0xEDB88320, data, len));
+            assert_int_equal(k_crc32c(0, data, len),
+                             ref_crc32(0x82F63B78, data, len));
+        }
+    }
+
+    assert_int_equal(k_crc32(0, buffer, sizeof(buffer)),
+                     ref_crc32(0xEDB88320, buffer, sizeof(buffer)));
+}
+
+static void test_chunked(void ** arg)
+{
+    uint8_t  crc8  = 0;
+    uint16_t crc16 = 0;
+    uint32_t crc32 = 0;
+    uint32_t crc32c = 0;
+    size_t   pos   = 0;
+    size_t   chunk = 1;
+
+    /* Chunks of increasing size, so the breaks fall mid-slice */
+    while (pos < sizeof(buffer))
+    {
+        if (chunk > sizeof(buffer) - pos)
+        {
+            chunk = sizeof(buffer) - pos;
+        }
+
+        crc8   = k_crc8(crc8, buffer + pos, chunk);
+        crc16  = k_crc16_ccitt(crc16, buffer + pos, chunk);
+        crc32  = k_crc32(crc32, buffer + pos, chunk);
+        crc32c = k_crc32c(crc32c, buffer + pos, chunk);
+
+        pos += chunk;
+        chunk += 3;
+    }
+
+    assert_int_equal(crc8, k_crc8(0, buffer, sizeof(buffer)));
+    assert_int_equal(crc16, k_crc16_ccitt(0, buffer, sizeof(buffer)));
+    assert_int_equal(crc32, k_crc32(0, buffer, sizeof(buffer)));
+    assert_int_equal(crc32c, k_crc32c(0, buffer, sizeof(buffer)));
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_check_values),
+        cmocka_unit_test(test_empty),
+        cmocka_unit_test(test_reference),
+        cmocka_unit_test(test_chunked),
+    };
+
+    return cmocka_run_group_tests(tests, setup, NULL);
+}
@@ -0,0 +1,198 @@
+/*
+ * KubOS HAL
+ * Copyright (C) 2018 Kubos Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cmocka.h>
+#include <time.h>
+#include "power-policy.h"
+
+static void sleep_ms(long ms)
+{
+    const struct timespec delay = {.tv_sec = ms / 1000, .tv_nsec = (ms % 1000) * 1000000 };
+
+    nanosleep(&delay, NULL);
+}
+
+static int setup(void ** state)
+{
+    k_power_config config = K_POWER_DEFAULT_CONFIG;
+
+    k_power_configure(&config);
+    k_power_update(POWER_MODE_NORMAL, 0, NULL);
+
+    return 0;
+}
+
+static void test_configure_bad_args(void ** arg)
+{
+    k_power_config config = K_POWER_DEFAULT_CONFIG;
+
+    assert_int_equal(k_power_configure(NULL), POWER_ERROR_CONFIG);
+
+    config.interval_scale[POWER_MODE_SAFE] = 0;
+    assert_int_equal(k_power_configure(&config), POWER_ERROR_CONFIG);
+
+    config.interval_scale[POWER_MODE_SAFE] = 100;
+    config.vbatt_safe = 6800;
+    config.vbatt_critical = 7000;
+    assert_int_equal(k_power_configure(&config), POWER_ERROR_CONFIG);
+}
+
+static void test_reported_mode(void ** arg)
+{
+    KPowerMode mode;
+
+    assert_int_equal(k_power_update(POWER_MODE_SAFE, 8000, &mode), POWER_OK);
+    assert_int_equal(mode, POWER_MODE_SAFE);
+    assert_int_equal(k_power_get_mode(), POWER_MODE_SAFE);
+
+    assert_int_equal(k_power_update(POWER_MODE_NORMAL, 8000, &mode), POWER_OK);
+    assert_int_equal(mode, POWER_MODE_NORMAL);
+
+    assert_int_equal(k_power_update(POWER_MODE_COUNT, 8000, &mode), POWER_ERROR_CONFIG);
+}
+
+static void test_vbatt_hysteresis(void ** arg)
+{
+    k_power_config config = K_POWER_DEFAULT_CONFIG;
+    KPowerMode     mode;
+
+    config.vbatt_safe     = 7000;
+    config.vbatt_critical = 6500;
+    config.hysteresis     = 200;
+    assert_int_equal(k_power_configure(&config), POWER_OK);
+
+    k_power_update(POWER_MODE_NORMAL, 7100, &mode);
+    assert_int_equal(mode, POWER_MODE_NORMAL);
+
+    k_power_update(POWER_MODE_NORMAL, 6900, &mode);
+    assert_int_equal(mode, POWER_MODE_SAFE);
+
+    /* Recovered past the threshold, but not past the hysteresis */
+    k_power_update(POWER_MODE_NORMAL, 7100, &mode);
+    assert_int_equal(mode, POWER_MODE_SAFE);
+
+    k_power_update(POWER_MODE_NORMAL, 6400, &mode);
+    assert_int_equal(mode, POWER_MODE_CRITICAL);
+
+    k_power_update(POWER_MODE_NORMAL, 6600, &mode);
+    assert_int_equal(mode, POWER_MODE_CRITICAL);
+
+    k_power_update(POWER_MODE_NORMAL, 6800, &mode);
+    assert_int_equal(mode, POWER_MODE_SAFE);
+
+    k_power_update(POWER_MODE_NORMAL, 7300, &mode);
+    assert_int_equal(mode, POWER_MODE_NORMAL);
+
+    /* The EPS's own mode wins if it's more severe */
+    k_power_update(POWER_MODE_CRITICAL, 7300, &mode);
+    assert_int_equal(mode, POWER_MODE_CRITICAL);
+}
+
+static void test_poll_interval(void ** arg)
+{
+    k_power_poll_stats stats;
+    int                id;
+
+    assert_int_equal(k_power_register_poll("test", 1000, &id), POWER_OK);
+
+    assert_int_equal(k_power_poll(id), 1000);
+
+    k_power_update(POWER_MODE_SAFE, 0, NULL);
+    assert_int_equal(k_power_poll(id), 4000);
+
+    k_power_update(POWER_MODE_CRITICAL, 0, NULL);
+    assert_int_equal(k_power_poll(id), 10000);
+
+    assert_int_equal(k_power_get_poll_stats(id, &stats), POWER_OK);
+    assert_int_equal(stats.interval, 10000);
+    assert_int_equal(stats.polls, 3);
+    assert_int_equal(stats.polls_by_mode[POWER_MODE_NORMAL], 1);
+    assert_int_equal(stats.polls_by_mode[POWER_MODE_SAFE], 1);
+    assert_int_equal(stats.polls_by_mode[POWER_MODE_CRITICAL], 1);
+
+    assert_int_equal(k_power_unregister_poll(id), POWER_OK);
+}
+
+static void test_poll_mean(void ** arg)
+{
+    k_power_poll_stats stats;
+    int                id;
+
+    assert_int_equal(k_power_register_poll("test", 20, &id), POWER_OK);
+
+    for (int i = 0; i < 5; i++)
+    {
+        sleep_ms(k_power_poll(id));
+    }
+
+    assert_int_equal(k_power_get_poll_stats(id, &stats), POWER_OK);
+    assert_in_range(stats.interval_mean, 20, 60);
+
+    assert_int_equal(k_power_unregister_poll(id), POWER_OK);
+}
+
+static void test_poll_bad_id(void ** arg)
+{
+    k_power_poll_stats stats;
+    int                id;
+
+    assert_int_equal(k_power_register_poll("test", 0, &id), POWER_ERROR_CONFIG);
+    assert_int_equal(k_power_register_poll(NULL, 1000, &id), POWER_ERROR_CONFIG);
+
+    assert_int_equal(k_power_register_poll("test", 1000, &id), POWER_OK);
+    assert_int_equal(k_power_unregister_poll(id), POWER_OK);
+
+    assert_int_equal(k_power_poll(id), 0);
+    assert_int_equal(k_power_poll(-1), 0);
+    assert_int_equal(k_power_poll(K_POWER_MAX_POLLS), 0);
+    assert_int_equal(k_power_get_poll_stats(id, &stats), POWER_ERROR_CONFIG);
+    assert_int_equal(k_power_unregister_poll(id), POWER_ERROR_CONFIG);
+}
+
+static void test_stats(void ** arg)
+{
+    k_power_stats before;
+    k_power_stats after;
+
+    assert_int_equal(k_power_get_stats(&before), POWER_OK);
+
+    k_power_update(POWER_MODE_SAFE, 0, NULL);
+    sleep_ms(50);
+    k_power_update(POWER_MODE_NORMAL, 0, NULL);
+
+    assert_int_equal(k_power_get_stats(&after), POWER_OK);
+    assert_int_equal(after.mode, POWER_MODE_NORMAL);
+    assert_int_equal(after.mode_changes, before.mode_changes + 2);
+    assert_in_range(after.time_in_mode[POWER_MODE_SAFE]
+                         - before.time_in_mode[POWER_MODE_SAFE],
+                     40, 500);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup(test_configure_bad_args, setup),
+        cmocka_unit_test_setup(test_reported_mode, setup),
+        cmocka_unit_test_setup(test_vbatt_hysteresis, setup),
+        cmocka_unit_test_setup(test_poll_interval, setup),
+        cmocka_unit_test_setup(test_poll_mean, setup),
+        cmocka_unit_test_setup(test_poll_bad_id, setup),
+        cmocka_unit_test_setup(test_stats, setup),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,407 @@
+/*
+ * KubOS HAL
+ * Copyright (C) 2018 Kubos Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cmocka.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <time.h>
+#include "watchdog.h"
+
+/*
+ * Mocked monotonic clock. The scheduler's waits end as soon as the mocked time
+ * reaches their deadline, so the tests step time forward rather than sleeping
+ */
+static pthread_mutex_t clock_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  clock_cond  = PTHREAD_COND_INITIALIZER;
+static struct timespec mock_now    = {.tv_sec = 1000 };
+/* Set while the scheduler is blocked waiting for a deadline in the future */
+static bool            scheduler_waiting = false;
+
+static atomic_int kicks_a;
+static atomic_int kicks_b;
+
+/* Kick times, used to check the longest gap between kicks */
+static int64_t last_kick_a;
+static int64_t last_kick_b;
+static int64_t max_gap_a;
+static int64_t max_gap_b;
+
+int __real_clock_gettime(clockid_t clock, struct timespec * time);
+int __real_pthread_cond_timedwait(pthread_cond_t * cond, pthread_mutex_t * mutex,
+                                  const struct timespec * abstime);
+
+static int64_t mock_ms(const struct timespec * time)
+{
+    return (int64_t) time->tv_sec * 1000 + time->tv_nsec / 1000000;
+}
+
+int __wrap_clock_gettime(clockid_t clock, struct timespec * time)
+{
+    if (clock != CLOCK_MONOTONIC)
+    {
+        return __real_clock_gettime(clock, time);
+    }
+
+    pthread_mutex_lock(&clock_mutex);
+    *time = mock_now;
+    pthread_mutex_unlock(&clock_mutex);
+
+    return 0;
+}
+
+int __wrap_pthread_cond_timedwait(pthread_cond_t * cond, pthread_mutex_t * mutex,
+                                  const struct timespec * abstime)
+{
+    struct timespec poll;
+
+    pthread_mutex_lock(&clock_mutex);
+    if (mock_ms(abstime) <= mock_ms(&mock_now))
+    {
+        scheduler_waiting = false;
+        pthread_mutex_unlock(&clock_mutex);
+        return ETIMEDOUT;
+    }
+
+    scheduler_waiting = true;
+    pthread_cond_broadcast(&clock_cond);
+    pthread_mutex_unlock(&clock_mutex);
+
+    /* Still woken by changes to the table, and checks the mocked time every millisecond */
+    __real_clock_gettime(CLOCK_MONOTONIC, &poll);
+    poll.tv_nsec += 1000000;
+    if (poll.tv_nsec >= 1000000000)
+    {
+        poll.tv_sec++;
+        poll.tv_nsec -= 1000000000;
+    }
+
+    __real_pthread_cond_timedwait(cond, mutex, &poll);
+
+    pthread_mutex_lock(&clock_mutex);
+    scheduler_waiting = false;
+    pthread_mutex_unlock(&clock_mutex);
+
+    /* Looks like a spurious wakeup, so the scheduler works out its deadline again */
+    return 0;
+}
+
+/* Wait until the scheduler has made every kick due at the current mocked time */
+static void settle(void)
+{
+    pthread_mutex_lock(&clock_mutex);
+
+    scheduler_waiting = false;
+    while (!scheduler_waiting)
+    {
+        pthread_cond_wait(&clock_cond, &clock_mutex);
+    }
+
+    pthread_mutex_unlock(&clock_mutex);
+}
+
+/* Step the mocked clock a millisecond at a time. Needs a registered watchdog */
+static void advance_ms(int ms)
+{
+    for (int i = 0; i < ms; i++)
+    {
+        pthread_mutex_lock(&clock_mutex);
+        mock_now.tv_nsec += 1000000;
+        if (mock_now.tv_nsec >= 1000000000)
+        {
+            mock_now.tv_sec++;
+            mock_now.tv_nsec -= 1000000000;
+        }
+        pthread_mutex_unlock(&clock_mutex);
+
+        settle();
+    }
+}
+
+static int64_t record_kick(int64_t * last)
+{
+    struct timespec now;
+    int64_t         gap = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    if (*last != 0)
+    {
+        gap = mock_ms(&now) - *last;
+    }
+
+    *last = mock_ms(&now);
+
+    return gap;
+}
+
+static int kick_a(void * arg)
+{
+    int64_t gap = record_kick(&last_kick_a);
+
+    if (gap > max_gap_a)
+    {
+        max_gap_a = gap;
+    }
+
+    atomic_fetch_add(&kicks_a, 1);
+    return 0;
+}
+
+static int kick_b(void * arg)
+{
+    int64_t gap = record_kick(&last_kick_b);
+
+    if (gap > max_gap_b)
+    {
+        max_gap_b = gap;
+    }
+
+    atomic_fetch_add(&kicks_b, 1);
+    return 0;
+}
+
+static int kick_fail(void * arg)
+{
+    return -1;
+}
+
+static int setup(void ** state)
+{
+    atomic_store(&kicks_a, 0);
+    atomic_store(&kicks_b, 0);
+    last_kick_a = 0;
+    last_kick_b = 0;
+    max_gap_a   = 0;
+    max_gap_b   = 0;
+
+    k_watchdog_set_slack_scale(100);
+
+    return 0;
+}
+
+static void test_register_bad_args(void ** arg)
+{
+    int id;
+
+    assert_int_equal(k_watchdog_register(NULL, 10, 0, kick_a, NULL, &id),
+                     WATCHDOG_ERROR_CONFIG);
+    assert_int_equal(k_watchdog_register("test", 0, 0, kick_a, NULL, &id),
+                     WATCHDOG_ERROR_CONFIG);
+    assert_int_equal(k_watchdog_register("test", 10, 0, NULL, NULL, &id),
+                     WATCHDOG_ERROR_CONFIG);
+    assert_int_equal(k_watchdog_register("test", 10, 0, kick_a, NULL, NULL),
+                     WATCHDOG_ERROR_CONFIG);
+}
+
+static void test_register_kicks_immediately(void ** arg)
+{
+    k_watchdog_stats stats;
+    int              id;
+
+    assert_int_equal(k_watchdog_register("test", 1000, 0, kick_a, NULL, &id),
+                     WATCHDOG_OK);
+    assert_int_equal(atomic_load(&kicks_a), 1);
+
+    assert_int_equal(k_watchdog_get_stats(id, &stats), WATCHDOG_OK);
+    assert_int_equal(stats.kicks, 1);
+    assert_int_equal(stats.failures, 0);
+
+    assert_int_equal(k_watchdog_unregister(id), WATCHDOG_OK);
+}
+
+static void test_periodic(void ** arg)
+{
+    k_watchdog_stats stats;
+    int              id;
+
+    assert_int_equal(k_watchdog_register("test", 10, 0, kick_a, NULL, &id),
+                     WATCHDOG_OK);
+
+    advance_ms(55);
+
+    assert_int_equal(k_watchdog_get_stats(id, &stats), WATCHDOG_OK);
+    assert_int_equal(k_watchdog_unregister(id), WATCHDOG_OK);
+
+    /* At registration, then at 10, 20, 30, 40 and 50 ms */
+    assert_int_equal(stats.kicks, 6);
+    assert_int_equal(stats.kicks, atomic_load(&kicks_a));
+    assert_int_equal(max_gap_a, 10);
+    assert_int_equal(stats.latency_max, 0);
+}
+
+static void test_coalesce(void ** arg)
+{
+    int id_a;
+    int id_b;
+
+    assert_int_equal(k_watchdog_register("a", 20, 20, kick_a, NULL, &id_a),
+                     WATCHDOG_OK);
+    advance_ms(5);
+    assert_int_equal(k_watchdog_register("b", 20, 20, kick_b, NULL, &id_b),
+                     WATCHDOG_OK);
+
+    uint32_t start = k_watchdog_get_wakeups();
+
+    advance_ms(110);
+
+    assert_int_equal(k_watchdog_unregister(id_a), WATCHDOG_OK);
+    assert_int_equal(k_watchdog_unregister(id_b), WATCHDOG_OK);
+
+    uint32_t wakeups = k_watchdog_get_wakeups() - start;
+
+    /*
+     * b is brought forward 5 ms to share a's wakeup at 20 ms, and from then on
+     * both are due together, at 20, 40, 60, 80 and 100 ms
+     */
+    assert_int_equal(wakeups, 5);
+    assert_int_equal(atomic_load(&kicks_a), 6);
+    assert_int_equal(atomic_load(&kicks_b), 6);
+    assert_true(max_gap_a <= 20);
+    assert_true(max_gap_b <= 20);
+}
+
+/* However much the slack is scaled, a kick is never later than its period */
+static void test_slack_scale(void ** arg)
+{
+    int id_a;
+    int id_b;
+
+    k_watchdog_set_slack_scale(400);
+
+    assert_int_equal(k_watchdog_register("a", 40, 10, kick_a, NULL, &id_a),
+                     WATCHDOG_OK);
+    advance_ms(7);
+    assert_int_equal(k_watchdog_register("b", 30, 7, kick_b, NULL, &id_b),
+                     WATCHDOG_OK);
+
+    advance_ms(600);
+
+    assert_int_equal(k_watchdog_unregister(id_a), WATCHDOG_OK);
+    assert_int_equal(k_watchdog_unregister(id_b), WATCHDOG_OK);
+
+    assert_true(max_gap_a <= 40);
+    assert_true(max_gap_b <= 30);
+
+    /* Slack is capped at half the period, so early kicks at most double the rate */
+    assert_true(atomic_load(&kicks_a) <= 1 + 600 / 20);
+    assert_true(atomic_load(&kicks_b) <= 1 + 600 / 15);
+}
+
+static void test_failures(void ** arg)
+{
+    k_watchdog_stats stats;
+    int              id;
+
+    assert_int_equal(k_watchdog_register("test", 10, 0, kick_fail, NULL, &id),
+                     WATCHDOG_OK);
+
+    advance_ms(25);
+
+    assert_int_equal(k_watchdog_get_stats(id, &stats), WATCHDOG_OK);
+    assert_int_equal(k_watchdog_unregister(id), WATCHDOG_OK);
+
+    assert_int_equal(stats.kicks, 3);
+    assert_int_equal(stats.failures, stats.kicks);
+}
+
+static void test_unregister(void ** arg)
+{
+    int id_a;
+    int id_b;
+
+    assert_int_equal(k_watchdog_register("a", 5, 0, kick_a, NULL, &id_a),
+                     WATCHDOG_OK);
+    advance_ms(12);
+    assert_int_equal(k_watchdog_unregister(id_a), WATCHDOG_OK);
+
+    assert_int_equal(atomic_load(&kicks_a), 3);
+
+    /* Keep the scheduler running with another watchdog */
+    assert_int_equal(k_watchdog_register("b", 5, 0, kick_b, NULL, &id_b),
+                     WATCHDOG_OK);
+    advance_ms(15);
+    assert_int_equal(k_watchdog_unregister(id_b), WATCHDOG_OK);
+
+    assert_int_equal(atomic_load(&kicks_a), 3);
+    assert_int_equal(atomic_load(&kicks_b), 4);
+    assert_int_equal(k_watchdog_unregister(id_a), WATCHDOG_ERROR_CONFIG);
+}
+
+static void test_set_period(void ** arg)
+{
+    int id;
+
+    assert_int_equal(k_watchdog_register("test", 60000, 0, kick_a, NULL, &id),
+                     WATCHDOG_OK);
+    advance_ms(5);
+
+    /* The next kick is already overdue with the new period */
+    assert_int_equal(k_watchdog_set_period(id, 1, 0), WATCHDOG_OK);
+    settle();
+    assert_int_equal(atomic_load(&kicks_a), 2);
+
+    advance_ms(10);
+    assert_int_equal(atomic_load(&kicks_a), 12);
+
+    assert_int_equal(k_watchdog_set_period(id, 60000, 0), WATCHDOG_OK);
+    advance_ms(10);
+
+    assert_int_equal(atomic_load(&kicks_a), 12);
+    assert_int_equal(k_watchdog_set_period(id, 0, 0), WATCHDOG_ERROR_CONFIG);
+    assert_int_equal(k_watchdog_unregister(id), WATCHDOG_OK);
+}
+
+static void test_full(void ** arg)
+{
+    int ids[K_WATCHDOG_MAX];
+    int id;
+
+    for (int i = 0; i < K_WATCHDOG_MAX; i++)
+    {
+        assert_int_equal(k_watchdog_register("test", 60000, 0, kick_a, NULL, &ids[i]),
+                         WATCHDOG_OK);
+    }
+
+    assert_int_equal(k_watchdog_register("test", 60000, 0, kick_a, NULL, &id),
+                     WATCHDOG_ERROR_FULL);
+
+    for (int i = 0; i < K_WATCHDOG_MAX; i++)
+    {
+        assert_int_equal(k_watchdog_unregister(ids[i]), WATCHDOG_OK);
+    }
+
+    assert_int_equal(atomic_load(&kicks_a), K_WATCHDOG_MAX);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup(test_register_bad_args, setup),
+        cmocka_unit_test_setup(test_register_kicks_immediately, setup),
+        cmocka_unit_test_setup(test_periodic, setup),
+        cmocka_unit_test_setup(test_coalesce, setup),
+        cmocka_unit_test_setup(test_slack_scale, setup),
+        cmocka_unit_test_setup(test_failures, setup),
+        cmocka_unit_test_setup(test_unregister, setup),
+        cmocka_unit_test_setup(test_set_period, setup),
+        cmocka_unit_test_setup(test_full, setup),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
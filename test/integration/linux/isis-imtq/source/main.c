@@ -235,7 +235,7 @@ KADCSStatus get_orientation()
     adcs_orient data;
 
     status = k_adcs_get_orientation(&data);
-    if (status != ADCS_ERROR_NOT_IMPLEMENTED)
+    if (status != ADCS_OK)
     {
         fprintf(fp, "[Orientation Test] Received unexpected ADCS orientation RC: %d\n",
                 status);
@@ -244,6 +244,9 @@ KADCSStatus get_orientation()
         return ADCS_ERROR;
     }
 
+    fprintf(fp, "[Orientation Test] Field: %f nT Direction: %f, %f, %f\n",
+            data.field, data.x, data.y, data.z);
+
     fprintf(fp, "[Orientation Test] Test completed successfully\n");
 
     return ADCS_OK;
@@ -255,13 +258,16 @@ KADCSStatus get_spin()
     adcs_spin data;
 
     status = k_adcs_get_spin(&data);
-    if (status != ADCS_ERROR_NOT_IMPLEMENTED)
+    if (status != ADCS_OK)
     {
         fprintf(fp, "[Spin Test] Received unexpected ADCS spin RC: %d\n", status);
         fprintf(stderr, "[Spin Test] Received unexpected ADCS spin RC: %d\n", status);
         return ADCS_ERROR;
     }
 
+    fprintf(fp, "[Spin Test] Rate: %f rad/s from %d samples\n", data.rate,
+            data.samples);
+
     fprintf(fp, "[Spin Test] Test completed successfully\n");
 
     return ADCS_OK;